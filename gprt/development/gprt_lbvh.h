@@ -21,192 +21,617 @@
 // SOFTWARE.
 #pragma once
 
-#error "This file needs refactoring to use slang"
-
 #include "gprt.h"
 
+#define LBVH_THREADGROUP_SIZE 256
+
+// Primitive kinds an LBVH can be built over
+#define LBVH_POINTS    1
+#define LBVH_EDGES     2
+#define LBVH_TRIANGLES 4
+
+// Treelet restructuring, after Karras and Aila, "Fast Parallel Construction of High-Quality Bounding
+// Volume Hierarchies" (HPG 2013). Each treelet has this many leaves, which are reorganized into the
+// topology with the lowest SAH cost. The optimization is exhaustive, so the work per treelet grows
+// as 3^LBVH_TREELET_SIZE.
+#define LBVH_TREELET_SIZE 7
+
+// SAH costs of traversing an inner node and of intersecting a primitive
+#define LBVH_COST_INNER     1.2f
+#define LBVH_COST_PRIMITIVE 1.0f
+
+// Wide (4 or 8 child) nodes, collapsed from the binary tree by gprtLBVHCollapse. Each node is a run of
+// 32-bit words sized to one cache line for 4-wide nodes (64 bytes) and one 128-byte line for 8-wide nodes:
+//   [0, 3)          float3 origin of the node's bounds
+//   [3]             per-axis biased exponents in bytes 0-2, child count in byte 3
+//   [4, 4 + W)      child references. Wide node indices, or LBVH_WIDE_LEAF_BIT | primitive ID for leaves.
+//   [4 + W, ...)    6 bytes per child, quantized min xyz and max xyz relative to the origin
+// Child bounds are decoded as origin + q * 2^exponent, and are always conservative.
+#define LBVH_WIDE_LEAF_BIT 0x80000000u
+#define LBVH_WIDE_NODE_WORDS(width) ((width) <= 4 ? 16 : 32)
+
+// Binary traversal holds at most one stack entry per level plus one, and wide traversal one entry per wide node,
+// and wide trees are shallower. Duplicate Morton codes and treelet restructuring can both deepen a tree, so
+// gprtLBVHBuild measures the depth of every tree it builds and rejects those too deep for this stack. Traversal
+// also never pushes past it, dropping the farthest entries instead.
+#define LBVH_WIDE_STACK_SIZE 64
+
 struct LBVHData {
   // input
   uint32_t numPrims;
   uint32_t numNodes;
   uint32_t numInner;
-  uint32_t tmp;
-  gprt::Buffer positions;
-  gprt::Buffer edges;
-  gprt::Buffer triangles;
+  uint32_t type;
+  float3 *positions;
+  uint2 *edges;
+  uint3 *triangles;
+
+  // Bounds over all primitive centroids, stored as order-preserving unsigned integers so that
+  // they can be reduced with integer atomics. Min xyz followed by max xyz.
+  uint32_t *bounds;
 
   // Morton codes of quantized primitive centroids
   // One uint32_t per primitive
-  gprt::Buffer mortonCodes;
+  uint32_t *mortonCodes;
 
-  // Primitive IDs that correspond to sorted morton codes. 
+  // Primitive IDs that correspond to sorted morton codes.
   // One uint32_t per primitive
-  gprt::Buffer ids;
-  
-  // numPrims-1 + numPrims long. 
-  // The "numPrims-1" section contains inner nodes
+  uint32_t *ids;
+
+  // numPrims-1 + numPrims long.
+  // The "numPrims-1" section contains inner nodes, with the root at 0
   // The "numPrims" section contains leaves
-  // Each node is an int4. 
+  // Each node is an int4.
   // "X" is left, "Y" is right, "Z" is parent, and "W" is leaf or -1 if internal node.
-  gprt::Buffer nodes;
+  int4 *nodes;
 
   // numPrims-1 + numPrims long. Each aabb is a pair of float3.
-  gprt::Buffer aabbs;
+  float3 *aabbs;
+
+  // numPrims-1 + numPrims long. SAH cost of the subtree under each node.
+  float *costs;
+
+  // numPrims-1 long. Number of primitives under each inner node.
+  uint32_t *leafCounts;
+
+  // numPrims-1 long. Counts child arrivals during bottom-up passes over the tree.
+  uint32_t *counters;
+
+  // Depth of the deepest leaf, measured after each build
+  uint32_t *maxDepth;
+
+  // Collapsing into wide nodes proceeds top down, one level of wide nodes per launch.
+  // Frontiers hold (binary node, wide node) pairs still to be collapsed.
+  uint32_t *wideNodes;
+  uint2 *wideFrontier;
+  uint2 *wideNextFrontier;
+  // [0] allocates wide nodes, [1] counts entries added to the next frontier
+  uint32_t *wideCounters;
+  uint32_t wideWidth;
+  uint32_t wideFrontierSize;
+};
+
+#if defined(__SLANG_COMPILER__)
+// Implemented by device code to intersect the primitives of an LBVH during traversal
+interface ILBVHIntersector {
+  // Returns the distance to the primitive along the ray, or tMax if it is missed or further away
+  float intersect(uint32_t primID, float3 origin, float3 direction, float tMax);
 };
 
-#ifndef GPRT_DEVICE
+// Returns the distance along the ray to the box, or tMax if the box is missed
+float
+lbvhIntersectBox(float3 origin, float3 invDir, float3 aabbMin, float3 aabbMax, float tMax) {
+  float3 t0 = (aabbMin - origin) * invDir;
+  float3 t1 = (aabbMax - origin) * invDir;
+  float3 tNear = min(t0, t1);
+  float3 tFar = max(t0, t1);
+  float tEnter = max(max(tNear.x, tNear.y), max(tNear.z, 0.f));
+  float tExit = min(min(tFar.x, tFar.y), min(tFar.z, tMax));
+  return (tEnter <= tExit && tEnter < tMax) ? tEnter : tMax;
+}
+
+uint32_t
+lbvhWideQuantizedByte(uint32_t *node, uint32_t width, uint32_t byteIndex) {
+  return (node[4 + width + byteIndex / 4] >> (8 * (byteIndex % 4))) & 0xFF;
+}
+
+void
+lbvhWideDecodeChild(uint32_t *node, uint32_t width, uint32_t child, out float3 aabbMin, out float3 aabbMax) {
+  float3 origin = asfloat(uint3(node[0], node[1], node[2]));
+  uint32_t exponents = node[3];
+  float3 scale = asfloat(uint3(exponents & 0xFF, (exponents >> 8) & 0xFF, (exponents >> 16) & 0xFF) << 23);
+  uint3 qMin = uint3(lbvhWideQuantizedByte(node, width, child * 6 + 0), lbvhWideQuantizedByte(node, width, child * 6 + 1),
+                     lbvhWideQuantizedByte(node, width, child * 6 + 2));
+  uint3 qMax = uint3(lbvhWideQuantizedByte(node, width, child * 6 + 3), lbvhWideQuantizedByte(node, width, child * 6 + 4),
+                     lbvhWideQuantizedByte(node, width, child * 6 + 5));
+  aabbMin = origin + float3(qMin) * scale;
+  aabbMax = origin + float3(qMax) * scale;
+}
+
+// Closest hit traversal of the binary tree. Returns the hit distance, or tMax on a miss.
+float
+lbvhTraceBinary<T : ILBVHIntersector>(int4 *nodes, float3 *aabbs, float3 origin, float3 direction, float tMax,
+                                      T intersector, out uint32_t hitPrim, inout uint32_t nodeVisits) {
+  float3 invDir = 1.f / direction;
+  float tHit = tMax;
+  hitPrim = ~0u;
+
+  int stack[LBVH_WIDE_STACK_SIZE];
+  int stackSize = 0;
+  if (lbvhIntersectBox(origin, invDir, aabbs[0], aabbs[1], tHit) < tHit)
+    stack[stackSize++] = 0;
+
+  while (stackSize > 0) {
+    int address = stack[--stackSize];
+    nodeVisits++;
+    int4 node = nodes[address];
+    if (node.w != -1) {
+      float t = intersector.intersect(node.w, origin, direction, tHit);
+      if (t < tHit) {
+        tHit = t;
+        hitPrim = node.w;
+      }
+      continue;
+    }
+
+    float tLeft = lbvhIntersectBox(origin, invDir, aabbs[node.x * 2 + 0], aabbs[node.x * 2 + 1], tHit);
+    float tRight = lbvhIntersectBox(origin, invDir, aabbs[node.y * 2 + 0], aabbs[node.y * 2 + 1], tHit);
+    // the nearer child is pushed last, so that it is visited first
+    // the farther child leaves room for the nearer one on a full stack
+    bool leftFirst = tLeft <= tRight;
+    if (max(tLeft, tRight) < tHit && stackSize < LBVH_WIDE_STACK_SIZE - 1)
+      stack[stackSize++] = leftFirst ? node.y : node.x;
+    if (min(tLeft, tRight) < tHit && stackSize < LBVH_WIDE_STACK_SIZE)
+      stack[stackSize++] = leftFirst ? node.x : node.y;
+  }
+  return tHit;
+}
+
+// Closest hit traversal of the wide nodes made by gprtLBVHCollapse. Returns the hit distance, or tMax on a miss.
+//
+// Leaf children are intersected as soon as their node is visited, nearest first. The nearest inner child is
+// visited next, and the remaining inner children are pushed as a single stack entry holding the node and
+// their slots in near to far order, 4 bits each. Entries are re-culled against the closest hit when popped.
+float
+lbvhTraceWide<T : ILBVHIntersector>(uint32_t *wideNodes, uint32_t width, float3 origin, float3 direction,
+                                    float tMax, T intersector, out uint32_t hitPrim, inout uint32_t nodeVisits) {
+  const uint32_t nodeWords = LBVH_WIDE_NODE_WORDS(width);
+  float3 invDir = 1.f / direction;
+  float tHit = tMax;
+  hitPrim = ~0u;
+
+  uint2 stack[LBVH_WIDE_STACK_SIZE];
+  int stackSize = 0;
+  uint32_t current = 0;
+  bool haveNode = true;
+  while (true) {
+    if (haveNode) {
+      haveNode = false;
+      nodeVisits++;
+      uint32_t nodeIndex = current;
+      uint32_t *node = wideNodes + uint64_t(nodeIndex) * nodeWords;
+      uint32_t numChildren = node[3] >> 24;
+
+      // Sort the children that were hit, nearest first
+      float distances[8];
+      uint32_t slots[8];
+      uint32_t numHits = 0;
+      for (uint32_t c = 0; c < numChildren; ++c) {
+        float3 aabbMin, aabbMax;
+        lbvhWideDecodeChild(node, width, c, aabbMin, aabbMax);
+        float t = lbvhIntersectBox(origin, invDir, aabbMin, aabbMax, tHit);
+        if (t >= tHit)
+          continue;
+        uint32_t i = numHits++;
+        while (i > 0 && distances[i - 1] > t) {
+          distances[i] = distances[i - 1];
+          slots[i] = slots[i - 1];
+          i--;
+        }
+        distances[i] = t;
+        slots[i] = c;
+      }
+
+      uint32_t innerSlots = 0;
+      uint32_t numInner = 0;
+      for (uint32_t i = 0; i < numHits; ++i) {
+        if (distances[i] >= tHit)
+          break;
+        uint32_t child = node[4 + slots[i]];
+        if ((child & LBVH_WIDE_LEAF_BIT) != 0) {
+          uint32_t primID = child & ~LBVH_WIDE_LEAF_BIT;
+          float t = intersector.intersect(primID, origin, direction, tHit);
+          if (t < tHit) {
+            tHit = t;
+            hitPrim = primID;
+          }
+        } else if (numInner == 0) {
+          current = child;
+          haveNode = true;
+          numInner++;
+        } else {
+          innerSlots |= slots[i] << (4 * (numInner - 1));
+          numInner++;
+        }
+      }
+      if (numInner > 1 && stackSize < LBVH_WIDE_STACK_SIZE)
+        stack[stackSize++] = uint2(nodeIndex, (innerSlots << 4) | (numInner - 1));
+      if (haveNode)
+        continue;
+    }
+
+    // Pop the next inner child still in front of the closest hit
+    while (!haveNode && stackSize > 0) {
+      uint2 entry = stack[stackSize - 1];
+      uint32_t count = entry.y & 0xF;
+      uint32_t slot = (entry.y >> 4) & 0xF;
+      if (count == 1)
+        stackSize--;
+      else
+        stack[stackSize - 1].y = ((entry.y >> 8) << 4) | (count - 1);
+
+      uint32_t *node = wideNodes + uint64_t(entry.x) * nodeWords;
+      float3 aabbMin, aabbMax;
+      lbvhWideDecodeChild(node, width, slot, aabbMin, aabbMax);
+      if (lbvhIntersectBox(origin, invDir, aabbMin, aabbMax, tHit) < tHit) {
+        current = node[4 + slot];
+        haveNode = true;
+      }
+    }
+    if (!haveNode)
+      break;
+  }
+  return tHit;
+}
+#endif
+
+#if !defined(__SLANG_COMPILER__)
+#include <algorithm>
+#include <chrono>
 #include <limits.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
 extern GPRTProgram lbvhDeviceCode;
 
+typedef enum { GPRT_LBVH_POINTS = LBVH_POINTS, GPRT_LBVH_EDGES = LBVH_EDGES, GPRT_LBVH_TRIANGLES = LBVH_TRIANGLES } GPRTLBVHType;
+
 typedef enum {
-    GPRT_LBVH_POINTS = 1,
-    GPRT_LBVH_EDGES = 2,
-    GPRT_LBVH_TRIANGLES = 4
-} GPRTLBVHType;
+  // Morton-ordered LBVH only. Fastest to build, but SAH quality suffers on clustered geometry.
+  GPRT_LBVH_BUILD_FAST = 0,
+  // LBVH followed by rounds of treelet restructuring. Emits the same node layout.
+  GPRT_LBVH_BUILD_HIGH_QUALITY = 1
+} GPRTLBVHBuildMode;
+
+// Summary of how well a tree is likely to perform during traversal
+struct GPRTLBVHStats {
+  // Expected cost of a random ray, LBVH_COST_INNER per inner node and LBVH_COST_PRIMITIVE per
+  // primitive visited, relative to intersecting the root box alone
+  float sahCost;
+  // Primitives per leaf. Every leaf of this node layout holds a single primitive, so this is 1.
+  float averageLeafSize;
+  float averageLeafDepth;
+  uint32_t maxLeafDepth;
+  // Sum over inner nodes of the surface area where the two child boxes overlap, relative to the root.
+  // Overlap forces traversal into both children, so lower is better.
+  float overlap;
+  // Wall clock time of the last gprtLBVHBuild
+  float buildTime;
+};
 
 struct GPRTLBVH {
-    LBVHData handle;
-    GPRTModule module;
-
-    GPRTLBVHType type;
-
-    GPRTBufferOf<uint32_t> mortonCodes;
-    GPRTBufferOf<uint32_t> ids;
-    GPRTBufferOf<int4> nodes;
-    GPRTBufferOf<float3> aabbs;
-
-    GPRTBufferOf<uint8_t> scratch;
-
-    GPRTComputeOf<LBVHData> computePointBounds;
-    GPRTComputeOf<LBVHData> computeEdgeBounds;
-    GPRTComputeOf<LBVHData> computeTriangleBounds;
-    GPRTComputeOf<LBVHData> computePointMortonCodes;
-    GPRTComputeOf<LBVHData> computeEdgeMortonCodes;
-    GPRTComputeOf<LBVHData> computeTriangleMortonCodes;
-    GPRTComputeOf<LBVHData> makeNodes;
-    GPRTComputeOf<LBVHData> splitNodes;
-    GPRTComputeOf<LBVHData> buildHierarchy;
+  LBVHData handle;
+  GPRTModule module;
+
+  GPRTLBVHType type;
+
+  GPRTBufferOf<uint32_t> bounds;
+  GPRTBufferOf<uint32_t> mortonCodes;
+  GPRTBufferOf<uint32_t> ids;
+  GPRTBufferOf<int4> nodes;
+  GPRTBufferOf<float3> aabbs;
+  GPRTBufferOf<float> costs;
+  GPRTBufferOf<uint32_t> leafCounts;
+  GPRTBufferOf<uint32_t> counters;
+  GPRTBufferOf<uint32_t> maxDepth;
+
+  GPRTBufferOf<uint8_t> scratch;
+
+  GPRTComputeOf<LBVHData> computeBounds;
+  GPRTComputeOf<LBVHData> computeMortonCodes;
+  GPRTComputeOf<LBVHData> makeNodes;
+  GPRTComputeOf<LBVHData> splitNodes;
+  GPRTComputeOf<LBVHData> buildHierarchy;
+  GPRTComputeOf<LBVHData> resetCounters;
+  GPRTComputeOf<LBVHData> restructureTreelets;
+  GPRTComputeOf<LBVHData> computeDepth;
+  GPRTComputeOf<LBVHData> collapseNodes;
+
+  // Made by gprtLBVHCollapse
+  GPRTBufferOf<uint32_t> wideNodes;
+  GPRTBufferOf<uint2> wideFrontiers[2];
+  GPRTBufferOf<uint32_t> wideCounters;
+  uint32_t numWideNodes;
+
+  float buildTime;
 };
 
-inline 
-GPRTLBVH gprtPointsLBVHCreate(GPRTContext context, GPRTBufferOf<float3> vertices, uint32_t count) {
-    GPRTLBVH lbvh;
-    lbvh.type = GPRT_LBVH_POINTS;
-    lbvh.module = gprtModuleCreate(context, lbvhDeviceCode);
-
-    lbvh.computePointBounds = gprtComputeCreate<LBVHData>(context, lbvh.module, "ComputePointBounds");
-    lbvh.computePointMortonCodes = gprtComputeCreate<LBVHData>(context, lbvh.module, "ComputePointMortonCodes");
-    lbvh.makeNodes = gprtComputeCreate<LBVHData>(context, lbvh.module, "MakeNodes");
-    lbvh.splitNodes = gprtComputeCreate<LBVHData>(context, lbvh.module, "SplitNodes");
-    lbvh.buildHierarchy = gprtComputeCreate<LBVHData>(context, lbvh.module, "BuildPointHierarchy");
-    
-    lbvh.handle.numPrims = count;
-    lbvh.handle.numNodes = lbvh.handle.numPrims * 2 - 1;
-    lbvh.handle.numInner = lbvh.handle.numPrims - 1;
-    lbvh.handle.positions = gprtBufferGetHandle(vertices);
-
-    lbvh.mortonCodes = gprtDeviceBufferCreate<uint32_t>(context, lbvh.handle.numPrims);
-    lbvh.ids = gprtDeviceBufferCreate<uint32_t>(context, lbvh.handle.numPrims);
-    lbvh.nodes = gprtDeviceBufferCreate<int4>(context, lbvh.handle.numNodes);
-    lbvh.aabbs = gprtDeviceBufferCreate<float3>(context, 2 * lbvh.handle.numNodes);
-    lbvh.scratch = gprtDeviceBufferCreate<uint8_t>(context);
-
-    lbvh.handle.mortonCodes = gprtBufferGetHandle(lbvh.mortonCodes);
-    lbvh.handle.ids = gprtBufferGetHandle(lbvh.ids);
-    lbvh.handle.nodes = gprtBufferGetHandle(lbvh.nodes);
-    lbvh.handle.aabbs = gprtBufferGetHandle(lbvh.aabbs);
-
-    gprtComputeSetParameters(lbvh.computePointBounds, &lbvh.handle);
-    gprtComputeSetParameters(lbvh.computePointMortonCodes, &lbvh.handle);
-    gprtComputeSetParameters(lbvh.makeNodes, &lbvh.handle);
-    gprtComputeSetParameters(lbvh.splitNodes, &lbvh.handle);
-    gprtComputeSetParameters(lbvh.buildHierarchy, &lbvh.handle);
-
-    gprtBuildShaderBindingTable(context, GPRT_SBT_COMPUTE);
-
-    return lbvh;
+inline GPRTLBVH
+_gprtLBVHCreate(GPRTContext context, GPRTLBVHType type, uint32_t count) {
+  GPRTLBVH lbvh;
+  lbvh.type = type;
+  lbvh.module = gprtModuleCreate(context, lbvhDeviceCode);
+
+  lbvh.computeBounds = gprtComputeCreate<LBVHData>(context, lbvh.module, "ComputeBounds");
+  lbvh.computeMortonCodes = gprtComputeCreate<LBVHData>(context, lbvh.module, "ComputeMortonCodes");
+  lbvh.makeNodes = gprtComputeCreate<LBVHData>(context, lbvh.module, "MakeNodes");
+  lbvh.splitNodes = gprtComputeCreate<LBVHData>(context, lbvh.module, "SplitNodes");
+  lbvh.buildHierarchy = gprtComputeCreate<LBVHData>(context, lbvh.module, "BuildHierarchy");
+  lbvh.resetCounters = gprtComputeCreate<LBVHData>(context, lbvh.module, "ResetCounters");
+  lbvh.restructureTreelets = gprtComputeCreate<LBVHData>(context, lbvh.module, "RestructureTreelets");
+  lbvh.computeDepth = gprtComputeCreate<LBVHData>(context, lbvh.module, "ComputeDepth");
+  lbvh.collapseNodes = gprtComputeCreate<LBVHData>(context, lbvh.module, "CollapseNodes");
+
+  lbvh.handle = {};
+  lbvh.handle.type = type;
+  lbvh.handle.numPrims = count;
+  lbvh.handle.numNodes = lbvh.handle.numPrims * 2 - 1;
+  lbvh.handle.numInner = lbvh.handle.numPrims - 1;
+
+  lbvh.bounds = gprtDeviceBufferCreate<uint32_t>(context, 6);
+  lbvh.mortonCodes = gprtDeviceBufferCreate<uint32_t>(context, lbvh.handle.numPrims);
+  lbvh.ids = gprtDeviceBufferCreate<uint32_t>(context, lbvh.handle.numPrims);
+  lbvh.nodes = gprtDeviceBufferCreate<int4>(context, lbvh.handle.numNodes);
+  lbvh.aabbs = gprtDeviceBufferCreate<float3>(context, 2 * lbvh.handle.numNodes);
+  lbvh.costs = gprtDeviceBufferCreate<float>(context, lbvh.handle.numNodes);
+  // max() keeps these valid for single primitive trees, which have no inner nodes
+  lbvh.leafCounts = gprtDeviceBufferCreate<uint32_t>(context, std::max(lbvh.handle.numInner, 1u));
+  lbvh.counters = gprtDeviceBufferCreate<uint32_t>(context, std::max(lbvh.handle.numInner, 1u));
+  lbvh.maxDepth = gprtDeviceBufferCreate<uint32_t>(context, 1);
+  lbvh.scratch = gprtDeviceBufferCreate<uint8_t>(context);
+
+  lbvh.handle.bounds = gprtBufferGetDevicePointer(lbvh.bounds);
+  lbvh.handle.mortonCodes = gprtBufferGetDevicePointer(lbvh.mortonCodes);
+  lbvh.handle.ids = gprtBufferGetDevicePointer(lbvh.ids);
+  lbvh.handle.nodes = gprtBufferGetDevicePointer(lbvh.nodes);
+  lbvh.handle.aabbs = gprtBufferGetDevicePointer(lbvh.aabbs);
+  lbvh.handle.costs = gprtBufferGetDevicePointer(lbvh.costs);
+  lbvh.handle.leafCounts = gprtBufferGetDevicePointer(lbvh.leafCounts);
+  lbvh.handle.counters = gprtBufferGetDevicePointer(lbvh.counters);
+  lbvh.handle.maxDepth = gprtBufferGetDevicePointer(lbvh.maxDepth);
+
+  lbvh.wideNodes = nullptr;
+  lbvh.wideFrontiers[0] = lbvh.wideFrontiers[1] = nullptr;
+  lbvh.wideCounters = nullptr;
+  lbvh.numWideNodes = 0;
+
+  lbvh.buildTime = 0.f;
+  return lbvh;
+}
+
+inline GPRTLBVH
+gprtPointsLBVHCreate(GPRTContext context, GPRTBufferOf<float3> vertices, uint32_t count) {
+  GPRTLBVH lbvh = _gprtLBVHCreate(context, GPRT_LBVH_POINTS, count);
+  lbvh.handle.positions = gprtBufferGetDevicePointer(vertices);
+  return lbvh;
+}
+
+inline GPRTLBVH
+gprtEdgeLBVHCreate(GPRTContext context, GPRTBufferOf<float3> vertices, GPRTBufferOf<uint2> indices, uint32_t count) {
+  GPRTLBVH lbvh = _gprtLBVHCreate(context, GPRT_LBVH_EDGES, count);
+  lbvh.handle.positions = gprtBufferGetDevicePointer(vertices);
+  lbvh.handle.edges = gprtBufferGetDevicePointer(indices);
+  return lbvh;
+}
+
+inline GPRTLBVH
+gprtTriangleLBVHCreate(GPRTContext context, GPRTBufferOf<float3> vertices, GPRTBufferOf<uint3> indices,
+                       uint32_t count) {
+  GPRTLBVH lbvh = _gprtLBVHCreate(context, GPRT_LBVH_TRIANGLES, count);
+  lbvh.handle.positions = gprtBufferGetDevicePointer(vertices);
+  lbvh.handle.triangles = gprtBufferGetDevicePointer(indices);
+  return lbvh;
+}
+
+inline void
+_gprtLBVHLaunch(GPRTComputeOf<LBVHData> compute, uint32_t numThreads, LBVHData &handle) {
+  // One thread per item, so trees are currently limited to WORKGROUP_LIMIT * LBVH_THREADGROUP_SIZE primitives
+  uint32_t numGroups = std::max((numThreads + LBVH_THREADGROUP_SIZE - 1) / LBVH_THREADGROUP_SIZE, 1u);
+  gprtComputeLaunch(compute, {numGroups, 1, 1}, {LBVH_THREADGROUP_SIZE, 1, 1}, handle);
+}
+
+/**
+ * @brief Builds the tree over the primitives given at creation. Can be called again to rebuild after the
+ * primitives move.
+ *
+ * @param mode GPRT_LBVH_BUILD_FAST builds a plain Morton-ordered LBVH. GPRT_LBVH_BUILD_HIGH_QUALITY
+ * additionally runs rounds of treelet restructuring, which typically lowers SAH cost (and with it, the node
+ * visits of software traversal) on clustered geometry at a few times the build cost. Both emit the same nodes.
+ * @param rounds The number of treelet restructuring rounds in high quality mode. Most of the improvement
+ * comes from the first few rounds.
+ */
+inline void
+gprtLBVHBuild(GPRTContext context, GPRTLBVH &lbvh, GPRTLBVHBuildMode mode = GPRT_LBVH_BUILD_FAST,
+              uint32_t rounds = 3) {
+  auto start = std::chrono::high_resolution_clock::now();
+
+  // initialize centroid bounds to an empty box
+  gprtBufferMap(lbvh.bounds);
+  uint32_t *boundsPtr = gprtBufferGetHostPointer(lbvh.bounds);
+  boundsPtr[0] = boundsPtr[1] = boundsPtr[2] = UINT_MAX;
+  boundsPtr[3] = boundsPtr[4] = boundsPtr[5] = 0;
+  gprtBufferUnmap(lbvh.bounds);
+
+  _gprtLBVHLaunch(lbvh.computeBounds, lbvh.handle.numPrims, lbvh.handle);
+  _gprtLBVHLaunch(lbvh.computeMortonCodes, lbvh.handle.numPrims, lbvh.handle);
+  gprtBufferSortPayload(context, lbvh.mortonCodes, lbvh.ids, lbvh.scratch);
+  _gprtLBVHLaunch(lbvh.makeNodes, lbvh.handle.numNodes, lbvh.handle);
+  _gprtLBVHLaunch(lbvh.splitNodes, lbvh.handle.numInner, lbvh.handle);
+  _gprtLBVHLaunch(lbvh.buildHierarchy, lbvh.handle.numPrims, lbvh.handle);
+
+  if (mode == GPRT_LBVH_BUILD_HIGH_QUALITY && lbvh.handle.numPrims >= LBVH_TREELET_SIZE) {
+    for (uint32_t round = 0; round < rounds; ++round) {
+      _gprtLBVHLaunch(lbvh.resetCounters, lbvh.handle.numInner, lbvh.handle);
+      _gprtLBVHLaunch(lbvh.restructureTreelets, lbvh.handle.numPrims, lbvh.handle);
+    }
+  }
+
+  // Traversal keeps at most one stack entry per level, plus one
+  gprtBufferClear(lbvh.maxDepth);
+  _gprtLBVHLaunch(lbvh.computeDepth, lbvh.handle.numPrims, lbvh.handle);
+  gprtBufferMap(lbvh.maxDepth);
+  uint32_t maxDepth = gprtBufferGetHostPointer(lbvh.maxDepth)[0];
+  gprtBufferUnmap(lbvh.maxDepth);
+
+  auto stop = std::chrono::high_resolution_clock::now();
+  lbvh.buildTime = std::chrono::duration<float, std::milli>(stop - start).count();
+
+  if (maxDepth + 1 > LBVH_WIDE_STACK_SIZE)
+    throw std::runtime_error("Error, LBVH is " + std::to_string(maxDepth) +
+                             " levels deep, too deep for a traversal stack of " +
+                             std::to_string(LBVH_WIDE_STACK_SIZE) + " entries!");
 }
 
-inline 
-GPRTLBVH gprtTriangleLBVHCreate(GPRTContext context, GPRTBufferOf<float3> vertices, GPRTBufferOf<uint3> indices, uint32_t count) {
-    GPRTLBVH lbvh;
-    lbvh.type = GPRT_LBVH_TRIANGLES;
-    lbvh.module = gprtModuleCreate(context, lbvhDeviceCode);
-
-    lbvh.computeTriangleBounds = gprtComputeCreate<LBVHData>(context, lbvh.module, "ComputeTriangleBounds");
-    lbvh.computeTriangleMortonCodes = gprtComputeCreate<LBVHData>(context, lbvh.module, "ComputeTriangleMortonCodes");
-    lbvh.makeNodes = gprtComputeCreate<LBVHData>(context, lbvh.module, "MakeNodes");
-    lbvh.splitNodes = gprtComputeCreate<LBVHData>(context, lbvh.module, "SplitNodes");
-    lbvh.buildHierarchy = gprtComputeCreate<LBVHData>(context, lbvh.module, "BuildTriangleHierarchy");
-
-    lbvh.handle.numPrims = count;
-    lbvh.handle.numNodes = lbvh.handle.numPrims * 2 - 1;
-    lbvh.handle.numInner = lbvh.handle.numPrims - 1;
-    lbvh.handle.positions = gprtBufferGetHandle(vertices);
-    lbvh.handle.triangles = gprtBufferGetHandle(indices);
-
-    lbvh.mortonCodes = gprtDeviceBufferCreate<uint32_t>(context, lbvh.handle.numPrims);
-    lbvh.ids = gprtDeviceBufferCreate<uint32_t>(context, lbvh.handle.numPrims);
-    lbvh.nodes = gprtDeviceBufferCreate<int4>(context, lbvh.handle.numNodes);
-    lbvh.aabbs = gprtDeviceBufferCreate<float3>(context, 2 * lbvh.handle.numNodes);
-    lbvh.scratch = gprtDeviceBufferCreate<uint8_t>(context);
-
-    lbvh.handle.mortonCodes = gprtBufferGetHandle(lbvh.mortonCodes);
-    lbvh.handle.ids = gprtBufferGetHandle(lbvh.ids);
-    lbvh.handle.nodes = gprtBufferGetHandle(lbvh.nodes);
-    lbvh.handle.aabbs = gprtBufferGetHandle(lbvh.aabbs);
-    
-    gprtComputeSetParameters(lbvh.computeTriangleBounds, &lbvh.handle);
-    gprtComputeSetParameters(lbvh.computeTriangleMortonCodes, &lbvh.handle);
-    gprtComputeSetParameters(lbvh.makeNodes, &lbvh.handle);
-    gprtComputeSetParameters(lbvh.splitNodes, &lbvh.handle);
-    gprtComputeSetParameters(lbvh.buildHierarchy, &lbvh.handle);
-
-    gprtBuildShaderBindingTable(context, GPRT_SBT_COMPUTE);
-
-    return lbvh;
+/**
+ * @brief Collapses a built binary tree into 4 or 8 wide nodes with quantized child bounds, for traversal with
+ * lbvhTraceWide in device code. Each wide node takes the place of a binary node and its descendants, opening
+ * the child with the largest surface area until the node is full.
+ *
+ * The binary tree is left intact. Collapse again after each rebuild.
+ *
+ * @param width Either 4 or 8 children per node.
+ */
+inline void
+gprtLBVHCollapse(GPRTContext context, GPRTLBVH &lbvh, uint32_t width = 4) {
+  if (width != 4 && width != 8)
+    throw std::runtime_error("Error, wide LBVH nodes must have either 4 or 8 children!");
+
+  // Every wide node stands in for a distinct binary node. Single primitive trees still get a root.
+  uint32_t maxWideNodes = std::max(lbvh.handle.numInner, 1u);
+  if (!lbvh.wideNodes) {
+    lbvh.wideNodes = gprtDeviceBufferCreate<uint32_t>(context, maxWideNodes * LBVH_WIDE_NODE_WORDS(8));
+    lbvh.wideFrontiers[0] = gprtDeviceBufferCreate<uint2>(context, maxWideNodes);
+    lbvh.wideFrontiers[1] = gprtDeviceBufferCreate<uint2>(context, maxWideNodes);
+    lbvh.wideCounters = gprtDeviceBufferCreate<uint32_t>(context, 2);
+  }
+  lbvh.handle.wideNodes = gprtBufferGetDevicePointer(lbvh.wideNodes);
+  lbvh.handle.wideCounters = gprtBufferGetDevicePointer(lbvh.wideCounters);
+  lbvh.handle.wideWidth = width;
+
+  // Start from the root, which becomes wide node 0
+  gprtBufferMap(lbvh.wideFrontiers[0]);
+  gprtBufferGetHostPointer(lbvh.wideFrontiers[0])[0] = uint2(0, 0);
+  gprtBufferUnmap(lbvh.wideFrontiers[0]);
+
+  gprtBufferMap(lbvh.wideCounters);
+  uint32_t *counters = gprtBufferGetHostPointer(lbvh.wideCounters);
+  counters[0] = 1;
+  counters[1] = 0;
+  gprtBufferUnmap(lbvh.wideCounters);
+
+  uint32_t frontier = 0;
+  uint32_t frontierSize = 1;
+  while (frontierSize > 0) {
+    lbvh.handle.wideFrontier = gprtBufferGetDevicePointer(lbvh.wideFrontiers[frontier]);
+    lbvh.handle.wideNextFrontier = gprtBufferGetDevicePointer(lbvh.wideFrontiers[frontier ^ 1]);
+    lbvh.handle.wideFrontierSize = frontierSize;
+    _gprtLBVHLaunch(lbvh.collapseNodes, frontierSize, lbvh.handle);
+
+    gprtBufferMap(lbvh.wideCounters);
+    counters = gprtBufferGetHostPointer(lbvh.wideCounters);
+    frontierSize = counters[1];
+    lbvh.numWideNodes = counters[0];
+    counters[1] = 0;
+    gprtBufferUnmap(lbvh.wideCounters);
+    frontier ^= 1;
+  }
 }
 
-inline void gprtLBVHBuild(GPRTContext context, GPRTLBVH &lbvh) {
-    typedef uint32_t uint;
-
-    // initialize root AABB
-    gprtBufferMap(lbvh.aabbs);
-    float3* aabbPtr = gprtBufferGetHostPointer(lbvh.aabbs);
-    aabbPtr[0].x = aabbPtr[0].y = aabbPtr[0].z = std::numeric_limits<float>::max();
-    aabbPtr[1].x = aabbPtr[1].y = aabbPtr[1].z = -std::numeric_limits<float>::max();
-    gprtBufferUnmap(lbvh.aabbs);
-
-    // Now compute bounding boxes over the primitives
-    if (lbvh.type == GPRT_LBVH_POINTS) {
-        gprtComputeLaunch1D(context, lbvh.computePointBounds, lbvh.handle.numPrims);
-        gprtComputeLaunch1D(context, lbvh.computePointMortonCodes, lbvh.handle.numPrims);
-    } else if (lbvh.type == GPRT_LBVH_EDGES) {
-        gprtComputeLaunch1D(context, lbvh.computeEdgeBounds, lbvh.handle.numPrims);
-        gprtComputeLaunch1D(context, lbvh.computeEdgeMortonCodes, lbvh.handle.numPrims);
-    } else if (lbvh.type == GPRT_LBVH_TRIANGLES) {
-        gprtComputeLaunch1D(context, lbvh.computeTriangleBounds, lbvh.handle.numPrims);
-        gprtComputeLaunch1D(context, lbvh.computeTriangleMortonCodes, lbvh.handle.numPrims);
+/**
+ * @brief Measures the quality of a built tree by walking it on the host. Meant for tuning and benchmarking,
+ * as this downloads the whole tree.
+ */
+inline void
+gprtLBVHGetStats(GPRTLBVH &lbvh, GPRTLBVHStats *stats) {
+  auto area = [](float3 lo, float3 hi) {
+    float3 d = max(hi - lo, float3(0.f, 0.f, 0.f));
+    return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  };
+
+  gprtBufferMap(lbvh.nodes);
+  gprtBufferMap(lbvh.aabbs);
+  int4 *nodes = gprtBufferGetHostPointer(lbvh.nodes);
+  float3 *aabbs = gprtBufferGetHostPointer(lbvh.aabbs);
+
+  *stats = {};
+  stats->buildTime = lbvh.buildTime;
+  uint32_t numLeaves = 0;
+  uint64_t totalLeafDepth = 0;
+  double innerArea = 0.0, leafArea = 0.0, overlapArea = 0.0;
+  float rootArea = area(aabbs[0], aabbs[1]);
+
+  // (node, depth) pairs
+  std::vector<std::pair<int, uint32_t>> stack = {{0, 0}};
+  while (!stack.empty()) {
+    auto [nodeID, depth] = stack.back();
+    stack.pop_back();
+    int4 node = nodes[nodeID];
+    float3 lo = aabbs[nodeID * 2 + 0], hi = aabbs[nodeID * 2 + 1];
+    if (node.w != -1 || lbvh.handle.numPrims == 1) {
+      numLeaves++;
+      totalLeafDepth += depth;
+      stats->maxLeafDepth = std::max(stats->maxLeafDepth, depth);
+      leafArea += area(lo, hi);
+      continue;
     }
-    gprtBufferSortPayload(context, lbvh.mortonCodes, lbvh.ids, lbvh.scratch);
-    gprtComputeLaunch1D(context, lbvh.makeNodes, lbvh.handle.numNodes);
-    gprtComputeLaunch1D(context, lbvh.splitNodes, lbvh.handle.numInner);
-    gprtComputeLaunch1D(context, lbvh.buildHierarchy, lbvh.handle.numPrims);
+    innerArea += area(lo, hi);
+    float3 lLo = aabbs[node.x * 2 + 0], lHi = aabbs[node.x * 2 + 1];
+    float3 rLo = aabbs[node.y * 2 + 0], rHi = aabbs[node.y * 2 + 1];
+    overlapArea += area(max(lLo, rLo), min(lHi, rHi));
+    stack.push_back({node.x, depth + 1});
+    stack.push_back({node.y, depth + 1});
+  }
+
+  gprtBufferUnmap(lbvh.nodes);
+  gprtBufferUnmap(lbvh.aabbs);
+
+  if (rootArea > 0.f) {
+    stats->sahCost = float((LBVH_COST_INNER * innerArea + LBVH_COST_PRIMITIVE * leafArea) / rootArea);
+    stats->overlap = float(overlapArea / rootArea);
+  }
+  stats->averageLeafSize = float(lbvh.handle.numPrims) / float(std::max(numLeaves, 1u));
+  stats->averageLeafDepth = float(totalLeafDepth) / float(std::max(numLeaves, 1u));
 }
 
-inline void gprtLBVHDestroy(GPRTLBVH &lbvh) {
-    gprtBufferDestroy(lbvh.mortonCodes);
-    gprtBufferDestroy(lbvh.ids);
-    gprtBufferDestroy(lbvh.nodes);
-    gprtBufferDestroy(lbvh.aabbs);
-    gprtBufferDestroy(lbvh.scratch);
-
-    gprtComputeDestroy(lbvh.computePointBounds);
-    gprtComputeDestroy(lbvh.computePointMortonCodes);
-    gprtComputeDestroy(lbvh.makeNodes);
-    gprtComputeDestroy(lbvh.splitNodes);
-    gprtComputeDestroy(lbvh.buildHierarchy);
-    gprtModuleDestroy(lbvh.module);
+inline void
+gprtLBVHDestroy(GPRTLBVH &lbvh) {
+  gprtBufferDestroy(lbvh.bounds);
+  gprtBufferDestroy(lbvh.mortonCodes);
+  gprtBufferDestroy(lbvh.ids);
+  gprtBufferDestroy(lbvh.nodes);
+  gprtBufferDestroy(lbvh.aabbs);
+  gprtBufferDestroy(lbvh.costs);
+  gprtBufferDestroy(lbvh.leafCounts);
+  gprtBufferDestroy(lbvh.counters);
+  gprtBufferDestroy(lbvh.maxDepth);
+  gprtBufferDestroy(lbvh.scratch);
+
+  gprtComputeDestroy(lbvh.computeBounds);
+  gprtComputeDestroy(lbvh.computeMortonCodes);
+  gprtComputeDestroy(lbvh.makeNodes);
+  gprtComputeDestroy(lbvh.splitNodes);
+  gprtComputeDestroy(lbvh.buildHierarchy);
+  gprtComputeDestroy(lbvh.resetCounters);
+  gprtComputeDestroy(lbvh.restructureTreelets);
+  gprtComputeDestroy(lbvh.computeDepth);
+  gprtComputeDestroy(lbvh.collapseNodes);
+  if (lbvh.wideNodes) {
+    gprtBufferDestroy(lbvh.wideNodes);
+    gprtBufferDestroy(lbvh.wideFrontiers[0]);
+    gprtBufferDestroy(lbvh.wideFrontiers[1]);
+    gprtBufferDestroy(lbvh.wideCounters);
+  }
+  gprtModuleDestroy(lbvh.module);
 }
 
-#endif
\ No newline at end of file
+#endif
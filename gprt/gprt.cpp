@@ -21,15 +21,22 @@
 // SOFTWARE.
 
 #include <algorithm>
+#include <array>
 #include <assert.h>
 #include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
 #include <fstream>
 #include <gprt_host.h>
+#include <iomanip>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <mutex>
 #include <set>
 #include <sstream>
+#include <thread>
 
 #include <regex>
 
@@ -82,9 +89,21 @@
 // For software fallbacks for various primitive types
 #include "gprt_fallbacks.h"
 
+// For device-side buffer utilities (fills, iota, random initialization, ...)
+#include "gprt_buffer.h"
+
+// For rasterizing primary visibility
+#include "gprt_raster.h"
+
+// For scoring track lengths into mesh tallies
+#include "gprt_tally.h"
+
 /** @brief A collection of features that are requested to support before
  * creating a GPRT context. These features might not be available on all
  * platforms.
+ *
+ * Each context keeps its own copy, taken when it is created, so the gprtRequest* calls only set the defaults for
+ * contexts created afterwards. Logging is the exception, and always follows these defaults.
  */
 static struct RequestedFeatures {
   /** A window (VK_KHR_SURFACE, SWAPCHAIN, etc...)*/
@@ -112,6 +131,7 @@ static struct RequestedFeatures {
   uint32_t missRecordSize = 256;
   uint32_t callableRecordSize = 256;
 
+  // Initial size of the bindless resource heap. The heap grows on demand up to the device limit.
   uint32_t maxDescriptorCount = 256;
 
   // Not all GPUs support the RT pipeline.
@@ -125,6 +145,10 @@ static struct RequestedFeatures {
   bool invocationReordering = false;
   bool linearSweptSpheres = true;
 
+  /** Captures per stage register, spill and stack statistics of every pipeline, see
+   * gprtContextGetPipelineStatistics. Off by default, as drivers may spend extra time compiling. */
+  bool pipelineStatistics = false;
+
   bool debugPrintf = true;
 
   /*! returns whether logging is enabled */
@@ -133,6 +157,12 @@ static struct RequestedFeatures {
   }
 } requestedFeatures;
 
+// Context creation initializes GLFW, which may not race
+static std::mutex contextCreationMutex;
+
+// glfwTerminate tears GLFW down for the whole process, so only the last context using it may call it
+static uint32_t numGlfwContexts = 0;
+
 #if defined(_MSC_VER)
 //&& !defined(__PRETTY_FUNCTION__)
 #define __PRETTY_FUNCTION__ __FUNCTION__
@@ -302,9 +332,16 @@ debugUtilsMessengerCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeveri
 // extern std::vector<uint8_t> scanDeviceCode;
 extern GPRTProgram sortDeviceCode;
 extern GPRTProgram fallbacksDeviceCode;
+extern GPRTProgram bufferDeviceCode;
+extern GPRTProgram rasterDeviceCode;
+extern GPRTProgram tallyDeviceCode;
 
 // forward declarations...
 struct Context;
+struct Buffer;
+struct BufferPool;
+void releasePooledBuffer(Buffer *buffer);
+struct TransientPool;
 struct Geom;
 struct Accel;
 struct Texture;
@@ -314,16 +351,21 @@ struct Callable;
 struct Compute;
 struct Module;
 struct ImageResource;
-struct Buffer;
 struct GeomType;
 struct TriangleGeom;
 struct TriangleGeomType;
+struct MotionTriangleGeom;
+struct MotionTriangleGeomType;
 struct SphereGeom;
 struct SphereGeomType;
 struct LSSGeom;
 struct LSSGeomType;
 struct SolidGeom;
 struct SolidGeomType;
+struct VoxelGeom;
+struct VoxelGeomType;
+struct CurveGeom;
+struct CurveGeomType;
 struct AABBGeom;
 struct AABBGeomType;
 struct NNPointGeom;
@@ -333,31 +375,6 @@ struct NNEdgeGeomType;
 struct NNTriangleGeom;
 struct NNTriangleGeomType;
 
-namespace gprt {
-PFN_vkGetBufferDeviceAddressKHR vkGetBufferDeviceAddress;
-PFN_vkCreateAccelerationStructureKHR vkCreateAccelerationStructure;
-PFN_vkDestroyAccelerationStructureKHR vkDestroyAccelerationStructure;
-PFN_vkGetAccelerationStructureBuildSizesKHR vkGetAccelerationStructureBuildSizes;
-PFN_vkGetAccelerationStructureDeviceAddressKHR vkGetAccelerationStructureDeviceAddress;
-PFN_vkCmdBuildAccelerationStructuresKHR vkCmdBuildAccelerationStructures;
-PFN_vkCmdCopyAccelerationStructureKHR vkCmdCopyAccelerationStructure;
-PFN_vkBuildAccelerationStructuresKHR vkBuildAccelerationStructures;
-PFN_vkCopyAccelerationStructureKHR vkCopyAccelerationStructure;
-PFN_vkCmdTraceRaysKHR vkCmdTraceRays;
-PFN_vkGetRayTracingShaderGroupHandlesKHR vkGetRayTracingShaderGroupHandles;
-PFN_vkCreateRayTracingPipelinesKHR vkCreateRayTracingPipelines;
-PFN_vkCmdWriteAccelerationStructuresPropertiesKHR vkCmdWriteAccelerationStructuresProperties;
-
-PFN_vkCreateDebugUtilsMessengerEXT vkCreateDebugUtilsMessengerEXT;
-PFN_vkDestroyDebugUtilsMessengerEXT vkDestroyDebugUtilsMessengerEXT;
-VkDebugUtilsMessengerEXT debugUtilsMessenger;
-
-// Note, the following were deprecated and shouldn't be used
-// PFN_vkCreateDebugReportCallbackEXT vkCreateDebugReportCallbackEXT;
-// PFN_vkDestroyDebugReportCallbackEXT vkDestroyDebugReportCallbackEXT;
-// VkDebugReportCallbackEXT debugReportCallback;
-}   // namespace gprt
-
 struct Stage {
   // for copying transforms into the instance buffer
   // std::string fillInstanceDataEntryPoint = "gprtFillInstanceData";
@@ -374,10 +391,16 @@ struct Context {
   // For convenience, an opaque handle to the context
   GPRTContext context = (GPRTContext) this;
 
+  // The features this context was created with
+  RequestedFeatures features;
+
   VkApplicationInfo appInfo;
 
   // Vulkan instance, stores all per-application states
   VkInstance instance;
+  VkDebugUtilsMessengerEXT debugUtilsMessenger = VK_NULL_HANDLE;
+  PFN_vkCreateDebugUtilsMessengerEXT vkCreateDebugUtilsMessengerEXT = nullptr;
+  PFN_vkDestroyDebugUtilsMessengerEXT vkDestroyDebugUtilsMessengerEXT = nullptr;
   std::vector<VkLayerProperties> supportedInstanceLayers;
   std::vector<std::string> supportedInstanceLayerNames;
   std::vector<VkExtensionProperties> supportedInstanceExtensions;
@@ -407,6 +430,19 @@ struct Context {
     Texture *depthAttachment = nullptr;
   } imgui;
 
+  // For rasterizing primary visibility, see gprtAccelRasterizeVisibility
+  struct VisibilityData {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkFramebuffer frameBuffer = VK_NULL_HANDLE;
+    Texture *colorAttachment = nullptr;
+    Texture *depthAttachment = nullptr;
+  } visibility;
+
   // Physical device (GPU) that Vulkan will use
   VkPhysicalDevice physicalDevice;
   // Stores physical device properties (for e.g. checking device limits)
@@ -430,6 +466,7 @@ struct Context {
   VkPhysicalDeviceRayQueryFeaturesKHR rtQueryFeatures;
   VkPhysicalDeviceMutableDescriptorTypeFeaturesEXT mutableDescriptorFeatures;
   VkPhysicalDeviceShaderClockFeaturesKHR shaderClockFeatures;
+  VkPhysicalDevicePipelineExecutablePropertiesFeaturesKHR pipelineExecutablePropertiesFeatures;
 
   // Stores all available memory (type) properties for the physical device
   VkPhysicalDeviceMemoryProperties deviceMemoryProperties;
@@ -464,11 +501,60 @@ struct Context {
   /** @brief Logical device, application's view of the physical device (GPU) */
   VkDevice logicalDevice;
 
+  // Extension entry points, loaded from this context's own logical device. Vulkan only allows a device's entry
+  // points to be used with that device, so each context keeps its own.
+  PFN_vkGetBufferDeviceAddressKHR vkGetBufferDeviceAddress = nullptr;
+  PFN_vkCreateAccelerationStructureKHR vkCreateAccelerationStructure = nullptr;
+  PFN_vkDestroyAccelerationStructureKHR vkDestroyAccelerationStructure = nullptr;
+  PFN_vkGetAccelerationStructureBuildSizesKHR vkGetAccelerationStructureBuildSizes = nullptr;
+  PFN_vkGetAccelerationStructureDeviceAddressKHR vkGetAccelerationStructureDeviceAddress = nullptr;
+  PFN_vkCmdBuildAccelerationStructuresKHR vkCmdBuildAccelerationStructures = nullptr;
+  PFN_vkCmdCopyAccelerationStructureKHR vkCmdCopyAccelerationStructure = nullptr;
+  PFN_vkBuildAccelerationStructuresKHR vkBuildAccelerationStructures = nullptr;
+  PFN_vkCopyAccelerationStructureKHR vkCopyAccelerationStructure = nullptr;
+  PFN_vkCmdTraceRaysKHR vkCmdTraceRays = nullptr;
+  PFN_vkGetRayTracingShaderGroupHandlesKHR vkGetRayTracingShaderGroupHandles = nullptr;
+  PFN_vkCreateRayTracingPipelinesKHR vkCreateRayTracingPipelines = nullptr;
+  PFN_vkCmdWriteAccelerationStructuresPropertiesKHR vkCmdWriteAccelerationStructuresProperties = nullptr;
+  PFN_vkGetRayTracingShaderGroupStackSizeKHR vkGetRayTracingShaderGroupStackSize = nullptr;
+  PFN_vkGetRayTracingPipelineStackSizeKHR vkGetRayTracingPipelineStackSize = nullptr;
+  PFN_vkGetPipelineExecutablePropertiesKHR vkGetPipelineExecutableProperties = nullptr;
+  PFN_vkGetPipelineExecutableStatisticsKHR vkGetPipelineExecutableStatistics = nullptr;
+
   // Handle to the device graphics queue that command buffers are submitted to
   VkQueue graphicsQueue;
   VkQueue computeQueue;
   VkQueue transferQueue;
 
+  // Always on, see gprtContextGetCounters
+  GPRTCounters counters = {};
+
+  // Every submit and every wait for the device goes through these, so that they are counted
+  VkResult queueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo *submits, VkFence fence) {
+    counters.queueSubmits++;
+    lastSubmission++;
+    oldestPendingSubmission.emplace(queue, lastSubmission);
+    return vkQueueSubmit(queue, submitCount, submits, fence);
+  }
+
+  VkResult queueWaitIdle(VkQueue queue) {
+    counters.queueWaits++;
+    oldestPendingSubmission.erase(queue);
+    return vkQueueWaitIdle(queue);
+  }
+
+  // Submissions are numbered in order. Per queue, the oldest submission not yet waited on, if any.
+  uint64_t lastSubmission = 0;
+  std::map<VkQueue, uint64_t> oldestPendingSubmission;
+
+  // The latest submission that, along with all before it, the device is known to have finished
+  uint64_t getCompletedSubmission() {
+    uint64_t completed = lastSubmission;
+    for (auto &pending : oldestPendingSubmission)
+      completed = std::min(completed, pending.second - 1);
+    return completed;
+  }
+
   // Depth buffer format (selected during Vulkan initialization)
   VkFormat depthFormat;
   // Command buffer pool
@@ -479,6 +565,18 @@ struct Context {
   VkQueryPool compactedSizeQueryPool;
   bool queryRequested = false;
 
+  // Tuned compute workgroup sizes, see gprtContextSetTuningCache. Entries are keyed by "<device> <kernel>", and
+  // entries for other devices are kept so that they survive rewriting the file.
+  std::string tuningCachePath;
+  std::map<std::string, uint32_t> tuningCache;
+
+  std::string getTuningDeviceKey() {
+    std::stringstream key;
+    key << std::hex << deviceProperties.vendorID << ":" << deviceProperties.deviceID << ":"
+        << deviceProperties.driverVersion;
+    return key.str();
+  }
+
   /** @brief Pipeline stages used to wait at for graphics queue submissions */
   VkPipelineStageFlags submitPipelineStages =
       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;   // not sure I need this one
@@ -510,6 +608,10 @@ struct Context {
   std::vector<Callable *> callables;
   std::vector<GeomType *> geomTypes;
   std::vector<Buffer *> buffers;
+  // Slots in the above list released by destroyed buffers, reused before the list grows
+  std::vector<uint32_t> freeBufferAddresses;
+  std::vector<BufferPool *> bufferPools;
+  std::vector<TransientPool *> transientPools;
   std::vector<ImageResource *> imageResources;
   std::vector<Geom *> geoms;
   std::vector<Accel *> accels;
@@ -520,19 +622,50 @@ struct Context {
   VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
   VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
 
+  // The layout is sized once for the largest heap the device supports, so pipelines stay valid as the heap grows.
+  // Growing only reallocates the pool and set (see growDescriptorHeap).
+  uint32_t descriptorHeapLimit = 0;
+  // Caps the layout on drivers that report very large limits, since some reserve memory for the whole layout
+  static constexpr uint32_t maxDescriptorHeapSize = 1u << 20;
+  // Slots in imageResources released by destroyed image resources, reused before the list grows
+  std::vector<uint32_t> freeImageResourceAddresses;
+  // Image resource descriptors not yet written into the heap, by address. Flushed in one batch before launches.
+  std::map<uint32_t, std::pair<VkDescriptorType, VkDescriptorImageInfo>> pendingDescriptorWrites;
+
+  void allocateDescriptorHeap(uint32_t descriptorCount);
+  void growDescriptorHeap(uint32_t minDescriptorCount);
+  void flushDescriptorWrites();
+
   VkDescriptorPool imguiPool = VK_NULL_HANDLE;
 
   std::vector<VkRayTracingShaderGroupCreateInfoKHR> shaderGroups{};
+  // Entry points of the ray tracing pipeline's stages, which shaderGroups index into
+  std::vector<std::string> shaderStageNames;
+  // Owns the report returned by gprtContextGetPipelineStatistics
+  std::string pipelineStatisticsReport;
   Buffer *raygenTable = nullptr;
   Buffer *missTable = nullptr;
   Buffer *callableTable = nullptr;
   Buffer *hitgroupTable = nullptr;
 
+  // Reused across calls to gprtBufferReadCompressed, and grown as needed
+  Buffer *compressedStream = nullptr;
+  Buffer *compressedScratch = nullptr;
+  Buffer *compressedReadback = nullptr;
+
+  // Created along with the first motion triangle geometry type. The slot holds the address of rayTimes, one float
+  // per launch index, which gprtRayGenLaunch3D grows to fit.
+  Buffer *rayTimeSlot = nullptr;
+  Buffer *rayTimes = nullptr;
+
   std::map<std::string, Compute *> internalComputePrograms;
 
   Module *radixSortModule = nullptr;
   // Module *scanModule = nullptr;
   Module *fallbacksModule = nullptr;
+  Module *bufferModule = nullptr;
+  Module *rasterModule = nullptr;
+  Module *tallyModule = nullptr;
 
   VkPipelineShaderStageCreateInfo LSSIntersectionShaderStage;
 
@@ -567,7 +700,7 @@ struct Context {
   void enumerateInstanceValidationLayers();
   void enumerateInstanceExtensions();
 
-  Context(int32_t *requestedDeviceIDs, int numRequestedDevices);
+  Context(const RequestedFeatures &features, int32_t *requestedDeviceIDs, int numRequestedDevices);
 
   void destroy();
 
@@ -595,6 +728,12 @@ struct Context {
   void setRasterAttachments(Texture *colorTexture, Texture *depthTexture);
 
   void rasterizeGui();
+
+  // For primary visibility
+  void buildVisibilityPipeline();
+  void setVisibilitySize(uint32_t width, uint32_t height);
+  void rasterizeVisibility(Accel *accel, Buffer *visibilityBuffer, uint32_t width, uint32_t height,
+                           float4x4 viewProjection, float3 cameraPosition);
 };
 
 struct Module {
@@ -726,11 +865,28 @@ struct Buffer {
   VkDeviceSize alignment = 16;
   void *mapped = nullptr;
 
+  // Buffers sub-allocated from a BufferPool alias a range of one of the pool's blocks, sharing the block's
+  // VkBuffer, allocation and staging buffer. For all other buffers, poolOffset is 0 and pool is nullptr.
+  BufferPool *pool = nullptr;
+  uint32_t poolBlock = 0;
+  VmaVirtualAllocation poolAllocation = VK_NULL_HANDLE;
+  VkDeviceSize poolOffset = 0;
+  // The block's persistently mapped host (or staging) memory, so that pooled buffers never map individually.
+  void *poolMapped = nullptr;
+
+  // Buffers handed out by a TransientPool go back to it when destroyed, rather than being freed
+  TransientPool *transientPool = nullptr;
+
   VkResult map(VkDeviceSize mapSize = VK_WHOLE_SIZE, VkDeviceSize offset = 0) {
     if (mapped)
       return VK_SUCCESS;
 
     if (hostVisible) {
+      if (poolMapped) {
+        vmaInvalidateAllocation(context->allocator, allocation, poolOffset, size);
+        mapped = (uint8_t *) poolMapped + poolOffset;
+        return VK_SUCCESS;
+      }
       vmaInvalidateAllocation(context->allocator, allocation, 0, VK_WHOLE_SIZE);
       return vmaMapMemory(context->allocator, allocation, &mapped);
     } else {
@@ -743,10 +899,12 @@ struct Buffer {
 
       // To do, consider allowing users to specify offsets here...
       VkBufferCopy region;
-      region.srcOffset = offset;
-      region.dstOffset = 0;
+      region.srcOffset = poolOffset + offset;
+      region.dstOffset = poolOffset;
       region.size = (mapSize == VK_WHOLE_SIZE) ? size : mapSize;
       vkCmdCopyBuffer(context->graphicsCommandBuffer, buffer, stagingBuffer.buffer, 1, &region);
+      context->counters.stagingCopies++;
+      context->counters.bytesDownloaded += region.size;
 
       err = vkEndCommandBuffer(context->graphicsCommandBuffer);
       if (err)
@@ -763,14 +921,19 @@ struct Buffer {
       submitInfo.signalSemaphoreCount = 0;
       submitInfo.pSignalSemaphores = nullptr;
 
-      err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+      err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
       if (err)
         LOG_ERROR("failed to submit to queue for buffer map! : \n" + errorString(err));
 
-      err = vkQueueWaitIdle(context->graphicsQueue);
+      err = context->queueWaitIdle(context->graphicsQueue);
       if (err)
         LOG_ERROR("failed to wait for queue idle for buffer map! : \n" + errorString(err));
 
+      if (poolMapped) {
+        vmaInvalidateAllocation(context->allocator, stagingBuffer.allocation, poolOffset, size);
+        mapped = (uint8_t *) poolMapped + poolOffset;
+        return VK_SUCCESS;
+      }
       vmaInvalidateAllocation(context->allocator, stagingBuffer.allocation, 0, VK_WHOLE_SIZE);
       return vmaMapMemory(context->allocator, stagingBuffer.allocation, &mapped);
     }
@@ -781,7 +944,10 @@ struct Buffer {
       return;
 
     if (hostVisible) {
-      if (mapped) {
+      if (poolMapped) {
+        vmaFlushAllocation(context->allocator, allocation, poolOffset, size);
+        mapped = nullptr;
+      } else {
         vmaFlushAllocation(context->allocator, allocation, 0, VK_WHOLE_SIZE);
         vmaUnmapMemory(context->allocator, allocation);
         mapped = nullptr;
@@ -796,10 +962,12 @@ struct Buffer {
 
       // To do, consider allowing users to specify offsets here...
       VkBufferCopy region;
-      region.srcOffset = 0;
-      region.dstOffset = offset;
+      region.srcOffset = poolOffset;
+      region.dstOffset = poolOffset + offset;
       region.size = (mapSize == VK_WHOLE_SIZE) ? size : mapSize;
       vkCmdCopyBuffer(context->graphicsCommandBuffer, stagingBuffer.buffer, buffer, 1, &region);
+      context->counters.stagingCopies++;
+      context->counters.bytesUploaded += region.size;
 
       err = vkEndCommandBuffer(context->graphicsCommandBuffer);
       if (err)
@@ -816,50 +984,77 @@ struct Buffer {
       submitInfo.signalSemaphoreCount = 0;
       submitInfo.pSignalSemaphores = nullptr;
 
-      err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+      err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
       if (err)
         LOG_ERROR("failed to submit to queue for buffer map! : \n" + errorString(err));
 
-      err = vkQueueWaitIdle(context->graphicsQueue);
+      err = context->queueWaitIdle(context->graphicsQueue);
       if (err)
         LOG_ERROR("failed to wait for queue idle for buffer map! : \n" + errorString(err));
 
-      vmaFlushAllocation(context->allocator, stagingBuffer.allocation, 0, VK_WHOLE_SIZE);
-      vmaUnmapMemory(context->allocator, stagingBuffer.allocation);
+      if (poolMapped) {
+        vmaFlushAllocation(context->allocator, stagingBuffer.allocation, poolOffset, size);
+      } else {
+        vmaFlushAllocation(context->allocator, stagingBuffer.allocation, 0, VK_WHOLE_SIZE);
+        vmaUnmapMemory(context->allocator, stagingBuffer.allocation);
+      }
       mapped = nullptr;
     }
   }
 
+  // Unmaps without copying the staging memory back to a device buffer, for when its contents no longer matter
+  void discardMapping() {
+    if (!mapped || hostVisible) {
+      unmap();
+      return;
+    }
+    if (!poolMapped)
+      vmaUnmapMemory(context->allocator, stagingBuffer.allocation);
+    mapped = nullptr;
+  }
+
   // flushes from host to device
   void flush() {
     if (hostVisible) {
-      vmaFlushAllocation(context->allocator, allocation, 0, VK_WHOLE_SIZE);
+      vmaFlushAllocation(context->allocator, allocation, poolOffset, size);
     } else {
-      vmaFlushAllocation(context->allocator, stagingBuffer.allocation, 0, VK_WHOLE_SIZE);
+      vmaFlushAllocation(context->allocator, stagingBuffer.allocation, poolOffset, size);
     }
   }
 
   // invalidates from device back to host
   void invalidate() {
     // device never directly writes to staging buffer
-    vmaInvalidateAllocation(context->allocator, allocation, 0, VK_WHOLE_SIZE);
+    vmaInvalidateAllocation(context->allocator, allocation, poolOffset, size);
   }
 
   VkDeviceAddress getDeviceAddress() {
     VkBufferDeviceAddressInfoKHR info = {};
     info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
     info.buffer = buffer;
-    VkDeviceAddress addr = gprt::vkGetBufferDeviceAddress(context->logicalDevice, &info);
-    return addr;
+    VkDeviceAddress addr = context->vkGetBufferDeviceAddress(context->logicalDevice, &info);
+    return addr + poolOffset;
   }
 
   /*! Calls vkDestroy on the buffer, and frees underlying memory */
   void destroy() {
     // Free sampler slot for use by subsequently made buffers
-    context->buffers[virtualAddress] = nullptr;
+    if (virtualAddress != -1) {
+      context->buffers[virtualAddress] = nullptr;
+      context->freeBufferAddresses.push_back(virtualAddress);
+      virtualAddress = -1;
+    }
 
     unmap();
 
+    // Pooled buffers return their range to the pool, which owns the underlying Vulkan resources
+    if (pool) {
+      releasePooledBuffer(this);
+      buffer = VK_NULL_HANDLE;
+      stagingBuffer.buffer = VK_NULL_HANDLE;
+      return;
+    }
+
     if (buffer) {
       vmaDestroyBuffer(context->allocator, buffer, allocation);
       // vkDestroyBuffer(device, buffer, nullptr);
@@ -873,12 +1068,28 @@ struct Buffer {
     }
   }
 
+  /* Repeats the given 32-bit word over the given byte range on the device.
+     Offset and size must be multiples of 4 (or size may be VK_WHOLE_SIZE) */
+  void fill(VkDeviceSize offset, VkDeviceSize bytes, uint32_t data) {
+    if (bytes == VK_WHOLE_SIZE)
+      bytes = (size - offset) & ~VkDeviceSize(3);
+    VkCommandBuffer commandBuffer = context->beginSingleTimeCommands(context->graphicsCommandPool);
+    vkCmdFillBuffer(commandBuffer, buffer, poolOffset + offset, bytes, data);
+    context->endSingleTimeCommands(commandBuffer, context->graphicsCommandPool, context->graphicsQueue);
+  }
+
   /* Sets all bytes to 0 */
   void clear() {
     if (hostVisible) {
       if (!mapped)
         map();
       memset(mapped, 0, size);
+    } else if ((size % 4) == 0) {
+      // Clear on the device, rather than round tripping through the staging buffer
+      fill(0, size, 0);
+      // Keep any mapped staging copy consistent, otherwise a later unmap would undo the clear
+      if (mapped)
+        memset(mapped, 0, size);
     } else {
       map();
       memset(mapped, 0, size);
@@ -891,6 +1102,15 @@ struct Buffer {
     if (size == bytes)
       return;
 
+    if (pool)
+      LOG_ERROR("buffers allocated from a buffer pool cannot be resized!");
+    if (transientPool)
+      LOG_ERROR("transient buffers cannot be resized!");
+
+    context->counters.bufferResizes++;
+    if (preserveContents)
+      context->counters.resizeBytesCopied += std::min(size, VkDeviceSize(bytes));
+
     if (hostVisible) {
       // if we are host visible, we need to create a new buffer before releasing the
       // previous one to preserve values...
@@ -939,11 +1159,11 @@ struct Buffer {
         submitInfo.signalSemaphoreCount = 0;
         submitInfo.pSignalSemaphores = nullptr;
 
-        err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+        err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
         if (err)
           LOG_ERROR("failed to submit to queue for buffer resize! : \n" + errorString(err));
 
-        err = vkQueueWaitIdle(context->graphicsQueue);
+        err = context->queueWaitIdle(context->graphicsQueue);
         if (err)
           LOG_ERROR("failed to wait for queue idle for buffer resize! : \n" + errorString(err));
 
@@ -1016,11 +1236,11 @@ struct Buffer {
         submitInfo.signalSemaphoreCount = 0;
         submitInfo.pSignalSemaphores = nullptr;
 
-        err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+        err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
         if (err)
           LOG_ERROR("failed to submit to queue for buffer resize! : \n" + errorString(err));
 
-        err = vkQueueWaitIdle(context->graphicsQueue);
+        err = context->queueWaitIdle(context->graphicsQueue);
         if (err)
           LOG_ERROR("failed to wait for queue idle for buffer resize! : \n" + errorString(err));
       }
@@ -1070,11 +1290,11 @@ struct Buffer {
         submitInfo.signalSemaphoreCount = 0;
         submitInfo.pSignalSemaphores = nullptr;
 
-        err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+        err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
         if (err)
           LOG_ERROR("failed to submit to queue for buffer resize! : \n" + errorString(err));
 
-        err = vkQueueWaitIdle(context->graphicsQueue);
+        err = context->queueWaitIdle(context->graphicsQueue);
         if (err)
           LOG_ERROR("failed to wait for queue idle for buffer resize! : \n" + errorString(err));
       }
@@ -1114,26 +1334,52 @@ struct Buffer {
   /* Default Constructor */
   Buffer() {};
 
+  void registerVirtualAddress() {
+    // Reuse the virtual address of a previously destroyed buffer if there is one
+    if (!context->freeBufferAddresses.empty()) {
+      virtualAddress = context->freeBufferAddresses.back();
+      context->freeBufferAddresses.pop_back();
+      context->buffers[virtualAddress] = this;
+    }
+    // Otherwise, allocate a new one
+    else {
+      context->buffers.push_back(this);
+      virtualAddress = (uint32_t) context->buffers.size() - 1;
+    }
+  }
+
+  /* Sub-allocating constructor. The new buffer aliases \p size bytes at \p offset within one of the
+     blocks of the given pool. */
+  Buffer(Context *context, BufferPool *pool, Buffer *block, void *blockMapped, uint32_t poolBlock,
+         VmaVirtualAllocation poolAllocation, VkDeviceSize offset, VkDeviceSize size, VkDeviceSize alignment) {
+    this->context = context;
+    registerVirtualAddress();
+
+    this->pool = pool;
+    this->poolBlock = poolBlock;
+    this->poolAllocation = poolAllocation;
+    this->poolOffset = offset;
+    this->poolMapped = blockMapped;
+    this->size = size;
+    this->alignment = alignment;
+
+    memoryProperties = block->memoryProperties;
+    usageFlags = block->usageFlags;
+    hostVisible = block->hostVisible;
+    buffer = block->buffer;
+    allocation = block->allocation;
+    stagingBuffer = block->stagingBuffer;
+
+    if ((usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) != 0)
+      deviceAddress = block->deviceAddress + poolOffset;
+  }
+
   ~Buffer() {};
 
   Buffer(Context* context, VkBufferUsageFlags _usageFlags, VkMemoryPropertyFlags _memoryPropertyFlags, VkDeviceSize _size, VkDeviceSize _alignment,
          void *data = nullptr) {
     this->context = context;
-
-    // Hunt for an existing free virtual address for this buffer
-    for (uint32_t i = 0; i < context->buffers.size(); ++i) {
-      if (context->buffers[i] == nullptr) {
-        context->buffers[i] = this;
-        virtualAddress = i;
-        break;
-      }
-    }
-    // If we cant find a free spot in the current buffer list, allocate a new
-    // one
-    if (virtualAddress == -1) {
-      context->buffers.push_back(this);
-      virtualAddress = (uint32_t) context->buffers.size() - 1;
-    }
+    registerVirtualAddress();
 
     // For performance reasons, round the size up for vectorized/multiword reads
     uint32_t multiwordSize = 16;
@@ -1211,6 +1457,312 @@ struct Buffer {
   }
 };
 
+/*! A buffer pool carves many small buffers out of a few large blocks of memory. Each block is an ordinary
+  Buffer which is persistently mapped once, and whose range is divided up using a VMA virtual block.
+  Buffers allocated from the pool alias a range within one of these blocks, so creating and destroying them
+  requires no Vulkan calls, and their device addresses remain valid for the lifetime of the buffer. */
+struct BufferPool {
+  Context *context;
+  VkBufferUsageFlags usageFlags;
+  VkMemoryPropertyFlags memoryPropertyFlags;
+  VkDeviceSize blockSize;
+  VkDeviceSize minAlignment;
+
+  struct Block {
+    Buffer *buffer = nullptr;
+    void *mapped = nullptr;
+    VmaVirtualBlock virtualBlock = VK_NULL_HANDLE;
+    uint32_t numAllocations = 0;
+  };
+  std::vector<Block> blocks;
+
+  uint64_t numAllocations = 0;
+  uint64_t allocatedBytes = 0;
+
+  BufferPool(Context *context, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags,
+             VkDeviceSize blockSize) {
+    this->context = context;
+    this->usageFlags = usageFlags;
+    this->memoryPropertyFlags = memoryPropertyFlags;
+    this->blockSize = blockSize;
+    // Sub-allocations must be usable as storage buffer bindings (eg, by the sort) as well as by address
+    this->minAlignment = std::max(VkDeviceSize(16), context->deviceProperties.limits.minStorageBufferOffsetAlignment);
+    context->bufferPools.push_back(this);
+  }
+
+  ~BufferPool() {}
+
+  uint32_t createBlock(VkDeviceSize bytes) {
+    Block block;
+    block.buffer = new Buffer(context, usageFlags, memoryPropertyFlags, bytes, minAlignment);
+
+    // Map the whole block once. Pooled buffers then simply offset into this pointer, since each VMA
+    // allocation can only be mapped a limited number of times simultaneously.
+    VmaAllocation mappedAllocation =
+        block.buffer->hostVisible ? block.buffer->allocation : block.buffer->stagingBuffer.allocation;
+    VK_CHECK_RESULT(vmaMapMemory(context->allocator, mappedAllocation, &block.mapped));
+
+    VmaVirtualBlockCreateInfo blockCreateInfo = {};
+    blockCreateInfo.size = bytes;
+    VK_CHECK_RESULT(vmaCreateVirtualBlock(&blockCreateInfo, &block.virtualBlock));
+
+    // Reuse a slot left behind by a previously freed dedicated block
+    for (uint32_t i = 0; i < blocks.size(); ++i) {
+      if (blocks[i].buffer == nullptr) {
+        blocks[i] = block;
+        return i;
+      }
+    }
+    blocks.push_back(block);
+    return (uint32_t) blocks.size() - 1;
+  }
+
+  void destroyBlock(uint32_t index) {
+    Block &block = blocks[index];
+    VmaAllocation mappedAllocation =
+        block.buffer->hostVisible ? block.buffer->allocation : block.buffer->stagingBuffer.allocation;
+    vmaUnmapMemory(context->allocator, mappedAllocation);
+    vmaClearVirtualBlock(block.virtualBlock);
+    vmaDestroyVirtualBlock(block.virtualBlock);
+    block.buffer->destroy();
+    delete block.buffer;
+    block = Block();
+  }
+
+  Buffer *allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    if (size == 0)
+      LOG_ERROR("buffer pool allocations must be non-empty!");
+    alignment = std::max(alignment, minAlignment);
+    if ((alignment & (alignment - 1)) != 0)
+      LOG_ERROR("buffer pool alignment must be a power of two!");
+
+    VmaVirtualAllocationCreateInfo allocCreateInfo = {};
+    allocCreateInfo.size = size;
+    allocCreateInfo.alignment = alignment;
+
+    VmaVirtualAllocation virtualAllocation;
+    VkDeviceSize offset;
+    uint32_t blockIndex = (uint32_t) -1;
+
+    // First fit over the existing blocks
+    if (size <= blockSize) {
+      for (uint32_t i = 0; i < blocks.size(); ++i) {
+        if (blocks[i].buffer == nullptr)
+          continue;
+        if (vmaVirtualAllocate(blocks[i].virtualBlock, &allocCreateInfo, &virtualAllocation, &offset) ==
+            VK_SUCCESS) {
+          blockIndex = i;
+          break;
+        }
+      }
+    }
+
+    // Otherwise, grow the pool. Allocations larger than a block get a dedicated block of their own.
+    if (blockIndex == (uint32_t) -1) {
+      blockIndex = createBlock(std::max(size, blockSize));
+      VK_CHECK_RESULT(
+          vmaVirtualAllocate(blocks[blockIndex].virtualBlock, &allocCreateInfo, &virtualAllocation, &offset));
+    }
+
+    Block &block = blocks[blockIndex];
+    block.numAllocations++;
+    numAllocations++;
+    allocatedBytes += size;
+    return new Buffer(context, this, block.buffer, block.mapped, blockIndex, virtualAllocation, offset, size,
+                      alignment);
+  }
+
+  void release(Buffer *buffer) {
+    Block &block = blocks[buffer->poolBlock];
+    vmaVirtualFree(block.virtualBlock, buffer->poolAllocation);
+    block.numAllocations--;
+    numAllocations--;
+    allocatedBytes -= buffer->size;
+
+    // Return memory from dedicated, oversized blocks right away. Regular blocks are kept around for reuse.
+    if (block.numAllocations == 0 && block.buffer->size > blockSize)
+      destroyBlock(buffer->poolBlock);
+  }
+
+  void destroy() {
+    if (numAllocations > 0) {
+      LOG_WARNING("buffer pool destroyed with " + std::to_string(numAllocations) +
+                  " buffers still allocated! These buffers are now invalid.");
+      for (uint32_t i = 0; i < context->buffers.size(); ++i) {
+        Buffer *buffer = context->buffers[i];
+        if (buffer != nullptr && buffer->pool == this) {
+          buffer->destroy();
+          delete buffer;
+        }
+      }
+    }
+    for (uint32_t i = 0; i < blocks.size(); ++i) {
+      if (blocks[i].buffer != nullptr)
+        destroyBlock(i);
+    }
+    blocks.clear();
+
+    auto it = std::find(context->bufferPools.begin(), context->bufferPools.end(), this);
+    if (it != context->bufferPools.end())
+      context->bufferPools.erase(it);
+  }
+};
+
+void
+releasePooledBuffer(Buffer *buffer) {
+  buffer->pool->release(buffer);
+  buffer->pool = nullptr;
+}
+
+/* Recycles whole buffers for per-frame temporaries. Buffers are bucketed by capacity, rounded up to a power of two,
+   so that a request is served by any released buffer of its bucket. Released buffers only become reusable once the
+   device has finished every submission made before their release, and are freed after sitting unused for too many
+   frames. */
+struct TransientPool {
+  Context *context;
+  VkBufferUsageFlags usageFlags;
+  VkMemoryPropertyFlags memoryPropertyFlags;
+  uint32_t maxIdleFrames;
+  uint64_t frame = 0;
+
+  static constexpr VkDeviceSize minCapacity = 256;
+
+  struct Entry {
+    Buffer *buffer;
+    VkDeviceSize capacity;
+    uint64_t stamp;   // the last submission before release while pending, the last frame used once free
+  };
+  std::map<Buffer *, VkDeviceSize> live;
+  std::deque<Entry> pending;
+  std::map<VkDeviceSize, std::vector<Entry>> freeLists;
+
+  GPRTTransientPoolStats stats = {};
+
+  TransientPool(Context *context, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags,
+                uint32_t maxIdleFrames) {
+    this->context = context;
+    this->usageFlags = usageFlags;
+    this->memoryPropertyFlags = memoryPropertyFlags;
+    this->maxIdleFrames = maxIdleFrames;
+    context->transientPools.push_back(this);
+  }
+
+  ~TransientPool() {}
+
+  static VkDeviceSize getCapacity(VkDeviceSize bytes) {
+    VkDeviceSize capacity = minCapacity;
+    while (capacity < bytes)
+      capacity *= 2;
+    return capacity;
+  }
+
+  // Moves released buffers the device is done with to the free lists
+  void collect() {
+    uint64_t completed = context->getCompletedSubmission();
+    while (!pending.empty() && pending.front().stamp <= completed) {
+      Entry entry = pending.front();
+      pending.pop_front();
+      entry.stamp = frame;
+      freeLists[entry.capacity].push_back(entry);
+    }
+  }
+
+  void freeBuffer(Buffer *buffer, VkDeviceSize capacity) {
+    buffer->transientPool = nullptr;
+    buffer->destroy();
+    delete buffer;
+    stats.numFrees++;
+    stats.reservedBytes -= capacity;
+  }
+
+  Buffer *acquire(VkDeviceSize bytes) {
+    if (bytes == 0)
+      LOG_ERROR("transient buffers must be non-empty!");
+    collect();
+
+    VkDeviceSize capacity = getCapacity(bytes);
+    Buffer *buffer = nullptr;
+    auto &bucket = freeLists[capacity];
+    stats.numAcquires++;
+    if (!bucket.empty()) {
+      // Most recently used first, as it's the most likely to still be resident in caches
+      buffer = bucket.back().buffer;
+      bucket.pop_back();
+      stats.numReuses++;
+    } else {
+      buffer = new Buffer(context, usageFlags, memoryPropertyFlags, capacity, 16);
+      buffer->transientPool = this;
+      stats.numAllocations++;
+      stats.reservedBytes += capacity;
+    }
+
+    // The buffer reports the requested size, its capacity beyond that goes unused
+    buffer->size = bytes;
+    live[buffer] = capacity;
+    return buffer;
+  }
+
+  void release(Buffer *buffer) {
+    auto it = live.find(buffer);
+    if (it == live.end())
+      LOG_ERROR("transient buffer released twice!");
+    // The next user gets no guarantees about the contents, so skip the upload a mapped device buffer would do
+    buffer->discardMapping();
+    pending.push_back({buffer, it->second, context->lastSubmission});
+    live.erase(it);
+  }
+
+  void nextFrame() {
+    frame++;
+    collect();
+    for (auto &bucket : freeLists) {
+      auto &entries = bucket.second;
+      auto idle = std::remove_if(entries.begin(), entries.end(), [&](const Entry &entry) {
+        if (frame - entry.stamp <= maxIdleFrames)
+          return false;
+        freeBuffer(entry.buffer, entry.capacity);
+        return true;
+      });
+      entries.erase(idle, entries.end());
+    }
+  }
+
+  GPRTTransientPoolStats getStats() {
+    collect();
+    GPRTTransientPoolStats result = stats;
+    result.numLive = (uint32_t) live.size();
+    result.numPending = (uint32_t) pending.size();
+    result.numFree = 0;
+    for (auto &bucket : freeLists)
+      result.numFree += (uint32_t) bucket.second.size();
+    return result;
+  }
+
+  void destroy() {
+    if (!live.empty()) {
+      LOG_WARNING("transient pool destroyed with " + std::to_string(live.size()) +
+                  " buffers still acquired! These buffers are now invalid.");
+    }
+    // Destroying frees every buffer the pool holds, so the device must be done with all of them
+    if (!pending.empty())
+      context->queueWaitIdle(context->graphicsQueue);
+    for (auto &entry : live)
+      freeBuffer(entry.first, entry.second);
+    for (auto &entry : pending)
+      freeBuffer(entry.buffer, entry.capacity);
+    for (auto &bucket : freeLists)
+      for (auto &entry : bucket.second)
+        freeBuffer(entry.buffer, entry.capacity);
+    live.clear();
+    pending.clear();
+    freeLists.clear();
+
+    auto it = std::find(context->transientPools.begin(), context->transientPools.end(), this);
+    if (it != context->transientPools.end())
+      context->transientPools.erase(it);
+  }
+};
+
 inline size_t
 gprtFormatGetSize(GPRTFormat format) {
   switch (format) {
@@ -1228,6 +1780,8 @@ gprtFormatGetSize(GPRTFormat format) {
     return 4;
   case GPRT_FORMAT_R32G32B32A32_SFLOAT:
     return 16;
+  case GPRT_FORMAT_R32G32B32A32_UINT:
+    return 16;
   default:
     throw std::runtime_error("Error, unhandled image format");
     return -1;
@@ -1256,27 +1810,43 @@ struct ImageResource {
 
   ~ImageResource() {};
 
+  // The descriptor last written for this resource, kept so it can be rewritten when the heap grows
+  VkDescriptorType descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  VkDescriptorImageInfo descriptorInfo = {};
+  bool hasDescriptor = false;
+
   ImageResource(Context *context) {
     this->context = context;
 
-    // Hunt for an existing free address for this image resource
-    for (uint32_t i = 0; i < context->imageResources.size(); ++i) {
-      if (context->imageResources[i] == nullptr) {
-        context->imageResources[i] = this;
-        address = i;
-        break;
-      }
+    // Reuse the address of a destroyed image resource if there is one
+    if (!context->freeImageResourceAddresses.empty()) {
+      address = context->freeImageResourceAddresses.back();
+      context->freeImageResourceAddresses.pop_back();
+      context->imageResources[address] = this;
     }
-    // If we cant find a free spot in the current list, allocate a new one
-    if (address == -1) {
+    // Otherwise, allocate a new one
+    else {
       context->imageResources.push_back(this);
       address = (uint32_t) context->imageResources.size() - 1;
     }
+
+    if (address >= context->descriptorPoolSize.descriptorCount)
+      context->growDescriptorHeap(address + 1);
   };
 
+  /*! Queues the descriptor for this resource to be written into the heap before the next launch */
+  void writeDescriptor(VkDescriptorType type, VkDescriptorImageInfo info) {
+    descriptorType = type;
+    descriptorInfo = info;
+    hasDescriptor = true;
+    context->pendingDescriptorWrites[address] = {type, info};
+  }
+
   virtual void destroy() {
     // Free slot for use by subsequently made image resource
     context->imageResources[address] = nullptr;
+    context->pendingDescriptorWrites.erase(address);
+    context->freeImageResourceAddresses.push_back(address);
   }
 
   virtual ImageResourceType getType() { return GPRT_IMAGE_RESOURCE_TYPE_UNKNOWN; }
@@ -1558,6 +2128,8 @@ struct Texture : public ImageResource {
       copyRegion.imageSubresource.layerCount = 1;
       copyRegion.imageSubresource.mipLevel = 0;
       vkCmdCopyBufferToImage(context->graphicsCommandBuffer, stagingBuffer.buffer, image, layout, 1, &copyRegion);
+      context->counters.stagingCopies++;
+      context->counters.bytesUploaded += size;
 
       // transition device to an optimal device format
       setImageLayout(context->graphicsCommandBuffer, image, layout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
@@ -1579,11 +2151,11 @@ struct Texture : public ImageResource {
       submitInfo.signalSemaphoreCount = 0;
       submitInfo.pSignalSemaphores = nullptr;   //&writeImageSemaphoreHandleList[currentImageIndex]};
 
-      err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+      err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
       if (err)
         LOG_ERROR("failed to submit to queue for texture map! : \n" + errorString(err));
 
-      err = vkQueueWaitIdle(context->graphicsQueue);
+      err = context->queueWaitIdle(context->graphicsQueue);
       if (err)
         LOG_ERROR("failed to wait for queue idle for texture map! : \n" + errorString(err));
 
@@ -1596,13 +2168,24 @@ struct Texture : public ImageResource {
     }
   }
 
+  /* Clears all texels to 0 (or a depth of 1 for depth textures) */
   void clear() {
+    VkClearColorValue color;
+    memset(&color, 0, sizeof(color));
+    VkClearDepthStencilValue depthStencil;
+    depthStencil.depth = 1.f;
+    depthStencil.stencil = 0;
+    fill(color, depthStencil);
+  }
+
+  /* Clears all texels of all mip levels to the given value on the device */
+  void fill(VkClearColorValue color, VkClearDepthStencilValue depthStencil) {
     VkResult err;
     VkCommandBufferBeginInfo cmdBufInfo{};
     cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     err = vkBeginCommandBuffer(context->graphicsCommandBuffer, &cmdBufInfo);
     if (err)
-      LOG_ERROR("failed to begin command buffer for texture mipmap generation! : \n" + errorString(err));
+      LOG_ERROR("failed to begin command buffer for texture clear! : \n" + errorString(err));
 
     // Move to a destination optimal format
     setImageLayout(context->graphicsCommandBuffer, image, layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
@@ -1610,19 +2193,12 @@ struct Texture : public ImageResource {
 
     // clear the image
     if (aspectFlagBits == VK_IMAGE_ASPECT_DEPTH_BIT) {
-      VkClearDepthStencilValue val;
-      val.depth = 1.f;
-      val.stencil = 0;
       VkImageSubresourceRange range = {uint32_t(aspectFlagBits), 0, mipLevels, 0, 1};
-      vkCmdClearDepthStencilImage(context->graphicsCommandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &val, 1,
-                                  &range);
+      vkCmdClearDepthStencilImage(context->graphicsCommandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                  &depthStencil, 1, &range);
     } else {
-      VkClearColorValue val;
-      val.float32[0] = val.float32[1] = val.float32[2] = val.float32[3] = 0.f;
-      val.int32[0] = val.int32[1] = val.int32[2] = val.int32[3] = 0;
-      val.uint32[0] = val.uint32[1] = val.uint32[2] = val.uint32[3] = 0;
       VkImageSubresourceRange range = {uint32_t(aspectFlagBits), 0, mipLevels, 0, 1};
-      vkCmdClearColorImage(context->graphicsCommandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &val, 1,
+      vkCmdClearColorImage(context->graphicsCommandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1,
                            &range);
     }
 
@@ -1632,7 +2208,7 @@ struct Texture : public ImageResource {
 
     err = vkEndCommandBuffer(context->graphicsCommandBuffer);
     if (err)
-      LOG_ERROR("failed to end command buffer for texture mipmap generation! : \n" + errorString(err));
+      LOG_ERROR("failed to end command buffer for texture clear! : \n" + errorString(err));
 
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -1645,13 +2221,13 @@ struct Texture : public ImageResource {
     submitInfo.signalSemaphoreCount = 0;
     submitInfo.pSignalSemaphores = nullptr;   //&writeImageSemaphoreHandleList[currentImageIndex]};
 
-    err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
     if (err)
-      LOG_ERROR("failed to submit to queue for texture mipmap generation! : \n" + errorString(err));
+      LOG_ERROR("failed to submit to queue for texture clear! : \n" + errorString(err));
 
-    err = vkQueueWaitIdle(context->graphicsQueue);
+    err = context->queueWaitIdle(context->graphicsQueue);
     if (err)
-      LOG_ERROR("failed to wait for queue idle for texture mipmap generation! : \n" + errorString(err));
+      LOG_ERROR("failed to wait for queue idle for texture clear! : \n" + errorString(err));
   }
 
   void generateMipmap() {
@@ -1777,11 +2353,11 @@ struct Texture : public ImageResource {
     submitInfo.signalSemaphoreCount = 0;
     submitInfo.pSignalSemaphores = nullptr;   //&writeImageSemaphoreHandleList[currentImageIndex]};
 
-    err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
     if (err)
       LOG_ERROR("failed to submit to queue for texture mipmap generation! : \n" + errorString(err));
 
-    err = vkQueueWaitIdle(context->graphicsQueue);
+    err = context->queueWaitIdle(context->graphicsQueue);
     if (err)
       LOG_ERROR("failed to wait for queue idle for texture mipmap generation! : \n" + errorString(err));
   }
@@ -1979,11 +2555,11 @@ struct Texture : public ImageResource {
       submitInfo.signalSemaphoreCount = 0;
       submitInfo.pSignalSemaphores = nullptr;   //&writeImageSemaphoreHandleList[currentImageIndex]};
 
-      err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+      err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
       if (err)
         LOG_ERROR("failed to submit to queue for buffer map! : \n" + errorString(err));
 
-      err = vkQueueWaitIdle(context->graphicsQueue);
+      err = context->queueWaitIdle(context->graphicsQueue);
       if (err)
         LOG_ERROR("failed to wait for queue idle for buffer map! : \n" + errorString(err));
     }
@@ -2025,17 +2601,7 @@ struct Texture : public ImageResource {
     VkDescriptorImageInfo imageDescriptor = {};
     imageDescriptor.imageView = imageView;
     imageDescriptor.imageLayout = layout;
-
-    VkWriteDescriptorSet writeDescriptorSet = {};
-    writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    writeDescriptorSet.dstBinding = 0;
-    writeDescriptorSet.dstArrayElement = address;
-    writeDescriptorSet.descriptorCount = 1;
-    writeDescriptorSet.pBufferInfo = 0;
-    writeDescriptorSet.dstSet = context->descriptorSet;
-    writeDescriptorSet.pImageInfo = &imageDescriptor;
-    writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-    vkUpdateDescriptorSets(context->logicalDevice, 1, &writeDescriptorSet, 0, nullptr);
+    writeDescriptor(VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, imageDescriptor);
   }
 
   /*! Calls vkDestroy on the image, and frees underlying memory */
@@ -2107,20 +2673,10 @@ struct Sampler : public ImageResource {
 
     VK_CHECK_RESULT(vkCreateSampler(context->logicalDevice, &samplerInfo, nullptr, &sampler));
 
-    // Write the image into the desscriptor array
+    // Write the sampler into the desscriptor array
     VkDescriptorImageInfo imageDescriptor = {};
     imageDescriptor.sampler = sampler;
-
-    VkWriteDescriptorSet writeDescriptorSet = {};
-    writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    writeDescriptorSet.dstBinding = 0;
-    writeDescriptorSet.dstArrayElement = address;
-    writeDescriptorSet.descriptorCount = 1;
-    writeDescriptorSet.pBufferInfo = 0;
-    writeDescriptorSet.dstSet = context->descriptorSet;
-    writeDescriptorSet.pImageInfo = &imageDescriptor;
-    writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-    vkUpdateDescriptorSets(context->logicalDevice, 1, &writeDescriptorSet, 0, nullptr);
+    writeDescriptor(VK_DESCRIPTOR_TYPE_SAMPLER, imageDescriptor);
   }
 
   void destroy() override {
@@ -2134,6 +2690,66 @@ struct Sampler : public ImageResource {
   virtual ImageResourceType getType() { return GPRT_IMAGE_RESOURCE_TYPE_SAMPLER; }
 };
 
+/* Whether the group size of the given compute entry point comes from the GPRT_GROUP_SIZE_CONSTANT_ID specialization
+   constant, either through a LocalSizeId execution mode, or through a WorkgroupSize built-in made of specialization
+   constants. SPIRV-Reflect only reports the literal group size, so this walks the instructions itself. */
+static bool
+hasSpecializedGroupSize(const std::vector<uint32_t> &binary, const std::string &entryPoint) {
+  if (binary.size() < 5 || binary[0] != SpvMagicNumber)
+    return false;
+
+  uint32_t function = UINT32_MAX;
+  std::set<uint32_t> groupSizeConstants;   // ids decorated with SpecId GPRT_GROUP_SIZE_CONSTANT_ID
+  std::set<uint32_t> workgroupSizes;       // ids decorated with BuiltIn WorkgroupSize
+  std::map<uint32_t, std::vector<uint32_t>> localSizeIds;       // function -> size ids
+  std::map<uint32_t, std::vector<uint32_t>> compositeConstants;   // id -> constituent ids
+  for (size_t i = 5; i < binary.size();) {
+    uint32_t opcode = binary[i] & SpvOpCodeMask;
+    uint32_t wordCount = binary[i] >> SpvWordCountShift;
+    if (wordCount == 0 || i + wordCount > binary.size())
+      return false;
+    const uint32_t *operands = &binary[i + 1];
+    switch (opcode) {
+    case SpvOpEntryPoint:
+      if (wordCount > 3 && operands[0] == SpvExecutionModelGLCompute &&
+          strncmp((const char *) &operands[2], entryPoint.c_str(), (wordCount - 3) * sizeof(uint32_t)) == 0)
+        function = operands[1];
+      break;
+    case SpvOpExecutionModeId:
+      if (wordCount == 6 && operands[1] == SpvExecutionModeLocalSizeId)
+        localSizeIds[operands[0]] = {operands[2], operands[3], operands[4]};
+      break;
+    case SpvOpDecorate:
+      if (wordCount == 4 && operands[1] == SpvDecorationSpecId && operands[2] == GPRT_GROUP_SIZE_CONSTANT_ID)
+        groupSizeConstants.insert(operands[0]);
+      if (wordCount == 4 && operands[1] == SpvDecorationBuiltIn && operands[2] == SpvBuiltInWorkgroupSize)
+        workgroupSizes.insert(operands[0]);
+      break;
+    case SpvOpSpecConstantComposite:
+      compositeConstants[operands[1]] = std::vector<uint32_t>(operands + 2, operands + wordCount - 1);
+      break;
+    }
+    i += wordCount;
+  }
+  if (function == UINT32_MAX)
+    return false;
+
+  auto usesGroupSizeConstant = [&](const std::vector<uint32_t> &ids) {
+    for (uint32_t id : ids)
+      if (groupSizeConstants.count(id))
+        return true;
+    return false;
+  };
+  // The WorkgroupSize built-in overrides the group size of every entry point in the module
+  for (uint32_t id : workgroupSizes) {
+    auto composite = compositeConstants.find(id);
+    if (composite != compositeConstants.end())
+      return usesGroupSizeConstant(composite->second);
+  }
+  auto localSize = localSizeIds.find(function);
+  return localSize != localSizeIds.end() && usesGroupSizeConstant(localSize->second);
+}
+
 struct Compute {
   Context *context;
 
@@ -2148,6 +2764,17 @@ struct Compute {
   VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
   VkPipeline pipeline = VK_NULL_HANDLE;
 
+  // Kernels that declare their group size with the GPRT_GROUP_SIZE_CONSTANT_ID specialization constant can be
+  // launched with other group sizes, one pipeline per size. A tuned size of 0 means the kernel's own size is used.
+  // Vulkan silently ignores specialization of a constant the kernel doesn't declare, so kernels with a fixed group
+  // size are never tuned.
+  bool tunable = false;
+  std::map<uint32_t, VkPipeline> specializedPipelines;
+  uint32_t tunedGroupSize = 0;
+
+  // Identifies this kernel in the tuning cache. The binary hash invalidates entries when the kernel is recompiled.
+  std::string tuningKey;
+
   Compute(Context *context, Module *module, const char *_entryPoint) {
     this->context = context;
 
@@ -2180,9 +2807,79 @@ struct Compute {
     shaderStage.module = shaderModule;
     shaderStage.pName = entryPoint.c_str();
     assert(shaderStage.module != VK_NULL_HANDLE);
+
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t word : binary) {
+      hash ^= word;
+      hash *= 1099511628211ull;
+    }
+    std::stringstream key;
+    key << entryPoint << ":" << std::hex << hash;
+    tuningKey = key.str();
+    tunable = hasSpecializedGroupSize(binary, entryPoint);
   }
   ~Compute() {}
 
+  void destroySpecializedPipelines() {
+    for (auto &specialized : specializedPipelines)
+      vkDestroyPipeline(context->logicalDevice, specialized.second, nullptr);
+    specializedPipelines.clear();
+  }
+
+  // Returns the pipeline to launch with the given group size, where 0 means the kernel's own group size
+  VkPipeline getPipeline(uint32_t groupSize) {
+    if (groupSize == 0)
+      return pipeline;
+
+    auto it = specializedPipelines.find(groupSize);
+    if (it != specializedPipelines.end())
+      return it->second;
+
+    VkSpecializationMapEntry mapEntry{};
+    mapEntry.constantID = GPRT_GROUP_SIZE_CONSTANT_ID;
+    mapEntry.offset = 0;
+    mapEntry.size = sizeof(uint32_t);
+
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = 1;
+    specializationInfo.pMapEntries = &mapEntry;
+    specializationInfo.dataSize = sizeof(uint32_t);
+    specializationInfo.pData = &groupSize;
+
+    VkPipelineShaderStageCreateInfo specializedStage = shaderStage;
+    specializedStage.pSpecializationInfo = &specializationInfo;
+
+    VkComputePipelineCreateInfo computePipelineCreateInfo = {};
+    computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    computePipelineCreateInfo.layout = pipelineLayout;
+    computePipelineCreateInfo.flags =
+        (context->features.pipelineStatistics) ? VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR : 0;
+    computePipelineCreateInfo.stage = specializedStage;
+
+    VkPipeline specialized = VK_NULL_HANDLE;
+    VkResult err = vkCreateComputePipelines(context->logicalDevice, VK_NULL_HANDLE, 1, &computePipelineCreateInfo,
+                                            nullptr, &specialized);
+    if (err) {
+      LOG_ERROR("failed to create compute pipeline for \"" + entryPoint + "\" with a group size of " +
+                std::to_string(groupSize) + "\n" + errorString(err));
+    }
+    specializedPipelines[groupSize] = specialized;
+    return specialized;
+  }
+
+  // The tuned group size, picked up from the context's tuning cache if this kernel hasn't been tuned yet
+  uint32_t getTunedGroupSize() {
+    if (!tunable)
+      return 0;
+    if (tunedGroupSize == 0 && !context->tuningCache.empty()) {
+      auto it = context->tuningCache.find(context->getTuningDeviceKey() + " " + tuningKey);
+      if (it != context->tuningCache.end())
+        tunedGroupSize = it->second;
+    }
+    return tunedGroupSize;
+  }
+
   void buildPipeline(VkDescriptorSetLayout descriptorSetLayout) {
     // If we already have a pipeline layout, free it so that we can make a new one
     if (pipelineLayout) {
@@ -2195,6 +2892,7 @@ struct Compute {
       vkDestroyPipeline(context->logicalDevice, pipeline, nullptr);
       pipeline = VK_NULL_HANDLE;
     }
+    destroySpecializedPipelines();
 
     // currently not using cache.
     VkPipelineCache cache = VK_NULL_HANDLE;
@@ -2219,7 +2917,8 @@ struct Compute {
     VkComputePipelineCreateInfo computePipelineCreateInfo = {};
     computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
     computePipelineCreateInfo.layout = pipelineLayout;
-    computePipelineCreateInfo.flags = 0;
+    computePipelineCreateInfo.flags =
+        (context->features.pipelineStatistics) ? VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR : 0;
     computePipelineCreateInfo.stage = shaderStage;
 
     // If the below function is crashing, double check that all parameters to the compute kernel are tagged as
@@ -2242,6 +2941,7 @@ struct Compute {
     if (pipeline) {
       vkDestroyPipeline(context->logicalDevice, pipeline, nullptr);
     }
+    destroySpecializedPipelines();
 
     if (shaderModule) {
       vkDestroyShaderModule(context->logicalDevice, shaderModule, nullptr);
@@ -2644,7 +3344,7 @@ struct Geom : public SBTEntry {
   };
   ~Geom() {};
 
-  void destroy() {
+  virtual void destroy() {
     // Free geometry slot for use by subsequently made geometries
     context->geoms[address] = nullptr;
   }
@@ -2710,6 +3410,76 @@ Geom *TriangleGeomType::createGeom() {
   return new TriangleGeom(this);
 }
 
+struct MotionTriangleGeomType : public TriangleGeomType {
+  MotionTriangleGeomType(Context* context, uint32_t numRayTypes, size_t recordSize)
+      : TriangleGeomType(context, numRayTypes, recordSize) {}
+  ~MotionTriangleGeomType() {}
+
+  Geom *createGeom();
+
+  GPRTGeomKind getKind() { return GPRT_MOTION_TRIANGLES; }
+};
+
+// Triangles whose vertices move through keyframes. Each entry of vertex.buffers holds one keyframe, all sharing the
+// same count, stride and offset.
+struct MotionTriangleGeom : public TriangleGeom {
+  // The device address of the first vertex of each keyframe, which the built-in programs index by keyframe
+  Buffer *keys = nullptr;
+
+  MotionTriangleGeom(MotionTriangleGeomType *_geomType) : TriangleGeom(_geomType) {}
+  ~MotionTriangleGeom() {}
+
+  void destroy() override {
+    if (keys) {
+      gprtBufferDestroy((GPRTBuffer) keys);
+      keys = nullptr;
+    }
+    TriangleGeom::destroy();
+  }
+
+  void setMotionVertices(uint32_t numKeys, Buffer **vertices, uint32_t count, uint32_t stride, uint32_t offset) {
+    vertex.buffers.assign(vertices, vertices + numKeys);
+    vertex.count = count;
+    vertex.stride = stride;
+    vertex.offset = offset;
+  }
+
+  // Everything the bounds kernel and the intersection program need, minus the AABB output
+  MotionTriangleParameters getParameters() {
+    if (!keys || keys->getSize() != vertex.buffers.size() * sizeof(uint64_t)) {
+      if (keys)
+        gprtBufferDestroy((GPRTBuffer) keys);
+      keys = (Buffer *) gprtDeviceBufferCreate(
+          (GPRTContext) context, sizeof(uint64_t), vertex.buffers.size(), nullptr);
+    }
+
+    MotionTriangleParameters params = {};
+    params.keys = (float3 **) keys->getDeviceAddress();
+    params.indices = (uint3 *) index.buffer->getDeviceAddress();
+    params.numKeys = (uint32_t) vertex.buffers.size();
+    params.verticesStride = vertex.stride;
+    params.indicesOffset = index.offset;
+    params.indicesStride = index.stride;
+    params.firstVertex = index.firstVertex;
+    params.count = index.count;
+    return params;
+  }
+
+  // Keyframe buffers may have been resized, and so moved, since they were set
+  void uploadKeys() {
+    std::vector<uint64_t> addresses(vertex.buffers.size());
+    for (uint32_t key = 0; key < vertex.buffers.size(); ++key)
+      addresses[key] = vertex.buffers[key]->getDeviceAddress() + vertex.offset;
+    keys->map();
+    memcpy(keys->mapped, addresses.data(), addresses.size() * sizeof(uint64_t));
+    keys->unmap();
+  }
+};
+
+Geom *MotionTriangleGeomType::createGeom() {
+  return new MotionTriangleGeom(this);
+}
+
 struct SphereGeomType : public GeomType {
   SphereGeomType(Context* context, uint32_t numRayTypes, size_t recordSize)
       : GeomType(context, numRayTypes, recordSize) {}
@@ -2857,6 +3627,12 @@ struct SolidGeom : public Geom {
     Buffer *buffer = nullptr;
   } types;
 
+  // Face neighbors of each cell, built on request by gprtSolidsBuildAdjacency
+  Buffer *adjacency = nullptr;
+
+  // Optional gprt::SolidValueFilter, read by the built-in intersection program
+  Buffer *valueFilter = nullptr;
+
   SolidGeom(SolidGeomType *_geomType) : Geom(_geomType->context) {
     geomType = (GeomType *) _geomType;
 
@@ -2864,7 +3640,13 @@ struct SolidGeom : public Geom {
     this->SBTRecord = (uint8_t *) malloc(geomType->recordSize);
     this->recordSize = geomType->recordSize;
   };
-  ~SolidGeom() { free(this->SBTRecord); };
+  ~SolidGeom() {
+    free(this->SBTRecord);
+    if (adjacency) {
+      adjacency->destroy();
+      delete adjacency;
+    }
+  };
 
   void setAABBs(Buffer *aabbs, uint32_t count, uint32_t stride, uint32_t offset) {
     aabb.buffers.resize(1);
@@ -2901,38 +3683,175 @@ Geom *SolidGeomType::createGeom() {
   return new SolidGeom(this);
 }
 
-struct AABBGeomType : public GeomType {
-  AABBGeomType(Context* context, uint32_t numRayTypes, size_t recordSize)
+struct VoxelGeomType : public GeomType {
+  VoxelGeomType(Context* context, uint32_t numRayTypes, size_t recordSize)
       : GeomType(context, numRayTypes, recordSize) {}
-  ~AABBGeomType() {}
+  ~VoxelGeomType() {}
   Geom *createGeom();
 
-  GPRTGeomKind getKind() { return GPRT_AABBS; }
+  GPRTGeomKind getKind() { return GPRT_VOXELS; }
 };
 
-struct AABBGeom : public Geom {
+struct VoxelGeom : public Geom {
   struct {
-    uint32_t count;
-    uint32_t stride;
-    uint32_t offset;
-    std::vector<Buffer *> buffers;
-  } aabb;
+    uint3 dims = uint3(0, 0, 0);
+    uint32_t stride = 0;   // stride between values
+    uint32_t offset = 0;   // offset in bytes to the first value
+    Buffer *buffer = nullptr;
+  } values;
 
-  AABBGeom(AABBGeomType *_geomType) : Geom(_geomType->context) {
+  float3 origin = float3(0.f, 0.f, 0.f);
+  float3 spacing = float3(1.f, 1.f, 1.f);
+  uint32_t brickSize = 8;
+  uint32_t flags = GPRT_VOXEL_REPORT_EACH_VOXEL;   // set by the accel, read by the intersection program
+
+  VoxelGeom(VoxelGeomType *_geomType) : Geom(_geomType->context) {
     geomType = (GeomType *) _geomType;
 
     // Allocate the variables for this geometry
     this->SBTRecord = (uint8_t *) malloc(geomType->recordSize);
     this->recordSize = geomType->recordSize;
   };
-  ~AABBGeom() { free(this->SBTRecord); };
+  ~VoxelGeom() { free(this->SBTRecord); };
 
-  void setAABBs(Buffer *aabbs, uint32_t count, uint32_t stride, uint32_t offset) {
-    // assuming no motion blurred triangles for now, so we assume 1 buffer
-    aabb.buffers.resize(1);
-    aabb.buffers[0] = aabbs;
-    aabb.count = count;
-    aabb.stride = stride;
+  void setValues(Buffer *buffer, uint3 dims, uint32_t stride, uint32_t offset) {
+    values.buffer = buffer;
+    values.dims = dims;
+    values.stride = stride;
+    values.offset = offset;
+  }
+
+  uint3 getBricks() {
+    return uint3((values.dims.x + brickSize - 1) / brickSize, (values.dims.y + brickSize - 1) / brickSize,
+                 (values.dims.z + brickSize - 1) / brickSize);
+  }
+
+  uint32_t getBrickCount() {
+    uint3 bricks = getBricks();
+    return bricks.x * bricks.y * bricks.z;
+  }
+
+  // Everything the bounds kernel and the intersection program need, minus the AABB output
+  VoxelParameters getParameters() {
+    VoxelParameters params = {};
+    params.values = (float *) values.buffer->getDeviceAddress();
+    params.origin = origin;
+    params.spacing = spacing;
+    params.dims = values.dims;
+    params.bricks = getBricks();
+    params.brickSize = brickSize;
+    params.valuesOffset = values.offset;
+    params.valuesStride = values.stride;
+    params.flags = flags;
+    params.count = getBrickCount();
+    return params;
+  }
+};
+
+Geom *VoxelGeomType::createGeom() {
+  return new VoxelGeom(this);
+}
+
+struct CurveGeomType : public GeomType {
+  CurveGeomType(Context* context, uint32_t numRayTypes, size_t recordSize)
+      : GeomType(context, numRayTypes, recordSize) {}
+  ~CurveGeomType() {}
+  Geom *createGeom();
+
+  GPRTGeomKind getKind() { return GPRT_CURVES; }
+};
+
+struct CurveGeom : public Geom {
+  struct {
+    uint32_t count = 0;    // number of segments
+    uint32_t stride = 0;   // stride between indices
+    uint32_t offset = 0;   // offset in bytes to the first index
+    Buffer *buffer = nullptr;
+  } index;
+
+  struct {
+    uint32_t count = 0;    // number of control points
+    uint32_t stride = 0;   // stride between control points
+    uint32_t offset = 0;   // an offset in bytes to the first control point
+    Buffer *buffer = nullptr;
+  } vertex;
+
+  uint32_t basis = GPRT_CURVE_BSPLINE;
+
+  CurveGeom(CurveGeomType *_geomType) : Geom(_geomType->context) {
+    geomType = (GeomType *) _geomType;
+
+    // Allocate the variables for this geometry
+    this->SBTRecord = (uint8_t *) malloc(geomType->recordSize);
+    this->recordSize = geomType->recordSize;
+  };
+  ~CurveGeom() { free(this->SBTRecord); };
+
+  void setVertices(Buffer *vertices, uint32_t count, uint32_t stride, uint32_t offset) {
+    vertex.buffer = vertices;
+    vertex.count = count;
+    vertex.stride = stride;
+    vertex.offset = offset;
+  }
+
+  void setIndices(Buffer *indices, uint32_t count, uint32_t stride, uint32_t offset) {
+    index.buffer = indices;
+    index.count = count;
+    index.stride = stride;
+    index.offset = offset;
+  }
+
+  // Everything the bounds kernel and the intersection program need, minus the AABB output
+  CurveParameters getParameters() {
+    CurveParameters params = {};
+    params.vertices = (float4 *) vertex.buffer->getDeviceAddress();
+    params.indices = (uint32_t *) index.buffer->getDeviceAddress();
+    params.verticesOffset = vertex.offset;
+    params.verticesStride = vertex.stride;
+    params.indicesOffset = index.offset;
+    params.indicesStride = index.stride;
+    params.basis = basis;
+    params.count = index.count;
+    return params;
+  }
+};
+
+Geom *CurveGeomType::createGeom() {
+  return new CurveGeom(this);
+}
+
+struct AABBGeomType : public GeomType {
+  AABBGeomType(Context* context, uint32_t numRayTypes, size_t recordSize)
+      : GeomType(context, numRayTypes, recordSize) {}
+  ~AABBGeomType() {}
+  Geom *createGeom();
+
+  GPRTGeomKind getKind() { return GPRT_AABBS; }
+};
+
+struct AABBGeom : public Geom {
+  struct {
+    uint32_t count;
+    uint32_t stride;
+    uint32_t offset;
+    std::vector<Buffer *> buffers;
+  } aabb;
+
+  AABBGeom(AABBGeomType *_geomType) : Geom(_geomType->context) {
+    geomType = (GeomType *) _geomType;
+
+    // Allocate the variables for this geometry
+    this->SBTRecord = (uint8_t *) malloc(geomType->recordSize);
+    this->recordSize = geomType->recordSize;
+  };
+  ~AABBGeom() { free(this->SBTRecord); };
+
+  void setAABBs(Buffer *aabbs, uint32_t count, uint32_t stride, uint32_t offset) {
+    // assuming no motion blurred triangles for now, so we assume 1 buffer
+    aabb.buffers.resize(1);
+    aabb.buffers[0] = aabbs;
+    aabb.count = count;
+    aabb.stride = stride;
     aabb.offset = offset;
   }
 };
@@ -2948,7 +3867,10 @@ typedef enum {
   GPRT_TRIANGLE_ACCEL = 0x3,
   GPRT_SPHERE_ACCEL = 0x4,
   GPRT_LSS_ACCEL = 0x5,
-  GPRT_SOLID_ACCEL = 0x6
+  GPRT_SOLID_ACCEL = 0x6,
+  GPRT_VOXEL_ACCEL = 0x7,
+  GPRT_CURVE_ACCEL = 0x8,
+  GPRT_MOTION_TRIANGLE_ACCEL = 0x9
 } AccelType;
 
 struct Accel {
@@ -3049,7 +3971,7 @@ public:
     isCompact = false;
 
     if (compactBuffer) {
-      gprt::vkDestroyAccelerationStructure(context->logicalDevice, compactAccelerationStructure, nullptr);
+      context->vkDestroyAccelerationStructure(context->logicalDevice, compactAccelerationStructure, nullptr);
       compactAccelerationStructure = VK_NULL_HANDLE;
       compactBuffer->destroy();
       delete (compactBuffer);
@@ -3059,7 +3981,7 @@ public:
 
   void freeFullTree() {
     if (accelBuffer) {
-      gprt::vkDestroyAccelerationStructure(context->logicalDevice, accelerationStructure, nullptr);
+      context->vkDestroyAccelerationStructure(context->logicalDevice, accelerationStructure, nullptr);
       accelerationStructure = VK_NULL_HANDLE;
       accelBuffer->destroy();
       delete (accelBuffer);
@@ -3101,7 +4023,7 @@ public:
   void resizeFullTree(VkAccelerationStructureBuildSizesInfoKHR accelerationStructureBuildSizesInfo) {
     // Destroy old accel handle
     if (accelBuffer && accelBuffer->size < accelerationStructureBuildSizesInfo.accelerationStructureSize) {
-      gprt::vkDestroyAccelerationStructure(context->logicalDevice, accelerationStructure, nullptr);
+      context->vkDestroyAccelerationStructure(context->logicalDevice, accelerationStructure, nullptr);
       accelerationStructure = VK_NULL_HANDLE;
       accelBuffer->destroy();
       delete (accelBuffer);
@@ -3137,8 +4059,8 @@ public:
       accelerationStructureCreateInfo.createFlags =
           VK_ACCELERATION_STRUCTURE_CREATE_DEVICE_ADDRESS_CAPTURE_REPLAY_BIT_KHR;
       accelerationStructureCreateInfo.deviceAddress = accelBuffer->deviceAddress;
-      VkResult err = gprt::vkCreateAccelerationStructure(context->logicalDevice, &accelerationStructureCreateInfo,
-                                                         nullptr, &accelerationStructure);
+      VkResult err = context->vkCreateAccelerationStructure(context->logicalDevice, &accelerationStructureCreateInfo,
+                                                            nullptr, &accelerationStructure);
       if (err)
         LOG_ERROR("failed to create acceleration structure: \n" + errorString(err));
     }
@@ -3156,9 +4078,9 @@ public:
     // reset the query so we can use it again
     vkCmdResetQueryPool(context->graphicsCommandBuffer, context->compactedSizeQueryPool, 0, 1);
 
-    gprt::vkCmdWriteAccelerationStructuresProperties(context->graphicsCommandBuffer, 1, &accelerationStructure,
-                                                     VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR,
-                                                     context->compactedSizeQueryPool, 0);
+    context->vkCmdWriteAccelerationStructuresProperties(context->graphicsCommandBuffer, 1, &accelerationStructure,
+                                                        VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR,
+                                                        context->compactedSizeQueryPool, 0);
 
     err = vkEndCommandBuffer(context->graphicsCommandBuffer);
     if (err)
@@ -3175,11 +4097,11 @@ public:
     submitInfo.signalSemaphoreCount = 0;
     submitInfo.pSignalSemaphores = nullptr;   //&writeImageSemaphoreHandleList[currentImageIndex]};
 
-    err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
     if (err)
       LOG_ERROR("failed to submit to queue for query compaction size! : \n" + errorString(err));
 
-    err = vkQueueWaitIdle(context->graphicsQueue);
+    err = context->queueWaitIdle(context->graphicsQueue);
     if (err)
       LOG_ERROR("failed to wait for queue idle for query compaction size! : \n" + errorString(err));
 
@@ -3199,7 +4121,7 @@ public:
     // allocate compact buffer and compact acceleration structure
     if (compactBuffer && compactBuffer->size != compactedSize) {
       // Destroy old accel handle too
-      gprt::vkDestroyAccelerationStructure(context->logicalDevice, compactAccelerationStructure, nullptr);
+      context->vkDestroyAccelerationStructure(context->logicalDevice, compactAccelerationStructure, nullptr);
       compactAccelerationStructure = VK_NULL_HANDLE;
       compactBuffer->destroy();
       delete (compactBuffer);
@@ -3234,8 +4156,8 @@ public:
       accelerationStructureCreateInfo.createFlags =
           VK_ACCELERATION_STRUCTURE_CREATE_DEVICE_ADDRESS_CAPTURE_REPLAY_BIT_KHR;
       accelerationStructureCreateInfo.deviceAddress = compactBuffer->deviceAddress;
-      VkResult err = gprt::vkCreateAccelerationStructure(context->logicalDevice, &accelerationStructureCreateInfo,
-                                                         nullptr, &compactAccelerationStructure);
+      VkResult err = context->vkCreateAccelerationStructure(context->logicalDevice, &accelerationStructureCreateInfo,
+                                                            nullptr, &compactAccelerationStructure);
       if (err)
         LOG_ERROR("failed to create compact acceleration structure: \n" + errorString(err));
     }
@@ -3243,6 +4165,7 @@ public:
 
   // Copies over the uncompact tree into compacted tree memory
   void compactTree() {
+    context->counters.accelCompactions++;
 
     // Copy over the compacted acceleration structure
     VkCopyAccelerationStructureInfoKHR copyAccelerationStructureInfo{};
@@ -3260,7 +4183,7 @@ public:
       if (err)
         LOG_ERROR("failed to begin command buffer for compaction! : \n" + errorString(err));
 
-      gprt::vkCmdCopyAccelerationStructure(context->graphicsCommandBuffer, &copyAccelerationStructureInfo);
+      context->vkCmdCopyAccelerationStructure(context->graphicsCommandBuffer, &copyAccelerationStructureInfo);
 
       err = vkEndCommandBuffer(context->graphicsCommandBuffer);
       if (err)
@@ -3277,11 +4200,11 @@ public:
       submitInfo.signalSemaphoreCount = 0;
       submitInfo.pSignalSemaphores = nullptr;   //&writeImageSemaphoreHandleList[currentImageIndex]};
 
-      err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+      err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
       if (err)
         LOG_ERROR("failed to submit to queue for compaction! : \n" + errorString(err));
 
-      err = vkQueueWaitIdle(context->graphicsQueue);
+      err = context->queueWaitIdle(context->graphicsQueue);
       if (err)
         LOG_ERROR("failed to wait for queue idle for compaction! : \n" + errorString(err));
     }
@@ -3296,6 +4219,7 @@ public:
   // - std::vector<VkAccelerationStructureGeometryKHR> accelerationStructureGeometries;
   // - std::vector<uint32_t> maxPrimitiveCounts;
   void innerBuildProc(GPRTBuildMode buildMode, bool allowCompaction, bool minimizeMemory) {
+    context->counters.accelBuilds++;
     VkResult err;
 
     // Get size info
@@ -3335,12 +4259,12 @@ public:
 
     VkAccelerationStructureBuildSizesInfoKHR accelerationStructureBuildSizesInfo{};
     accelerationStructureBuildSizesInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR;
-    gprt::vkGetAccelerationStructureBuildSizes(context->logicalDevice, VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
-                                               &accelerationStructureBuildGeometryInfo, maxPrimitiveCounts.data(),
-                                               &accelerationStructureBuildSizesInfo);
+    context->vkGetAccelerationStructureBuildSizes(
+        context->logicalDevice, VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
+        &accelerationStructureBuildGeometryInfo, maxPrimitiveCounts.data(), &accelerationStructureBuildSizesInfo);
 
     // for TLAS, called like this:
-    // gprt::vkGetAccelerationStructureBuildSizes(context->logicalDevice,
+    // context->vkGetAccelerationStructureBuildSizes(context->logicalDevice,
     // VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
     //                                            &accelerationStructureBuildGeometryInfo, &primitive_count,
     //                                            &accelerationStructureBuildSizesInfo);
@@ -3400,8 +4324,8 @@ public:
     if (err)
       LOG_ERROR("failed to begin command buffer for triangle accel build! : \n" + errorString(err));
 
-    gprt::vkCmdBuildAccelerationStructures(context->graphicsCommandBuffer, 1, &accelerationBuildGeometryInfo,
-                                           accelerationBuildStructureRangeInfoPtrs.data());
+    context->vkCmdBuildAccelerationStructures(context->graphicsCommandBuffer, 1, &accelerationBuildGeometryInfo,
+                                              accelerationBuildStructureRangeInfoPtrs.data());
 
     err = vkEndCommandBuffer(context->graphicsCommandBuffer);
     if (err)
@@ -3426,11 +4350,11 @@ public:
     // if (err) LOG_ERROR("failed to create fence for triangle accel build! :
     // \n" + errorString(err));
 
-    err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
     if (err)
       LOG_ERROR("failed to submit to queue for triangle accel build! : \n" + errorString(err));
 
-    err = vkQueueWaitIdle(context->graphicsQueue);
+    err = context->queueWaitIdle(context->graphicsQueue);
     if (err)
       LOG_ERROR("failed to wait for queue idle for triangle accel build! : \n" + errorString(err));
 
@@ -3463,6 +4387,7 @@ public:
     if (buildMode == GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE) {
       LOG_ERROR("Previous build mode must support updates!");
     }
+    context->counters.accelUpdates++;
 
     VkResult err;
 
@@ -3500,7 +4425,7 @@ public:
 
       VkAccelerationStructureBuildSizesInfoKHR accelerationStructureBuildSizesInfo{};
       accelerationStructureBuildSizesInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR;
-      gprt::vkGetAccelerationStructureBuildSizes(
+      context->vkGetAccelerationStructureBuildSizes(
           context->logicalDevice, VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
           &accelerationStructureBuildGeometryInfo, maxPrimitiveCounts.data(), &accelerationStructureBuildSizesInfo);
 
@@ -3548,8 +4473,8 @@ public:
     if (err)
       LOG_ERROR("failed to begin command buffer for triangle accel build! : \n" + errorString(err));
 
-    gprt::vkCmdBuildAccelerationStructures(context->graphicsCommandBuffer, 1, &accelerationBuildGeometryInfo,
-                                           accelerationBuildStructureRangeInfoPtrs.data());
+    context->vkCmdBuildAccelerationStructures(context->graphicsCommandBuffer, 1, &accelerationBuildGeometryInfo,
+                                              accelerationBuildStructureRangeInfoPtrs.data());
 
     err = vkEndCommandBuffer(context->graphicsCommandBuffer);
     if (err)
@@ -3566,11 +4491,11 @@ public:
     submitInfo.signalSemaphoreCount = 0;
     submitInfo.pSignalSemaphores = nullptr;   //&writeImageSemaphoreHandleList[currentImageIndex]};
 
-    err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+    err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
     if (err)
       LOG_ERROR("failed to submit to queue for AABB accel build! : \n" + errorString(err));
 
-    err = vkQueueWaitIdle(context->graphicsQueue);
+    err = context->queueWaitIdle(context->graphicsQueue);
     if (err)
       LOG_ERROR("failed to wait for queue idle for AABB accel build! : \n" + errorString(err));
 
@@ -3608,12 +4533,12 @@ public:
   };
   virtual void destroy() {
     if (accelerationStructure) {
-      gprt::vkDestroyAccelerationStructure(context->logicalDevice, accelerationStructure, nullptr);
+      context->vkDestroyAccelerationStructure(context->logicalDevice, accelerationStructure, nullptr);
       accelerationStructure = VK_NULL_HANDLE;
     }
 
     if (compactAccelerationStructure) {
-      gprt::vkDestroyAccelerationStructure(context->logicalDevice, compactAccelerationStructure, nullptr);
+      context->vkDestroyAccelerationStructure(context->logicalDevice, compactAccelerationStructure, nullptr);
       compactAccelerationStructure = VK_NULL_HANDLE;
     }
 
@@ -3729,7 +4654,7 @@ struct SphereAccel : public Accel {
     memcpy(this->geometries.data(), geometries.data(), sizeof(GPRTGeom *) * geometries.size());
 
     // If we don't have hardware acceleration for spheres, fall back to AABBs
-    if (!requestedFeatures.linearSweptSpheres) {
+    if (!context->features.linearSweptSpheres) {
       fallbackAABBOffsets.resize(geometries.size() + 1);
       // Placeholder. The actual allocation here will vary from build to build.
       fallbackAABBs = gprtDeviceBufferCreate<float3>((GPRTContext) context, 1, nullptr);
@@ -3751,7 +4676,7 @@ struct SphereAccel : public Accel {
     accelerationStructureGeometrySpheres.resize(geometries.size());
 #endif
 
-    if (!requestedFeatures.linearSweptSpheres) {
+    if (!context->features.linearSweptSpheres) {
       // Do a prefix sum over the sphere counts
       fallbackAABBOffsets[0] = 0;
       for (uint32_t gid = 0; gid < geometries.size(); ++gid) {
@@ -3796,7 +4721,7 @@ struct SphereAccel : public Accel {
 
       #ifdef VK_NV_ray_tracing_linear_swept_spheres
       // If we have hardware accelerated support for LSS, use the built-in type
-      if (requestedFeatures.linearSweptSpheres) {
+      if (context->features.linearSweptSpheres) {
         // Specify that the geometry type is LSS
         geom.geometryType = VkGeometryTypeKHR::VK_GEOMETRY_TYPE_SPHERES_NV;
 
@@ -3881,7 +4806,7 @@ struct LSSAccel : public Accel {
     useEndCaps = ((flags & GPRT_LSS_CHAINED_END_CAPS) != 0);
 
     // If we don't have hardware acceleration for LSS, fall back to AABBs
-    if (!requestedFeatures.linearSweptSpheres) {
+    if (!context->features.linearSweptSpheres) {
       fallbackAABBOffsets.resize(geometries.size() + 1);
       // Placeholder. The actual allocation here will vary from build to build.
       fallbackAABBs = gprtDeviceBufferCreate<float3>((GPRTContext) context, 1, nullptr);
@@ -3908,7 +4833,7 @@ struct LSSAccel : public Accel {
     accelerationStructureGeometryLinearSweptSpheres.resize(geometries.size());
     #endif
 
-    if (!requestedFeatures.linearSweptSpheres) {
+    if (!context->features.linearSweptSpheres) {
       // Do a prefix sum over the LSS counts
       fallbackAABBOffsets[0] = 0;
       for (uint32_t gid = 0; gid < geometries.size(); ++gid) {
@@ -3956,7 +4881,7 @@ struct LSSAccel : public Accel {
 
 #ifdef VK_NV_ray_tracing_linear_swept_spheres
       // If we have hardware accelerated support for LSS, use the built-in type
-      if (requestedFeatures.linearSweptSpheres) {
+      if (context->features.linearSweptSpheres) {
         // Specify that the geometry type is LSS
         geom.geometryType = VkGeometryTypeKHR::VK_GEOMETRY_TYPE_LINEAR_SWEPT_SPHERES_NV;
 
@@ -4074,7 +4999,7 @@ struct SolidAccel : public Accel {
         auto &geom = accelerationStructureGeometries[gid];
         SolidGeom *solidGeom = (SolidGeom *) geometries[gid];
 
-        SolidParameters params;
+        SolidParameters params = {};
         params.aabbs = gprtBufferGetDevicePointer(AABBs);
         params.vertices = (float4 *) solidGeom->vertex.buffers[0]->getDeviceAddress();
         params.indices = (uint4 *) solidGeom->index.buffer->getDeviceAddress();
@@ -4166,6 +5091,273 @@ struct SolidAccel : public Accel {
   // }
 };
 
+struct VoxelAccel : public Accel {
+  // One AABB per brick, rather than per voxel
+  GPRTBufferOf<float3> AABBs = nullptr;
+  std::vector<uint32_t> AABBOffsets;
+
+  VoxelAccel(Context *context, std::vector<VoxelGeom*> geometries, unsigned int flags) : Accel(context, true) {
+    this->geometries.resize(geometries.size());
+    memcpy(this->geometries.data(), geometries.data(), sizeof(GPRTGeom *) * geometries.size());
+    for (auto geom : geometries)
+      geom->flags = flags;
+
+    AABBOffsets.resize(geometries.size() + 1);
+    // Placeholder. The actual allocation here will vary from build to build.
+    AABBs = gprtDeviceBufferCreate<float3>((GPRTContext) context, 1, nullptr);
+  };
+
+  ~VoxelAccel() {};
+
+  void destroy() {
+    if (AABBs) {
+      gprtBufferDestroy(AABBs);
+      AABBs = nullptr;
+    }
+    Accel::destroy();
+  }
+
+  AccelType getType() { return GPRT_VOXEL_ACCEL; }
+
+  void build(GPRTBuildMode buildMode, bool allowCompaction, bool minimizeMemory) {
+    this->buildMode = buildMode;
+
+    accelerationBuildStructureRangeInfos.resize(geometries.size());
+    accelerationBuildStructureRangeInfoPtrs.resize(geometries.size());
+    accelerationStructureGeometries.resize(geometries.size());
+    maxPrimitiveCounts.resize(geometries.size());
+
+    // Do a prefix sum over the brick counts
+    AABBOffsets[0] = 0;
+    for (uint32_t gid = 0; gid < geometries.size(); ++gid) {
+      VoxelGeom *voxelGeom = (VoxelGeom *) geometries[gid];
+      if (voxelGeom->values.buffer == nullptr)
+        LOG_ERROR("voxel geometry has no values, call gprtVoxelsSetValues before building!");
+      AABBOffsets[gid + 1] = voxelGeom->getBrickCount() + AABBOffsets[gid];
+    }
+
+    // Resize the AABB buffer if needed...
+    size_t requiredBytesForAABBs = 2 * sizeof(float3) * AABBOffsets[geometries.size()];
+    if (gprtBufferGetSize(AABBs) != requiredBytesForAABBs) {
+      gprtBufferResize((GPRTContext) context, AABBs, AABBOffsets[geometries.size()] * 2, false);
+    }
+
+    // Now populate the AABB buffer, one AABB per brick
+    auto VoxelBounds = (GPRTComputeOf<VoxelParameters>) context->internalComputePrograms["VoxelBounds"];
+    for (uint32_t gid = 0; gid < geometries.size(); ++gid) {
+      VoxelGeom *voxelGeom = (VoxelGeom *) geometries[gid];
+      VoxelParameters params = voxelGeom->getParameters();
+      params.aabbs = gprtBufferGetDevicePointer(AABBs);
+      params.offset = AABBOffsets[gid];
+      gprtComputeLaunch(VoxelBounds, uint3(((params.count + 255) / 256), 1, 1), uint3(256, 1, 1), params);
+    }
+
+    for (uint32_t gid = 0; gid < geometries.size(); ++gid) {
+      auto &geom = accelerationStructureGeometries[gid];
+      VoxelGeom *voxelGeom = (VoxelGeom *) geometries[gid];
+      uint32_t numBricks = AABBOffsets[gid + 1] - AABBOffsets[gid];
+
+      geom.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+      geom.flags = VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR;
+      geom.geometryType = VkGeometryTypeKHR::VK_GEOMETRY_TYPE_AABBS_KHR;
+
+      geom.geometry.aabbs.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_AABBS_DATA_KHR;
+      geom.geometry.aabbs.pNext = VK_NULL_HANDLE;
+      geom.geometry.aabbs.stride = 2 * sizeof(float3);
+      geom.geometry.aabbs.data.deviceAddress = (VkDeviceAddress) gprtBufferGetDevicePointer(AABBs);
+
+      auto &geomRange = accelerationBuildStructureRangeInfos[gid];
+      accelerationBuildStructureRangeInfoPtrs[gid] = &accelerationBuildStructureRangeInfos[gid];
+      geomRange.primitiveCount = numBricks;
+      geomRange.primitiveOffset = AABBOffsets[gid] * 2 * sizeof(float3);
+      geomRange.firstVertex = 0;   // unused
+      geomRange.transformOffset = 0;
+
+      maxPrimitiveCounts[gid] = numBricks;
+    }
+
+    innerBuildProc(buildMode, allowCompaction, minimizeMemory);
+  }
+};
+
+struct CurveAccel : public Accel {
+  // One AABB per curve segment
+  GPRTBufferOf<float3> AABBs = nullptr;
+  std::vector<uint32_t> AABBOffsets;
+
+  CurveAccel(Context *context, std::vector<CurveGeom*> geometries) : Accel(context, true) {
+    this->geometries.resize(geometries.size());
+    memcpy(this->geometries.data(), geometries.data(), sizeof(GPRTGeom *) * geometries.size());
+
+    AABBOffsets.resize(geometries.size() + 1);
+    // Placeholder. The actual allocation here will vary from build to build.
+    AABBs = gprtDeviceBufferCreate<float3>((GPRTContext) context, 1, nullptr);
+  };
+
+  ~CurveAccel() {};
+
+  void destroy() {
+    if (AABBs) {
+      gprtBufferDestroy(AABBs);
+      AABBs = nullptr;
+    }
+    Accel::destroy();
+  }
+
+  AccelType getType() { return GPRT_CURVE_ACCEL; }
+
+  void build(GPRTBuildMode buildMode, bool allowCompaction, bool minimizeMemory) {
+    this->buildMode = buildMode;
+
+    accelerationBuildStructureRangeInfos.resize(geometries.size());
+    accelerationBuildStructureRangeInfoPtrs.resize(geometries.size());
+    accelerationStructureGeometries.resize(geometries.size());
+    maxPrimitiveCounts.resize(geometries.size());
+
+    // Do a prefix sum over the segment counts
+    AABBOffsets[0] = 0;
+    for (uint32_t gid = 0; gid < geometries.size(); ++gid) {
+      CurveGeom *curveGeom = (CurveGeom *) geometries[gid];
+      if (curveGeom->vertex.buffer == nullptr || curveGeom->index.buffer == nullptr)
+        LOG_ERROR("curve geometry is missing control points or indices, call gprtCurvesSetVertices and "
+                  "gprtCurvesSetIndices before building!");
+      AABBOffsets[gid + 1] = curveGeom->index.count + AABBOffsets[gid];
+    }
+
+    // Resize the AABB buffer if needed...
+    size_t requiredBytesForAABBs = 2 * sizeof(float3) * AABBOffsets[geometries.size()];
+    if (gprtBufferGetSize(AABBs) != requiredBytesForAABBs) {
+      gprtBufferResize((GPRTContext) context, AABBs, AABBOffsets[geometries.size()] * 2, false);
+    }
+
+    // Now populate the AABB buffer, one AABB per segment
+    auto CurveBounds = (GPRTComputeOf<CurveParameters>) context->internalComputePrograms["CurveBounds"];
+    for (uint32_t gid = 0; gid < geometries.size(); ++gid) {
+      CurveGeom *curveGeom = (CurveGeom *) geometries[gid];
+      CurveParameters params = curveGeom->getParameters();
+      params.aabbs = gprtBufferGetDevicePointer(AABBs);
+      params.offset = AABBOffsets[gid];
+      gprtComputeLaunch(CurveBounds, uint3(((params.count + 255) / 256), 1, 1), uint3(256, 1, 1), params);
+    }
+
+    for (uint32_t gid = 0; gid < geometries.size(); ++gid) {
+      auto &geom = accelerationStructureGeometries[gid];
+      uint32_t numSegments = AABBOffsets[gid + 1] - AABBOffsets[gid];
+
+      geom.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+      geom.flags = VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR;
+      geom.geometryType = VkGeometryTypeKHR::VK_GEOMETRY_TYPE_AABBS_KHR;
+
+      geom.geometry.aabbs.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_AABBS_DATA_KHR;
+      geom.geometry.aabbs.pNext = VK_NULL_HANDLE;
+      geom.geometry.aabbs.stride = 2 * sizeof(float3);
+      geom.geometry.aabbs.data.deviceAddress = (VkDeviceAddress) gprtBufferGetDevicePointer(AABBs);
+
+      auto &geomRange = accelerationBuildStructureRangeInfos[gid];
+      accelerationBuildStructureRangeInfoPtrs[gid] = &accelerationBuildStructureRangeInfos[gid];
+      geomRange.primitiveCount = numSegments;
+      geomRange.primitiveOffset = AABBOffsets[gid] * 2 * sizeof(float3);
+      geomRange.firstVertex = 0;   // unused
+      geomRange.transformOffset = 0;
+
+      maxPrimitiveCounts[gid] = numSegments;
+    }
+
+    innerBuildProc(buildMode, allowCompaction, minimizeMemory);
+  }
+};
+
+// Bounds each triangle over all of its keyframes once, so that the tree stays valid at any time in between. The
+// built-in intersection program then interpolates the triangle to the time of each ray.
+struct MotionTriangleAccel : public Accel {
+  // One AABB per triangle
+  GPRTBufferOf<float3> AABBs = nullptr;
+  std::vector<uint32_t> AABBOffsets;
+
+  MotionTriangleAccel(Context *context, std::vector<MotionTriangleGeom*> geometries) : Accel(context, true) {
+    this->geometries.resize(geometries.size());
+    memcpy(this->geometries.data(), geometries.data(), sizeof(GPRTGeom *) * geometries.size());
+
+    AABBOffsets.resize(geometries.size() + 1);
+    // Placeholder. The actual allocation here will vary from build to build.
+    AABBs = gprtDeviceBufferCreate<float3>((GPRTContext) context, 1, nullptr);
+  };
+
+  ~MotionTriangleAccel() {};
+
+  void destroy() {
+    if (AABBs) {
+      gprtBufferDestroy(AABBs);
+      AABBs = nullptr;
+    }
+    Accel::destroy();
+  }
+
+  AccelType getType() { return GPRT_MOTION_TRIANGLE_ACCEL; }
+
+  void build(GPRTBuildMode buildMode, bool allowCompaction, bool minimizeMemory) {
+    this->buildMode = buildMode;
+
+    accelerationBuildStructureRangeInfos.resize(geometries.size());
+    accelerationBuildStructureRangeInfoPtrs.resize(geometries.size());
+    accelerationStructureGeometries.resize(geometries.size());
+    maxPrimitiveCounts.resize(geometries.size());
+
+    // Do a prefix sum over the triangle counts
+    AABBOffsets[0] = 0;
+    for (uint32_t gid = 0; gid < geometries.size(); ++gid) {
+      MotionTriangleGeom *motionGeom = (MotionTriangleGeom *) geometries[gid];
+      if (motionGeom->vertex.buffers.empty() || motionGeom->index.buffer == nullptr)
+        LOG_ERROR("motion triangle geometry is missing keyframes or indices, call gprtTrianglesSetMotionVertices and "
+                  "gprtTrianglesSetIndices before building!");
+      AABBOffsets[gid + 1] = motionGeom->index.count + AABBOffsets[gid];
+    }
+
+    // Resize the AABB buffer if needed...
+    size_t requiredBytesForAABBs = 2 * sizeof(float3) * AABBOffsets[geometries.size()];
+    if (gprtBufferGetSize(AABBs) != requiredBytesForAABBs) {
+      gprtBufferResize((GPRTContext) context, AABBs, AABBOffsets[geometries.size()] * 2, false);
+    }
+
+    // Now populate the AABB buffer, one AABB per triangle covering every keyframe
+    auto MotionTriangleBounds =
+        (GPRTComputeOf<MotionTriangleParameters>) context->internalComputePrograms["MotionTriangleBounds"];
+    for (uint32_t gid = 0; gid < geometries.size(); ++gid) {
+      MotionTriangleGeom *motionGeom = (MotionTriangleGeom *) geometries[gid];
+      MotionTriangleParameters params = motionGeom->getParameters();
+      motionGeom->uploadKeys();
+      params.aabbs = gprtBufferGetDevicePointer(AABBs);
+      params.offset = AABBOffsets[gid];
+      gprtComputeLaunch(MotionTriangleBounds, uint3(((params.count + 255) / 256), 1, 1), uint3(256, 1, 1), params);
+    }
+
+    for (uint32_t gid = 0; gid < geometries.size(); ++gid) {
+      auto &geom = accelerationStructureGeometries[gid];
+      uint32_t numTriangles = AABBOffsets[gid + 1] - AABBOffsets[gid];
+
+      geom.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+      geom.flags = VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR;
+      geom.geometryType = VkGeometryTypeKHR::VK_GEOMETRY_TYPE_AABBS_KHR;
+
+      geom.geometry.aabbs.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_AABBS_DATA_KHR;
+      geom.geometry.aabbs.pNext = VK_NULL_HANDLE;
+      geom.geometry.aabbs.stride = 2 * sizeof(float3);
+      geom.geometry.aabbs.data.deviceAddress = (VkDeviceAddress) gprtBufferGetDevicePointer(AABBs);
+
+      auto &geomRange = accelerationBuildStructureRangeInfos[gid];
+      accelerationBuildStructureRangeInfoPtrs[gid] = &accelerationBuildStructureRangeInfos[gid];
+      geomRange.primitiveCount = numTriangles;
+      geomRange.primitiveOffset = AABBOffsets[gid] * 2 * sizeof(float3);
+      geomRange.firstVertex = 0;   // unused
+      geomRange.transformOffset = 0;
+
+      maxPrimitiveCounts[gid] = numTriangles;
+    }
+
+    innerBuildProc(buildMode, allowCompaction, minimizeMemory);
+  }
+};
+
 struct AABBAccel : public Accel {
   AABBAccel(Context *context, std::vector<AABBGeom*> geometries) : Accel(context, true) {
     this->geometries.resize(geometries.size());
@@ -4264,7 +5456,7 @@ struct InstanceAccel : public Accel {
     //   if (context->accels[i]->getType() == GPRT_INSTANCE_ACCEL) {
     //     InstanceAccel *instanceAccel = (InstanceAccel *) context->accels[i];
     //     size_t numGeometry = instanceAccel->getNumGeometries();
-    //     instanceOffset += numGeometry * requestedFeatures.numRayTypes;
+    //     instanceOffset += numGeometry * context->features.numRayTypes;
     //   }
     // }
 
@@ -4275,7 +5467,7 @@ struct InstanceAccel : public Accel {
     // int blasOffsetWithinCurrentTLAS = 0;
     // for (uint32_t i = 0; i < numInstances; ++i) {
     //   gprt::Instance *instance = &((gprt::Instance *) instancesBuffer->mapped)[i];
-    //   instance->__gprtSBTOffset = i * requestedFeatures.numRayTypes;
+    //   instance->__gprtSBTOffset = i * context->features.numRayTypes;
       // instanceOffset + blasOffsetWithinCurrentTLAS;
       // if (instance->__gprtAccelAddress != 0) {
       //   Accel *accel = context->accels[instance->__gprtInstanceIndex];
@@ -4283,7 +5475,7 @@ struct InstanceAccel : public Accel {
         // for now, this works. Eventually I'd like this to act more like a lookup / prefix sum...
         // int numGeometriesInAccel = accel->geometries.size();
         // numGeometriesInTLAS += accel->geometries.size();
-        // blasOffsetWithinCurrentTLAS += numGeometriesInAccel * requestedFeatures.numRayTypes;
+        // blasOffsetWithinCurrentTLAS += numGeometriesInAccel * context->features.numRayTypes;
       // }
     // }
     // instancesBuffer->unmap();
@@ -4345,12 +5537,13 @@ Context::getNumHitRecords() {
     }
   }
 
-  int numHitRecords = totalGeometries * requestedFeatures.numRayTypes;
+  int numHitRecords = totalGeometries * features.numRayTypes;
   return numHitRecords;
 }
 
 void
 Context::buildSBT(GPRTBuildSBTFlags flags) {
+  counters.sbtBuilds++;
   auto alignedSize = [](uint32_t value, uint32_t alignment) -> uint32_t {
     return (value + alignment - 1) & ~(alignment - 1);
   };
@@ -4448,15 +5641,21 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
           shaderGroupType = VK_RAY_TRACING_SHADER_GROUP_TYPE_PROCEDURAL_HIT_GROUP_KHR;
         else if (geomType->getKind() == GPRT_SOLIDS)
           shaderGroupType = VK_RAY_TRACING_SHADER_GROUP_TYPE_PROCEDURAL_HIT_GROUP_KHR;
+        else if (geomType->getKind() == GPRT_VOXELS)
+          shaderGroupType = VK_RAY_TRACING_SHADER_GROUP_TYPE_PROCEDURAL_HIT_GROUP_KHR;
+        else if (geomType->getKind() == GPRT_CURVES)
+          shaderGroupType = VK_RAY_TRACING_SHADER_GROUP_TYPE_PROCEDURAL_HIT_GROUP_KHR;
+        else if (geomType->getKind() == GPRT_MOTION_TRIANGLES)
+          shaderGroupType = VK_RAY_TRACING_SHADER_GROUP_TYPE_PROCEDURAL_HIT_GROUP_KHR;
         else if (geomType->getKind() == GPRT_LSS) {
-          if (requestedFeatures.linearSweptSpheres) {
+          if (features.linearSweptSpheres) {
             shaderGroupType = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_NV;   // ?
           } else {
             // AABB fallback
             shaderGroupType = VK_RAY_TRACING_SHADER_GROUP_TYPE_PROCEDURAL_HIT_GROUP_KHR;
           }
         } else if (geomType->getKind() == GPRT_SPHERES) {
-          if (requestedFeatures.linearSweptSpheres) {
+          if (features.linearSweptSpheres) {
             shaderGroupType = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_NV;   // ?
           } else {
             // AABB fallback
@@ -4466,7 +5665,7 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
           LOG_ERROR("Unsupported geometry type found.");
         }
 
-        for (uint32_t rayType = 0; rayType < requestedFeatures.numRayTypes; ++rayType) {
+        for (uint32_t rayType = 0; rayType < features.numRayTypes; ++rayType) {
           VkRayTracingShaderGroupCreateInfoKHR shaderGroup{};
           shaderGroup.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
           shaderGroup.type = shaderGroupType;
@@ -4503,47 +5702,75 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
       */
       VkRayTracingPipelineInterfaceCreateInfoKHR pipelineInterfaceCreateInfo{};
       pipelineInterfaceCreateInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_INTERFACE_CREATE_INFO_KHR;
-      pipelineInterfaceCreateInfo.maxPipelineRayPayloadSize = requestedFeatures.maxRayPayloadSize;
-      pipelineInterfaceCreateInfo.maxPipelineRayHitAttributeSize = requestedFeatures.maxRayHitAttributeSize;
+      pipelineInterfaceCreateInfo.maxPipelineRayPayloadSize = features.maxRayPayloadSize;
+      pipelineInterfaceCreateInfo.maxPipelineRayHitAttributeSize = features.maxRayHitAttributeSize;
+
+      VkPipelineCreateFlags pipelineFlags = 0;
+      if (features.pipelineStatistics)
+        pipelineFlags |= VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR;
 
       void* pNext = nullptr;
       #ifdef VK_NV_ray_tracing_linear_swept_spheres
-      if (requestedFeatures.linearSweptSpheres) {
-        VkPipelineCreateFlags2CreateInfo pipelineCreateFlags;
+      // Flags 2 replace the flags of the create info, so they carry the statistics flag as well
+      VkPipelineCreateFlags2CreateInfo pipelineCreateFlags{};
+      if (features.linearSweptSpheres) {
         pipelineCreateFlags.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATE_FLAGS_2_CREATE_INFO;
         pipelineCreateFlags.flags = VK_PIPELINE_CREATE_2_RAY_TRACING_ALLOW_SPHERES_AND_LINEAR_SWEPT_SPHERES_BIT_NV ;
+        if (features.pipelineStatistics)
+          pipelineCreateFlags.flags |= VK_PIPELINE_CREATE_2_CAPTURE_STATISTICS_BIT_KHR;
         pipelineCreateFlags.pNext = nullptr;
         pNext = &pipelineCreateFlags;
       }
       #endif
 
+      // Hand every stage the address of the ray time slot, which TraceMotionRay and the motion triangle
+      // intersection program read from
+      uint32_t rayTimeSlotAddress[2] = {0, 0};
+      VkSpecializationMapEntry rayTimeSlotEntries[2] = {
+          {GPRT_RAY_TIME_SLOT_CONSTANT_ID_LO, 0, sizeof(uint32_t)},
+          {GPRT_RAY_TIME_SLOT_CONSTANT_ID_HI, sizeof(uint32_t), sizeof(uint32_t)}};
+      VkSpecializationInfo rayTimeSlotInfo = {2, rayTimeSlotEntries, sizeof(rayTimeSlotAddress), rayTimeSlotAddress};
+      if (rayTimeSlot) {
+        uint64_t address = rayTimeSlot->getDeviceAddress();
+        rayTimeSlotAddress[0] = uint32_t(address);
+        rayTimeSlotAddress[1] = uint32_t(address >> 32);
+        for (auto &shaderStage : shaderStages)
+          shaderStage.pSpecializationInfo = &rayTimeSlotInfo;
+      }
+
       VkRayTracingPipelineCreateInfoKHR rayTracingPipelineCI{};
       rayTracingPipelineCI.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR;
+      rayTracingPipelineCI.flags = pipelineFlags;
       rayTracingPipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
       rayTracingPipelineCI.pStages = shaderStages.data();
       rayTracingPipelineCI.groupCount = static_cast<uint32_t>(shaderGroups.size());
       rayTracingPipelineCI.pGroups = shaderGroups.data();
-      rayTracingPipelineCI.maxPipelineRayRecursionDepth = requestedFeatures.rayRecursionDepth;
+      rayTracingPipelineCI.maxPipelineRayRecursionDepth = features.rayRecursionDepth;
       rayTracingPipelineCI.layout = raytracingPipelineLayout;
       rayTracingPipelineCI.pLibraryInterface = &pipelineInterfaceCreateInfo;
       rayTracingPipelineCI.pNext = pNext;
 
       LOG_INFO("Creating VkRayTracingPipelineCreateInfoKHR with max recursion depth of " +
-               std::to_string(requestedFeatures.rayRecursionDepth) + ".");
+               std::to_string(features.rayRecursionDepth) + ".");
 
       if (raytracingPipeline != VK_NULL_HANDLE) {
         vkDestroyPipeline(logicalDevice, raytracingPipeline, nullptr);
         raytracingPipeline = VK_NULL_HANDLE;
       }
-      VkResult err = gprt::vkCreateRayTracingPipelines(logicalDevice, VK_NULL_HANDLE, VK_NULL_HANDLE, 1,
-                                                       &rayTracingPipelineCI, nullptr, &raytracingPipeline);
+      VkResult err = vkCreateRayTracingPipelines(logicalDevice, VK_NULL_HANDLE, VK_NULL_HANDLE, 1,
+                                                 &rayTracingPipelineCI, nullptr, &raytracingPipeline);
       if (err) {
         LOG_ERROR("failed to create ray tracing pipeline! Are all entrypoint names correct? \n" + errorString(err));
       }
+
+      shaderStageNames.clear();
+      for (auto &shaderStage : shaderStages)
+        shaderStageNames.push_back(shaderStage.pName);
     }
 
     // Mark our ray tracing pipeline as "updated".
     raytracingPipelineOutOfDate = false;
+    counters.pipelineRebuilds++;
   }
 
   const uint32_t handleSize = rayTracingPipelineProperties.shaderGroupHandleSize;
@@ -4551,28 +5778,28 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
   const uint32_t groupAlignment = rayTracingPipelineProperties.shaderGroupHandleAlignment;
   const uint32_t maxShaderRecordStride = rayTracingPipelineProperties.maxShaderGroupStride;
 
-  if (requestedFeatures.hitRecordSize > maxGroupSize) {
+  if (features.hitRecordSize > maxGroupSize) {
     LOG_ERROR("Requested hit record size is too large! Max record size for this platform is " +
               std::to_string(maxGroupSize) + " bytes.");
   }
-  if (requestedFeatures.raygenRecordSize > maxGroupSize) {
+  if (features.raygenRecordSize > maxGroupSize) {
     LOG_ERROR("Requested raygen record size is too large! Max record size for this platform is " +
               std::to_string(maxGroupSize) + " bytes.");
   }
-  if (requestedFeatures.missRecordSize > maxGroupSize) {
+  if (features.missRecordSize > maxGroupSize) {
     LOG_ERROR("Requested miss record size is too large! Max record size for this platform is " +
               std::to_string(maxGroupSize) + " bytes.");
   }
-  if (requestedFeatures.callableRecordSize> maxGroupSize) {
+  if (features.callableRecordSize> maxGroupSize) {
     LOG_ERROR("Requested callable record size is too large! Max record size for this platform is " +
               std::to_string(maxGroupSize) + " bytes.");
   }
 
   // Doubling the record size to allow GPRT to store internal facing data
-  const uint32_t raygenRecordSize = alignedSize(std::min(maxGroupSize, requestedFeatures.raygenRecordSize + requestedFeatures.internalAdditionalSize), groupAlignment);
-  const uint32_t hitRecordSize = alignedSize(std::min(maxGroupSize, requestedFeatures.hitRecordSize + requestedFeatures.internalAdditionalSize), groupAlignment);
-  const uint32_t missRecordSize = alignedSize(std::min(maxGroupSize, requestedFeatures.missRecordSize + requestedFeatures.internalAdditionalSize), groupAlignment);
-  const uint32_t callableRecordSize = alignedSize(std::min(maxGroupSize, requestedFeatures.callableRecordSize + requestedFeatures.internalAdditionalSize), groupAlignment);
+  const uint32_t raygenRecordSize = alignedSize(std::min(maxGroupSize, features.raygenRecordSize + features.internalAdditionalSize), groupAlignment);
+  const uint32_t hitRecordSize = alignedSize(std::min(maxGroupSize, features.hitRecordSize + features.internalAdditionalSize), groupAlignment);
+  const uint32_t missRecordSize = alignedSize(std::min(maxGroupSize, features.missRecordSize + features.internalAdditionalSize), groupAlignment);
+  const uint32_t callableRecordSize = alignedSize(std::min(maxGroupSize, features.callableRecordSize + features.internalAdditionalSize), groupAlignment);
 
   // Check here to confirm we really do have ray tracing programs. With raster support, sometimes
   // we might only have raster programs, and no RT programs.
@@ -4581,8 +5808,8 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
     const uint32_t sbtSize = groupCount * handleSize;
 
     std::vector<uint8_t> shaderHandleStorage(sbtSize);
-    VkResult err = gprt::vkGetRayTracingShaderGroupHandles(logicalDevice, raytracingPipeline, 0, groupCount, sbtSize,
-                                                           shaderHandleStorage.data());
+    VkResult err = vkGetRayTracingShaderGroupHandles(logicalDevice, raytracingPipeline, 0, groupCount, sbtSize,
+                                                     shaderHandleStorage.data());
     if (err)
       LOG_ERROR("failed to get ray tracing shader group handles! : \n" + errorString(err));
 
@@ -4613,6 +5840,7 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
       raygenTable = nullptr;
     }
     if (!raygenTable && raygens.size() > 0) {
+      counters.sbtReallocations++;
       raygenTable =
           new Buffer(this, bufferUsageFlags,
                      memoryUsageFlags, raygenRecordSize * numRayGens, rayTracingPipelineProperties.shaderGroupBaseAlignment);
@@ -4626,6 +5854,7 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
       missTable = nullptr;
     }
     if (!missTable && misses.size() > 0) {
+      counters.sbtReallocations++;
       missTable = new Buffer(this, bufferUsageFlags,
                              memoryUsageFlags, missRecordSize * numMissProgs,
                              rayTracingPipelineProperties.shaderGroupBaseAlignment);
@@ -4639,6 +5868,7 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
       callableTable = nullptr;
     }
     if (!callableTable && callables.size() > 0) {
+      counters.sbtReallocations++;
       callableTable = new Buffer(this,
                                  bufferUsageFlags, memoryUsageFlags, callableRecordSize * numCallableProgs,
                                  rayTracingPipelineProperties.shaderGroupBaseAlignment);
@@ -4652,6 +5882,7 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
       hitgroupTable = nullptr;
     }
     if (!hitgroupTable && numHitRecords > 0) {
+      counters.sbtReallocations++;
       hitgroupTable = new Buffer(this,
                                  bufferUsageFlags, memoryUsageFlags, hitRecordSize * numHitRecords,
                                  rayTracingPipelineProperties.shaderGroupBaseAlignment);
@@ -4759,15 +5990,15 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
               for (uint32_t geomID = 0; geomID < blas->geometries.size(); ++geomID) {
                 auto &geom = blas->geometries[geomID];
 
-                for (uint32_t rayType = 0; rayType < requestedFeatures.numRayTypes; ++rayType) {
+                for (uint32_t rayType = 0; rayType < features.numRayTypes; ++rayType) {
                   size_t recordStride = hitRecordSize;
                   size_t handleStride = handleSize;
 
                   // First, copy handle
                   size_t recordOffset =
-                      recordStride * (rayType + requestedFeatures.numRayTypes * geomID + instance.__gprtSBTOffset);
+                      recordStride * (rayType + features.numRayTypes * geomID + instance.__gprtSBTOffset);
                   size_t handleOffset =
-                      handleStride * (geom->geomType->address * requestedFeatures.numRayTypes + rayType) +
+                      handleStride * (geom->geomType->address * features.numRayTypes + rayType) +
                       handleStride * (numRayGens + numMissProgs + numCallableProgs);
                   memcpy(mapped + recordOffset, shaderHandleStorage.data() + handleOffset, handleSize);
 
@@ -4777,8 +6008,8 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
                   memcpy(params, geom->SBTRecord, geom->recordSize);
 
                   // If implementing a software fallback, additionally memcpy data required for intersection testing
-                  uint8_t *internalParams = params + (requestedFeatures.hitRecordSize);
-                  if (geom->geomType->getKind() == GPRT_LSS && !requestedFeatures.linearSweptSpheres) {
+                  uint8_t *internalParams = params + (features.hitRecordSize);
+                  if (geom->geomType->getKind() == GPRT_LSS && !features.linearSweptSpheres) {
                     LSSGeom *lss = (LSSGeom *) geom;
                     LSSParameters isectParams;
                     isectParams.vertices = (float4 *) lss->vertex.buffers[0]->getDeviceAddress();
@@ -4790,7 +6021,7 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
                     memcpy(internalParams, &isectParams, sizeof(LSSParameters));
                   }
 
-                  if (geom->geomType->getKind() == GPRT_SPHERES && !requestedFeatures.linearSweptSpheres) {
+                  if (geom->geomType->getKind() == GPRT_SPHERES && !features.linearSweptSpheres) {
                     SphereGeom *s = (SphereGeom *) geom;
                     SphereParameters isectParams;
                     isectParams.vertices = (float4 *) s->vertex.buffers[0]->getDeviceAddress();
@@ -4800,7 +6031,7 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
 
                   if (geom->geomType->getKind() == GPRT_SOLIDS) {
                     SolidGeom *solidGeom = (SolidGeom *) geom;
-                    SolidParameters params;
+                    SolidParameters params = {};
                     params.vertices = (float4 *) solidGeom->vertex.buffers[0]->getDeviceAddress();
                     params.indices = (uint4 *) solidGeom->index.buffer->getDeviceAddress();
                     params.types = (uint8_t *) solidGeom->types.buffer->getDeviceAddress();
@@ -4810,8 +6041,30 @@ Context::buildSBT(GPRTBuildSBTFlags flags) {
                     params.indicesStride = solidGeom->index.stride;
                     params.typesOffset = solidGeom->types.offset;
                     params.typesStride = solidGeom->types.stride;
+                    if (solidGeom->valueFilter && blas->getType() == GPRT_SOLID_ACCEL) {
+                      // The filter compares against the value ranges stored with the accel's bounds
+                      SolidAccel *solidAccel = (SolidAccel *) blas;
+                      params.aabbs = gprtBufferGetDevicePointer(solidAccel->AABBs);
+                      params.offset = solidAccel->AABBOffsets[geomID];
+                      params.filter = (gprt::SolidValueFilter *) solidGeom->valueFilter->getDeviceAddress();
+                    }
                     memcpy(internalParams, &params, sizeof(SolidParameters));
                   }
+
+                  if (geom->geomType->getKind() == GPRT_VOXELS) {
+                    VoxelParameters params = ((VoxelGeom *) geom)->getParameters();
+                    memcpy(internalParams, &params, sizeof(VoxelParameters));
+                  }
+
+                  if (geom->geomType->getKind() == GPRT_CURVES) {
+                    CurveParameters params = ((CurveGeom *) geom)->getParameters();
+                    memcpy(internalParams, &params, sizeof(CurveParameters));
+                  }
+
+                  if (geom->geomType->getKind() == GPRT_MOTION_TRIANGLES) {
+                    MotionTriangleParameters params = ((MotionTriangleGeom *) geom)->getParameters();
+                    memcpy(internalParams, &params, sizeof(MotionTriangleParameters));
+                  }
                 }
               }
             } else {
@@ -4858,6 +6111,24 @@ Context::destroy() {
     imgui.frameBuffer = nullptr;
   }
 
+  setVisibilitySize(0, 0);
+  if (visibility.pipeline) {
+    vkDestroyPipeline(logicalDevice, visibility.pipeline, nullptr);
+    visibility.pipeline = VK_NULL_HANDLE;
+  }
+  if (visibility.pipelineLayout) {
+    vkDestroyPipelineLayout(logicalDevice, visibility.pipelineLayout, nullptr);
+    visibility.pipelineLayout = VK_NULL_HANDLE;
+  }
+  if (visibility.renderPass) {
+    vkDestroyRenderPass(logicalDevice, visibility.renderPass, nullptr);
+    visibility.renderPass = VK_NULL_HANDLE;
+  }
+  if (visibility.shaderModule) {
+    vkDestroyShaderModule(logicalDevice, visibility.shaderModule, nullptr);
+    visibility.shaderModule = VK_NULL_HANDLE;
+  }
+
   if (imageAvailableSemaphore) {
     vkDestroySemaphore(logicalDevice, imageAvailableSemaphore, nullptr);
     imageAvailableSemaphore = nullptr;
@@ -4878,9 +6149,13 @@ Context::destroy() {
   }
   if (window) {
     glfwDestroyWindow(window);
-    glfwTerminate();
     window = nullptr;
   }
+  if (features.window) {
+    std::lock_guard<std::mutex> lock(contextCreationMutex);
+    if (--numGlfwContexts == 0)
+      glfwTerminate();
+  }
   if (surface) {
     vkDestroySurfaceKHR(instance, surface, nullptr);
     surface = nullptr;
@@ -4925,6 +6200,13 @@ Context::destroy() {
     delete hitgroupTable;
     hitgroupTable = nullptr;
   }
+  for (Buffer **buffer : {&compressedStream, &compressedScratch, &compressedReadback, &rayTimeSlot, &rayTimes}) {
+    if (*buffer) {
+      (*buffer)->destroy();
+      delete *buffer;
+      *buffer = nullptr;
+    }
+  }
 
   descriptorPoolSize = {};
 
@@ -4950,6 +6232,26 @@ Context::destroy() {
   }
   accels.resize(0);
 
+  // Pooled buffers go first, since they alias the blocks owned by their pools
+  for (uint32_t i = 0; i < buffers.size(); ++i) {
+    Buffer *buffer = buffers[i];
+    if (buffer != nullptr && buffer->pool != nullptr) {
+      buffer->destroy();
+      delete buffer;
+    }
+  }
+  // Pools remove themselves from these lists when destroyed
+  while (!bufferPools.empty()) {
+    BufferPool *pool = bufferPools.back();
+    pool->destroy();
+    delete pool;
+  }
+  while (!transientPools.empty()) {
+    TransientPool *pool = transientPools.back();
+    pool->destroy();
+    delete pool;
+  }
+
   for (uint32_t i = 0; i < buffers.size(); ++i) {
     if (buffers[i] != nullptr) {
       buffers[i]->destroy();
@@ -4963,6 +6265,8 @@ Context::destroy() {
     }
   }
   imageResources.resize(0);
+  freeImageResourceAddresses.clear();
+  pendingDescriptorWrites.clear();
 
   for (uint32_t i = 0; i < computes.size(); ++i) {
     if (computes[i] != nullptr) {
@@ -4998,15 +6302,15 @@ Context::destroy() {
   vkDestroyQueryPool(logicalDevice, compactedSizeQueryPool, nullptr);
   vkDestroyDevice(logicalDevice, nullptr);
 
-  if (requestedFeatures.debugPrintf)
+  if (features.debugPrintf)
     freeDebugCallback(instance);
   vkDestroyInstance(instance, nullptr);
 }
 
 void
 Context::freeDebugCallback(VkInstance instance) {
-  if (gprt::debugUtilsMessenger != VK_NULL_HANDLE) {
-    gprt::vkDestroyDebugUtilsMessengerEXT(instance, gprt::debugUtilsMessenger, nullptr);
+  if (debugUtilsMessenger != VK_NULL_HANDLE) {
+    vkDestroyDebugUtilsMessengerEXT(instance, debugUtilsMessenger, nullptr);
   }
 }
 
@@ -5043,7 +6347,9 @@ void Context::enumerateInstanceExtensions()
   }
 }
 
-Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
+Context::Context(const RequestedFeatures &_features, int32_t *requestedDeviceIDs, int numRequestedDevices)
+    : features(_features) {
+  std::lock_guard<std::mutex> lock(contextCreationMutex);
   enumerateInstanceValidationLayers();
   enumerateInstanceExtensions();
 
@@ -5086,7 +6392,7 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
   instanceCreateInfo.pApplicationInfo = &appInfo;
   // instanceCreateInfo.pNext = VK_NULL_HANDLE;
 
-  if (requestedFeatures.debugPrintf) {
+  if (features.debugPrintf) {
     instanceCreateInfo.pNext = &validationFeatures;
   } else {
     LOG_WARNING("Debug printf disabled");
@@ -5095,11 +6401,12 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
 
   uint32_t glfwExtensionCount = 0;
   const char **glfwExtensions;
-  if (requestedFeatures.window) {
+  if (features.window) {
     if (!glfwInit()) {
       LOG_WARNING("Unable to create window. Falling back to headless mode.");
-      requestedFeatures.window = false;
+      features.window = false;
     } else {
+      ++numGlfwContexts;
       if (!glfwVulkanSupported()) {
         LOG_ERROR("Window requested but unsupported!");
       }
@@ -5115,7 +6422,7 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
 #endif
 
   // Useful to disable, since some profiling tools don't support this.
-  if (requestedFeatures.debugPrintf) {
+  if (features.debugPrintf) {
     instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
   }
 
@@ -5128,7 +6435,7 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
   const char *layerNames[1] = {"VK_LAYER_KHRONOS_validation"};
   instanceCreateInfo.ppEnabledLayerNames = &layerNames[0];
 
-  if (requestedFeatures.debugPrintf) {
+  if (features.debugPrintf) {
     // Todo, look and see if any profiling layers might be active. If so, we should disable printf.
     if (std::find(supportedInstanceLayerNames.begin(), supportedInstanceLayerNames.end(), layerNames[0]) ==
         supportedInstanceLayerNames.end()) {
@@ -5148,13 +6455,13 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
   }
 
   /// 1.5 - create a window and surface if requested
-  if (requestedFeatures.window) {
+  if (features.window) {
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
     // todo, allow the window to resize and recreate swapchain
     glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-    window = glfwCreateWindow(requestedFeatures.windowProperties.initialWidth,
-                              requestedFeatures.windowProperties.initialHeight,
-                              requestedFeatures.windowProperties.title.c_str(), NULL, NULL);
+    window = glfwCreateWindow(features.windowProperties.initialWidth,
+                              features.windowProperties.initialHeight,
+                              features.windowProperties.title.c_str(), NULL, NULL);
 
     VkResult err = glfwCreateWindowSurface(instance, window, nullptr, &surface);
     if (err != VK_SUCCESS) {
@@ -5165,10 +6472,10 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
   }
 
   // Setup debug printf callback
-  if (requestedFeatures.debugPrintf) {
-    gprt::vkCreateDebugUtilsMessengerEXT = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(
+  if (features.debugPrintf) {
+    vkCreateDebugUtilsMessengerEXT = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(
         vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT"));
-    gprt::vkDestroyDebugUtilsMessengerEXT = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(
+    vkDestroyDebugUtilsMessengerEXT = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(
         vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT"));
 
     VkDebugUtilsMessengerCreateInfoEXT debugUtilsMessengerCI{};
@@ -5183,7 +6490,7 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
         VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
     debugUtilsMessengerCI.pfnUserCallback = debugUtilsMessengerCallback;
     VkResult result =
-        gprt::vkCreateDebugUtilsMessengerEXT(instance, &debugUtilsMessengerCI, nullptr, &gprt::debugUtilsMessenger);
+        vkCreateDebugUtilsMessengerEXT(instance, &debugUtilsMessengerCI, nullptr, &debugUtilsMessenger);
     assert(result == VK_SUCCESS);
   }
 
@@ -5231,7 +6538,7 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
     bool lss = false;
   };
 
-  auto checkDeviceExtensionSupport = [](VkPhysicalDevice device, std::vector<const char *> deviceExtensions, FallbackRequests &fallbackRequests) -> bool {
+  auto checkDeviceExtensionSupport = [this](VkPhysicalDevice device, std::vector<const char *> deviceExtensions, FallbackRequests &fallbackRequests) -> bool {
     uint32_t extensionCount;
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
 
@@ -5247,7 +6554,7 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
       requiredExtensions.erase(extension.extensionName);
     }
 
-    if (requestedFeatures.linearSweptSpheres) {
+    if (features.linearSweptSpheres) {
       if (requiredExtensions.find(VK_NV_RAY_TRACING_LINEAR_SWEPT_SPHERES_EXTENSION_NAME) != requiredExtensions.end()) {
         if (requiredExtensions.find(VK_NV_RAY_TRACING_EXTENSION_NAME) == requiredExtensions.end()) {
           requiredExtensions.erase(VK_NV_RAY_TRACING_LINEAR_SWEPT_SPHERES_EXTENSION_NAME);
@@ -5296,28 +6603,28 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
   // Required for floating point atomics
   enabledDeviceExtensions.push_back(VK_EXT_SHADER_ATOMIC_FLOAT_EXTENSION_NAME);
 
-  if (requestedFeatures.window) {
+  if (features.window) {
     // If the device will be used for presenting to a display via a swapchain
     // we need to request the swapchain extension
     enabledDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
   }
 
-  if (requestedFeatures.rayQueries) {
+  if (features.rayQueries) {
     // If the device will be using ray queries for inline ray tracing,
     // we need to explicitly request this.
     enabledDeviceExtensions.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
   }
 
-  if (requestedFeatures.invocationReordering) {
+  if (features.invocationReordering) {
     enabledDeviceExtensions.push_back(VK_NV_RAY_TRACING_INVOCATION_REORDER_EXTENSION_NAME);
   }
 
-  if (requestedFeatures.linearSweptSpheres) {
+  if (features.linearSweptSpheres) {
     #ifdef VK_NV_ray_tracing_linear_swept_spheres
     enabledDeviceExtensions.push_back(VK_NV_RAY_TRACING_LINEAR_SWEPT_SPHERES_EXTENSION_NAME);
     #else
     LOG_WARNING("Hardware acceleration for LSS unavailable. Using software fallback.");
-    requestedFeatures.linearSweptSpheres = false;
+    features.linearSweptSpheres = false;
     #endif
   }
 
@@ -5380,7 +6687,7 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
       LOG_INFO("Selecting first usable device");
       if (usableDeviceFallbackRequests[0].lss ) {
         LOG_WARNING("Hardware acceleration for LSS unavailable. Using software fallback.");
-        requestedFeatures.linearSweptSpheres = false;
+        features.linearSweptSpheres = false;
         enabledDeviceExtensions.erase(
             std::remove(enabledDeviceExtensions.begin(), enabledDeviceExtensions.end(), std::string(VK_NV_RAY_TRACING_LINEAR_SWEPT_SPHERES_EXTENSION_NAME)),
             enabledDeviceExtensions.end()
@@ -5455,8 +6762,8 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
 
   invocationReorderFeatures = {};
   invocationReorderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_INVOCATION_REORDER_FEATURES_NV;
-  if (requestedFeatures.rayQueries) {
-    // invocationReorderFeatures.rayTracingInvocationReorder = requestedFeatures.invocationReordering;
+  if (features.rayQueries) {
+    // invocationReorderFeatures.rayTracingInvocationReorder = features.invocationReordering;
     invocationReorderFeatures.pNext = pNext;
     pNext = &invocationReorderFeatures;
   }
@@ -5464,7 +6771,7 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
   #ifdef VK_NV_ray_tracing_linear_swept_spheres
   linearSweptSpheresFeatures = {};
   linearSweptSpheresFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_LINEAR_SWEPT_SPHERES_FEATURES_NV;
-  if (requestedFeatures.linearSweptSpheres) {
+  if (features.linearSweptSpheres) {
     linearSweptSpheresFeatures.pNext = pNext;
     pNext = &linearSweptSpheresFeatures;
   }
@@ -5482,8 +6789,8 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
 
   rtQueryFeatures = {};
   rtQueryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR;
-  if (requestedFeatures.rayQueries) {
-    // rtQueryFeatures.rayQuery = requestedFeatures.rayQueries;
+  if (features.rayQueries) {
+    // rtQueryFeatures.rayQuery = features.rayQueries;
     rtQueryFeatures.pNext = pNext;
     pNext = &rtQueryFeatures;
   }
@@ -5530,6 +6837,27 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
     }
   }
 
+  if (features.pipelineStatistics) {
+    pipelineExecutablePropertiesFeatures = {};
+    pipelineExecutablePropertiesFeatures.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_EXECUTABLE_PROPERTIES_FEATURES_KHR;
+    if (extensionSupported(VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME, supportedExtensions)) {
+      VkPhysicalDeviceFeatures2 query{};
+      query.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+      query.pNext = &pipelineExecutablePropertiesFeatures;
+      vkGetPhysicalDeviceFeatures2(physicalDevice, &query);
+    }
+    if (pipelineExecutablePropertiesFeatures.pipelineExecutableInfo) {
+      enabledDeviceExtensions.push_back(VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME);
+      pipelineExecutablePropertiesFeatures.pNext = deviceFeatures2.pNext;
+      deviceFeatures2.pNext = &pipelineExecutablePropertiesFeatures;
+    } else {
+      LOG_WARNING("Pipeline statistics unavailable, \"" VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME
+                  "\" is not supported. Only stack sizes will be reported.");
+      features.pipelineStatistics = false;
+    }
+  }
+
   // Now, create the logical device and all requested queues
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos{};
   // Get queue family indices for the requested queue family types
@@ -5683,33 +7011,43 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
 
   // Get the ray tracing and acceleration structure related function pointers
   // required by this sample
-  gprt::vkGetBufferDeviceAddress = reinterpret_cast<PFN_vkGetBufferDeviceAddressKHR>(
+  vkGetBufferDeviceAddress = reinterpret_cast<PFN_vkGetBufferDeviceAddressKHR>(
       vkGetDeviceProcAddr(logicalDevice, "vkGetBufferDeviceAddressKHR"));
-  gprt::vkCmdBuildAccelerationStructures = reinterpret_cast<PFN_vkCmdBuildAccelerationStructuresKHR>(
+  vkCmdBuildAccelerationStructures = reinterpret_cast<PFN_vkCmdBuildAccelerationStructuresKHR>(
       vkGetDeviceProcAddr(logicalDevice, "vkCmdBuildAccelerationStructuresKHR"));
-  gprt::vkCmdCopyAccelerationStructure = reinterpret_cast<PFN_vkCmdCopyAccelerationStructureKHR>(
+  vkCmdCopyAccelerationStructure = reinterpret_cast<PFN_vkCmdCopyAccelerationStructureKHR>(
       vkGetDeviceProcAddr(logicalDevice, "vkCmdCopyAccelerationStructureKHR"));
-  gprt::vkBuildAccelerationStructures = reinterpret_cast<PFN_vkBuildAccelerationStructuresKHR>(
+  vkBuildAccelerationStructures = reinterpret_cast<PFN_vkBuildAccelerationStructuresKHR>(
       vkGetDeviceProcAddr(logicalDevice, "vkBuildAccelerationStructuresKHR"));
-  gprt::vkCopyAccelerationStructure = reinterpret_cast<PFN_vkCopyAccelerationStructureKHR>(
+  vkCopyAccelerationStructure = reinterpret_cast<PFN_vkCopyAccelerationStructureKHR>(
       vkGetDeviceProcAddr(logicalDevice, "vkCopyAccelerationStructureKHR"));
-  gprt::vkCreateAccelerationStructure = reinterpret_cast<PFN_vkCreateAccelerationStructureKHR>(
+  vkCreateAccelerationStructure = reinterpret_cast<PFN_vkCreateAccelerationStructureKHR>(
       vkGetDeviceProcAddr(logicalDevice, "vkCreateAccelerationStructureKHR"));
-  gprt::vkDestroyAccelerationStructure = reinterpret_cast<PFN_vkDestroyAccelerationStructureKHR>(
+  vkDestroyAccelerationStructure = reinterpret_cast<PFN_vkDestroyAccelerationStructureKHR>(
       vkGetDeviceProcAddr(logicalDevice, "vkDestroyAccelerationStructureKHR"));
-  gprt::vkGetAccelerationStructureBuildSizes = reinterpret_cast<PFN_vkGetAccelerationStructureBuildSizesKHR>(
+  vkGetAccelerationStructureBuildSizes = reinterpret_cast<PFN_vkGetAccelerationStructureBuildSizesKHR>(
       vkGetDeviceProcAddr(logicalDevice, "vkGetAccelerationStructureBuildSizesKHR"));
-  gprt::vkGetAccelerationStructureDeviceAddress = reinterpret_cast<PFN_vkGetAccelerationStructureDeviceAddressKHR>(
+  vkGetAccelerationStructureDeviceAddress = reinterpret_cast<PFN_vkGetAccelerationStructureDeviceAddressKHR>(
       vkGetDeviceProcAddr(logicalDevice, "vkGetAccelerationStructureDeviceAddressKHR"));
-  gprt::vkCmdTraceRays =
+  vkCmdTraceRays =
       reinterpret_cast<PFN_vkCmdTraceRaysKHR>(vkGetDeviceProcAddr(logicalDevice, "vkCmdTraceRaysKHR"));
-  gprt::vkGetRayTracingShaderGroupHandles = reinterpret_cast<PFN_vkGetRayTracingShaderGroupHandlesKHR>(
+  vkGetRayTracingShaderGroupHandles = reinterpret_cast<PFN_vkGetRayTracingShaderGroupHandlesKHR>(
       vkGetDeviceProcAddr(logicalDevice, "vkGetRayTracingShaderGroupHandlesKHR"));
-  gprt::vkCreateRayTracingPipelines = reinterpret_cast<PFN_vkCreateRayTracingPipelinesKHR>(
+  vkCreateRayTracingPipelines = reinterpret_cast<PFN_vkCreateRayTracingPipelinesKHR>(
       vkGetDeviceProcAddr(logicalDevice, "vkCreateRayTracingPipelinesKHR"));
-  gprt::vkCmdWriteAccelerationStructuresProperties =
+  vkCmdWriteAccelerationStructuresProperties =
       reinterpret_cast<PFN_vkCmdWriteAccelerationStructuresPropertiesKHR>(
           vkGetDeviceProcAddr(logicalDevice, "vkCmdWriteAccelerationStructuresPropertiesKHR"));
+  vkGetRayTracingShaderGroupStackSize = reinterpret_cast<PFN_vkGetRayTracingShaderGroupStackSizeKHR>(
+      vkGetDeviceProcAddr(logicalDevice, "vkGetRayTracingShaderGroupStackSizeKHR"));
+  vkGetRayTracingPipelineStackSize = reinterpret_cast<PFN_vkGetRayTracingPipelineStackSizeKHR>(
+      vkGetDeviceProcAddr(logicalDevice, "vkGetRayTracingPipelineStackSizeKHR"));
+  if (features.pipelineStatistics) {
+    vkGetPipelineExecutableProperties = reinterpret_cast<PFN_vkGetPipelineExecutablePropertiesKHR>(
+        vkGetDeviceProcAddr(logicalDevice, "vkGetPipelineExecutablePropertiesKHR"));
+    vkGetPipelineExecutableStatistics = reinterpret_cast<PFN_vkGetPipelineExecutableStatisticsKHR>(
+        vkGetDeviceProcAddr(logicalDevice, "vkGetPipelineExecutableStatisticsKHR"));
+  }
 
   auto createCommandPool = [&](uint32_t queueFamilyIndex,
                                VkCommandPoolCreateFlags createFlags =
@@ -5784,9 +7122,12 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
   radixSortModule = new Module(this, sortDeviceCode);
   // scanModule = new Module(scanDeviceCode);
   fallbacksModule = new Module(this, fallbacksDeviceCode);
+  bufferModule = new Module(this, bufferDeviceCode);
+  rasterModule = new Module(this, rasterDeviceCode);
+  tallyModule = new Module(this, tallyDeviceCode);
 
   // Swapchain semaphores and fences
-  if (requestedFeatures.window) {
+  if (features.window) {
     VkSemaphoreCreateInfo semaphoreInfo{};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
@@ -5801,7 +7142,7 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
   }
 
   // Swapchain setup
-  if (requestedFeatures.window) {
+  if (features.window) {
     VkSurfaceCapabilitiesKHR surfaceCapabilities;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &surfaceCapabilities);
 
@@ -5917,21 +7258,6 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
 
   // Allocate resource heap
   {
-    descriptorPoolSize.type = VK_DESCRIPTOR_TYPE_MUTABLE_EXT;
-    descriptorPoolSize.descriptorCount = requestedFeatures.maxDescriptorCount;
-
-    VkDescriptorPoolCreateInfo descriptorPoolInfo{};
-    descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    descriptorPoolInfo.poolSizeCount = 1;
-    descriptorPoolInfo.pPoolSizes = &descriptorPoolSize;
-    descriptorPoolInfo.maxSets = 1;   // just one descriptor set for now.
-    descriptorPoolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-    // "If [below] does not exist, the descriptor pool allocates enough memory to be able to allocate a [mutable
-    // descriptor]
-    //  with any supported VkDescriptorType as a mutable descriptor."
-    // descriptorPoolInfo.pNext = &mutableTypeInfo;
-    VK_CHECK_RESULT(vkCreateDescriptorPool(logicalDevice, &descriptorPoolInfo, nullptr, &descriptorPool));
-
     VkDescriptorType cbvSrvUavTypes[] = {VK_DESCRIPTOR_TYPE_SAMPLER,
                                          VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
                                          VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
@@ -5950,18 +7276,19 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
     mutableTypeInfo.mutableDescriptorTypeListCount = 1;
     mutableTypeInfo.pMutableDescriptorTypeLists = &cbvSrvUavTypeList;
 
+    // One flag per binding. Partially bound, since most of the heap is unwritten at any given time.
     VkDescriptorSetLayoutBindingFlagsCreateInfoEXT setLayoutBindingFlags{};
     setLayoutBindingFlags.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
-    std::vector<VkDescriptorBindingFlagsEXT> descriptorBindingFlags = {
-        VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT};
+    VkDescriptorBindingFlagsEXT descriptorBindingFlags =
+        VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
     setLayoutBindingFlags.bindingCount = 1;
-    setLayoutBindingFlags.pBindingFlags = descriptorBindingFlags.data();
+    setLayoutBindingFlags.pBindingFlags = &descriptorBindingFlags;
     setLayoutBindingFlags.pNext = &mutableTypeInfo;
 
     VkDescriptorSetLayoutBinding binding{};
     binding.binding = 0;
     binding.descriptorType = VK_DESCRIPTOR_TYPE_MUTABLE_EXT;
-    binding.descriptorCount = descriptorPoolSize.descriptorCount;
+    binding.descriptorCount = 1;
     binding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_ANY_HIT_BIT_KHR |
                          VK_SHADER_STAGE_INTERSECTION_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR |
                          VK_SHADER_STAGE_CALLABLE_BIT_KHR | VK_SHADER_STAGE_RAYGEN_BIT_KHR |
@@ -5974,31 +7301,34 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
     descriptorSetLayoutCreateInfo.pBindings = setLayoutBindings.data();
     descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
     descriptorSetLayoutCreateInfo.pNext = &setLayoutBindingFlags;
-    VK_CHECK_RESULT(
-        vkCreateDescriptorSetLayout(logicalDevice, &descriptorSetLayoutCreateInfo, nullptr, &descriptorSetLayout));
 
-    // Now, making the descriptor sets (for now, just putting samplers here...)
-    VkDescriptorSetVariableDescriptorCountAllocateInfoEXT variableDescriptorCountAllocInfo{};
+    // Ask how large the variable sized binding can get on this device, and size the layout for that.
+    VkDescriptorSetVariableDescriptorCountLayoutSupport variableCountSupport{};
+    variableCountSupport.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_LAYOUT_SUPPORT;
+    VkDescriptorSetLayoutSupport layoutSupport{};
+    layoutSupport.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_SUPPORT;
+    layoutSupport.pNext = &variableCountSupport;
+    vkGetDescriptorSetLayoutSupport(logicalDevice, &descriptorSetLayoutCreateInfo, &layoutSupport);
 
-    uint32_t variableDescCounts[] = {static_cast<uint32_t>(descriptorPoolSize.descriptorCount)};
-
-    variableDescriptorCountAllocInfo.sType =
-        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO_EXT;
-    variableDescriptorCountAllocInfo.descriptorSetCount = 1;
-    variableDescriptorCountAllocInfo.pDescriptorCounts = variableDescCounts;
+    descriptorHeapLimit = std::min(variableCountSupport.maxVariableDescriptorCount, maxDescriptorHeapSize);
+    if (descriptorHeapLimit < features.maxDescriptorCount) {
+      LOG_WARNING("Device reports support for only " + std::to_string(descriptorHeapLimit) +
+                  " bindless descriptors; the resource heap will not grow beyond its initial " +
+                  std::to_string(features.maxDescriptorCount) + " descriptors.");
+      descriptorHeapLimit = features.maxDescriptorCount;
+    }
 
-    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
-    descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    descriptorSetAllocateInfo.descriptorPool = descriptorPool;
-    descriptorSetAllocateInfo.pSetLayouts = &descriptorSetLayout;
-    descriptorSetAllocateInfo.descriptorSetCount = 1;
-    descriptorSetAllocateInfo.pNext = &variableDescriptorCountAllocInfo;
+    binding.descriptorCount = descriptorHeapLimit;
+    setLayoutBindings = {binding};
+    descriptorSetLayoutCreateInfo.pBindings = setLayoutBindings.data();
+    VK_CHECK_RESULT(
+        vkCreateDescriptorSetLayout(logicalDevice, &descriptorSetLayoutCreateInfo, nullptr, &descriptorSetLayout));
 
-    VK_CHECK_RESULT(vkAllocateDescriptorSets(logicalDevice, &descriptorSetAllocateInfo, &descriptorSet));
+    allocateDescriptorHeap(features.maxDescriptorCount);
   }
 
   // Init imgui
-  if (requestedFeatures.window) {
+  if (features.window) {
     // 1: create descriptor pool for IMGUI
     // the size of the pool is very oversize, but it's copied from imgui demo itself.
     VkDescriptorPoolSize pool_sizes[] = {{VK_DESCRIPTOR_TYPE_SAMPLER, 1000},
@@ -6039,6 +7369,87 @@ Context::Context(int32_t *requestedDeviceIDs, int numRequestedDevices) {
   buildSBT(GPRT_SBT_ALL);
 };
 
+void
+Context::allocateDescriptorHeap(uint32_t descriptorCount) {
+  descriptorPoolSize.type = VK_DESCRIPTOR_TYPE_MUTABLE_EXT;
+  descriptorPoolSize.descriptorCount = descriptorCount;
+
+  VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+  descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  descriptorPoolInfo.poolSizeCount = 1;
+  descriptorPoolInfo.pPoolSizes = &descriptorPoolSize;
+  descriptorPoolInfo.maxSets = 1;   // just one descriptor set for now.
+  descriptorPoolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+  // "If [below] does not exist, the descriptor pool allocates enough memory to be able to allocate a [mutable
+  // descriptor]
+  //  with any supported VkDescriptorType as a mutable descriptor."
+  // descriptorPoolInfo.pNext = &mutableTypeInfo;
+  VK_CHECK_RESULT(vkCreateDescriptorPool(logicalDevice, &descriptorPoolInfo, nullptr, &descriptorPool));
+
+  VkDescriptorSetVariableDescriptorCountAllocateInfoEXT variableDescriptorCountAllocInfo{};
+  variableDescriptorCountAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO_EXT;
+  variableDescriptorCountAllocInfo.descriptorSetCount = 1;
+  variableDescriptorCountAllocInfo.pDescriptorCounts = &descriptorCount;
+
+  VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+  descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  descriptorSetAllocateInfo.descriptorPool = descriptorPool;
+  descriptorSetAllocateInfo.pSetLayouts = &descriptorSetLayout;
+  descriptorSetAllocateInfo.descriptorSetCount = 1;
+  descriptorSetAllocateInfo.pNext = &variableDescriptorCountAllocInfo;
+  VK_CHECK_RESULT(vkAllocateDescriptorSets(logicalDevice, &descriptorSetAllocateInfo, &descriptorSet));
+}
+
+void
+Context::growDescriptorHeap(uint32_t minDescriptorCount) {
+  if (minDescriptorCount > descriptorHeapLimit) {
+    LOG_ERROR("Out of bindless descriptors! This device supports at most " + std::to_string(descriptorHeapLimit) +
+              " textures and samplers alive at once.");
+  }
+
+  uint32_t descriptorCount = std::max(descriptorPoolSize.descriptorCount, 1u);
+  while (descriptorCount < minDescriptorCount)
+    descriptorCount = (descriptorCount > descriptorHeapLimit / 2) ? descriptorHeapLimit : descriptorCount * 2;
+
+  // Previous launches may still be reading from the old heap
+  if (getCompletedSubmission() < lastSubmission)
+    queueWaitIdle(graphicsQueue);
+
+  vkFreeDescriptorSets(logicalDevice, descriptorPool, 1, &descriptorSet);
+  vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
+  allocateDescriptorHeap(descriptorCount);
+
+  // The new set starts out empty, so every live descriptor needs writing again
+  for (auto &resource : imageResources) {
+    if (resource && resource->hasDescriptor)
+      pendingDescriptorWrites[resource->address] = {resource->descriptorType, resource->descriptorInfo};
+  }
+  counters.descriptorHeapGrowths++;
+}
+
+void
+Context::flushDescriptorWrites() {
+  if (pendingDescriptorWrites.empty())
+    return;
+
+  std::vector<VkWriteDescriptorSet> writes;
+  writes.reserve(pendingDescriptorWrites.size());
+  for (auto &pending : pendingDescriptorWrites) {
+    VkWriteDescriptorSet writeDescriptorSet = {};
+    writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstBinding = 0;
+    writeDescriptorSet.dstArrayElement = pending.first;
+    writeDescriptorSet.descriptorCount = 1;
+    writeDescriptorSet.dstSet = descriptorSet;
+    writeDescriptorSet.descriptorType = pending.second.first;
+    writeDescriptorSet.pImageInfo = &pending.second.second;
+    writes.push_back(writeDescriptorSet);
+  }
+  vkUpdateDescriptorSets(logicalDevice, (uint32_t) writes.size(), writes.data(), 0, nullptr);
+  counters.descriptorWrites += writes.size();
+  pendingDescriptorWrites.clear();
+}
+
 // void buildPrograms()
 // {
 //   // At the moment, we don't actually build our programs here.
@@ -6423,6 +7834,59 @@ Context::setupInternalPrograms() {
     internalComputePrograms.insert({"LSSBounds", new Compute(context, fallbacksModule, "LSSBounds")});
     internalComputePrograms.insert({"SphereBounds", new Compute(context, fallbacksModule, "SphereBounds")});
     internalComputePrograms.insert({"SolidBounds", new Compute(context, fallbacksModule, "SolidBounds")});
+    internalComputePrograms.insert({"VoxelBounds", new Compute(context, fallbacksModule, "VoxelBounds")});
+    internalComputePrograms.insert({"CurveBounds", new Compute(context, fallbacksModule, "CurveBounds")});
+    internalComputePrograms.insert(
+        {"MotionTriangleBounds", new Compute(context, fallbacksModule, "MotionTriangleBounds")});
+  }
+
+  // Buffer utility programs
+  {
+    Context *context = this;
+    internalComputePrograms.insert({"BufferFill", new Compute(context, bufferModule, "BufferFill")});
+    internalComputePrograms.insert({"BufferIota", new Compute(context, bufferModule, "BufferIota")});
+    internalComputePrograms.insert({"BufferRandom", new Compute(context, bufferModule, "BufferRandom")});
+    internalComputePrograms.insert({"BufferGather", new Compute(context, bufferModule, "BufferGather")});
+    internalComputePrograms.insert({"BufferScatter", new Compute(context, bufferModule, "BufferScatter")});
+    internalComputePrograms.insert(
+        {"BufferSegmentedSortLocal", new Compute(context, bufferModule, "BufferSegmentedSortLocal")});
+    internalComputePrograms.insert(
+        {"BufferSegmentedSortClassify", new Compute(context, bufferModule, "BufferSegmentedSortClassify")});
+    internalComputePrograms.insert(
+        {"BufferSegmentedSortGather", new Compute(context, bufferModule, "BufferSegmentedSortGather")});
+    internalComputePrograms.insert(
+        {"BufferSegmentedSortRekey", new Compute(context, bufferModule, "BufferSegmentedSortRekey")});
+    internalComputePrograms.insert(
+        {"BufferSegmentedSortPermute", new Compute(context, bufferModule, "BufferSegmentedSortPermute")});
+    internalComputePrograms.insert(
+        {"BufferSegmentedSortScatter", new Compute(context, bufferModule, "BufferSegmentedSortScatter")});
+    internalComputePrograms.insert({"BufferRunCount", new Compute(context, bufferModule, "BufferRunCount")});
+    internalComputePrograms.insert(
+        {"BufferRunScanBlocks", new Compute(context, bufferModule, "BufferRunScanBlocks")});
+    internalComputePrograms.insert({"BufferRunScatter", new Compute(context, bufferModule, "BufferRunScatter")});
+    internalComputePrograms.insert({"BufferRunReduce", new Compute(context, bufferModule, "BufferRunReduce")});
+    internalComputePrograms.insert(
+        {"BufferBuildSearchIndex", new Compute(context, bufferModule, "BufferBuildSearchIndex")});
+    internalComputePrograms.insert({"BufferLowerBound", new Compute(context, bufferModule, "BufferLowerBound")});
+    internalComputePrograms.insert({"HashMapCompact", new Compute(context, bufferModule, "HashMapCompact")});
+    internalComputePrograms.insert({"HashMapUnpack", new Compute(context, bufferModule, "HashMapUnpack")});
+    internalComputePrograms.insert(
+        {"BufferCompressCount", new Compute(context, bufferModule, "BufferCompressCount")});
+    internalComputePrograms.insert(
+        {"BufferCompressScanBlocks", new Compute(context, bufferModule, "BufferCompressScanBlocks")});
+    internalComputePrograms.insert(
+        {"BufferCompressWrite", new Compute(context, bufferModule, "BufferCompressWrite")});
+  }
+
+  // Mesh tally programs
+  {
+    Context *context = this;
+    internalComputePrograms.insert({"TallyScoreGrid", new Compute(context, tallyModule, "TallyScoreGrid")});
+    internalComputePrograms.insert({"TallyScoreMesh", new Compute(context, tallyModule, "TallyScoreMesh")});
+    internalComputePrograms.insert(
+        {"TallyScoreGridPrivatized", new Compute(context, tallyModule, "TallyScoreGridPrivatized")});
+    internalComputePrograms.insert(
+        {"TallyScoreMeshPrivatized", new Compute(context, tallyModule, "TallyScoreMeshPrivatized")});
   }
   computePipelinesOutOfDate = true;
 }
@@ -6512,8 +7976,8 @@ Context::endSingleTimeCommands(VkCommandBuffer commandBuffer, VkCommandPool pool
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(queue);
+  queueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+  queueWaitIdle(queue);
 
   vkFreeCommandBuffers(logicalDevice, pool, 1, &commandBuffer);
 }
@@ -6687,8 +8151,8 @@ Context::setRasterAttachments(Texture *colorTexture, Texture *depthTexture) {
   submitInfo.signalSemaphoreCount = 0;
   submitInfo.pSignalSemaphores = nullptr;
 
-  VK_CHECK_RESULT(vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE));
-  VK_CHECK_RESULT(vkQueueWaitIdle(graphicsQueue));
+  VK_CHECK_RESULT(queueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE));
+  VK_CHECK_RESULT(queueWaitIdle(graphicsQueue));
 
   // clear font textures from cpu data
   ImGui_ImplVulkan_DestroyFontUploadObjects();
@@ -6758,15 +8222,391 @@ Context::rasterizeGui() {
   submitInfo.signalSemaphoreCount = 0;
   submitInfo.pSignalSemaphores = nullptr;   //&writeImageSemaphoreHandleList[currentImageIndex]};
 
-  err = vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+  err = queueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
   if (err)
     LOG_ERROR("failed to submit to queue! : \n" + errorString(err));
 
-  err = vkQueueWaitIdle(graphicsQueue);
+  err = queueWaitIdle(graphicsQueue);
   if (err)
     LOG_ERROR("failed to wait for queue idle! : \n" + errorString(err));
 }
 
+void
+Context::buildVisibilityPipeline() {
+  // Instance, geometry and primitive indices, followed by the hit distance
+  VkAttachmentDescription colorAttachment{};
+  colorAttachment.format = VK_FORMAT_R32G32B32A32_UINT;
+  colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+  colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  // Contents are cleared anyways, and afterwards copied out to the user's visibility buffer
+  colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+  VkAttachmentDescription depthAttachment{};
+  depthAttachment.format = VK_FORMAT_D32_SFLOAT;
+  depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+  depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+  std::vector<VkAttachmentDescription> attachments = {colorAttachment, depthAttachment};
+
+  VkAttachmentReference colorAttachmentRef{};
+  colorAttachmentRef.attachment = 0;
+  colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+  VkAttachmentReference depthAttachmentRef{};
+  depthAttachmentRef.attachment = 1;
+  depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+  VkSubpassDescription subpass{};
+  subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpass.colorAttachmentCount = 1;
+  subpass.pColorAttachments = &colorAttachmentRef;
+  subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+  // Wait on any previous copy out of the color attachment before clearing it, and make the rasterized
+  // results available to the copy that follows the render pass.
+  std::array<VkSubpassDependency, 2> dependencies{};
+  dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[0].dstSubpass = 0;
+  dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  dependencies[0].srcAccessMask = 0;
+  dependencies[0].dstStageMask =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependencies[1].srcSubpass = 0;
+  dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+  VkRenderPassCreateInfo renderPassCreateInfo{};
+  renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  renderPassCreateInfo.attachmentCount = (uint32_t) attachments.size();
+  renderPassCreateInfo.pAttachments = attachments.data();
+  renderPassCreateInfo.subpassCount = 1;
+  renderPassCreateInfo.pSubpasses = &subpass;
+  renderPassCreateInfo.dependencyCount = (uint32_t) dependencies.size();
+  renderPassCreateInfo.pDependencies = dependencies.data();
+  VK_CHECK_RESULT(vkCreateRenderPass(logicalDevice, &renderPassCreateInfo, nullptr, &visibility.renderPass));
+
+  // Same layout as our other programs. Geometry is pulled through device addresses in the push constants.
+  VkPushConstantRange pushConstantRange = {};
+  pushConstantRange.size = PUSH_CONSTANTS_LIMIT;
+  pushConstantRange.offset = 0;
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+  VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+  pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  std::vector<VkDescriptorSetLayout> layouts = {descriptorSetLayout};
+  pipelineLayoutCreateInfo.setLayoutCount = (uint32_t) layouts.size();
+  pipelineLayoutCreateInfo.pSetLayouts = layouts.data();
+  pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+  pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+  VK_CHECK_RESULT(
+      vkCreatePipelineLayout(logicalDevice, &pipelineLayoutCreateInfo, nullptr, &visibility.pipelineLayout));
+
+  VkShaderModuleCreateInfo moduleCreateInfo{};
+  moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  moduleCreateInfo.codeSize = rasterModule->binary.size() * sizeof(uint32_t);
+  moduleCreateInfo.pCode = rasterModule->binary.data();
+  VK_CHECK_RESULT(vkCreateShaderModule(logicalDevice, &moduleCreateInfo, nullptr, &visibility.shaderModule));
+
+  std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
+  shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  shaderStages[0].module = visibility.shaderModule;
+  shaderStages[0].pName = "VisibilityVertex";
+  shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  shaderStages[1].module = visibility.shaderModule;
+  shaderStages[1].pName = "VisibilityPixel";
+
+  // No vertex attributes, vertices are pulled from the geometry's buffers
+  VkPipelineVertexInputStateCreateInfo vertexInputState{};
+  vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+  VkPipelineInputAssemblyStateCreateInfo inputAssemblyState{};
+  inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+  // Viewport and scissor are dynamic, so that the visibility buffer can change size without a new pipeline
+  VkPipelineViewportStateCreateInfo viewportState{};
+  viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  viewportState.viewportCount = 1;
+  viewportState.scissorCount = 1;
+
+  // Like traced rays without culling flags, both sides of a triangle are visible
+  VkPipelineRasterizationStateCreateInfo rasterizationState{};
+  rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+  rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+  rasterizationState.cullMode = VK_CULL_MODE_NONE;
+  rasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  rasterizationState.lineWidth = 1.0f;
+
+  VkPipelineMultisampleStateCreateInfo multisampleState{};
+  multisampleState.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+  multisampleState.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkPipelineDepthStencilStateCreateInfo depthStencilState{};
+  depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+  depthStencilState.depthTestEnable = VK_TRUE;
+  depthStencilState.depthWriteEnable = VK_TRUE;
+  depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS;
+
+  VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+  colorBlendAttachment.blendEnable = VK_FALSE;
+  colorBlendAttachment.colorWriteMask =
+      VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+  VkPipelineColorBlendStateCreateInfo colorBlendState{};
+  colorBlendState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  colorBlendState.attachmentCount = 1;
+  colorBlendState.pAttachments = &colorBlendAttachment;
+
+  std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+  VkPipelineDynamicStateCreateInfo dynamicState{};
+  dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dynamicState.dynamicStateCount = (uint32_t) dynamicStates.size();
+  dynamicState.pDynamicStates = dynamicStates.data();
+
+  VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
+  pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pipelineCreateInfo.stageCount = (uint32_t) shaderStages.size();
+  pipelineCreateInfo.pStages = shaderStages.data();
+  pipelineCreateInfo.pVertexInputState = &vertexInputState;
+  pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
+  pipelineCreateInfo.pViewportState = &viewportState;
+  pipelineCreateInfo.pRasterizationState = &rasterizationState;
+  pipelineCreateInfo.pMultisampleState = &multisampleState;
+  pipelineCreateInfo.pDepthStencilState = &depthStencilState;
+  pipelineCreateInfo.pColorBlendState = &colorBlendState;
+  pipelineCreateInfo.pDynamicState = &dynamicState;
+  pipelineCreateInfo.layout = visibility.pipelineLayout;
+  pipelineCreateInfo.renderPass = visibility.renderPass;
+  pipelineCreateInfo.subpass = 0;
+
+  VkResult err =
+      vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &visibility.pipeline);
+  if (err)
+    LOG_ERROR("failed to create visibility pipeline! : \n" + errorString(err));
+}
+
+void
+Context::setVisibilitySize(uint32_t width, uint32_t height) {
+  if (visibility.width == width && visibility.height == height)
+    return;
+
+  if (visibility.frameBuffer) {
+    vkDestroyFramebuffer(logicalDevice, visibility.frameBuffer, nullptr);
+    visibility.frameBuffer = VK_NULL_HANDLE;
+  }
+  if (visibility.colorAttachment) {
+    visibility.colorAttachment->destroy();
+    delete visibility.colorAttachment;
+    visibility.colorAttachment = nullptr;
+  }
+  if (visibility.depthAttachment) {
+    visibility.depthAttachment->destroy();
+    delete visibility.depthAttachment;
+    visibility.depthAttachment = nullptr;
+  }
+
+  visibility.width = width;
+  visibility.height = height;
+  if (width == 0 || height == 0)
+    return;
+
+  const VkImageUsageFlags imageUsageFlags =
+      VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  visibility.colorAttachment =
+      new Texture(this, imageUsageFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_TYPE_2D,
+                  VK_FORMAT_R32G32B32A32_UINT, width, height, 1, false);
+  visibility.depthAttachment = new Texture(this, imageUsageFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                           VK_IMAGE_TYPE_2D, VK_FORMAT_D32_SFLOAT, width, height, 1, false);
+
+  VkImageView attachmentViews[] = {visibility.colorAttachment->imageView, visibility.depthAttachment->imageView};
+
+  VkFramebufferCreateInfo framebufferInfo{};
+  framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+  framebufferInfo.renderPass = visibility.renderPass;
+  framebufferInfo.attachmentCount = 2;
+  framebufferInfo.pAttachments = attachmentViews;
+  framebufferInfo.width = width;
+  framebufferInfo.height = height;
+  framebufferInfo.layers = 1;
+  VK_CHECK_RESULT(vkCreateFramebuffer(logicalDevice, &framebufferInfo, nullptr, &visibility.frameBuffer));
+}
+
+void
+Context::rasterizeVisibility(Accel *accel, Buffer *visibilityBuffer, uint32_t width, uint32_t height,
+                             float4x4 viewProjection, float3 cameraPosition) {
+  if (width == 0 || height == 0)
+    LOG_ERROR("visibility buffer dimensions must be non-zero!");
+  if (visibilityBuffer->size < VkDeviceSize(width) * height * sizeof(gprt::Visibility))
+    LOG_ERROR("visibility buffer is too small for the requested dimensions!");
+
+  if (visibility.pipeline == VK_NULL_HANDLE)
+    buildVisibilityPipeline();
+  setVisibilitySize(width, height);
+
+  // Gather the triangle geometry to draw, along with the transform and instance index of each draw
+  struct Draw {
+    TriangleGeom *geom;
+    float3x4 transform;
+    uint32_t instanceIndex;
+    uint32_t geometryIndex;
+  };
+  std::vector<Draw> draws;
+  auto addDraws = [&](Accel *blas, const float3x4 &transform, uint32_t instanceIndex) {
+    // Only triangles can be rasterized. Other geometry is left to be traced.
+    if (blas->getType() != GPRT_TRIANGLE_ACCEL)
+      return;
+    for (uint32_t geomID = 0; geomID < blas->geometries.size(); ++geomID) {
+      TriangleGeom *geom = (TriangleGeom *) blas->geometries[geomID];
+      if (geom->index.count == 0 || geom->index.buffer == nullptr || geom->vertex.buffers.empty())
+        continue;
+      draws.push_back({geom, transform, instanceIndex, geomID});
+    }
+  };
+
+  if (accel->getType() == GPRT_INSTANCE_ACCEL) {
+    InstanceAccel *instanceAccel = (InstanceAccel *) accel;
+    bool previouslyMapped = (instanceAccel->instancesBuffer->mapped != nullptr);
+    if (!previouslyMapped)
+      instanceAccel->instancesBuffer->map();
+    gprt::Instance *instances = (gprt::Instance *) instanceAccel->instancesBuffer->mapped;
+    for (uint32_t instanceID = 0; instanceID < instanceAccel->numInstances; ++instanceID) {
+      gprt::Instance &instance = instances[instanceID];
+      // Masked out instances are invisible to all rays
+      if (instance.mask == 0 || instance.__gprtAccelAddress == 0)
+        continue;
+      Accel *blas = accels[instance.__gprtSBTOffset];
+      if (blas->getType() == GPRT_INSTANCE_ACCEL)
+        LOG_ERROR("Instance accels referenced by other instance accels is currently unsupported.");
+      addDraws(blas, instance.transform, instanceID);
+    }
+    if (!previouslyMapped)
+      instanceAccel->instancesBuffer->unmap();
+  } else {
+    float3x4 identity = {1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+    addDraws(accel, identity, 0);
+  }
+
+  VkResult err;
+  VkCommandBufferBeginInfo cmdBufInfo{};
+  cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  err = vkBeginCommandBuffer(graphicsCommandBuffer, &cmdBufInfo);
+  if (err)
+    LOG_ERROR("failed to begin command buffer for visibility rasterization! : \n" + errorString(err));
+
+  if (queryRequested) {
+    vkCmdResetQueryPool(graphicsCommandBuffer, queryPool, 0, 2);
+    vkCmdWriteTimestamp(graphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+  }
+
+  // Pixels without any geometry read as misses, infinitely far away
+  std::array<VkClearValue, 2> clearValues{};
+  clearValues[0].color.uint32[0] = GPRT_VISIBILITY_MISS;
+  clearValues[0].color.uint32[1] = GPRT_VISIBILITY_MISS;
+  clearValues[0].color.uint32[2] = GPRT_VISIBILITY_MISS;
+  clearValues[0].color.uint32[3] = 0x7F800000;   // +inf
+  clearValues[1].depthStencil = {1.0f, 0};
+
+  VkRenderPassBeginInfo renderPassBeginInfo = {};
+  renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  renderPassBeginInfo.renderPass = visibility.renderPass;
+  renderPassBeginInfo.framebuffer = visibility.frameBuffer;
+  renderPassBeginInfo.renderArea.offset = {0, 0};
+  renderPassBeginInfo.renderArea.extent = {width, height};
+  renderPassBeginInfo.clearValueCount = (uint32_t) clearValues.size();
+  renderPassBeginInfo.pClearValues = clearValues.data();
+  vkCmdBeginRenderPass(graphicsCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+  vkCmdBindPipeline(graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, visibility.pipeline);
+  flushDescriptorWrites();
+  std::vector<VkDescriptorSet> descriptorSets = {descriptorSet};
+  vkCmdBindDescriptorSets(graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, visibility.pipelineLayout, 0,
+                          (uint32_t) descriptorSets.size(), descriptorSets.data(), 0, nullptr);
+
+  // Flip the viewport, so that +y in normalized device coordinates points towards the first row of the image,
+  // matching the usual convention of a camera's "up" vector.
+  VkViewport viewport{};
+  viewport.x = 0.f;
+  viewport.y = float(height);
+  viewport.width = float(width);
+  viewport.height = -float(height);
+  viewport.minDepth = 0.f;
+  viewport.maxDepth = 1.f;
+  vkCmdSetViewport(graphicsCommandBuffer, 0, 1, &viewport);
+
+  VkRect2D scissor{};
+  scissor.offset = {0, 0};
+  scissor.extent = {width, height};
+  vkCmdSetScissor(graphicsCommandBuffer, 0, 1, &scissor);
+
+  RasterVisibilityParameters params = {};
+  params.viewProjection = viewProjection;
+  params.cameraPosition = cameraPosition;
+  for (auto &draw : draws) {
+    TriangleGeom *geom = draw.geom;
+    params.transform = draw.transform;
+    params.instanceIndex = draw.instanceIndex;
+    params.geometryIndex = draw.geometryIndex;
+    params.vertices = (uint8_t *) (geom->vertex.buffers[0]->getDeviceAddress() + geom->vertex.offset);
+    params.indices = (uint8_t *) (geom->index.buffer->getDeviceAddress() + geom->index.offset);
+    params.vertexStride = geom->vertex.stride;
+    params.indexStride = geom->index.stride;
+    params.firstVertex = geom->index.firstVertex;
+    vkCmdPushConstants(graphicsCommandBuffer, visibility.pipelineLayout,
+                       VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(params), &params);
+    vkCmdDraw(graphicsCommandBuffer, geom->index.count * 3, 1, 0, 0);
+  }
+
+  vkCmdEndRenderPass(graphicsCommandBuffer);
+  visibility.colorAttachment->layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  visibility.depthAttachment->layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+  // Copy the results out to the user's buffer, which raygen programs can then read from by pixel index
+  VkBufferImageCopy region{};
+  region.bufferOffset = visibilityBuffer->poolOffset;
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.imageOffset = {0, 0, 0};
+  region.imageExtent = {width, height, 1};
+  vkCmdCopyImageToBuffer(graphicsCommandBuffer, visibility.colorAttachment->image,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, visibilityBuffer->buffer, 1, &region);
+
+  if (queryRequested)
+    vkCmdWriteTimestamp(graphicsCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 1);
+
+  err = vkEndCommandBuffer(graphicsCommandBuffer);
+  if (err)
+    LOG_ERROR("failed to end command buffer for visibility rasterization! : \n" + errorString(err));
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &graphicsCommandBuffer;
+
+  err = queueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+  if (err)
+    LOG_ERROR("failed to submit to queue for visibility rasterization! : \n" + errorString(err));
+
+  err = queueWaitIdle(graphicsQueue);
+  if (err)
+    LOG_ERROR("failed to wait for queue idle for visibility rasterization! : \n" + errorString(err));
+}
+
 GPRT_API void
 gprtRequestWindow(uint32_t initialWidth, uint32_t initialHeight, const char *title) {
   LOG_API_CALL();
@@ -6788,6 +8628,12 @@ gprtRequestRayQueries() {
   requestedFeatures.rayQueries = true;
 }
 
+GPRT_API void
+gprtRequestPipelineStatistics() {
+  LOG_API_CALL();
+  requestedFeatures.pipelineStatistics = true;
+}
+
 GPRT_API void
 gprtRequestMaxPayloadSize(uint32_t payloadSize) {
   LOG_API_CALL();
@@ -6821,7 +8667,7 @@ GPRT_API bool
 gprtWindowShouldClose(GPRTContext _context) {
   LOG_API_CALL();
   Context *context = (Context *) _context;
-  if (!requestedFeatures.window)
+  if (!context->features.window)
     return true;
 
   glfwPollEvents();
@@ -6837,7 +8683,7 @@ GPRT_API void
 gprtSetWindowTitle(GPRTContext _context, const char *title) {
   LOG_API_CALL();
   Context *context = (Context *) _context;
-  if (!requestedFeatures.window)
+  if (!context->features.window)
     return;
 
   glfwSetWindowTitle(context->window, title);
@@ -6847,7 +8693,7 @@ GPRT_API void
 gprtGetCursorPos(GPRTContext _context, double *xpos, double *ypos) {
   LOG_API_CALL();
   Context *context = (Context *) _context;
-  if (!requestedFeatures.window)
+  if (!context->features.window)
     return;
 
   glfwGetCursorPos(context->window, xpos, ypos);
@@ -6857,7 +8703,7 @@ GPRT_API void
 gprtGrabAndHideCursor(GPRTContext _context, bool enabled) {
   LOG_API_CALL();
   Context *context = (Context *) _context;
-  if (!requestedFeatures.window)
+  if (!context->features.window)
     return;
 
   glfwSetInputMode(context->window, GLFW_CURSOR, enabled ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
@@ -6867,7 +8713,7 @@ GPRT_API int
 gprtGetMouseButton(GPRTContext _context, int button) {
   LOG_API_CALL();
   Context *context = (Context *) _context;
-  if (!requestedFeatures.window)
+  if (!context->features.window)
     return GPRT_RELEASE;
 
   return glfwGetMouseButton(context->window, button);
@@ -6877,7 +8723,7 @@ GPRT_API int
 gprtGetKey(GPRTContext _context, int key) {
   LOG_API_CALL();
   Context *context = (Context *) _context;
-  if (!requestedFeatures.window)
+  if (!context->features.window)
     return GPRT_RELEASE;
 
   return glfwGetKey(context->window, key);
@@ -6887,7 +8733,7 @@ GPRT_API double
 gprtGetTime(GPRTContext _context) {
   LOG_API_CALL();
   Context *context = (Context *) _context;
-  if (!requestedFeatures.window)
+  if (!context->features.window)
     return 0.0;
   return glfwGetTime();
 }
@@ -6895,9 +8741,9 @@ gprtGetTime(GPRTContext _context) {
 GPRT_API void
 gprtTexturePresent(GPRTContext _context, GPRTTexture _texture) {
   LOG_API_CALL();
-  if (!requestedFeatures.window)
-    return;
   Context *context = (Context *) _context;
+  if (!context->features.window)
+    return;
   Texture *texture = (Texture *) _texture;
 
   VkPresentInfoKHR presentInfo{};
@@ -7040,6 +8886,7 @@ gprtTexturePresent(GPRTContext _context, GPRTTexture _texture) {
 
   VkResult err2 = vkAcquireNextImageKHR(context->logicalDevice, context->swapchain, UINT64_MAX, VK_NULL_HANDLE,
                                         context->inFlightFence, &context->currentImageIndex);
+  context->counters.queueWaits++;
   vkWaitForFences(context->logicalDevice, 1, &context->inFlightFence, true, UINT_MAX);
   vkResetFences(context->logicalDevice, 1, &context->inFlightFence);
 }
@@ -7047,9 +8894,9 @@ gprtTexturePresent(GPRTContext _context, GPRTTexture _texture) {
 GPRT_API void
 gprtBufferPresent(GPRTContext _context, GPRTBuffer _buffer) {
   LOG_API_CALL();
-  if (!requestedFeatures.window)
-    return;
   Context *context = (Context *) _context;
+  if (!context->features.window)
+    return;
   Buffer *buffer = (Buffer *) _buffer;
 
   VkPresentInfoKHR presentInfo{};
@@ -7100,7 +8947,7 @@ gprtBufferPresent(GPRTContext _context, GPRTBuffer _buffer) {
   // now do the transfer
   {
     VkBufferImageCopy region{};
-    region.bufferOffset = 0;
+    region.bufferOffset = buffer->poolOffset;
     // if 0, vulkan assumes buffer memory is tightly packed
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
@@ -7176,6 +9023,7 @@ gprtBufferPresent(GPRTContext _context, GPRTBuffer _buffer) {
 
   VkResult err2 = vkAcquireNextImageKHR(context->logicalDevice, context->swapchain, UINT64_MAX, VK_NULL_HANDLE,
                                         context->inFlightFence, &context->currentImageIndex);
+  context->counters.queueWaits++;
   vkWaitForFences(context->logicalDevice, 1, &context->inFlightFence, true, UINT_MAX);
   vkResetFences(context->logicalDevice, 1, &context->inFlightFence);
 }
@@ -7197,7 +9045,63 @@ gprtGuiRasterize(GPRTContext _context) {
 GPRT_API GPRTContext
 gprtContextCreate(int32_t *requestedDeviceIDs, int numRequestedDevices) {
   LOG_API_CALL();
-  Context *context = new Context(requestedDeviceIDs, numRequestedDevices);
+  Context *context = new Context(requestedFeatures, requestedDeviceIDs, numRequestedDevices);
+  return (GPRTContext) context;
+}
+
+GPRT_API GPRTContextConfig
+gprtContextConfigGetDefault() {
+  LOG_API_CALL();
+  GPRTContextConfig config = {};
+  config.numRayTypes = requestedFeatures.numRayTypes;
+  config.rayRecursionDepth = requestedFeatures.rayRecursionDepth;
+  config.maxRayPayloadSize = requestedFeatures.maxRayPayloadSize;
+  config.maxRayHitAttributeSize = requestedFeatures.maxRayHitAttributeSize;
+  config.raygenRecordSize = requestedFeatures.raygenRecordSize;
+  config.hitRecordSize = requestedFeatures.hitRecordSize;
+  config.missRecordSize = requestedFeatures.missRecordSize;
+  config.callableRecordSize = requestedFeatures.callableRecordSize;
+  config.rayQueries = requestedFeatures.rayQueries;
+  config.pipelineStatistics = requestedFeatures.pipelineStatistics;
+  config.debugPrintf = requestedFeatures.debugPrintf;
+  config.window = requestedFeatures.window;
+  config.windowWidth = requestedFeatures.windowProperties.initialWidth;
+  config.windowHeight = requestedFeatures.windowProperties.initialHeight;
+  config.windowTitle = requestedFeatures.windowProperties.title.c_str();
+  return config;
+}
+
+GPRT_API GPRTContext
+gprtContextCreateWithConfig(const GPRTContextConfig *config, int32_t *requestedDeviceIDs, int numRequestedDevices) {
+  LOG_API_CALL();
+  if (config == nullptr)
+    return gprtContextCreate(requestedDeviceIDs, numRequestedDevices);
+  if (config->numRayTypes == 0)
+    LOG_ERROR("A context needs at least one ray type.");
+  if (config->maxRayHitAttributeSize > 32)
+    LOG_ERROR("Max attribute size is too large. Must be 32 bytes or smaller.");
+  if (config->rayRecursionDepth > 32)
+    LOG_ERROR("Max recursion depth is too large. Must be 32 or smaller.");
+
+  // Anything the config doesn't cover keeps its default
+  RequestedFeatures features = requestedFeatures;
+  features.numRayTypes = config->numRayTypes;
+  features.rayRecursionDepth = config->rayRecursionDepth;
+  features.maxRayPayloadSize = config->maxRayPayloadSize;
+  features.maxRayHitAttributeSize = config->maxRayHitAttributeSize;
+  features.raygenRecordSize = config->raygenRecordSize;
+  features.hitRecordSize = config->hitRecordSize;
+  features.missRecordSize = config->missRecordSize;
+  features.callableRecordSize = config->callableRecordSize;
+  features.rayQueries = config->rayQueries;
+  features.pipelineStatistics = config->pipelineStatistics;
+  features.debugPrintf = config->debugPrintf;
+  features.window = config->window;
+  features.windowProperties.initialWidth = config->windowWidth;
+  features.windowProperties.initialHeight = config->windowHeight;
+  features.windowProperties.title = std::string(config->windowTitle ? config->windowTitle : "");
+
+  Context *context = new Context(features, requestedDeviceIDs, numRequestedDevices);
   return (GPRTContext) context;
 }
 
@@ -7214,14 +9118,225 @@ GPRT_API void
 gprtContextSetRayTypeCount(GPRTContext _context, uint32_t numRayTypes) {
   LOG_API_CALL();
   Context *context = (Context *) _context;
-  requestedFeatures.numRayTypes = numRayTypes;
+  context->features.numRayTypes = numRayTypes;
 }
 
 GPRT_API size_t
 gprtContextGetRayTypeCount(GPRTContext _context) {
   LOG_API_CALL();
   Context *context = (Context *) _context;
-  return requestedFeatures.numRayTypes;
+  return context->features.numRayTypes;
+}
+
+GPRT_API GPRTCounters
+gprtContextGetCounters(GPRTContext _context) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  return context->counters;
+}
+
+GPRT_API void
+gprtContextResetCounters(GPRTContext _context) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  context->counters = {};
+}
+
+GPRT_API size_t
+gprtContextGetAllocatedMemory(GPRTContext _context) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  VmaTotalStatistics stats;
+  vmaCalculateStatistics(context->allocator, &stats);
+  return (size_t) stats.total.statistics.blockBytes;
+}
+
+static std::string
+jsonString(const std::string &str) {
+  std::stringstream json;
+  json << "\"";
+  for (char c : str) {
+    if (c == '"' || c == '\\')
+      json << '\\' << c;
+    else if (c == '\n')
+      json << "\\n";
+    else if ((unsigned char) c < 0x20)
+      json << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+    else
+      json << c;
+  }
+  json << "\"";
+  return json.str();
+}
+
+static std::string
+shaderStagesJSON(VkShaderStageFlags stages) {
+  static const std::pair<VkShaderStageFlagBits, const char *> names[] = {
+      {VK_SHADER_STAGE_RAYGEN_BIT_KHR, "raygen"},
+      {VK_SHADER_STAGE_MISS_BIT_KHR, "miss"},
+      {VK_SHADER_STAGE_CALLABLE_BIT_KHR, "callable"},
+      {VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR, "closestHit"},
+      {VK_SHADER_STAGE_ANY_HIT_BIT_KHR, "anyHit"},
+      {VK_SHADER_STAGE_INTERSECTION_BIT_KHR, "intersection"},
+      {VK_SHADER_STAGE_COMPUTE_BIT, "compute"},
+      {VK_SHADER_STAGE_VERTEX_BIT, "vertex"},
+      {VK_SHADER_STAGE_FRAGMENT_BIT, "fragment"}};
+  std::string json = "[";
+  for (auto &name : names) {
+    if ((stages & name.first) == 0)
+      continue;
+    if (json.size() > 1)
+      json += ", ";
+    json += jsonString(name.second);
+  }
+  return json + "]";
+}
+
+// The executables a driver compiled a pipeline into, along with whatever statistics the driver reports for each,
+// typically register counts, spills, shared memory and private memory. Names and units vary between vendors.
+static std::string
+pipelineExecutablesJSON(Context *context, VkPipeline pipeline, const std::string &indent) {
+  if (!context->features.pipelineStatistics || pipeline == VK_NULL_HANDLE)
+    return "[]";
+
+  VkPipelineInfoKHR pipelineInfo{};
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INFO_KHR;
+  pipelineInfo.pipeline = pipeline;
+  uint32_t numExecutables = 0;
+  context->vkGetPipelineExecutableProperties(context->logicalDevice, &pipelineInfo, &numExecutables, nullptr);
+  std::vector<VkPipelineExecutablePropertiesKHR> executables(numExecutables);
+  for (auto &executable : executables)
+    executable.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_PROPERTIES_KHR;
+  context->vkGetPipelineExecutableProperties(context->logicalDevice, &pipelineInfo, &numExecutables,
+                                             executables.data());
+
+  std::stringstream json;
+  json << "[";
+  for (uint32_t i = 0; i < numExecutables; ++i) {
+    VkPipelineExecutableInfoKHR executableInfo{};
+    executableInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INFO_KHR;
+    executableInfo.pipeline = pipeline;
+    executableInfo.executableIndex = i;
+    uint32_t numStatistics = 0;
+    context->vkGetPipelineExecutableStatistics(context->logicalDevice, &executableInfo, &numStatistics, nullptr);
+    std::vector<VkPipelineExecutableStatisticKHR> statistics(numStatistics);
+    for (auto &statistic : statistics)
+      statistic.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR;
+    context->vkGetPipelineExecutableStatistics(context->logicalDevice, &executableInfo, &numStatistics,
+                                               statistics.data());
+
+    json << ((i == 0) ? "\n" : ",\n") << indent << "  {\n";
+    json << indent << "    \"name\": " << jsonString(executables[i].name) << ",\n";
+    json << indent << "    \"description\": " << jsonString(executables[i].description) << ",\n";
+    json << indent << "    \"stages\": " << shaderStagesJSON(executables[i].stages) << ",\n";
+    json << indent << "    \"subgroupSize\": " << executables[i].subgroupSize << ",\n";
+    json << indent << "    \"statistics\": {";
+    for (uint32_t j = 0; j < numStatistics; ++j) {
+      json << ((j == 0) ? "\n" : ",\n") << indent << "      " << jsonString(statistics[j].name) << ": ";
+      switch (statistics[j].format) {
+      case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_BOOL32_KHR:
+        json << (statistics[j].value.b32 ? "true" : "false");
+        break;
+      case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_INT64_KHR:
+        json << statistics[j].value.i64;
+        break;
+      case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR:
+        json << statistics[j].value.u64;
+        break;
+      case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_FLOAT64_KHR:
+        json << statistics[j].value.f64;
+        break;
+      default:
+        json << "null";
+      }
+    }
+    json << ((numStatistics > 0) ? "\n" + indent + "    }\n" : "}\n");
+    json << indent << "  }";
+  }
+  json << ((numExecutables > 0) ? "\n" + indent + "]" : "]");
+  return json.str();
+}
+
+GPRT_API const char *
+gprtContextGetPipelineStatistics(GPRTContext _context) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+
+  std::stringstream json;
+  json << "{\n";
+  json << "  \"device\": " << jsonString(context->deviceProperties.deviceName) << ",\n";
+  json << "  \"rayRecursionDepth\": " << context->features.rayRecursionDepth << ",\n";
+  json << "  \"executableStatistics\": " << (context->features.pipelineStatistics ? "true" : "false") << ",\n";
+
+  // The stack size of each shader in each group, and the default stack size of the whole pipeline, which covers the
+  // requested recursion depth
+  json << "  \"rayTracingPipeline\": ";
+  if (context->raytracingPipeline == VK_NULL_HANDLE) {
+    json << "null,\n";
+  } else {
+    VkDevice device = context->logicalDevice;
+    VkPipeline pipeline = context->raytracingPipeline;
+    json << "{\n";
+    json << "    \"stackSize\": " << context->vkGetRayTracingPipelineStackSize(device, pipeline) << ",\n";
+    json << "    \"groups\": [";
+    for (uint32_t i = 0; i < context->shaderGroups.size(); ++i) {
+      auto &group = context->shaderGroups[i];
+      std::pair<uint32_t, VkShaderGroupShaderKHR> shaders[] = {
+          {group.generalShader, VK_SHADER_GROUP_SHADER_GENERAL_KHR},
+          {group.closestHitShader, VK_SHADER_GROUP_SHADER_CLOSEST_HIT_KHR},
+          {group.anyHitShader, VK_SHADER_GROUP_SHADER_ANY_HIT_KHR},
+          {group.intersectionShader, VK_SHADER_GROUP_SHADER_INTERSECTION_KHR}};
+      const char *shaderNames[] = {"general", "closestHit", "anyHit", "intersection"};
+
+      json << ((i == 0) ? "\n" : ",\n") << "      {\"group\": " << i;
+      for (uint32_t j = 0; j < 4; ++j) {
+        if (shaders[j].first == VK_SHADER_UNUSED_KHR || shaders[j].first >= context->shaderStageNames.size())
+          continue;
+        json << ", " << jsonString(shaderNames[j]) << ": {\"entryPoint\": "
+             << jsonString(context->shaderStageNames[shaders[j].first]) << ", \"stackSize\": "
+             << context->vkGetRayTracingShaderGroupStackSize(device, pipeline, i, shaders[j].second) << "}";
+      }
+      json << "}";
+    }
+    json << ((context->shaderGroups.size() > 0) ? "\n    ],\n" : "],\n");
+    json << "    \"executables\": " << pipelineExecutablesJSON(context, pipeline, "    ") << "\n";
+    json << "  },\n";
+  }
+
+  // Every built compute pipeline, including GPRT's own kernels and any tuned group sizes
+  json << "  \"computePipelines\": [";
+  bool first = true;
+  for (auto compute : context->computes) {
+    if (compute == nullptr || compute->pipeline == VK_NULL_HANDLE)
+      continue;
+    std::vector<std::pair<uint32_t, VkPipeline>> pipelines = {{0, compute->pipeline}};
+    pipelines.insert(pipelines.end(), compute->specializedPipelines.begin(), compute->specializedPipelines.end());
+    for (auto &pipeline : pipelines) {
+      json << (first ? "\n" : ",\n") << "    {\n";
+      json << "      \"entryPoint\": " << jsonString(compute->entryPoint) << ",\n";
+      json << "      \"groupSize\": " << pipeline.first << ",\n";
+      json << "      \"executables\": " << pipelineExecutablesJSON(context, pipeline.second, "      ") << "\n";
+      json << "    }";
+      first = false;
+    }
+  }
+  json << (first ? "]\n" : "\n  ]\n");
+  json << "}\n";
+
+  context->pipelineStatisticsReport = json.str();
+  return context->pipelineStatisticsReport.c_str();
+}
+
+GPRT_API bool
+gprtContextSavePipelineStatistics(GPRTContext context, const char *path) {
+  LOG_API_CALL();
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    LOG_WARNING("Unable to write pipeline statistics to \"" + std::string(path) + "\"");
+    return false;
+  }
+  file << gprtContextGetPipelineStatistics(context);
+  return true;
 }
 
 GPRT_API GPRTModule
@@ -7287,32 +9402,30 @@ GPRT_API void
 gprtTrianglesSetVertices(GPRTGeom _triangles, GPRTBuffer _vertices, uint32_t count, uint32_t stride, uint32_t offset) {
   LOG_API_CALL();
   TriangleGeom *triangles = (TriangleGeom *) _triangles;
-  if (triangles->geomType->getKind() != GPRT_TRIANGLES) LOG_ERROR("Calling gprtTrianglesSetVertices on non-triangular geometry type!");
+  if (triangles->geomType->getKind() != GPRT_TRIANGLES && triangles->geomType->getKind() != GPRT_MOTION_TRIANGLES)
+    LOG_ERROR("Calling gprtTrianglesSetVertices on non-triangular geometry type!");
   Buffer *vertices = (Buffer *) _vertices;
   triangles->setVertices(vertices, count, stride, offset);
 }
-// GPRT_API void gprtTrianglesSetMotionVertices(GPRTGeom triangles,
-//                                            /*! number of vertex arrays
-//                                                passed here, the first
-//                                                of those is for t=0,
-//                                                thelast for t=1,
-//                                                everything is linearly
-//                                                interpolated
-//                                                in-between */
-//                                            size_t    numKeys,
-//                                            GPRTBuffer *vertexArrays,
-//                                            size_t count,
-//                                            size_t stride,
-//                                            size_t offset)
-// {
-//   GPRT_NOTIMPLEMENTED;
-// }
+
+GPRT_API void
+gprtTrianglesSetMotionVertices(GPRTGeom _triangles, uint32_t numKeys, GPRTBuffer *vertexArrays, uint32_t count,
+                               uint32_t stride, uint32_t offset) {
+  LOG_API_CALL();
+  MotionTriangleGeom *triangles = (MotionTriangleGeom *) _triangles;
+  if (triangles->geomType->getKind() != GPRT_MOTION_TRIANGLES)
+    LOG_ERROR("Calling gprtTrianglesSetMotionVertices on non-motion triangle geometry type!");
+  if (numKeys < 1)
+    LOG_ERROR("gprtTrianglesSetMotionVertices requires at least one keyframe!");
+  triangles->setMotionVertices(numKeys, (Buffer **) vertexArrays, count, stride, offset);
+}
 
 GPRT_API void
 gprtTrianglesSetIndices(GPRTGeom _triangles, GPRTBuffer _indices, uint32_t count, uint32_t stride, uint32_t offset) {
   LOG_API_CALL();
   TriangleGeom *triangles = (TriangleGeom *) _triangles;
-  if (triangles->geomType->getKind() != GPRT_TRIANGLES) LOG_ERROR("Calling gprtTrianglesSetIndices on non-triangular geometry type!");
+  if (triangles->geomType->getKind() != GPRT_TRIANGLES && triangles->geomType->getKind() != GPRT_MOTION_TRIANGLES)
+    LOG_ERROR("Calling gprtTrianglesSetIndices on non-triangular geometry type!");
   Buffer *indices = (Buffer *) _indices;
   triangles->setIndices(indices, count, stride, offset);
 }
@@ -7380,6 +9493,202 @@ gprtSolidsSetPositions(GPRTGeom _solidGeom, GPRTBuffer _positions, uint32_t coun
   solidGeom->setAABBs(positions, count, stride, offset);
 }
 
+GPRT_API void
+gprtSolidsSetValueFilter(GPRTGeom _solidGeom, GPRTBuffer _filter) {
+  LOG_API_CALL();
+  SolidGeom *solidGeom = (SolidGeom *) _solidGeom;
+  if (solidGeom->geomType->getKind() != GPRT_SOLIDS)
+    LOG_ERROR("Calling gprtSolidsSetValueFilter on non-solid geometry type!");
+  Buffer *filter = (Buffer *) _filter;
+  if (filter && filter->getSize() < sizeof(gprt::SolidValueFilter))
+    LOG_ERROR("value filter buffer is too small to hold a gprt::SolidValueFilter!");
+  solidGeom->valueFilter = filter;
+}
+
+GPRT_API void
+gprtSolidValueFilterSetOccupancy(gprt::SolidValueFilter *filter, uint32_t numBins, const float *opacity,
+                                 float2 domain) {
+  LOG_API_CALL();
+  if (numBins > GPRT_SOLID_FILTER_MAX_BINS)
+    LOG_ERROR("value filters support at most " + std::to_string(GPRT_SOLID_FILTER_MAX_BINS) + " bins!");
+  if (numBins > 0 && !(domain.y > domain.x))
+    LOG_ERROR("value filter domain must be non-empty!");
+  filter->numBins = numBins;
+  filter->domain = domain;
+  filter->occupied[0] = 0;
+  for (uint32_t i = 0; i < numBins; ++i)
+    filter->occupied[i + 1] = filter->occupied[i] + ((opacity[i] > 0.f) ? 1 : 0);
+}
+
+GPRT_API void
+gprtSolidsBuildAdjacency(GPRTContext _context, GPRTGeom _solidGeom) {
+  LOG_API_CALL();
+  SolidGeom *solidGeom = (SolidGeom *) _solidGeom;
+  if (solidGeom->geomType->getKind() != GPRT_SOLIDS)
+    LOG_ERROR("Calling gprtSolidsBuildAdjacency on non-solid geometry type!");
+  if (!solidGeom->index.buffer || !solidGeom->types.buffer)
+    LOG_ERROR("solid indices and types must be set before building adjacency!");
+  uint32_t count = solidGeom->index.count;
+  if (count >= (1u << 29))
+    LOG_ERROR("solid adjacency supports fewer than 2^29 cells!");
+
+  Buffer *indexBuffer = solidGeom->index.buffer;
+  Buffer *typeBuffer = solidGeom->types.buffer;
+  bool indicesWereMapped = indexBuffer->mapped != nullptr;
+  bool typesWereMapped = typeBuffer->mapped != nullptr;
+  if (!indicesWereMapped)
+    indexBuffer->map();
+  if (!typesWereMapped)
+    typeBuffer->map();
+
+  // Every face of every cell, keyed by its sorted vertex indices. After sorting, the two cells sharing a face are
+  // neighbors in the list, which keeps this a single O(n log n) pass without a hash table.
+  using FaceKey = std::array<uint32_t, 4>;
+  std::vector<std::pair<FaceKey, uint32_t>> faces;
+  faces.reserve(size_t(count) * 4);
+  for (uint32_t cell = 0; cell < count; ++cell) {
+    uint8_t type = ((uint8_t *) typeBuffer->mapped)[solidGeom->types.offset + size_t(solidGeom->types.stride) * cell];
+    if (type < GPRT_SOLID_FIRST_FACE_TYPE || type > GPRT_SOLID_LAST_FACE_TYPE)
+      continue;   // eg, tetrahedral pairs, which are left on the boundary
+    const uint32_t *indices =
+        (const uint32_t *) ((uint8_t *) indexBuffer->mapped + solidGeom->index.offset +
+                            size_t(solidGeom->index.stride) * cell);
+    for (uint32_t face = 0; face < GPRT_SOLID_MAX_FACES; ++face) {
+      const uint32_t *corners = gprt::solidFaceCorners[type - GPRT_SOLID_FIRST_FACE_TYPE][face];
+      if (corners[0] == GPRT_SOLID_FACE_END)
+        continue;
+      FaceKey key = {UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX};
+      for (uint32_t i = 0; i < 4 && corners[i] != GPRT_SOLID_FACE_END; ++i)
+        key[i] = indices[corners[i]];
+      std::sort(key.begin(), key.end());
+      faces.push_back({key, (cell << 3) | face});
+    }
+  }
+
+  if (!indicesWereMapped)
+    indexBuffer->unmap();
+  if (!typesWereMapped)
+    typeBuffer->unmap();
+
+  std::sort(faces.begin(), faces.end());
+  std::vector<uint32_t> adjacency(size_t(count) * GPRT_SOLID_MAX_FACES, GPRT_SOLID_BOUNDARY);
+  uint32_t nonManifold = 0;
+  for (size_t i = 0; i < faces.size();) {
+    size_t j = i + 1;
+    while (j < faces.size() && faces[j].first == faces[i].first)
+      ++j;
+    if (j - i == 2) {
+      uint32_t a = faces[i].second, b = faces[i + 1].second;
+      adjacency[size_t(a >> 3) * GPRT_SOLID_MAX_FACES + (a & 7)] = b;
+      adjacency[size_t(b >> 3) * GPRT_SOLID_MAX_FACES + (b & 7)] = a;
+    } else if (j - i > 2) {
+      nonManifold++;
+    }
+    i = j;
+  }
+  if (nonManifold > 0)
+    LOG_WARNING(std::to_string(nonManifold) + " faces are shared by more than two cells, and are left as boundaries");
+
+  if (solidGeom->adjacency) {
+    solidGeom->adjacency->destroy();
+    delete solidGeom->adjacency;
+  }
+  solidGeom->adjacency =
+      (Buffer *) gprtDeviceBufferCreate(_context, sizeof(uint32_t), std::max<size_t>(adjacency.size(), 1),
+                                        adjacency.empty() ? nullptr : adjacency.data());
+}
+
+GPRT_API gprt::SolidMesh
+gprtSolidsGetMesh(GPRTGeom _solidGeom) {
+  LOG_API_CALL();
+  SolidGeom *solidGeom = (SolidGeom *) _solidGeom;
+  if (solidGeom->geomType->getKind() != GPRT_SOLIDS)
+    LOG_ERROR("Calling gprtSolidsGetMesh on non-solid geometry type!");
+  if (!solidGeom->adjacency)
+    LOG_ERROR("gprtSolidsBuildAdjacency must be called before gprtSolidsGetMesh!");
+  gprt::SolidMesh mesh = {};
+  mesh.vertices = (float4 *) solidGeom->vertex.buffers[0]->getDeviceAddress();
+  mesh.indices = (uint32_t *) solidGeom->index.buffer->getDeviceAddress();
+  mesh.types = (uint8_t *) solidGeom->types.buffer->getDeviceAddress();
+  mesh.adjacency = (uint32_t *) solidGeom->adjacency->getDeviceAddress();
+  mesh.count = solidGeom->index.count;
+  mesh.verticesOffset = solidGeom->vertex.offset;
+  mesh.verticesStride = solidGeom->vertex.stride;
+  mesh.indicesOffset = solidGeom->index.offset;
+  mesh.indicesStride = solidGeom->index.stride;
+  mesh.typesOffset = solidGeom->types.offset;
+  mesh.typesStride = solidGeom->types.stride;
+  return mesh;
+}
+
+GPRT_API void
+gprtVoxelsSetValues(GPRTGeom _voxelGeom, GPRTBuffer _values, uint3 dims, uint32_t stride, uint32_t offset) {
+  LOG_API_CALL();
+  VoxelGeom *voxelGeom = (VoxelGeom *) _voxelGeom;
+  if (voxelGeom->geomType->getKind() != GPRT_VOXELS)
+    LOG_ERROR("Calling gprtVoxelsSetValues on non-voxel geometry type!");
+  Buffer *values = (Buffer *) _values;
+  if (uint64_t(dims.x) * dims.y * dims.z >= UINT32_MAX)
+    LOG_ERROR("voxel grids support fewer than 2^32 voxels!");
+  if (values->getSize() < offset + uint64_t(stride) * (uint64_t(dims.x) * dims.y * dims.z - 1) + sizeof(float))
+    LOG_ERROR("values buffer is too small for the given grid dimensions!");
+  voxelGeom->setValues(values, dims, stride, offset);
+}
+
+GPRT_API void
+gprtVoxelsSetBounds(GPRTGeom _voxelGeom, float3 origin, float3 spacing) {
+  LOG_API_CALL();
+  VoxelGeom *voxelGeom = (VoxelGeom *) _voxelGeom;
+  if (voxelGeom->geomType->getKind() != GPRT_VOXELS)
+    LOG_ERROR("Calling gprtVoxelsSetBounds on non-voxel geometry type!");
+  if (spacing.x <= 0.f || spacing.y <= 0.f || spacing.z <= 0.f)
+    LOG_ERROR("voxel spacing must be positive!");
+  voxelGeom->origin = origin;
+  voxelGeom->spacing = spacing;
+}
+
+GPRT_API void
+gprtVoxelsSetBrickSize(GPRTGeom _voxelGeom, uint32_t brickSize) {
+  LOG_API_CALL();
+  VoxelGeom *voxelGeom = (VoxelGeom *) _voxelGeom;
+  if (voxelGeom->geomType->getKind() != GPRT_VOXELS)
+    LOG_ERROR("Calling gprtVoxelsSetBrickSize on non-voxel geometry type!");
+  if (brickSize == 0)
+    LOG_ERROR("voxel brick size must be non-zero!");
+  voxelGeom->brickSize = brickSize;
+}
+
+GPRT_API void
+gprtCurvesSetVertices(GPRTGeom _curveGeom, GPRTBuffer _vertices, uint32_t count, uint32_t stride, uint32_t offset) {
+  LOG_API_CALL();
+  CurveGeom *curveGeom = (CurveGeom *) _curveGeom;
+  if (curveGeom->geomType->getKind() != GPRT_CURVES)
+    LOG_ERROR("Calling gprtCurvesSetVertices on non-curve geometry type!");
+  Buffer *vertices = (Buffer *) _vertices;
+  curveGeom->setVertices(vertices, count, stride, offset);
+}
+
+GPRT_API void
+gprtCurvesSetIndices(GPRTGeom _curveGeom, GPRTBuffer _indices, uint32_t count, uint32_t stride, uint32_t offset) {
+  LOG_API_CALL();
+  CurveGeom *curveGeom = (CurveGeom *) _curveGeom;
+  if (curveGeom->geomType->getKind() != GPRT_CURVES)
+    LOG_ERROR("Calling gprtCurvesSetIndices on non-curve geometry type!");
+  Buffer *indices = (Buffer *) _indices;
+  curveGeom->setIndices(indices, count, stride, offset);
+}
+
+GPRT_API void
+gprtCurvesSetBasis(GPRTGeom _curveGeom, GPRTCurveBasis basis) {
+  LOG_API_CALL();
+  CurveGeom *curveGeom = (CurveGeom *) _curveGeom;
+  if (curveGeom->geomType->getKind() != GPRT_CURVES)
+    LOG_ERROR("Calling gprtCurvesSetBasis on non-curve geometry type!");
+  if (basis != GPRT_CURVE_BEZIER && basis != GPRT_CURVE_BSPLINE)
+    LOG_ERROR("unknown curve basis!");
+  curveGeom->basis = basis;
+}
+
 void
 gprtAABBsSetPositions(GPRTGeom _aabbs, GPRTBuffer _positions, uint32_t count, uint32_t stride, uint32_t offset) {
   LOG_API_CALL();
@@ -7599,34 +9908,63 @@ gprtGeomTypeCreate(GPRTContext _context, GPRTGeomKind kind, size_t recordSize) {
 
   switch (kind) {
   case GPRT_TRIANGLES:
-    geomType = new TriangleGeomType(context, requestedFeatures.numRayTypes, recordSize);
+    geomType = new TriangleGeomType(context, context->features.numRayTypes, recordSize);
     break;
   case GPRT_AABBS:
-    geomType = new AABBGeomType(context, requestedFeatures.numRayTypes, recordSize);
+    geomType = new AABBGeomType(context, context->features.numRayTypes, recordSize);
     break;
   case GPRT_SOLIDS:
-    geomType = new SolidGeomType(context, requestedFeatures.numRayTypes, recordSize);
+    geomType = new SolidGeomType(context, context->features.numRayTypes, recordSize);
     // Supply a built-in software intersector
-    for (int i = 0; i < requestedFeatures.numRayTypes; i++) {
+    for (int i = 0; i < context->features.numRayTypes; i++) {
       gprtGeomTypeSetIntersectionProg((GPRTGeomType) geomType, i, (GPRTModule) context->fallbacksModule,
                                       "SolidIntersection");
     }
     break;
-  case GPRT_LSS:
-    geomType = new LSSGeomType(context, requestedFeatures.numRayTypes, recordSize);
-    // Supply a software fallback intersectors when hardware support is missing
-    for (int i = 0; i < requestedFeatures.numRayTypes; i++) {
-      if (!requestedFeatures.linearSweptSpheres) {
-        gprtGeomTypeSetIntersectionProg((GPRTGeomType) geomType, i, (GPRTModule) context->fallbacksModule,
-                                        "LSSIntersection");
-      }
+  case GPRT_VOXELS:
+    geomType = new VoxelGeomType(context, context->features.numRayTypes, recordSize);
+    // Supply the built-in brick walking intersector
+    for (int i = 0; i < context->features.numRayTypes; i++) {
+      gprtGeomTypeSetIntersectionProg((GPRTGeomType) geomType, i, (GPRTModule) context->fallbacksModule,
+                                      "VoxelIntersection");
     }
     break;
-  case GPRT_SPHERES:
-    geomType = new SphereGeomType(context, requestedFeatures.numRayTypes, recordSize);
-    // Supply a software fallback intersectors when hardware support is missing
-    for (int i = 0; i < requestedFeatures.numRayTypes; i++) {
-      if (!requestedFeatures.linearSweptSpheres) {
+  case GPRT_CURVES:
+    geomType = new CurveGeomType(context, context->features.numRayTypes, recordSize);
+    // There is no cubic curve geometry to build over, so always supply the built-in subdividing intersector
+    for (int i = 0; i < context->features.numRayTypes; i++) {
+      gprtGeomTypeSetIntersectionProg((GPRTGeomType) geomType, i, (GPRTModule) context->fallbacksModule,
+                                      "CurveIntersection");
+    }
+    break;
+  case GPRT_MOTION_TRIANGLES:
+    geomType = new MotionTriangleGeomType(context, context->features.numRayTypes, recordSize);
+    // Motion triangles are always bounded over their keyframes and intersected in software at the ray's time
+    for (int i = 0; i < context->features.numRayTypes; i++) {
+      gprtGeomTypeSetIntersectionProg((GPRTGeomType) geomType, i, (GPRTModule) context->fallbacksModule,
+                                      "MotionTriangleIntersection");
+    }
+    if (!context->rayTimeSlot) {
+      context->rayTimeSlot = (Buffer *) gprtHostBufferCreate((GPRTContext) context, sizeof(uint64_t), 1, nullptr);
+      // Ray tracing programs read the slot through specialization constants, so those need rebuilding
+      context->raytracingPipelineOutOfDate = true;
+    }
+    break;
+  case GPRT_LSS:
+    geomType = new LSSGeomType(context, context->features.numRayTypes, recordSize);
+    // Supply a software fallback intersectors when hardware support is missing
+    for (int i = 0; i < context->features.numRayTypes; i++) {
+      if (!context->features.linearSweptSpheres) {
+        gprtGeomTypeSetIntersectionProg((GPRTGeomType) geomType, i, (GPRTModule) context->fallbacksModule,
+                                        "LSSIntersection");
+      }
+    }
+    break;
+  case GPRT_SPHERES:
+    geomType = new SphereGeomType(context, context->features.numRayTypes, recordSize);
+    // Supply a software fallback intersectors when hardware support is missing
+    for (int i = 0; i < context->features.numRayTypes; i++) {
+      if (!context->features.linearSweptSpheres) {
         gprtGeomTypeSetIntersectionProg((GPRTGeomType) geomType, i, (GPRTModule) context->fallbacksModule,
                                         "SphereIntersection");
       }
@@ -7848,6 +10186,18 @@ gprtTextureClear(GPRTTexture _texture) {
   texture->clear();
 }
 
+GPRT_API void
+gprtTextureFill(GPRTTexture _texture, const void *value) {
+  LOG_API_CALL();
+  Texture *texture = (Texture *) _texture;
+  VkClearColorValue color;
+  memcpy(&color, value, sizeof(color));
+  VkClearDepthStencilValue depthStencil;
+  memcpy(&depthStencil.depth, value, sizeof(float));
+  depthStencil.stencil = 0;
+  texture->fill(color, depthStencil);
+}
+
 GPRT_API void
 gprtTextureMap(GPRTTexture _texture, int deviceID) {
   LOG_API_CALL();
@@ -7976,6 +10326,135 @@ gprtSharedBufferCreate(GPRTContext _context, size_t size, size_t count, const vo
   return (GPRTBuffer) buffer;
 }
 
+static GPRTBufferPool
+bufferPoolCreate(GPRTContext _context, VkMemoryPropertyFlags memoryUsageFlags, size_t blockSize) {
+  const VkBufferUsageFlags bufferUsageFlags =
+      // Pooled buffers are used exactly like regular buffers, so support the same usage
+      VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+  Context *context = (Context *) _context;
+  if (blockSize == 0)
+    LOG_ERROR("buffer pool block size must be non-zero!");
+  BufferPool *pool = new BufferPool(context, bufferUsageFlags, memoryUsageFlags, blockSize);
+  return (GPRTBufferPool) pool;
+}
+
+GPRT_API GPRTBufferPool
+gprtHostBufferPoolCreate(GPRTContext _context, size_t blockSize) {
+  LOG_API_CALL();
+  return bufferPoolCreate(_context, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                          blockSize);
+}
+
+GPRT_API GPRTBufferPool
+gprtDeviceBufferPoolCreate(GPRTContext _context, size_t blockSize) {
+  LOG_API_CALL();
+  return bufferPoolCreate(_context, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, blockSize);
+}
+
+GPRT_API GPRTBufferPool
+gprtSharedBufferPoolCreate(GPRTContext _context, size_t blockSize) {
+  LOG_API_CALL();
+  return bufferPoolCreate(_context,
+                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                          blockSize);
+}
+
+GPRT_API GPRTBuffer
+gprtBufferPoolAllocate(GPRTBufferPool _pool, size_t size, size_t count, const void *init, size_t alignment) {
+  LOG_API_CALL();
+  BufferPool *pool = (BufferPool *) _pool;
+  Buffer *buffer = pool->allocate(size * count, alignment);
+
+  // Like host and shared buffers, pooled host visible buffers are pinned to the host. This is free, since
+  // the pool keeps its blocks persistently mapped.
+  if (buffer->hostVisible)
+    buffer->map();
+
+  if (init) {
+    buffer->map();
+    memcpy(buffer->mapped, init, size * count);
+    if (buffer->hostVisible)
+      buffer->flush();
+    else
+      buffer->unmap();
+  }
+  return (GPRTBuffer) buffer;
+}
+
+GPRT_API void
+gprtBufferPoolGetStats(GPRTBufferPool _pool, GPRTBufferPoolStats *stats) {
+  LOG_API_CALL();
+  BufferPool *pool = (BufferPool *) _pool;
+  stats->numBlocks = 0;
+  stats->reservedBytes = 0;
+  for (auto &block : pool->blocks) {
+    if (block.buffer == nullptr)
+      continue;
+    stats->numBlocks++;
+    stats->reservedBytes += block.buffer->size;
+  }
+  stats->numAllocations = pool->numAllocations;
+  stats->allocatedBytes = pool->allocatedBytes;
+}
+
+GPRT_API void
+gprtBufferPoolDestroy(GPRTBufferPool _pool) {
+  LOG_API_CALL();
+  BufferPool *pool = (BufferPool *) _pool;
+  pool->destroy();
+  delete pool;
+  pool = nullptr;
+}
+
+GPRT_API GPRTTransientPool
+gprtTransientPoolCreate(GPRTContext _context, uint32_t maxIdleFrames) {
+  LOG_API_CALL();
+  // Transient buffers are used exactly like device buffers, so support the same usage
+  const VkBufferUsageFlags bufferUsageFlags =
+      VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+  Context *context = (Context *) _context;
+  TransientPool *pool =
+      new TransientPool(context, bufferUsageFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, maxIdleFrames);
+  return (GPRTTransientPool) pool;
+}
+
+GPRT_API GPRTBuffer
+gprtTransientBufferAcquire(GPRTTransientPool _pool, size_t size, size_t count) {
+  LOG_API_CALL();
+  TransientPool *pool = (TransientPool *) _pool;
+  return (GPRTBuffer) pool->acquire(size * count);
+}
+
+GPRT_API void
+gprtTransientPoolNextFrame(GPRTTransientPool _pool) {
+  LOG_API_CALL();
+  TransientPool *pool = (TransientPool *) _pool;
+  pool->nextFrame();
+}
+
+GPRT_API void
+gprtTransientPoolGetStats(GPRTTransientPool _pool, GPRTTransientPoolStats *stats) {
+  LOG_API_CALL();
+  TransientPool *pool = (TransientPool *) _pool;
+  *stats = pool->getStats();
+}
+
+GPRT_API void
+gprtTransientPoolDestroy(GPRTTransientPool _pool) {
+  LOG_API_CALL();
+  TransientPool *pool = (TransientPool *) _pool;
+  pool->destroy();
+  delete pool;
+  pool = nullptr;
+}
+
 GPRT_API void
 gprtBufferClear(GPRTBuffer _buffer) {
   LOG_API_CALL();
@@ -7983,10 +10462,165 @@ gprtBufferClear(GPRTBuffer _buffer) {
   buffer->clear();
 }
 
+// Resolves a (possibly zero, meaning "until the end") element range for the device-side buffer initializers
+static size_t
+resolveInitializerRange(Buffer *buffer, size_t size, size_t offset, size_t count) {
+  size_t numElements = buffer->size / size;
+  if (offset > numElements)
+    LOG_ERROR("initializer offset exceeds the number of elements in the buffer!");
+  if (count == 0)
+    count = numElements - offset;
+  if (offset + count > numElements)
+    LOG_ERROR("initializer range exceeds the number of elements in the buffer!");
+  if (count > UINT32_MAX)
+    LOG_ERROR("initializer range exceeds 2^32 elements!");
+  return count;
+}
+
+// Number of workgroups to launch for the grid-stride buffer initializers
+static uint32_t
+initializerNumGroups(size_t count) {
+  size_t numGroups = (count + BUFFER_INIT_THREADGROUP_SIZE - 1) / BUFFER_INIT_THREADGROUP_SIZE;
+  return (uint32_t) std::min<size_t>(numGroups, WORKGROUP_LIMIT);
+}
+
+GPRT_API void
+gprtBufferFill(GPRTContext _context, GPRTBuffer _buffer, const void *pattern, size_t size, size_t offset,
+               size_t count) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Buffer *buffer = (Buffer *) _buffer;
+
+  if (size == 0)
+    LOG_ERROR("pattern size must be non-zero!");
+  count = resolveInitializerRange(buffer, size, offset, count);
+  if (count == 0)
+    return;
+
+  VkDeviceSize byteOffset = offset * size;
+  VkDeviceSize byteCount = count * size;
+
+  // Patterns that reduce to a single repeated 32-bit word can go straight through vkCmdFillBuffer
+  bool isWord = false;
+  uint32_t word = 0;
+  if (size == 1) {
+    word = uint32_t(*(const uint8_t *) pattern) * 0x01010101u;
+    isWord = true;
+  } else if (size == 2) {
+    uint16_t half;
+    memcpy(&half, pattern, sizeof(half));
+    word = uint32_t(half) | (uint32_t(half) << 16);
+    isWord = true;
+  } else if ((size % 4) == 0) {
+    memcpy(&word, pattern, sizeof(word));
+    isWord = true;
+    for (size_t i = 4; i < size; i += 4)
+      isWord &= (memcmp(&word, (const uint8_t *) pattern + i, sizeof(word)) == 0);
+  }
+
+  // Otherwise, fall back to a compute kernel that writes the pattern word by word, which limits the pattern size
+  bool useFillBuffer = isWord && (byteOffset % 4) == 0 && (byteCount % 4) == 0;
+  if (!useFillBuffer) {
+    if ((size % 4) != 0)
+      LOG_ERROR("pattern size must be a multiple of 4 bytes, or 1 or 2 bytes covering whole 32-bit words!");
+    if (size > BUFFER_FILL_MAX_PATTERN_WORDS * sizeof(uint32_t))
+      LOG_ERROR("pattern size exceeds " + std::to_string(BUFFER_FILL_MAX_PATTERN_WORDS * sizeof(uint32_t)) +
+                " bytes!");
+  }
+
+  // Like Buffer::clear, keep any mapped staging copy of a device buffer consistent, otherwise a later unmap would
+  // upload the stale copy over the fill. Only once the fill is known to be valid, so an error leaves both untouched.
+  if (!buffer->hostVisible && buffer->mapped) {
+    for (size_t i = 0; i < count; ++i)
+      memcpy((uint8_t *) buffer->mapped + byteOffset + i * size, pattern, size);
+  }
+
+  if (useFillBuffer) {
+    buffer->fill(byteOffset, byteCount, word);
+    return;
+  }
+
+  BufferFillParameters params = {};
+  params.buffer = (uint32_t *) (buffer->getDeviceAddress() + byteOffset);
+  params.count = (uint32_t) count;
+  params.patternWords = (uint32_t) (size / 4);
+  memcpy(params.pattern, pattern, size);
+
+  uint32_t numGroups = initializerNumGroups(count);
+  params.stride = numGroups * BUFFER_INIT_THREADGROUP_SIZE;
+
+  auto BufferFill = (GPRTComputeOf<BufferFillParameters>) context->internalComputePrograms["BufferFill"];
+  gprtComputeLaunch(BufferFill, uint3(numGroups, 1, 1), uint3(BUFFER_INIT_THREADGROUP_SIZE, 1, 1), params);
+}
+
+GPRT_API void
+gprtBufferIota(GPRTContext _context, GPRTBuffer _buffer, GPRTScalarType type, const void *start, const void *step,
+               size_t offset, size_t count) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Buffer *buffer = (Buffer *) _buffer;
+
+  // The generated values only exist on the device, so a mapped staging copy could not be kept consistent
+  if (!buffer->hostVisible && buffer->mapped)
+    LOG_ERROR("cannot initialize a mapped device buffer, unmap it first!");
+  count = resolveInitializerRange(buffer, sizeof(uint32_t), offset, count);
+  if (count == 0)
+    return;
+
+  BufferIotaParameters params = {};
+  params.buffer = (uint32_t *) (buffer->getDeviceAddress() + offset * sizeof(uint32_t));
+  params.count = (uint32_t) count;
+  params.type = (uint32_t) type;
+  memcpy(&params.start, start, sizeof(uint32_t));
+  memcpy(&params.step, step, sizeof(uint32_t));
+
+  uint32_t numGroups = initializerNumGroups(count);
+  params.stride = numGroups * BUFFER_INIT_THREADGROUP_SIZE;
+
+  auto BufferIota = (GPRTComputeOf<BufferIotaParameters>) context->internalComputePrograms["BufferIota"];
+  gprtComputeLaunch(BufferIota, uint3(numGroups, 1, 1), uint3(BUFFER_INIT_THREADGROUP_SIZE, 1, 1), params);
+}
+
+GPRT_API void
+gprtBufferRandom(GPRTContext _context, GPRTBuffer _buffer, GPRTScalarType type, uint32_t seed, const void *lower,
+                 const void *upper, size_t offset, size_t count) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Buffer *buffer = (Buffer *) _buffer;
+
+  // The generated values only exist on the device, so a mapped staging copy could not be kept consistent
+  if (!buffer->hostVisible && buffer->mapped)
+    LOG_ERROR("cannot initialize a mapped device buffer, unmap it first!");
+  count = resolveInitializerRange(buffer, sizeof(uint32_t), offset, count);
+  if (count == 0)
+    return;
+
+  BufferRandomParameters params = {};
+  params.buffer = (uint32_t *) (buffer->getDeviceAddress() + offset * sizeof(uint32_t));
+  params.count = (uint32_t) count;
+  params.type = (uint32_t) type;
+  params.seed = seed;
+  memcpy(&params.lower, lower, sizeof(uint32_t));
+  memcpy(&params.upper, upper, sizeof(uint32_t));
+
+  uint32_t numGroups = initializerNumGroups(count);
+  params.stride = numGroups * BUFFER_INIT_THREADGROUP_SIZE;
+
+  auto BufferRandom = (GPRTComputeOf<BufferRandomParameters>) context->internalComputePrograms["BufferRandom"];
+  gprtComputeLaunch(BufferRandom, uint3(numGroups, 1, 1), uint3(BUFFER_INIT_THREADGROUP_SIZE, 1, 1), params);
+}
+
 GPRT_API void
 gprtBufferDestroy(GPRTBuffer _buffer) {
   LOG_API_CALL();
   Buffer *buffer = (Buffer *) _buffer;
+
+  // Transient buffers are recycled by their pool
+  if (buffer->transientPool) {
+    buffer->transientPool->release(buffer);
+    return;
+  }
+
   buffer->destroy();
   delete buffer;
   buffer = nullptr;
@@ -8039,14 +10673,133 @@ gprtBufferCopy(GPRTContext _context, GPRTBuffer _source, GPRTBuffer _destination
   VkCommandBuffer commandBuffer = context->beginSingleTimeCommands(context->graphicsCommandPool);
 
   VkBufferCopy region;
-  region.srcOffset = srcOffset * size;
-  region.dstOffset = dstOffset * size;
+  region.srcOffset = source->poolOffset + srcOffset * size;
+  region.dstOffset = destination->poolOffset + dstOffset * size;
   region.size = count * size;
   vkCmdCopyBuffer(commandBuffer, source->buffer, destination->buffer, 1, &region);
 
   context->endSingleTimeCommands(commandBuffer, context->graphicsCommandPool, context->graphicsQueue);
 }
 
+GPRT_API void
+gprtBufferCopyRegions(GPRTContext _context, GPRTBuffer _source, GPRTBuffer _destination, size_t size,
+                      const GPRTBufferCopyRegion *regions, uint32_t numRegions, int srcDeviceID, int dstDeviceID) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Buffer *destination = (Buffer *) _destination;
+  Buffer *source = (Buffer *) _source;
+
+  std::vector<VkBufferCopy> copies;
+  copies.reserve(numRegions);
+  for (uint32_t i = 0; i < numRegions; ++i) {
+    // Vulkan disallows zero sized regions
+    if (regions[i].count == 0)
+      continue;
+
+    VkBufferCopy copy;
+    copy.srcOffset = regions[i].srcOffset * size;
+    copy.dstOffset = regions[i].dstOffset * size;
+    copy.size = regions[i].count * size;
+    if (copy.srcOffset + copy.size > source->size)
+      LOG_ERROR("copy region " + std::to_string(i) + " exceeds the size of the source buffer!");
+    if (copy.dstOffset + copy.size > destination->size)
+      LOG_ERROR("copy region " + std::to_string(i) + " exceeds the size of the destination buffer!");
+    copy.srcOffset += source->poolOffset;
+    copy.dstOffset += destination->poolOffset;
+    copies.push_back(copy);
+  }
+  if (copies.empty())
+    return;
+
+  // The copy is undefined if any source region overlaps any destination region in the same VkBuffer, which
+  // buffers from the same pool share. Sweep the sorted reads and writes to look for an intersection.
+  if (source->buffer == destination->buffer) {
+    std::vector<std::pair<VkDeviceSize, VkDeviceSize>> reads, writes;
+    for (const VkBufferCopy &copy : copies) {
+      reads.push_back({copy.srcOffset, copy.srcOffset + copy.size});
+      writes.push_back({copy.dstOffset, copy.dstOffset + copy.size});
+    }
+    std::sort(reads.begin(), reads.end());
+    std::sort(writes.begin(), writes.end());
+    for (size_t r = 0, w = 0; r < reads.size() && w < writes.size();) {
+      if (reads[r].first < writes[w].second && writes[w].first < reads[r].second)
+        LOG_ERROR("copy regions overlap between the source and the destination!");
+      if (reads[r].second <= writes[w].second)
+        r++;
+      else
+        w++;
+    }
+  }
+
+  // All regions go into a single copy command, and a single submission
+  VkCommandBuffer commandBuffer = context->beginSingleTimeCommands(context->graphicsCommandPool);
+  vkCmdCopyBuffer(commandBuffer, source->buffer, destination->buffer, (uint32_t) copies.size(), copies.data());
+  context->endSingleTimeCommands(commandBuffer, context->graphicsCommandPool, context->graphicsQueue);
+}
+
+// Shared implementation of gprtBufferGather and gprtBufferScatter
+static void
+bufferGatherScatter(Context *context, const char *program, Buffer *source, Buffer *indices, Buffer *destination,
+                    size_t size, size_t count, size_t srcStride, size_t dstStride) {
+  if (srcStride == 0)
+    srcStride = size;
+  if (dstStride == 0)
+    dstStride = size;
+
+  if ((size % 4) != 0 || (srcStride % 4) != 0 || (dstStride % 4) != 0)
+    LOG_ERROR("element sizes and strides must be multiples of 4 bytes!");
+  if (srcStride < size || dstStride < size)
+    LOG_ERROR("element strides must be at least as large as the element size!");
+  if (indices->size < count * sizeof(uint32_t))
+    LOG_ERROR("index buffer holds fewer than count indices!");
+  if (count > UINT32_MAX)
+    LOG_ERROR("gather / scatter count exceeds 2^32 elements!");
+  if (count == 0)
+    return;
+
+  BufferGatherScatterParameters params = {};
+  params.src = (uint32_t *) source->getDeviceAddress();
+  params.dst = (uint32_t *) destination->getDeviceAddress();
+  params.indices = (uint32_t *) indices->getDeviceAddress();
+  params.count = (uint32_t) count;
+  params.elementWords = (uint32_t) (size / 4);
+  params.srcStrideWords = (uint32_t) (srcStride / 4);
+  params.dstStrideWords = (uint32_t) (dstStride / 4);
+
+  uint32_t numGroups = initializerNumGroups(count);
+  params.stride = numGroups * BUFFER_INIT_THREADGROUP_SIZE;
+
+  auto GatherScatter =
+      (GPRTComputeOf<BufferGatherScatterParameters>) context->internalComputePrograms[program];
+  gprtComputeLaunch(GatherScatter, uint3(numGroups, 1, 1), uint3(BUFFER_INIT_THREADGROUP_SIZE, 1, 1), params);
+}
+
+GPRT_API void
+gprtBufferGather(GPRTContext _context, GPRTBuffer _source, GPRTBuffer _indices, GPRTBuffer _destination, size_t size,
+                 size_t count, size_t srcStride, size_t dstStride) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Buffer *source = (Buffer *) _source;
+  Buffer *indices = (Buffer *) _indices;
+  Buffer *destination = (Buffer *) _destination;
+  if (destination->size < (count == 0 ? 0 : (count - 1) * (dstStride ? dstStride : size) + size))
+    LOG_ERROR("destination buffer is too small for the gathered elements!");
+  bufferGatherScatter(context, "BufferGather", source, indices, destination, size, count, srcStride, dstStride);
+}
+
+GPRT_API void
+gprtBufferScatter(GPRTContext _context, GPRTBuffer _source, GPRTBuffer _indices, GPRTBuffer _destination, size_t size,
+                  size_t count, size_t srcStride, size_t dstStride) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Buffer *source = (Buffer *) _source;
+  Buffer *indices = (Buffer *) _indices;
+  Buffer *destination = (Buffer *) _destination;
+  if (source->size < (count == 0 ? 0 : (count - 1) * (srcStride ? srcStride : size) + size))
+    LOG_ERROR("source buffer is too small for the scattered elements!");
+  bufferGatherScatter(context, "BufferScatter", source, indices, destination, size, count, srcStride, dstStride);
+}
+
 void
 gprtBufferTextureCopy(GPRTContext _context, GPRTBuffer _buffer, GPRTTexture _texture, uint32_t bufferOffset,
                       uint32_t bufferRowLength, uint32_t bufferImageHeight, uint32_t imageOffsetX,
@@ -8067,7 +10820,7 @@ gprtBufferTextureCopy(GPRTContext _context, GPRTBuffer _buffer, GPRTTexture _tex
   texture->layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 
   VkBufferImageCopy region;
-  region.bufferOffset = bufferOffset;
+  region.bufferOffset = buffer->poolOffset + bufferOffset;
   region.bufferRowLength = bufferRowLength;
   region.bufferImageHeight = bufferImageHeight;
   region.imageOffset.x = imageOffsetX;
@@ -8181,8 +10934,12 @@ gprtBufferSelect(GPRTContext _context, GPRTBuffer _input, bool selectPositive, G
   return bufferScan(_context, _input, _output, _scratch, false, true, selectPositive);
 }
 
+// Radix sorts the first numKeys keys (and values) of the given buffers, or the whole buffer if numKeys is 0. Only
+// the low keyBits bits of each key are sorted on, which must be a multiple of two passes so that the result ends
+// up back in the keys buffer.
 void
-bufferSort(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values, GPRTBuffer _scratch) {
+bufferSort(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values, GPRTBuffer _scratch, uint32_t numKeys = 0,
+           uint32_t keyBits = 64) {
   LOG_API_CALL();
 
   Context *context = (Context *) _context;
@@ -8190,6 +10947,8 @@ bufferSort(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values, GPRTBuffe
   Buffer *values = (Buffer *) _values;
   Buffer *scratch = (Buffer *) _scratch;
 
+  assert(keyBits <= 64 && keyBits % (2 * PARALLELSORT_SORT_BITS_PER_PASS) == 0);
+
   bool bHasPayload = false;
   if (values) {
     if (keys->getSize() != values->getSize())
@@ -8198,7 +10957,8 @@ bufferSort(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values, GPRTBuffe
     bHasPayload = true;
   }
 
-  uint32_t numKeys = uint32_t(keys->getSize() / sizeof(uint64_t));
+  if (numKeys == 0)
+    numKeys = uint32_t(keys->getSize() / sizeof(uint64_t));
   uint32_t maxNumThreadgroups = 800;
   ParallelSortCB constantBufferData = {0};
 
@@ -8259,13 +11019,15 @@ bufferSort(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values, GPRTBuffe
     VkBuffer BufferMaps[4];
     VkDeviceSize Offsets1[4] = {0, 0, 0, 0};
 
-    // Map inputs/outputs
+    // Map inputs/outputs. Keys and values might be sub-allocated from a buffer pool.
     BufferMaps[0] = keys->buffer;
     BufferMaps[1] = scratch->buffer;
+    Offsets1[0] = keys->poolOffset;
+    Offsets1[1] = 0;
     if (bHasPayload) {
       BufferMaps[2] = values->buffer;
       BufferMaps[3] = scratch->buffer;
-      Offsets1[2] = 0;
+      Offsets1[2] = values->poolOffset;
       Offsets1[3] = valuesOffset;
     }
     BindUAVBuffer(BufferMaps, Offsets1, context->sortStages.m_SortDescriptorSetInputOutput[0], 0,
@@ -8273,11 +11035,13 @@ bufferSort(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values, GPRTBuffe
 
     BufferMaps[0] = scratch->buffer;
     BufferMaps[1] = keys->buffer;
+    Offsets1[0] = 0;
+    Offsets1[1] = keys->poolOffset;
     if (bHasPayload) {
       BufferMaps[2] = scratch->buffer;
       BufferMaps[3] = values->buffer;
       Offsets1[2] = valuesOffset;
-      Offsets1[3] = 0;
+      Offsets1[3] = values->poolOffset;
     }
     BindUAVBuffer(BufferMaps, Offsets1, context->sortStages.m_SortDescriptorSetInputOutput[1], 0,
                   (bHasPayload) ? 4 : 2);
@@ -8330,7 +11094,7 @@ bufferSort(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values, GPRTBuffe
   // Perform Radix Sort (currently only support 64-bit key/payload sorting
   uint32_t inputSet = 0;
   VkBufferMemoryBarrier Barriers[3];
-  for (uint64_t Shift = 0; Shift < 64u; Shift += PARALLELSORT_SORT_BITS_PER_PASS) {
+  for (uint64_t Shift = 0; Shift < keyBits; Shift += PARALLELSORT_SORT_BITS_PER_PASS) {
     // Update the bit shift
     vkCmdPushConstants(commandList, context->sortStages.layout, VK_SHADER_STAGE_ALL, sizeof(ParallelSortCB) - 4, 4,
                        &Shift);
@@ -8406,16 +11170,20 @@ bufferSort(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values, GPRTBuffe
 
     // Finish doing everything and barrier for the next pass
     VkBuffer keysBuffer = (inputSet) ? scratch->buffer : keys->buffer;
+    VkDeviceSize keysBarrierOffset = (inputSet) ? 0 : keys->poolOffset;
+    VkDeviceSize keysBarrierSize = (inputSet) ? keysSize : keys->size;
     Barriers[0] = BufferTransition(keysBuffer, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
-                                   VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, 0, keysSize);
+                                   VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, keysBarrierOffset,
+                                   keysBarrierSize);
     vkCmdPipelineBarrier(commandList, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0,
                          nullptr, 1, Barriers, 0, nullptr);
 
     if (bHasPayload) {
       VkBuffer valsBuffer = (inputSet) ? scratch->buffer : values->buffer;
-      VkDeviceSize offset = (inputSet) ? valuesOffset : 0;
+      VkDeviceSize offset = (inputSet) ? valuesOffset : values->poolOffset;
+      VkDeviceSize size = (inputSet) ? valuesSize : values->size;
       Barriers[0] = BufferTransition(valsBuffer, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
-                                     VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, offset, valuesSize);
+                                     VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, offset, size);
       vkCmdPipelineBarrier(commandList, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0,
                            nullptr, 1, Barriers, 0, nullptr);
     }
@@ -8436,6 +11204,981 @@ gprtBufferSortPayload(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values
   bufferSort(_context, _keys, _values, _scratch);
 }
 
+// Sorts each segment independently. Small segments are sorted by one workgroup each in a single launch. Segments
+// too large for shared memory are packed together and sorted in one batch: a stable radix sort by key, then a
+// stable radix sort by the start of each key's packed segment range, which regroups the keys by segment while
+// keeping them in key order. The only read back is three counters, used to validate the offsets and to size the
+// packed buffers.
+void
+bufferSegmentedSort(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values, GPRTBuffer _segmentOffsets,
+                    uint32_t numSegments, GPRTBuffer _scratch) {
+  LOG_API_CALL();
+
+  Context *context = (Context *) _context;
+  Buffer *keys = (Buffer *) _keys;
+  Buffer *values = (Buffer *) _values;
+  Buffer *segmentOffsets = (Buffer *) _segmentOffsets;
+
+  if (values && keys->getSize() != values->getSize())
+    LOG_ERROR("Keys and Values buffers must be equal in size\n");
+  if (segmentOffsets->getSize() < (numSegments + 1) * sizeof(uint32_t))
+    LOG_ERROR("segment offsets buffer must hold numSegments + 1 offsets!");
+  if (numSegments == 0)
+    return;
+
+  GPRTBuffer counters = gprtDeviceBufferCreate(_context, sizeof(uint32_t), 3);
+  GPRTBuffer largeSegments = gprtDeviceBufferCreate(_context, 2 * sizeof(uint32_t), numSegments);
+  gprtBufferClear(counters);
+
+  BufferSegmentedSortParameters params = {};
+  params.keys = (uint64_t *) keys->getDeviceAddress();
+  params.values = values ? (uint64_t *) values->getDeviceAddress() : nullptr;
+  params.segmentOffsets = (uint32_t *) segmentOffsets->getDeviceAddress();
+  params.counters = (uint32_t *) ((Buffer *) counters)->getDeviceAddress();
+  params.largeSegments = (uint32_t *) ((Buffer *) largeSegments)->getDeviceAddress();
+  params.numKeys = uint32_t(keys->getSize() / sizeof(uint64_t));
+  params.numSegments = numSegments;
+
+  uint32_t numGroups = initializerNumGroups(numSegments);
+  params.stride = numGroups * SEGMENTED_SORT_THREADGROUP_SIZE;
+  auto Classify =
+      (GPRTComputeOf<BufferSegmentedSortParameters>) context->internalComputePrograms["BufferSegmentedSortClassify"];
+  gprtComputeLaunch(Classify, uint3(numGroups, 1, 1), uint3(SEGMENTED_SORT_THREADGROUP_SIZE, 1, 1), params);
+
+  gprtBufferMap(counters);
+  uint32_t *count = (uint32_t *) gprtBufferGetHostPointer(counters);
+  uint32_t numLarge = count[0];
+  uint32_t numPacked = count[1];
+  uint32_t numInvalid = count[2];
+  gprtBufferUnmap(counters);
+  if (numInvalid > 0) {
+    gprtBufferDestroy(largeSegments);
+    gprtBufferDestroy(counters);
+    LOG_ERROR("segment offsets must be non-decreasing and must not exceed the number of keys!");
+  }
+
+  if (numLarge < numSegments) {
+    numGroups = std::min<uint32_t>(numSegments, WORKGROUP_LIMIT);
+    params.stride = numGroups;
+    auto SegmentedSortLocal =
+        (GPRTComputeOf<BufferSegmentedSortParameters>) context->internalComputePrograms["BufferSegmentedSortLocal"];
+    gprtComputeLaunch(SegmentedSortLocal, uint3(numGroups, 1, 1), uint3(SEGMENTED_SORT_THREADGROUP_SIZE, 1, 1),
+                      params);
+  }
+
+  if (numLarge > 0) {
+    // Both sorts carry the packed positions as their payload, so all of these match in size as the sort requires
+    GPRTBuffer packedKeys = gprtDeviceBufferCreate(_context, sizeof(uint64_t), numPacked);
+    GPRTBuffer packedIndices = gprtDeviceBufferCreate(_context, sizeof(uint64_t), numPacked);
+    GPRTBuffer segmentKeys = gprtDeviceBufferCreate(_context, sizeof(uint64_t), numPacked);
+    GPRTBuffer packedValues = values ? gprtDeviceBufferCreate(_context, sizeof(uint64_t), numPacked) : nullptr;
+    GPRTBuffer packedStarts = gprtDeviceBufferCreate(_context, sizeof(uint32_t), numPacked);
+    GPRTBuffer packedSources = gprtDeviceBufferCreate(_context, sizeof(uint32_t), numPacked);
+    GPRTBuffer scratch = _scratch ? _scratch : gprtDeviceBufferCreate(_context, 1, 1);
+
+    params.packedKeys = (uint64_t *) ((Buffer *) packedKeys)->getDeviceAddress();
+    params.packedIndices = (uint64_t *) ((Buffer *) packedIndices)->getDeviceAddress();
+    params.segmentKeys = (uint64_t *) ((Buffer *) segmentKeys)->getDeviceAddress();
+    params.packedValues = values ? (uint64_t *) ((Buffer *) packedValues)->getDeviceAddress() : nullptr;
+    params.packedStarts = (uint32_t *) ((Buffer *) packedStarts)->getDeviceAddress();
+    params.packedSources = (uint32_t *) ((Buffer *) packedSources)->getDeviceAddress();
+    params.numPacked = numPacked;
+
+    numGroups = std::min<uint32_t>(numLarge, WORKGROUP_LIMIT);
+    params.stride = numGroups;
+    auto Gather =
+        (GPRTComputeOf<BufferSegmentedSortParameters>) context->internalComputePrograms["BufferSegmentedSortGather"];
+    gprtComputeLaunch(Gather, uint3(numGroups, 1, 1), uint3(SEGMENTED_SORT_THREADGROUP_SIZE, 1, 1), params);
+
+    bufferSort(_context, packedKeys, packedIndices, scratch);
+
+    numGroups = initializerNumGroups(numPacked);
+    params.stride = numGroups * SEGMENTED_SORT_THREADGROUP_SIZE;
+    auto Rekey =
+        (GPRTComputeOf<BufferSegmentedSortParameters>) context->internalComputePrograms["BufferSegmentedSortRekey"];
+    gprtComputeLaunch(Rekey, uint3(numGroups, 1, 1), uint3(SEGMENTED_SORT_THREADGROUP_SIZE, 1, 1), params);
+
+    // Segment starts are below numPacked, so only sort on as many bits as that takes
+    uint32_t startBits = 2 * PARALLELSORT_SORT_BITS_PER_PASS;
+    while (startBits < 32 && (uint64_t(numPacked) >> startBits) != 0)
+      startBits += 2 * PARALLELSORT_SORT_BITS_PER_PASS;
+    bufferSort(_context, segmentKeys, packedIndices, scratch, 0, startBits);
+
+    auto Permute =
+        (GPRTComputeOf<BufferSegmentedSortParameters>) context->internalComputePrograms["BufferSegmentedSortPermute"];
+    gprtComputeLaunch(Permute, uint3(numGroups, 1, 1), uint3(SEGMENTED_SORT_THREADGROUP_SIZE, 1, 1), params);
+    auto Scatter =
+        (GPRTComputeOf<BufferSegmentedSortParameters>) context->internalComputePrograms["BufferSegmentedSortScatter"];
+    gprtComputeLaunch(Scatter, uint3(numGroups, 1, 1), uint3(SEGMENTED_SORT_THREADGROUP_SIZE, 1, 1), params);
+
+    if (!_scratch)
+      gprtBufferDestroy(scratch);
+    gprtBufferDestroy(packedSources);
+    gprtBufferDestroy(packedStarts);
+    if (packedValues)
+      gprtBufferDestroy(packedValues);
+    gprtBufferDestroy(segmentKeys);
+    gprtBufferDestroy(packedIndices);
+    gprtBufferDestroy(packedKeys);
+  }
+
+  gprtBufferDestroy(largeSegments);
+  gprtBufferDestroy(counters);
+}
+
+GPRT_API void
+gprtBufferSegmentedSort(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _segmentOffsets, uint32_t numSegments,
+                        GPRTBuffer _scratch) {
+  bufferSegmentedSort(_context, _keys, nullptr, _segmentOffsets, numSegments, _scratch);
+}
+
+GPRT_API void
+gprtBufferSegmentedSortPayload(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values,
+                               GPRTBuffer _segmentOffsets, uint32_t numSegments, GPRTBuffer _scratch) {
+  bufferSegmentedSort(_context, _keys, _values, _segmentOffsets, numSegments, _scratch);
+}
+
+// Shared implementation of gprtBufferUnique, gprtBufferRunLengthEncode and gprtBufferReduceByKey. The number
+// of runs is only ever written to device memory, so that these can be chained without a read back.
+static void
+bufferRuns(Context *context, Buffer *keys, Buffer *values, GPRTScalarType type, size_t count, Buffer *runKeys,
+           Buffer *runValues, Buffer *numRuns, Buffer *scratch) {
+  if (count == 0)
+    count = keys->getSize() / sizeof(uint64_t);
+  if (count > keys->getSize() / sizeof(uint64_t))
+    LOG_ERROR("count exceeds the number of keys!");
+  if (count >= UINT32_MAX)
+    LOG_ERROR("run length encoding supports fewer than 2^32 keys!");
+  if (values && values->getSize() < count * sizeof(uint32_t))
+    LOG_ERROR("values buffer holds fewer than count values!");
+  if (runKeys && runKeys->getSize() < count * sizeof(uint64_t))
+    LOG_ERROR("run keys buffer must be able to hold one key per input key!");
+  if (runValues && runValues->getSize() < count * sizeof(uint32_t))
+    LOG_ERROR("run values buffer must be able to hold one value per input key!");
+  if (numRuns->getSize() < sizeof(uint32_t))
+    LOG_ERROR("run count buffer must hold at least one 32-bit value!");
+
+  uint32_t numBlocks = std::max<uint32_t>(1, uint32_t((count + RUN_BLOCK_SIZE - 1) / RUN_BLOCK_SIZE));
+
+  // Scratch holds the per block counts, followed by the start of each run plus one past the end
+  size_t scratchSize = (numBlocks + count + 1) * sizeof(uint32_t);
+  Buffer *ownedScratch = nullptr;
+  if (!scratch) {
+    scratch = ownedScratch = (Buffer *) gprtDeviceBufferCreate((GPRTContext) context, scratchSize, 1);
+  } else if (scratch->getSize() < scratchSize) {
+    scratch->resize(scratchSize, /*don't transfer old contents*/ false);
+  }
+
+  BufferRunParameters params = {};
+  params.keys = (uint64_t *) keys->getDeviceAddress();
+  params.values = values ? (uint32_t *) values->getDeviceAddress() : nullptr;
+  params.runKeys = runKeys ? (uint64_t *) runKeys->getDeviceAddress() : nullptr;
+  params.runValues = runValues ? (uint32_t *) runValues->getDeviceAddress() : nullptr;
+  params.blockCounts = (uint32_t *) scratch->getDeviceAddress();
+  params.runStarts = params.blockCounts + numBlocks;
+  params.numRuns = (uint32_t *) numRuns->getDeviceAddress();
+  params.count = (uint32_t) count;
+  params.numBlocks = numBlocks;
+  params.type = (uint32_t) type;
+
+  uint32_t numGroups = std::min<uint32_t>(numBlocks, WORKGROUP_LIMIT);
+  params.stride = numGroups;
+  auto program = [&](const char *name) {
+    return (GPRTComputeOf<BufferRunParameters>) context->internalComputePrograms[name];
+  };
+  gprtComputeLaunch(program("BufferRunCount"), uint3(numGroups, 1, 1), uint3(RUN_THREADGROUP_SIZE, 1, 1), params);
+  gprtComputeLaunch(program("BufferRunScanBlocks"), uint3(1, 1, 1), uint3(RUN_THREADGROUP_SIZE, 1, 1), params);
+  gprtComputeLaunch(program("BufferRunScatter"), uint3(numGroups, 1, 1), uint3(RUN_THREADGROUP_SIZE, 1, 1), params);
+  if (runValues) {
+    // sized for the worst case of every key being its own run
+    uint32_t numReduceGroups = initializerNumGroups(count);
+    params.stride = numReduceGroups;
+    gprtComputeLaunch(program("BufferRunReduce"), uint3(numReduceGroups, 1, 1), uint3(RUN_THREADGROUP_SIZE, 1, 1),
+                      params);
+  }
+
+  if (ownedScratch)
+    gprtBufferDestroy((GPRTBuffer) ownedScratch);
+}
+
+GPRT_API void
+gprtBufferUnique(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _uniqueKeys, GPRTBuffer _numUnique,
+                 size_t count, GPRTBuffer _scratch) {
+  LOG_API_CALL();
+  bufferRuns((Context *) _context, (Buffer *) _keys, nullptr, GPRT_SCALAR_TYPE_UINT32, count, (Buffer *) _uniqueKeys,
+             nullptr, (Buffer *) _numUnique, (Buffer *) _scratch);
+}
+
+GPRT_API void
+gprtBufferRunLengthEncode(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _runKeys, GPRTBuffer _runLengths,
+                          GPRTBuffer _numRuns, size_t count, GPRTBuffer _scratch) {
+  LOG_API_CALL();
+  bufferRuns((Context *) _context, (Buffer *) _keys, nullptr, GPRT_SCALAR_TYPE_UINT32, count, (Buffer *) _runKeys,
+             (Buffer *) _runLengths, (Buffer *) _numRuns, (Buffer *) _scratch);
+}
+
+GPRT_API void
+gprtBufferReduceByKey(GPRTContext _context, GPRTBuffer _keys, GPRTBuffer _values, GPRTScalarType type,
+                      GPRTBuffer _runKeys, GPRTBuffer _runSums, GPRTBuffer _numRuns, size_t count,
+                      GPRTBuffer _scratch) {
+  LOG_API_CALL();
+  if (!_values || !_runSums)
+    LOG_ERROR("reduce by key requires both a values and a run sums buffer!");
+  bufferRuns((Context *) _context, (Buffer *) _keys, (Buffer *) _values, type, count, (Buffer *) _runKeys,
+             (Buffer *) _runSums, (Buffer *) _numRuns, (Buffer *) _scratch);
+}
+
+GPRT_API gprt::SortedTable
+gprtBufferGetSortedTable(GPRTBuffer _values, GPRTBuffer _index, size_t count) {
+  LOG_API_CALL();
+  Buffer *values = (Buffer *) _values;
+  Buffer *index = (Buffer *) _index;
+  if (count == 0)
+    count = values->getSize() / sizeof(float);
+  if (count > values->getSize() / sizeof(float))
+    LOG_ERROR("count exceeds the number of table values!");
+  if (count >= UINT32_MAX)
+    LOG_ERROR("sorted tables support fewer than 2^32 values!");
+
+  gprt::SortedTable table = {};
+  table.values = (float *) values->getDeviceAddress();
+  table.count = (uint32_t) count;
+  if (index) {
+    // two header words, then one more boundary than there are buckets
+    size_t words = index->getSize() / sizeof(uint32_t);
+    if (words < 4)
+      LOG_ERROR("search index must hold at least one bucket!");
+    table.index = (uint32_t *) index->getDeviceAddress();
+    table.numBuckets = (uint32_t) std::min<size_t>(words - 3, UINT32_MAX - 1);
+  }
+  return table;
+}
+
+GPRT_API void
+gprtBufferBuildSearchIndex(GPRTContext _context, GPRTBuffer _values, GPRTBuffer _index, size_t count) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  if (!_index)
+    LOG_ERROR("a search index buffer is required!");
+
+  BufferSearchIndexParameters params = {};
+  params.table = gprtBufferGetSortedTable(_values, _index, count);
+  if (params.table.count == 0)
+    LOG_ERROR("cannot build a search index over an empty table!");
+
+  uint32_t numGroups = initializerNumGroups(size_t(params.table.numBuckets) + 1);
+  params.stride = numGroups * SEARCH_THREADGROUP_SIZE;
+  auto BuildSearchIndex =
+      (GPRTComputeOf<BufferSearchIndexParameters>) context->internalComputePrograms["BufferBuildSearchIndex"];
+  gprtComputeLaunch(BuildSearchIndex, uint3(numGroups, 1, 1), uint3(SEARCH_THREADGROUP_SIZE, 1, 1), params);
+}
+
+GPRT_API void
+gprtBufferLowerBound(GPRTContext _context, GPRTBuffer _values, GPRTBuffer _queries, GPRTBuffer _results,
+                     GPRTBuffer _index, size_t count, size_t numQueries) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Buffer *queries = (Buffer *) _queries;
+  Buffer *results = (Buffer *) _results;
+  if (numQueries == 0)
+    numQueries = queries->getSize() / sizeof(float);
+  if (numQueries > queries->getSize() / sizeof(float))
+    LOG_ERROR("numQueries exceeds the number of queries!");
+  if (results->getSize() < numQueries * sizeof(uint32_t))
+    LOG_ERROR("results buffer must hold one 32-bit position per query!");
+  if (numQueries >= UINT32_MAX)
+    LOG_ERROR("lower bound supports fewer than 2^32 queries per call!");
+  if (numQueries == 0)
+    return;
+
+  BufferLowerBoundParameters params = {};
+  params.table = gprtBufferGetSortedTable(_values, _index, count);
+  params.queries = (float *) queries->getDeviceAddress();
+  params.results = (uint32_t *) results->getDeviceAddress();
+  params.numQueries = (uint32_t) numQueries;
+
+  uint32_t numGroups = initializerNumGroups(numQueries);
+  params.stride = numGroups * SEARCH_THREADGROUP_SIZE;
+  auto LowerBound = (GPRTComputeOf<BufferLowerBoundParameters>) context->internalComputePrograms["BufferLowerBound"];
+  gprtComputeLaunch(LowerBound, uint3(numGroups, 1, 1), uint3(SEARCH_THREADGROUP_SIZE, 1, 1), params);
+}
+
+// Largest stream gprtBufferCompress can produce for the given number of input words
+static size_t
+compressedStreamBound(size_t numWords) {
+  size_t numBlocks = std::max<size_t>(1, (numWords + COMPRESS_BLOCK_WORDS - 1) / COMPRESS_BLOCK_WORDS);
+  return (COMPRESS_HEADER_WORDS + numBlocks * (1 + COMPRESS_MAX_BLOCK_WORDS)) * sizeof(uint32_t);
+}
+
+// Shared implementation of gprtBufferCompress and gprtBufferReadCompressed. Returns the size of the stream in bytes,
+// which costs a read back of a single word.
+static size_t
+bufferCompress(Context *context, Buffer *source, size_t size, Buffer *stream, Buffer *scratch) {
+  if (size == 0)
+    size = source->getSize();
+  if (size > source->getSize())
+    LOG_ERROR("size exceeds the size of the source buffer!");
+  if (size % sizeof(uint32_t) != 0)
+    LOG_ERROR("compression works on 32-bit words, so size must be a multiple of 4 bytes!");
+  size_t numWords = size / sizeof(uint32_t);
+  if (numWords >= UINT32_MAX)
+    LOG_ERROR("compression supports fewer than 2^32 words per call!");
+
+  uint32_t numBlocks = std::max<uint32_t>(1, uint32_t((numWords + COMPRESS_BLOCK_WORDS - 1) / COMPRESS_BLOCK_WORDS));
+  size_t streamBound = compressedStreamBound(numWords);
+  if (stream->getSize() < streamBound)
+    stream->resize(streamBound, /*don't transfer old contents*/ false);
+  size_t scratchSize = (numBlocks + 1) * sizeof(uint32_t);
+  if (scratch->getSize() < scratchSize)
+    scratch->resize(scratchSize, /*don't transfer old contents*/ false);
+
+  BufferCompressParameters params = {};
+  params.input = (uint32_t *) source->getDeviceAddress();
+  params.stream = (uint32_t *) stream->getDeviceAddress();
+  params.blockSizes = (uint32_t *) scratch->getDeviceAddress();
+  params.numWords = (uint32_t) numWords;
+  params.numBlocks = numBlocks;
+
+  uint32_t numGroups = std::min<uint32_t>(numBlocks, WORKGROUP_LIMIT);
+  params.stride = numGroups;
+  auto program = [&](const char *name) {
+    return (GPRTComputeOf<BufferCompressParameters>) context->internalComputePrograms[name];
+  };
+  gprtComputeLaunch(program("BufferCompressCount"), uint3(numGroups, 1, 1), uint3(COMPRESS_BLOCK_WORDS, 1, 1),
+                    params);
+  gprtComputeLaunch(program("BufferCompressScanBlocks"), uint3(1, 1, 1), uint3(COMPRESS_BLOCK_WORDS, 1, 1), params);
+  gprtComputeLaunch(program("BufferCompressWrite"), uint3(numGroups, 1, 1), uint3(COMPRESS_BLOCK_WORDS, 1, 1),
+                    params);
+
+  // Device buffers can copy just the total through their staging buffer
+  uint32_t payloadWords;
+  if (scratch->hostVisible) {
+    scratch->map();
+    memcpy(&payloadWords, (uint32_t *) scratch->mapped + numBlocks, sizeof(uint32_t));
+    scratch->unmap();
+  } else {
+    scratch->map(sizeof(uint32_t), numBlocks * sizeof(uint32_t));
+    memcpy(&payloadWords, scratch->mapped, sizeof(uint32_t));
+    scratch->unmap(sizeof(uint32_t), numBlocks * sizeof(uint32_t));
+  }
+  return (COMPRESS_HEADER_WORDS + size_t(numBlocks) + payloadWords) * sizeof(uint32_t);
+}
+
+GPRT_API size_t
+gprtBufferCompress(GPRTContext _context, GPRTBuffer _source, GPRTBuffer _compressed, size_t size,
+                   GPRTBuffer _scratch) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Buffer *scratch = (Buffer *) _scratch;
+  Buffer *ownedScratch = nullptr;
+  if (!scratch)
+    scratch = ownedScratch = (Buffer *) gprtDeviceBufferCreate(_context, sizeof(uint32_t), 1);
+  size_t compressedSize = bufferCompress(context, (Buffer *) _source, size, (Buffer *) _compressed, scratch);
+  if (ownedScratch)
+    gprtBufferDestroy((GPRTBuffer) ownedScratch);
+  return compressedSize;
+}
+
+GPRT_API size_t
+gprtDecompress(const void *compressed, size_t compressedSize, void *output, size_t outputSize) {
+  LOG_API_CALL();
+  const uint32_t *stream = (const uint32_t *) compressed;
+  size_t streamWords = compressedSize / sizeof(uint32_t);
+  if (streamWords < COMPRESS_HEADER_WORDS)
+    LOG_ERROR("compressed stream is truncated!");
+  uint32_t numWords = stream[0];
+  uint32_t numBlocks = stream[1];
+  if (size_t(numWords) * sizeof(uint32_t) > outputSize)
+    LOG_ERROR("output is too small to hold the decompressed stream!");
+  if (streamWords < COMPRESS_HEADER_WORDS + size_t(numBlocks) ||
+      numBlocks != std::max<uint32_t>(1, (numWords + COMPRESS_BLOCK_WORDS - 1) / COMPRESS_BLOCK_WORDS))
+    LOG_ERROR("compressed stream is malformed!");
+
+  const uint32_t *headers = stream + COMPRESS_HEADER_WORDS;
+  const uint32_t *payload = headers + numBlocks;
+  const uint32_t *end = stream + streamWords;
+  uint32_t *words = (uint32_t *) output;
+  for (uint32_t block = 0; block < numBlocks; ++block) {
+    uint32_t first = block * COMPRESS_BLOCK_WORDS;
+    uint32_t blockWords = std::min<uint32_t>(COMPRESS_BLOCK_WORDS, numWords - first);
+    uint32_t header = headers[block];
+    uint32_t count = header & 0xFFFF;
+    uint32_t bits = header >> 16;
+    if (payload + compressedBlockWords(header) > end || count > blockWords || (count > 0 && (bits == 0 || bits > 32)))
+      LOG_ERROR("compressed stream is malformed!");
+    if (count == 0) {
+      memset(words + first, 0, blockWords * sizeof(uint32_t));
+      continue;
+    }
+
+    const uint32_t *mask = (count < COMPRESS_BLOCK_WORDS) ? payload : nullptr;
+    const uint32_t *packed = payload + (mask ? COMPRESS_MASK_WORDS : 0);
+    uint64_t valueMask = (uint64_t(1) << bits) - 1;
+    uint32_t rank = 0;
+    for (uint32_t i = 0; i < blockWords; ++i) {
+      if (mask && !(mask[i / 32] & (1u << (i % 32)))) {
+        words[first + i] = 0;
+        continue;
+      }
+      uint32_t bit = rank * bits;
+      uint64_t window = packed[bit / 32];
+      if ((bit % 32) + bits > 32)
+        window |= uint64_t(packed[bit / 32 + 1]) << 32;
+      words[first + i] = uint32_t((window >> (bit % 32)) & valueMask);
+      rank++;
+    }
+    payload += compressedBlockWords(header);
+  }
+  return size_t(numWords) * sizeof(uint32_t);
+}
+
+GPRT_API size_t
+gprtBufferReadCompressed(GPRTContext _context, GPRTBuffer _source, void *output, size_t size) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Buffer *source = (Buffer *) _source;
+  if (size == 0)
+    size = source->getSize();
+  if (!context->compressedStream) {
+    context->compressedStream = (Buffer *) gprtDeviceBufferCreate(_context, sizeof(uint32_t), 1);
+    context->compressedScratch = (Buffer *) gprtDeviceBufferCreate(_context, sizeof(uint32_t), 1);
+  }
+  size_t compressedSize =
+      bufferCompress(context, source, size, context->compressedStream, context->compressedScratch);
+
+  // Only the compressed stream crosses the bus
+  if (!context->compressedReadback || context->compressedReadback->getSize() < compressedSize) {
+    if (context->compressedReadback)
+      gprtBufferDestroy((GPRTBuffer) context->compressedReadback);
+    context->compressedReadback = (Buffer *) gprtHostBufferCreate(_context, compressedSize, 1);
+  }
+  gprtBufferCopy(_context, (GPRTBuffer) context->compressedStream, (GPRTBuffer) context->compressedReadback, 0, 0,
+                 compressedSize, 1, 0, 0);
+  context->compressedReadback->map();
+  gprtDecompress(context->compressedReadback->mapped, compressedSize, output, size);
+  context->compressedReadback->unmap();
+  return compressedSize;
+}
+
+/*! A checkpoint copies a set of buffers into one of a few rotating, pinned host staging buffers, and a writer thread
+  streams each staging buffer to disk once its copy completes. The copy goes to the same queue as every launch,
+  followed by a barrier so that later work can't overwrite the buffers before they've been read, but unlike a map
+  the host never waits on it. Snapshots only block when every staging buffer is still waiting to be written. */
+#define GPRT_CHECKPOINT_MAGIC  0x54504B4354525047ull   // "GPRTCKPT"
+#define GPRT_CHECKPOINT_FORMAT 1
+
+// A checkpoint file is this header, then the size of each buffer as a uint64_t, then the contents of each buffer
+struct CheckpointHeader {
+  uint64_t magic;
+  uint32_t format;
+  uint32_t numBuffers;
+  uint64_t version;
+};
+
+struct Checkpoint {
+  struct Slot {
+    Buffer *staging = nullptr;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    std::vector<uint64_t> sizes;
+    uint64_t version = 0;
+    bool busy = false;   // set while the slot's copy or write is in flight
+  };
+
+  Context *context;
+  std::string prefix;
+  std::string lastPath;   // returned by gprtCheckpointGetPath
+  std::vector<Slot> slots;
+  uint32_t nextSlot = 0;
+  uint64_t nextVersion = 0;
+
+  // Everything below is shared with the writer thread
+  std::thread writer;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<uint32_t> pending;
+  bool quit = false;
+
+  static uint64_t alignedSize(uint64_t size) { return (size + 15) & ~uint64_t(15); }
+
+  std::string path(uint64_t version) { return prefix + "." + std::to_string(version) + ".gprtckpt"; }
+
+  // Runs on the writer thread
+  void write(Slot &slot) {
+    std::string target = path(slot.version);
+    std::string partial = target + ".partial";
+    FILE *file = fopen(partial.c_str(), "wb");
+    if (!file) {
+      LOG_WARNING("failed to open " + partial + " for writing, checkpoint " + std::to_string(slot.version) +
+                  " was dropped");
+      return;
+    }
+
+    CheckpointHeader header = {GPRT_CHECKPOINT_MAGIC, GPRT_CHECKPOINT_FORMAT, uint32_t(slot.sizes.size()),
+                               slot.version};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (!slot.sizes.empty())
+      ok = ok && fwrite(slot.sizes.data(), sizeof(uint64_t), slot.sizes.size(), file) == slot.sizes.size();
+    uint8_t *data = (uint8_t *) slot.staging->mapped;
+    for (uint64_t size : slot.sizes) {
+      ok = ok && fwrite(data, 1, size, file) == size;
+      data += alignedSize(size);
+    }
+    ok = (fclose(file) == 0) && ok;
+
+    // Only complete checkpoints ever appear under their final name, so a crash part way through a write can't
+    // leave a truncated checkpoint behind
+    if (ok)
+      ok = std::rename(partial.c_str(), target.c_str()) == 0;
+    if (!ok) {
+      std::remove(partial.c_str());
+      LOG_WARNING("failed to write " + target + ", checkpoint " + std::to_string(slot.version) + " was dropped");
+    }
+  }
+
+  void run() {
+    while (true) {
+      uint32_t slotID;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] { return quit || !pending.empty(); });
+        // Anything already snapshotted is still written before the thread exits
+        if (pending.empty())
+          return;
+        slotID = pending.front();
+      }
+
+      Slot &slot = slots[slotID];
+      vkWaitForFences(context->logicalDevice, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+      write(slot);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.pop_front();
+        slot.busy = false;
+      }
+      condition.notify_all();
+    }
+  }
+};
+
+GPRT_API GPRTCheckpoint
+gprtCheckpointCreate(GPRTContext _context, const char *prefix, uint32_t numSlots) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  if (numSlots == 0)
+    LOG_ERROR("a checkpoint needs at least one staging slot!");
+
+  Checkpoint *checkpoint = new Checkpoint();
+  checkpoint->context = context;
+  checkpoint->prefix = prefix;
+  checkpoint->slots.resize(numSlots);
+  for (auto &slot : checkpoint->slots) {
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = context->graphicsCommandPool;
+    allocInfo.commandBufferCount = 1;
+    VK_CHECK_RESULT(vkAllocateCommandBuffers(context->logicalDevice, &allocInfo, &slot.commandBuffer));
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VK_CHECK_RESULT(vkCreateFence(context->logicalDevice, &fenceInfo, nullptr, &slot.fence));
+  }
+  checkpoint->writer = std::thread(&Checkpoint::run, checkpoint);
+  return (GPRTCheckpoint) checkpoint;
+}
+
+GPRT_API uint64_t
+gprtCheckpointSnapshot(GPRTContext _context, GPRTCheckpoint _checkpoint, uint32_t numBuffers, GPRTBuffer *_buffers) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Checkpoint *checkpoint = (Checkpoint *) _checkpoint;
+  Buffer **buffers = (Buffer **) _buffers;
+
+  // Slots are reused round robin, so if the oldest one is still in flight we have to wait for its write
+  uint32_t slotID = checkpoint->nextSlot;
+  checkpoint->nextSlot = (slotID + 1) % uint32_t(checkpoint->slots.size());
+  Checkpoint::Slot &slot = checkpoint->slots[slotID];
+  {
+    std::unique_lock<std::mutex> lock(checkpoint->mutex);
+    checkpoint->condition.wait(lock, [&] { return !slot.busy; });
+  }
+
+  // Buffers are packed back to back in the slot's staging buffer
+  uint64_t totalSize = 0;
+  slot.sizes.resize(numBuffers);
+  for (uint32_t i = 0; i < numBuffers; ++i) {
+    slot.sizes[i] = buffers[i]->getSize();
+    totalSize += Checkpoint::alignedSize(slot.sizes[i]);
+  }
+  if (!slot.staging || slot.staging->getSize() < totalSize) {
+    if (slot.staging)
+      gprtBufferDestroy((GPRTBuffer) slot.staging);
+    slot.staging = (Buffer *) gprtHostBufferCreate(_context, std::max<uint64_t>(totalSize, 16), 1);
+  }
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  VK_CHECK_RESULT(vkBeginCommandBuffer(slot.commandBuffer, &beginInfo));
+
+  // Make prior writes to the buffers visible to the copies
+  VkMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+                       &barrier, 0, nullptr, 0, nullptr);
+
+  VkDeviceSize offset = 0;
+  for (uint32_t i = 0; i < numBuffers; ++i) {
+    // Vulkan disallows zero sized regions
+    if (slot.sizes[i] > 0) {
+      VkBufferCopy region;
+      region.srcOffset = buffers[i]->poolOffset;
+      region.dstOffset = slot.staging->poolOffset + offset;
+      region.size = slot.sizes[i];
+      vkCmdCopyBuffer(slot.commandBuffer, buffers[i]->buffer, slot.staging->buffer, 1, &region);
+      context->counters.stagingCopies++;
+      context->counters.bytesDownloaded += region.size;
+    }
+    offset += Checkpoint::alignedSize(slot.sizes[i]);
+  }
+
+  // Later submissions to this queue can't write to the buffers until the copies have read them, and the copied
+  // data must be visible to the writer thread once the fence signals
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0,
+                       nullptr);
+  VK_CHECK_RESULT(vkEndCommandBuffer(slot.commandBuffer));
+
+  VK_CHECK_RESULT(vkResetFences(context->logicalDevice, 1, &slot.fence));
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &slot.commandBuffer;
+  VkResult err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, slot.fence);
+  if (err)
+    LOG_ERROR("failed to submit to queue for checkpoint snapshot! : \n" + errorString(err));
+
+  uint64_t version = checkpoint->nextVersion++;
+  {
+    std::lock_guard<std::mutex> lock(checkpoint->mutex);
+    slot.version = version;
+    slot.busy = true;
+    checkpoint->pending.push_back(slotID);
+  }
+  checkpoint->condition.notify_all();
+  return version;
+}
+
+GPRT_API void
+gprtCheckpointWait(GPRTCheckpoint _checkpoint) {
+  LOG_API_CALL();
+  Checkpoint *checkpoint = (Checkpoint *) _checkpoint;
+  std::unique_lock<std::mutex> lock(checkpoint->mutex);
+  checkpoint->condition.wait(lock, [&] { return checkpoint->pending.empty(); });
+}
+
+GPRT_API const char *
+gprtCheckpointGetPath(GPRTCheckpoint _checkpoint, uint64_t version) {
+  LOG_API_CALL();
+  Checkpoint *checkpoint = (Checkpoint *) _checkpoint;
+  checkpoint->lastPath = checkpoint->path(version);
+  return checkpoint->lastPath.c_str();
+}
+
+GPRT_API void
+gprtCheckpointDestroy(GPRTCheckpoint _checkpoint) {
+  LOG_API_CALL();
+  Checkpoint *checkpoint = (Checkpoint *) _checkpoint;
+  Context *context = checkpoint->context;
+  {
+    std::lock_guard<std::mutex> lock(checkpoint->mutex);
+    checkpoint->quit = true;
+  }
+  checkpoint->condition.notify_all();
+  checkpoint->writer.join();
+
+  for (auto &slot : checkpoint->slots) {
+    vkDestroyFence(context->logicalDevice, slot.fence, nullptr);
+    vkFreeCommandBuffers(context->logicalDevice, context->graphicsCommandPool, 1, &slot.commandBuffer);
+    if (slot.staging)
+      gprtBufferDestroy((GPRTBuffer) slot.staging);
+  }
+  delete checkpoint;
+}
+
+GPRT_API uint64_t
+gprtCheckpointRestore(GPRTContext _context, const char *path, uint32_t numBuffers, GPRTBuffer *_buffers) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Buffer **buffers = (Buffer **) _buffers;
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    LOG_ERROR("failed to open checkpoint " + std::string(path) + "!");
+
+  CheckpointHeader header;
+  file.read((char *) &header, sizeof(header));
+  if (!file || header.magic != GPRT_CHECKPOINT_MAGIC)
+    LOG_ERROR(std::string(path) + " is not a checkpoint!");
+  if (header.format != GPRT_CHECKPOINT_FORMAT)
+    LOG_ERROR(std::string(path) + " has unsupported checkpoint format " + std::to_string(header.format) + "!");
+  if (header.numBuffers != numBuffers)
+    LOG_ERROR(std::string(path) + " holds " + std::to_string(header.numBuffers) + " buffers, but " +
+              std::to_string(numBuffers) + " were given to restore!");
+
+  std::vector<uint64_t> sizes(numBuffers);
+  uint64_t totalSize = 0;
+  file.read((char *) sizes.data(), sizeof(uint64_t) * numBuffers);
+  for (uint32_t i = 0; i < numBuffers; ++i) {
+    if (sizes[i] != buffers[i]->getSize())
+      LOG_ERROR("buffer " + std::to_string(i) + " is " + std::to_string(buffers[i]->getSize()) + " bytes, but " +
+                std::string(path) + " holds " + std::to_string(sizes[i]) + " bytes for it!");
+    totalSize += Checkpoint::alignedSize(sizes[i]);
+  }
+
+  // Read everything into one staging buffer, then upload it with a single submission
+  Buffer *staging = (Buffer *) gprtHostBufferCreate(_context, std::max<uint64_t>(totalSize, 16), 1);
+  uint8_t *data = (uint8_t *) staging->mapped;
+  for (uint32_t i = 0; i < numBuffers; ++i) {
+    file.read((char *) data, sizes[i]);
+    data += Checkpoint::alignedSize(sizes[i]);
+  }
+  if (!file) {
+    gprtBufferDestroy((GPRTBuffer) staging);
+    LOG_ERROR(std::string(path) + " is truncated!");
+  }
+
+  VkCommandBuffer commandBuffer = context->beginSingleTimeCommands(context->graphicsCommandPool);
+  VkDeviceSize offset = 0;
+  for (uint32_t i = 0; i < numBuffers; ++i) {
+    if (sizes[i] > 0) {
+      VkBufferCopy region;
+      region.srcOffset = staging->poolOffset + offset;
+      region.dstOffset = buffers[i]->poolOffset;
+      region.size = sizes[i];
+      vkCmdCopyBuffer(commandBuffer, staging->buffer, buffers[i]->buffer, 1, &region);
+      context->counters.stagingCopies++;
+      context->counters.bytesUploaded += region.size;
+    }
+    offset += Checkpoint::alignedSize(sizes[i]);
+  }
+  context->endSingleTimeCommands(commandBuffer, context->graphicsCommandPool, context->graphicsQueue);
+  gprtBufferDestroy((GPRTBuffer) staging);
+  return header.version;
+}
+
+/*! A device hash map is just three device buffers, whose layout is described by gprt::HashMap. All of the
+  probing happens in device code, so the host only creates, clears and extracts the map. */
+struct HashMap {
+  Buffer *keys = nullptr;
+  Buffer *values = nullptr;
+  Buffer *stats = nullptr;
+  uint32_t capacity = 0;
+
+  gprt::HashMap getHandle() {
+    gprt::HashMap handle = {};
+    handle.keys = (uint32_t *) keys->getDeviceAddress();
+    handle.values = (uint32_t *) values->getDeviceAddress();
+    handle.stats = (uint32_t *) stats->getDeviceAddress();
+    handle.capacity = capacity;
+    return handle;
+  }
+
+  // Copies the statistics words written by device code back to the host
+  void readStats(uint32_t out[3]) {
+    bool wasMapped = stats->mapped != nullptr;
+    if (!wasMapped)
+      stats->map();
+    memcpy(out, stats->mapped, 3 * sizeof(uint32_t));
+    if (!wasMapped)
+      stats->unmap();
+  }
+};
+
+GPRT_API GPRTHashMap
+gprtHashMapCreate(GPRTContext _context, size_t capacity) {
+  LOG_API_CALL();
+  if (capacity == 0)
+    LOG_ERROR("hash map capacity must be non-zero!");
+  if (capacity > (size_t(1) << 31))
+    LOG_ERROR("hash maps support at most 2^31 slots!");
+
+  // A power of two capacity lets probing wrap with a mask rather than a modulo
+  uint32_t rounded = 1;
+  while (rounded < capacity)
+    rounded <<= 1;
+
+  HashMap *map = new HashMap();
+  map->capacity = rounded;
+  map->keys = (Buffer *) gprtDeviceBufferCreate(_context, sizeof(uint32_t), rounded);
+  map->values = (Buffer *) gprtDeviceBufferCreate(_context, sizeof(uint32_t), rounded);
+  map->stats = (Buffer *) gprtDeviceBufferCreate(_context, sizeof(uint32_t), 4);
+  gprtHashMapClear(_context, (GPRTHashMap) map);
+  return (GPRTHashMap) map;
+}
+
+GPRT_API gprt::HashMap
+gprtHashMapGetHandle(GPRTHashMap _map) {
+  LOG_API_CALL();
+  HashMap *map = (HashMap *) _map;
+  return map->getHandle();
+}
+
+GPRT_API void
+gprtHashMapClear(GPRTContext _context, GPRTHashMap _map) {
+  LOG_API_CALL();
+  HashMap *map = (HashMap *) _map;
+  uint32_t empty = GPRT_HASH_MAP_EMPTY;
+  gprtBufferFill(_context, (GPRTBuffer) map->keys, &empty, sizeof(uint32_t));
+  map->values->clear();
+  map->stats->clear();
+}
+
+GPRT_API uint32_t
+gprtHashMapExtract(GPRTContext _context, GPRTHashMap _map, GPRTBuffer _keys, GPRTBuffer _values) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  HashMap *map = (HashMap *) _map;
+  Buffer *keys = (Buffer *) _keys;
+  Buffer *values = (Buffer *) _values;
+
+  uint32_t stats[3];
+  map->readStats(stats);
+  uint32_t count = stats[0];
+  if (keys && keys->getSize() < count * sizeof(uint32_t))
+    LOG_ERROR("keys buffer is too small to hold the entries of the hash map!");
+  if (values && values->getSize() < count * sizeof(uint32_t))
+    LOG_ERROR("values buffer is too small to hold the entries of the hash map!");
+  if (count == 0 || (!keys && !values))
+    return count;
+
+  // Keys are unique, so sorting the packed (key, value) pairs orders them by key alone
+  GPRTBuffer packed = gprtDeviceBufferCreate(_context, sizeof(uint64_t), count);
+  GPRTBuffer counter = gprtDeviceBufferCreate(_context, sizeof(uint32_t), 1);
+  GPRTBuffer scratch = gprtDeviceBufferCreate(_context, 1, 1);
+  gprtBufferClear(counter);
+
+  HashMapExtractParameters params = {};
+  params.map = map->getHandle();
+  params.packed = (uint64_t *) ((Buffer *) packed)->getDeviceAddress();
+  params.count = (uint32_t *) ((Buffer *) counter)->getDeviceAddress();
+  params.keys = keys ? (uint32_t *) keys->getDeviceAddress() : nullptr;
+  params.values = values ? (uint32_t *) values->getDeviceAddress() : nullptr;
+  params.numPacked = count;
+
+  uint32_t numGroups = initializerNumGroups(map->capacity);
+  params.stride = numGroups * HASH_MAP_THREADGROUP_SIZE;
+  auto Compact = (GPRTComputeOf<HashMapExtractParameters>) context->internalComputePrograms["HashMapCompact"];
+  gprtComputeLaunch(Compact, uint3(numGroups, 1, 1), uint3(HASH_MAP_THREADGROUP_SIZE, 1, 1), params);
+
+  bufferSort(_context, packed, nullptr, scratch, count);
+
+  numGroups = initializerNumGroups(count);
+  params.stride = numGroups * HASH_MAP_THREADGROUP_SIZE;
+  auto Unpack = (GPRTComputeOf<HashMapExtractParameters>) context->internalComputePrograms["HashMapUnpack"];
+  gprtComputeLaunch(Unpack, uint3(numGroups, 1, 1), uint3(HASH_MAP_THREADGROUP_SIZE, 1, 1), params);
+
+  gprtBufferDestroy(scratch);
+  gprtBufferDestroy(counter);
+  gprtBufferDestroy(packed);
+  return count;
+}
+
+GPRT_API void
+gprtHashMapGetStats(GPRTHashMap _map, GPRTHashMapStats *stats) {
+  LOG_API_CALL();
+  HashMap *map = (HashMap *) _map;
+  uint32_t words[3];
+  map->readStats(words);
+  stats->capacity = map->capacity;
+  stats->size = words[0];
+  stats->loadFactor = float(words[0]) / float(map->capacity);
+  stats->failedInsertions = words[1];
+  stats->maxProbeLength = words[2];
+}
+
+GPRT_API void
+gprtHashMapDestroy(GPRTHashMap _map) {
+  LOG_API_CALL();
+  HashMap *map = (HashMap *) _map;
+  gprtBufferDestroy((GPRTBuffer) map->stats);
+  gprtBufferDestroy((GPRTBuffer) map->values);
+  gprtBufferDestroy((GPRTBuffer) map->keys);
+  delete map;
+}
+
+// Shared implementation of gprtTallyScoreGrid and gprtTallyScoreMesh
+static void
+tallyScore(Context *context, Buffer *tracks, size_t numTracks, Buffer *bins, TallyParameters params,
+           GPRTTallyAccumulation accumulation, const char *direct, const char *privatized) {
+  if (numTracks == 0)
+    numTracks = tracks->getSize() / sizeof(gprt::TallyTrack);
+  if (numTracks > tracks->getSize() / sizeof(gprt::TallyTrack))
+    LOG_ERROR("numTracks exceeds the number of tracks!");
+  if (numTracks >= UINT32_MAX)
+    LOG_ERROR("tallies score fewer than 2^32 tracks at a time!");
+  if (bins->getSize() < size_t(params.numBins) * sizeof(float))
+    LOG_ERROR("bins buffer must hold one float per bin!");
+  if (numTracks == 0 || params.numBins == 0)
+    return;
+
+  params.tracks = (gprt::TallyTrack *) tracks->getDeviceAddress();
+  params.bins = (float *) bins->getDeviceAddress();
+  params.count = (uint32_t) numTracks;
+
+  // Privatized bins have to fit in shared memory
+  if (accumulation == GPRT_TALLY_PRIVATIZED && params.numBins > TALLY_PRIVATE_BINS)
+    accumulation = GPRT_TALLY_SUBGROUP;
+  params.accumulation = (uint32_t) accumulation;
+
+  size_t numGroups = (numTracks + TALLY_THREADGROUP_SIZE - 1) / TALLY_THREADGROUP_SIZE;
+  numGroups = std::min<size_t>(numGroups, (accumulation == GPRT_TALLY_PRIVATIZED) ? TALLY_PRIVATE_GROUPS
+                                                                                   : WORKGROUP_LIMIT);
+  params.stride = uint32_t(numGroups) * TALLY_THREADGROUP_SIZE;
+  auto program = (GPRTComputeOf<TallyParameters>)
+      context->internalComputePrograms[(accumulation == GPRT_TALLY_PRIVATIZED) ? privatized : direct];
+  gprtComputeLaunch(program, uint3(uint32_t(numGroups), 1, 1), uint3(TALLY_THREADGROUP_SIZE, 1, 1), params);
+}
+
+GPRT_API void
+gprtTallyScoreGrid(GPRTContext _context, GPRTBuffer _tracks, size_t numTracks, gprt::TallyGrid grid,
+                   GPRTBuffer _bins, GPRTTallyAccumulation accumulation) {
+  LOG_API_CALL();
+  if (grid.dims.x == 0 || grid.dims.y == 0 || grid.dims.z == 0)
+    LOG_ERROR("tally grids must have at least one bin along each axis!");
+  if (!(grid.lower.x < grid.upper.x && grid.lower.y < grid.upper.y && grid.lower.z < grid.upper.z))
+    LOG_ERROR("tally grids must have a lower corner below their upper corner!");
+  size_t numBins = size_t(grid.dims.x) * grid.dims.y * grid.dims.z;
+  if (numBins >= UINT32_MAX)
+    LOG_ERROR("tally grids support fewer than 2^32 bins!");
+
+  TallyParameters params = {};
+  params.grid = grid;
+  params.numBins = (uint32_t) numBins;
+  tallyScore((Context *) _context, (Buffer *) _tracks, numTracks, (Buffer *) _bins, params, accumulation,
+             "TallyScoreGrid", "TallyScoreGridPrivatized");
+}
+
+GPRT_API void
+gprtTallyScoreMesh(GPRTContext _context, GPRTBuffer _tracks, size_t numTracks, gprt::SolidMesh mesh,
+                   GPRTBuffer _bins, GPRTTallyAccumulation accumulation) {
+  LOG_API_CALL();
+  if (!mesh.adjacency)
+    LOG_ERROR("tally meshes come from gprtSolidsGetMesh, after gprtSolidsBuildAdjacency!");
+
+  TallyParameters params = {};
+  params.mesh = mesh;
+  params.numBins = mesh.count;
+  tallyScore((Context *) _context, (Buffer *) _tracks, numTracks, (Buffer *) _bins, params, accumulation,
+             "TallyScoreMesh", "TallyScoreMeshPrivatized");
+}
+
 // GPRT_API gprt::Buffer
 // gprtBufferGetHandle(GPRTBuffer _buffer, int deviceID) {
 //   LOG_API_CALL();
@@ -8572,6 +12315,45 @@ gprtSolidAccelCreate(GPRTContext _context, GPRTGeom _geom, unsigned int flags) {
   return (GPRTAccel) accel;
 }
 
+GPRT_API GPRTAccel
+gprtVoxelAccelCreate(GPRTContext _context, GPRTGeom _geom, unsigned int flags) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Geom* geom = ((Geom*)_geom);
+  if (geom->geomType->getKind() != GPRT_VOXELS) {
+    LOG_ERROR("Given geometry was made from an incompatible geometry type.");
+  }
+  std::vector<VoxelGeom*> geo = {(VoxelGeom *) _geom};
+  VoxelAccel *accel = new VoxelAccel(context, geo, flags);
+  return (GPRTAccel) accel;
+}
+
+GPRT_API GPRTAccel
+gprtCurveAccelCreate(GPRTContext _context, GPRTGeom _geom, unsigned int flags) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Geom* geom = ((Geom*)_geom);
+  if (geom->geomType->getKind() != GPRT_CURVES) {
+    LOG_ERROR("Given geometry was made from an incompatible geometry type.");
+  }
+  std::vector<CurveGeom*> geo = {(CurveGeom *) _geom};
+  CurveAccel *accel = new CurveAccel(context, geo);
+  return (GPRTAccel) accel;
+}
+
+GPRT_API GPRTAccel
+gprtMotionTriangleAccelCreate(GPRTContext _context, GPRTGeom _geom, unsigned int flags) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Geom* geom = ((Geom*)_geom);
+  if (geom->geomType->getKind() != GPRT_MOTION_TRIANGLES) {
+    LOG_ERROR("Given geometry was made from an incompatible geometry type.");
+  }
+  std::vector<MotionTriangleGeom*> geo = {(MotionTriangleGeom *) _geom};
+  MotionTriangleAccel *accel = new MotionTriangleAccel(context, geo);
+  return (GPRTAccel) accel;
+}
+
 GPRT_API GPRTAccel
 gprtInstanceAccelCreate(GPRTContext _context, uint32_t numInstances, GPRTBufferOf<gprt::Instance> instancesBuffer) {
   LOG_API_CALL();
@@ -8640,6 +12422,16 @@ gprtAccelGetInstance(GPRTAccel _accel) {
   return newInstance;
 }
 
+GPRT_API void
+gprtAccelRasterizeVisibility(GPRTContext _context, GPRTAccel _accel, GPRTBuffer _visibility, uint32_t width,
+                             uint32_t height, float4x4 viewProjection, float3 cameraPosition) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  Accel *accel = (Accel *) _accel;
+  Buffer *visibility = (Buffer *) _visibility;
+  context->rasterizeVisibility(accel, visibility, width, height, viewProjection, cameraPosition);
+}
+
 GPRT_API void
 gprtBuildShaderBindingTable(GPRTContext _context, GPRTBuildSBTFlags flags) {
   LOG_API_CALL();
@@ -8671,11 +12463,26 @@ gprtRayGenLaunch3D(GPRTContext _context, GPRTRayGen _rayGen, uint32_t dims_x, ui
   RayGen *raygen = (RayGen *) _rayGen;
   VkResult err;
 
+  // Make room for one ray time per launch index. Only the slot is baked into the pipeline, so this needs no rebuild.
+  if (context->rayTimeSlot) {
+    size_t numRays = size_t(dims_x) * size_t(dims_y) * size_t(dims_z);
+    if (!context->rayTimes || context->rayTimes->getSize() < numRays * sizeof(float)) {
+      if (context->rayTimes)
+        gprtBufferDestroy((GPRTBuffer) context->rayTimes);
+      context->rayTimes = (Buffer *) gprtDeviceBufferCreate(_context, sizeof(float), numRays, nullptr);
+      uint64_t address = context->rayTimes->getDeviceAddress();
+      context->rayTimeSlot->map();
+      memcpy(context->rayTimeSlot->mapped, &address, sizeof(uint64_t));
+      context->rayTimeSlot->unmap();
+    }
+  }
+
   VkCommandBufferBeginInfo cmdBufInfo{};
   cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
   err = vkBeginCommandBuffer(context->graphicsCommandBuffer, &cmdBufInfo);
 
+  context->flushDescriptorWrites();
   std::vector<VkDescriptorSet> descriptorSets = {context->descriptorSet};
   vkCmdBindDescriptorSets(context->graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR,
                           context->raytracingPipelineLayout, 0, (uint32_t) descriptorSets.size(), descriptorSets.data(),
@@ -8699,11 +12506,11 @@ gprtRayGenLaunch3D(GPRTContext _context, GPRTRayGen _rayGen, uint32_t dims_x, ui
                        0, pushConstantsSize, pushConstants);
   }
 
-  auto getBufferDeviceAddress = [](VkDevice device, VkBuffer buffer) -> uint64_t {
+  auto getBufferDeviceAddress = [context](VkDevice device, VkBuffer buffer) -> uint64_t {
     VkBufferDeviceAddressInfoKHR bufferDeviceAI{};
     bufferDeviceAI.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
     bufferDeviceAI.buffer = buffer;
-    return gprt::vkGetBufferDeviceAddress(device, &bufferDeviceAI);
+    return context->vkGetBufferDeviceAddress(device, &bufferDeviceAI);
   };
 
   auto alignedSize = [](uint32_t value, uint32_t alignment) -> uint32_t {
@@ -8715,10 +12522,10 @@ gprtRayGenLaunch3D(GPRTContext _context, GPRTRayGen _rayGen, uint32_t dims_x, ui
   const uint32_t groupAlignment = context->rayTracingPipelineProperties.shaderGroupHandleAlignment;
   const uint32_t maxShaderRecordStride = context->rayTracingPipelineProperties.maxShaderGroupStride;
 
-  const uint32_t raygenRecordSize   = alignedSize(std::min(maxGroupSize, requestedFeatures.raygenRecordSize + requestedFeatures.internalAdditionalSize), groupAlignment);
-  const uint32_t hitRecordSize      = alignedSize(std::min(maxGroupSize, requestedFeatures.hitRecordSize + requestedFeatures.internalAdditionalSize), groupAlignment);
-  const uint32_t missRecordSize     = alignedSize(std::min(maxGroupSize, requestedFeatures.missRecordSize + requestedFeatures.internalAdditionalSize), groupAlignment);
-  const uint32_t callableRecordSize = alignedSize(std::min(maxGroupSize, requestedFeatures.callableRecordSize + requestedFeatures.internalAdditionalSize), groupAlignment);
+  const uint32_t raygenRecordSize   = alignedSize(std::min(maxGroupSize, context->features.raygenRecordSize + context->features.internalAdditionalSize), groupAlignment);
+  const uint32_t hitRecordSize      = alignedSize(std::min(maxGroupSize, context->features.hitRecordSize + context->features.internalAdditionalSize), groupAlignment);
+  const uint32_t missRecordSize     = alignedSize(std::min(maxGroupSize, context->features.missRecordSize + context->features.internalAdditionalSize), groupAlignment);
+  const uint32_t callableRecordSize = alignedSize(std::min(maxGroupSize, context->features.callableRecordSize + context->features.internalAdditionalSize), groupAlignment);
 
 
   uint64_t raygenBaseAddr = getBufferDeviceAddress(context->logicalDevice, context->raygenTable->buffer);
@@ -8767,8 +12574,8 @@ gprtRayGenLaunch3D(GPRTContext _context, GPRTRayGen _rayGen, uint32_t dims_x, ui
     hitShaderSbtEntry.size = hitShaderSbtEntry.stride * numHitRecords;
   }
 
-  gprt::vkCmdTraceRays(context->graphicsCommandBuffer, &raygenShaderSbtEntry, &missShaderSbtEntry, &hitShaderSbtEntry,
-                       &callableShaderSbtEntry, dims_x, dims_y, dims_z);
+  context->vkCmdTraceRays(context->graphicsCommandBuffer, &raygenShaderSbtEntry, &missShaderSbtEntry,
+                          &hitShaderSbtEntry, &callableShaderSbtEntry, dims_x, dims_y, dims_z);
 
   if (context->queryRequested)
     vkCmdWriteTimestamp(context->graphicsCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, context->queryPool, 1);
@@ -8788,26 +12595,19 @@ gprtRayGenLaunch3D(GPRTContext _context, GPRTRayGen _rayGen, uint32_t dims_x, ui
   submitInfo.signalSemaphoreCount = 0;
   submitInfo.pSignalSemaphores = nullptr;   //&writeImageSemaphoreHandleList[currentImageIndex]};
 
-  err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+  err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
   if (err)
     LOG_ERROR("failed to submit to queue! : \n" + errorString(err));
 
-  err = vkQueueWaitIdle(context->graphicsQueue);
+  err = context->queueWaitIdle(context->graphicsQueue);
   if (err)
     LOG_ERROR("failed to wait for queue idle! : \n" + errorString(err));
 }
 
-void
-_gprtComputeLaunch(GPRTCompute _compute, uint3 numGroups, uint3 groupSize,
-                   std::array<char, PUSH_CONSTANTS_LIMIT> pushConstants) {
-  Compute *compute = (Compute *) _compute;
+static void
+dispatchCompute(Compute *compute, VkPipeline pipeline, uint3 numGroups,
+                const std::array<char, PUSH_CONSTANTS_LIMIT> &pushConstants) {
   Context *context = compute->context;
-
-  // Build / update the compute pipeline if required
-  if (compute->pipeline == VK_NULL_HANDLE) {
-    compute->buildPipeline(context->descriptorSetLayout);
-  }
-
   VkResult err;
 
   VkCommandBufferBeginInfo cmdBufInfo{};
@@ -8820,8 +12620,9 @@ _gprtComputeLaunch(GPRTCompute _compute, uint3 numGroups, uint3 groupSize,
     vkCmdWriteTimestamp(context->graphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, context->queryPool, 0);
   }
 
-  vkCmdBindPipeline(context->graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute->pipeline);
+  vkCmdBindPipeline(context->graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
 
+  context->flushDescriptorWrites();
   std::vector<VkDescriptorSet> descriptorSets = {context->descriptorSet};
 
   vkCmdBindDescriptorSets(context->graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute->pipelineLayout, 0,
@@ -8852,15 +12653,154 @@ _gprtComputeLaunch(GPRTCompute _compute, uint3 numGroups, uint3 groupSize,
   submitInfo.signalSemaphoreCount = 0;
   submitInfo.pSignalSemaphores = nullptr;   //&writeImageSemaphoreHandleList[currentImageIndex]};
 
-  err = vkQueueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+  err = context->queueSubmit(context->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
   if (err)
     LOG_ERROR("failed to submit to queue! : \n" + errorString(err));
 
-  err = vkQueueWaitIdle(context->graphicsQueue);
+  err = context->queueWaitIdle(context->graphicsQueue);
   if (err)
     LOG_ERROR("failed to wait for queue idle! : \n" + errorString(err));
 }
 
+void
+_gprtComputeLaunch(GPRTCompute _compute, uint3 numGroups, uint3 groupSize,
+                   std::array<char, PUSH_CONSTANTS_LIMIT> pushConstants) {
+  Compute *compute = (Compute *) _compute;
+  Context *context = compute->context;
+
+  // Build / update the compute pipeline if required
+  if (compute->pipeline == VK_NULL_HANDLE) {
+    compute->buildPipeline(context->descriptorSetLayout);
+  }
+
+  // Tuned kernels are one dimensional, so keep the total thread count and only regroup the threads
+  VkPipeline pipeline = compute->pipeline;
+  uint32_t tunedGroupSize = compute->getTunedGroupSize();
+  if (tunedGroupSize != 0 && groupSize[1] == 1 && groupSize[2] == 1 &&
+      numGroups[1] == 1 && numGroups[2] == 1) {
+    uint64_t numThreads = uint64_t(numGroups[0]) * groupSize[0];
+    uint64_t tunedNumGroups = (numThreads + tunedGroupSize - 1) / tunedGroupSize;
+    if (tunedNumGroups <= WORKGROUP_LIMIT) {
+      pipeline = compute->getPipeline(tunedGroupSize);
+      numGroups[0] = uint32_t(tunedNumGroups);
+    }
+  }
+
+  dispatchCompute(compute, pipeline, numGroups, pushConstants);
+}
+
+// Candidate group sizes, all multiples of the subgroup sizes of current hardware
+static const uint32_t autotuneGroupSizes[] = {32, 64, 128, 256, 512, 1024};
+// Each candidate is launched once to warm up, and then the fastest of this many launches is kept
+#define AUTOTUNE_REPETITIONS 5
+
+static float getProfileMilliseconds(Context *context);
+
+static void
+saveTuningCache(Context *context) {
+  std::ofstream file(context->tuningCachePath);
+  if (!file.is_open()) {
+    LOG_WARNING("Unable to write the tuning cache \"" + context->tuningCachePath + "\"");
+    return;
+  }
+  file << "# GPRT workgroup size tuning cache, <vendor:device:driver> <entrypoint:hash> <group size>\n";
+  for (auto &entry : context->tuningCache)
+    file << entry.first << " " << entry.second << "\n";
+}
+
+uint32_t
+_gprtComputeAutotune(GPRTCompute _compute, uint32_t numThreads, std::array<char, PUSH_CONSTANTS_LIMIT> pushConstants) {
+  Compute *compute = (Compute *) _compute;
+  Context *context = compute->context;
+
+  if (!compute->tunable) {
+    LOG_ERROR("\"" + compute->entryPoint + "\" has a fixed group size, and so cannot be tuned. Declare it with the " +
+              "GPRT_GROUP_SIZE_CONSTANT_ID specialization constant instead.");
+  }
+
+  if (compute->pipeline == VK_NULL_HANDLE) {
+    compute->buildPipeline(context->descriptorSetLayout);
+  }
+
+  uint32_t maxGroupSize = std::min<uint32_t>(
+      {THREADGROUP_LIMIT, context->deviceProperties.limits.maxComputeWorkGroupSize[0],
+       context->deviceProperties.limits.maxComputeWorkGroupInvocations});
+
+  // Timing reuses the profiling queries, so whatever profile is in progress is interrupted
+  bool queryRequested = context->queryRequested;
+  context->queryRequested = true;
+
+  uint32_t bestGroupSize = 0;
+  float bestTime = std::numeric_limits<float>::max();
+  for (uint32_t groupSize : autotuneGroupSizes) {
+    uint64_t numGroups = (uint64_t(numThreads) + groupSize - 1) / groupSize;
+    if (groupSize > maxGroupSize || numGroups > WORKGROUP_LIMIT || numGroups == 0)
+      continue;
+
+    VkPipeline pipeline = compute->getPipeline(groupSize);
+    float time = std::numeric_limits<float>::max();
+    for (uint32_t i = 0; i <= AUTOTUNE_REPETITIONS; ++i) {
+      dispatchCompute(compute, pipeline, {uint32_t(numGroups), 1, 1}, pushConstants);
+      float milliseconds = getProfileMilliseconds(context);
+      if (i > 0)
+        time = std::min(time, milliseconds);
+    }
+
+    if (time < bestTime) {
+      bestTime = time;
+      bestGroupSize = groupSize;
+    }
+  }
+
+  context->queryRequested = queryRequested;
+
+  if (bestGroupSize == 0) {
+    LOG_WARNING("No candidate group size fits " + std::to_string(numThreads) + " threads of \"" +
+                compute->entryPoint + "\", keeping its own group size");
+    return 0;
+  }
+
+  compute->tunedGroupSize = bestGroupSize;
+  if (!context->tuningCachePath.empty()) {
+    context->tuningCache[context->getTuningDeviceKey() + " " + compute->tuningKey] = bestGroupSize;
+    saveTuningCache(context);
+  }
+  return bestGroupSize;
+}
+
+GPRT_API uint32_t
+gprtComputeGetGroupSize(GPRTCompute _compute) {
+  LOG_API_CALL();
+  Compute *compute = (Compute *) _compute;
+  return compute->getTunedGroupSize();
+}
+
+GPRT_API void
+gprtContextSetTuningCache(GPRTContext _context, const char *path) {
+  LOG_API_CALL();
+  Context *context = (Context *) _context;
+  context->tuningCache.clear();
+  context->tuningCachePath = (path) ? std::string(path) : std::string();
+  if (context->tuningCachePath.empty())
+    return;
+
+  // A missing file is fine, it'll be made by the first tuning run
+  std::ifstream file(context->tuningCachePath);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::istringstream entry(line);
+    std::string deviceKey, kernelKey;
+    uint32_t groupSize = 0;
+    if (!(entry >> deviceKey >> kernelKey >> groupSize) || groupSize == 0 || groupSize > THREADGROUP_LIMIT) {
+      LOG_WARNING("Ignoring malformed tuning cache entry \"" + line + "\"");
+      continue;
+    }
+    context->tuningCache[deviceKey + " " + kernelKey] = groupSize;
+  }
+}
+
 GPRT_API void
 gprtBeginProfile(GPRTContext _context) {
   LOG_API_CALL();
@@ -8879,6 +12819,11 @@ gprtEndProfile(GPRTContext _context) {
     LOG_ERROR("Requested profile data without calling gprtBeginProfile");
   context->queryRequested = false;
 
+  return getProfileMilliseconds(context);
+}
+
+static float
+getProfileMilliseconds(Context *context) {
   uint64_t timestampsResults[2];
   VkResult result =
       vkGetQueryPoolResults(context->logicalDevice, context->queryPool, 0, 2, sizeof(uint64_t) * 2, timestampsResults,
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "gprt.h"
+
+// Scalar types understood by the iota and random buffer initializers.
+// Note, these must match the values of GPRTScalarType in gprt_host.h
+#define BUFFER_SCALAR_UINT32  0
+#define BUFFER_SCALAR_INT32   1
+#define BUFFER_SCALAR_FLOAT32 2
+
+// Largest repeating pattern, in 32-bit words, that BufferFill can write.
+// Keeps BufferFillParameters within PUSH_CONSTANTS_LIMIT.
+#define BUFFER_FILL_MAX_PATTERN_WORDS 32
+
+// All buffer initializers use a grid-stride loop, so that arbitrarily large
+// buffers can be initialized without exceeding WORKGROUP_LIMIT.
+#define BUFFER_INIT_THREADGROUP_SIZE 256
+
+struct BufferFillParameters {
+  uint32_t *buffer;
+  uint32_t count;          // number of times the pattern is repeated
+  uint32_t stride;         // total number of threads in the launch
+  uint32_t patternWords;   // number of 32-bit words in the pattern
+  uint32_t pattern[BUFFER_FILL_MAX_PATTERN_WORDS];
+};
+
+struct BufferIotaParameters {
+  uint32_t *buffer;
+  uint32_t count;
+  uint32_t stride;
+  uint32_t type;
+  uint32_t start;   // bit pattern of the first value
+  uint32_t step;    // bit pattern of the increment
+};
+
+struct BufferRandomParameters {
+  uint32_t *buffer;
+  uint32_t count;
+  uint32_t stride;
+  uint32_t type;
+  uint32_t seed;
+  uint32_t lower;   // bit pattern of the (inclusive) lower bound
+  uint32_t upper;   // bit pattern of the (exclusive) upper bound
+};
+
+// Gather and scatter move elements of elementWords 32-bit words between buffers.
+// Strides allow reading or writing a member out of a larger structure.
+struct BufferGatherScatterParameters {
+  uint32_t *src;
+  uint32_t *dst;
+  uint32_t *indices;
+  uint32_t count;
+  uint32_t stride;           // total number of threads in the launch
+  uint32_t elementWords;     // number of 32-bit words per element
+  uint32_t srcStrideWords;   // distance between consecutive source elements
+  uint32_t dstStrideWords;   // distance between consecutive destination elements
+};
+
+// Segments with at most SEGMENTED_SORT_LOCAL_CAPACITY keys are sorted entirely in shared memory, one workgroup
+// per segment. Larger segments are packed back to back and sorted together by two global radix sorts, first by
+// key and then by the packed start of their segment.
+#define SEGMENTED_SORT_THREADGROUP_SIZE 256
+#define SEGMENTED_SORT_KEYS_PER_THREAD  4
+#define SEGMENTED_SORT_LOCAL_CAPACITY   (SEGMENTED_SORT_THREADGROUP_SIZE * SEGMENTED_SORT_KEYS_PER_THREAD)
+
+struct BufferSegmentedSortParameters {
+  uint64_t *keys;
+  uint64_t *values;            // null when sorting keys only
+  uint32_t *segmentOffsets;    // numSegments + 1 offsets, segment i is [offsets[i], offsets[i + 1])
+  uint32_t *counters;          // number of large segments, keys in large segments and invalid segments
+  uint32_t *largeSegments;     // (segment, packed start) of each large segment
+  uint64_t *packedKeys;        // keys of the large segments, packed back to back
+  uint64_t *packedValues;      // null when sorting keys only
+  uint64_t *packedIndices;     // packed position of each key, carried through both global sorts
+  uint64_t *segmentKeys;       // packed start of the segment of each key, sorted on its low 32 bits at most
+  uint32_t *packedStarts;      // packed start of the segment of each packed key
+  uint32_t *packedSources;     // original position of each packed key
+  uint32_t numKeys;
+  uint32_t numSegments;
+  uint32_t numPacked;
+  uint32_t stride;             // total number of workgroups (Local, Gather) or threads (the others) in the launch
+};
+
+// Unique, run length encoding and reduce by key all find the runs of equal keys in three passes over blocks
+// of RUN_BLOCK_SIZE keys: count the run heads per block, scan those counts, then scatter each run's start.
+#define RUN_THREADGROUP_SIZE 256
+#define RUN_KEYS_PER_THREAD  4
+#define RUN_BLOCK_SIZE       (RUN_THREADGROUP_SIZE * RUN_KEYS_PER_THREAD)
+
+struct BufferRunParameters {
+  uint64_t *keys;
+  uint32_t *values;        // values to reduce per run, or null for run lengths
+  uint64_t *runKeys;       // first key of each run, may be null
+  uint32_t *runValues;     // run lengths or per run reductions, may be null
+  uint32_t *runStarts;     // scratch, numRuns + 1 entries
+  uint32_t *blockCounts;   // scratch, run heads per block and then their exclusive scan
+  uint32_t *numRuns;
+  uint32_t count;
+  uint32_t numBlocks;
+  uint32_t type;           // scalar type of the values
+  uint32_t stride;         // total number of workgroups in the launch
+};
+
+#define SEARCH_THREADGROUP_SIZE 256
+
+// Builds the bucket index of a gprt::SortedTable, one thread per bucket boundary
+struct BufferSearchIndexParameters {
+  gprt::SortedTable table;
+  uint32_t stride;   // total number of threads in the launch
+};
+
+// One lower bound search per query
+struct BufferLowerBoundParameters {
+  gprt::SortedTable table;
+  float *queries;
+  uint32_t *results;
+  uint32_t numQueries;
+  uint32_t stride;   // total number of threads in the launch
+};
+
+#define HASH_MAP_THREADGROUP_SIZE 256
+
+// Extracting a hash map packs each occupied slot's key and value into one 64-bit sort key, key in the high bits,
+// which the radix sort then orders by key
+struct HashMapExtractParameters {
+  gprt::HashMap map;
+  uint64_t *packed;
+  uint32_t *count;
+  uint32_t *keys;
+  uint32_t *values;
+  uint32_t numPacked;
+  uint32_t stride;   // total number of threads in the launch
+};
+
+// Compression splits the input into blocks of COMPRESS_BLOCK_WORDS 32-bit words, one word per thread, and stores
+// only the non-zero words of each block, bit packed to the width of the block's largest word. The stream is
+//
+//   [0] number of input words, [1] number of blocks, [2, 2 + numBlocks) one header per block, then the payloads
+//
+// where a header holds the block's non-zero word count in its low 16 bits and the packed width above them. A block's
+// payload is a bitmask of its non-zero words, omitted when every word is non-zero, followed by the packed words.
+#define COMPRESS_BLOCK_WORDS   RUN_THREADGROUP_SIZE   // the block scan is shared with the run primitives
+#define COMPRESS_MASK_WORDS    (COMPRESS_BLOCK_WORDS / 32)
+#define COMPRESS_HEADER_WORDS  2
+#define COMPRESS_MAX_BLOCK_WORDS (COMPRESS_MASK_WORDS + COMPRESS_BLOCK_WORDS - 1)
+
+// The number of payload words following a block with the given header
+inline uint32_t
+compressedBlockWords(uint32_t header) {
+  uint32_t count = header & 0xFFFF;
+  uint32_t bits = header >> 16;
+  if (count == 0)
+    return 0;
+  return ((count < COMPRESS_BLOCK_WORDS) ? COMPRESS_MASK_WORDS : 0) + (count * bits + 31) / 32;
+}
+
+struct BufferCompressParameters {
+  uint32_t *input;
+  uint32_t *stream;
+  uint32_t *blockSizes;   // scratch, payload words per block, then their exclusive scan followed by the total
+  uint32_t numWords;
+  uint32_t numBlocks;
+  uint32_t stride;        // total number of workgroups in the launch
+};
@@ -38,7 +38,8 @@ struct SolidParameters {
   float4 *vertices;
   uint4 *indices;
   uint8_t *types;
-  float4 *aabbs;
+  float4 *aabbs;                    // two per cell, the second holding the cell's value range in zw
+  gprt::SolidValueFilter *filter;   // may be null
   uint32_t offset;
   uint32_t count;
   uint32_t typesOffset;
@@ -47,4 +48,51 @@ struct SolidParameters {
   uint32_t indicesStride;
   uint32_t verticesOffset;
   uint32_t verticesStride;
-};
\ No newline at end of file
+};
+
+// Used both to bound the bricks of a structured grid, and by the built-in DDA intersection program
+struct VoxelParameters {
+  float *values;
+  float3 *aabbs;
+  float3 origin;
+  float3 spacing;
+  uint3 dims;
+  uint3 bricks;            // number of bricks along each axis
+  uint32_t brickSize;      // brick edge length, in voxels
+  uint32_t valuesOffset;   // offset in bytes to the first value
+  uint32_t valuesStride;   // stride in bytes between values
+  uint32_t flags;          // GPRTVoxelFlags
+  uint32_t offset;
+  uint32_t count;          // number of bricks
+};
+
+// Used both to bound the segments of a curve geometry, and by the built-in curve intersection program. Each
+// segment is four consecutive control points, starting at the segment's index, with the radius in w.
+struct CurveParameters {
+  float4 *vertices;
+  uint32_t *indices;
+  float3 *aabbs;
+  uint32_t verticesOffset;   // offset in bytes to the first control point
+  uint32_t verticesStride;   // stride in bytes between control points
+  uint32_t indicesOffset;    // offset in bytes to the first index
+  uint32_t indicesStride;    // stride in bytes between indices
+  uint32_t basis;            // GPRTCurveBasis
+  uint32_t offset;
+  uint32_t count;            // number of segments
+};
+
+// Used both to bound the triangles of a motion geometry over all of its keyframes, and by the built-in motion
+// triangle intersection program. Keyframes are evenly spaced over times 0 to 1, and vertices are interpolated
+// linearly between the two keyframes around a ray's time.
+struct MotionTriangleParameters {
+  float3 **keys;             // the first vertex of each keyframe
+  uint3 *indices;
+  float3 *aabbs;
+  uint32_t numKeys;
+  uint32_t verticesStride;   // stride in bytes between vertices
+  uint32_t indicesOffset;    // offset in bytes to the first index
+  uint32_t indicesStride;    // stride in bytes between indices
+  uint32_t firstVertex;      // added to the index values before fetching vertices
+  uint32_t offset;
+  uint32_t count;            // number of triangles
+};
@@ -105,6 +105,10 @@ using GPRTContext = struct _GPRTContext *;
 using GPRTModule = struct _GPRTModule *;
 using GPRTAccel = struct _GPRTAccel *;
 using GPRTBuffer = struct _GPRTBuffer *;
+using GPRTBufferPool = struct _GPRTBufferPool *;
+using GPRTTransientPool = struct _GPRTTransientPool *;
+using GPRTHashMap = struct _GPRTHashMap *;
+using GPRTCheckpoint = struct _GPRTCheckpoint *;
 using GPRTTexture = struct _GPRTTexture *;
 using GPRTSampler = struct _GPRTSampler *;
 using GPRTGeom = struct _GPRTGeom *;
@@ -201,7 +205,10 @@ typedef enum {
 } GPRTMatrixFormat;
 
 typedef enum { 
-  GPRT_UNKNOWN, GPRT_AABBS, GPRT_TRIANGLES, GPRT_SPHERES, GPRT_LSS, /*bilinear solids?*/GPRT_SOLIDS
+  GPRT_UNKNOWN, GPRT_AABBS, GPRT_TRIANGLES, GPRT_SPHERES, GPRT_LSS, /*bilinear solids?*/GPRT_SOLIDS,
+  /* structured grids, traversed a brick at a time */ GPRT_VOXELS,
+  /* cubic curves, swept by a varying radius */ GPRT_CURVES,
+  /* triangles moving through keyframes, see gprtTrianglesSetMotionVertices */ GPRT_MOTION_TRIANGLES
 } GPRTGeomKind;
 
 
@@ -263,6 +270,25 @@ typedef enum {
   GPRT_LSS_NO_END_CAPS = 2
 } GPRTLSSFlags;
 
+/** Controls which hits the built-in voxel intersection program reports, see gprtVoxelAccelCreate */
+typedef enum {
+  // Report a hit as the ray enters each voxel
+  GPRT_VOXEL_REPORT_EACH_VOXEL = 0,
+  // Merge consecutive voxels of equal value along the ray into a single hit. Runs are split at brick boundaries.
+  GPRT_VOXEL_REPORT_VALUE_CHANGES = 1,
+  // Never report voxels with a value of 0, and leave bricks holding only such voxels out of the tree entirely
+  GPRT_VOXEL_SKIP_EMPTY = 2,
+} GPRTVoxelFlags;
+
+/** The basis in which the control points of a curve geometry are given, see gprtCurvesSetBasis */
+typedef enum {
+  // Each segment is an independent cubic Bézier, which passes through its first and last control points
+  GPRT_CURVE_BEZIER = 0,
+  // Each segment is a uniform cubic B-spline span, so that consecutive segments sharing three control points join
+  // smoothly
+  GPRT_CURVE_BSPLINE = 1,
+} GPRTCurveBasis;
+
 typedef enum {
   GPRT_BUILD_MODE_UNINITIALIZED,
   GPRT_BUILD_MODE_FAST_BUILD_NO_UPDATE,
@@ -271,6 +297,23 @@ typedef enum {
   GPRT_BUILD_MODE_FAST_TRACE_AND_UPDATE,
 } GPRTBuildMode;
 
+/*! scalar element types understood by the device-side buffer initializers */
+typedef enum {
+  GPRT_SCALAR_TYPE_UINT32 = 0,
+  GPRT_SCALAR_TYPE_INT32 = 1,
+  GPRT_SCALAR_TYPE_FLOAT32 = 2,
+} GPRTScalarType;
+
+template <typename T>
+constexpr GPRTScalarType
+gprtScalarTypeOf() {
+  static_assert(std::is_same<T, uint32_t>::value || std::is_same<T, int32_t>::value || std::is_same<T, float>::value,
+                "Only uint32_t, int32_t and float element types are supported");
+  return std::is_same<T, float>::value     ? GPRT_SCALAR_TYPE_FLOAT32
+         : std::is_same<T, int32_t>::value ? GPRT_SCALAR_TYPE_INT32
+                                           : GPRT_SCALAR_TYPE_UINT32;
+}
+
 /*! supported formats for texels in textures */
 typedef enum {
   GPRT_IMAGE_TYPE_1D = VK_IMAGE_TYPE_1D,
@@ -287,6 +330,7 @@ typedef enum {
   GPRT_FORMAT_R8G8B8A8_SRGB = VK_FORMAT_R8G8B8A8_SRGB,
   GPRT_FORMAT_R32_SFLOAT = VK_FORMAT_R32_SFLOAT,
   GPRT_FORMAT_R32G32B32A32_SFLOAT = VK_FORMAT_R32G32B32A32_SFLOAT,
+  GPRT_FORMAT_R32G32B32A32_UINT = VK_FORMAT_R32G32B32A32_UINT,
   GPRT_FORMAT_D32_SFLOAT = VK_FORMAT_D32_SFLOAT
 } GPRTFormat;
 
@@ -394,19 +438,22 @@ gprtTrianglesSetVertices(GPRTGeomOf<T1> triangles, GPRTBufferOf<T2> vertices, ui
   gprtTrianglesSetVertices((GPRTGeom) triangles, (GPRTBuffer) vertices, count, stride, offset);
 }
 
-// GPRT_API void gprtTrianglesSetMotionVertices(GPRTGeom triangles,
-//                                            /*! number of vertex arrays
-//                                                passed here, the first
-//                                                of those is for t=0,
-//                                                thelast for t=1,
-//                                                everything is linearly
-//                                                interpolated
-//                                                in-between */
-//                                            size_t    numKeys,
-//                                            GPRTBuffer *vertexArrays,
-//                                            size_t count,
-//                                            size_t stride,
-//                                            size_t offset);
+/*! Sets the keyframes of a GPRT_MOTION_TRIANGLES geometry. The first of the numKeys vertex arrays is the mesh at
+  time 0 and the last at time 1, with the rest evenly spaced in between. Vertices are interpolated linearly between
+  the two keyframes around a ray's time. All keyframes share the geometry's indices, stride and offset. The buffers
+  are referenced, not copied, and keyframes may be edited between builds. */
+GPRT_API void gprtTrianglesSetMotionVertices(GPRTGeom triangles, uint32_t numKeys, GPRTBuffer *vertexArrays,
+                                             uint32_t count, uint32_t stride GPRT_IF_CPP(= sizeof(float3)),
+                                             uint32_t offset GPRT_IF_CPP(= 0));
+
+template <typename T1, typename T2>
+void
+gprtTrianglesSetMotionVertices(GPRTGeomOf<T1> triangles, uint32_t numKeys, GPRTBufferOf<T2> *vertexArrays,
+                               uint32_t count, uint32_t stride GPRT_IF_CPP(= sizeof(T2)),
+                               uint32_t offset GPRT_IF_CPP(= 0)) {
+  static_assert((std::is_same_v<T2, float3> || std::is_same_v<T2, float4>), "Triangle vertex buffer must contain floats.");
+  gprtTrianglesSetMotionVertices((GPRTGeom) triangles, numKeys, (GPRTBuffer *) vertexArrays, count, stride, offset);
+}
 
 GPRT_API void gprtTrianglesSetIndices(GPRTGeom triangles, GPRTBuffer indices, uint32_t count,
                                       uint32_t stride GPRT_IF_CPP(= sizeof(uint3)), uint32_t offset GPRT_IF_CPP(= 0));
@@ -493,6 +540,79 @@ gprtSolidsSetPositions(GPRTGeomOf<T1> aabbs, GPRTBufferOf<T2> positions, uint32_
   gprtSolidsSetPositions((GPRTGeom) aabbs, (GPRTBuffer) positions, count, stride, offset);
 }
 
+/*! build the face adjacency of a solid geometry, so that rays can walk its cells with gprt::solidWalkBegin and
+  gprt::solidWalkStep rather than querying the tree at every sample. Two cells are neighbors when they share all
+  the vertex indices of a face, so meshes must share vertices between cells. Indices and types _have_ to be set
+  first, and this must be called again whenever they change. Built once on the host. */
+GPRT_API void gprtSolidsBuildAdjacency(GPRTContext context, GPRTGeom solidsGeom);
+
+template <typename T1>
+void
+gprtSolidsBuildAdjacency(GPRTContext context, GPRTGeomOf<T1> solidsGeom) {
+  gprtSolidsBuildAdjacency(context, (GPRTGeom) solidsGeom);
+}
+
+/*! returns a device handle to a solid geometry and its face adjacency, for walking its cells from within a
+  kernel. gprtSolidsBuildAdjacency _has_ to be called first. */
+GPRT_API gprt::SolidMesh gprtSolidsGetMesh(GPRTGeom solidsGeom);
+
+template <typename T1>
+gprt::SolidMesh
+gprtSolidsGetMesh(GPRTGeomOf<T1> solidsGeom) {
+  return gprtSolidsGetMesh((GPRTGeom) solidsGeom);
+}
+
+/*! set a buffer holding a single gprt::SolidValueFilter, which lets the built-in intersection program skip cells
+  whose vertex values cannot pass the filter before inverting them, both for rays and for TracePoint. The buffer
+  is read at every launch, so the filter can be changed between launches, but setting or clearing it (with a null
+  buffer) takes effect at the next shader binding table build. */
+GPRT_API void gprtSolidsSetValueFilter(GPRTGeom solidsGeom, GPRTBuffer filter);
+
+template <typename T1>
+void
+gprtSolidsSetValueFilter(GPRTGeomOf<T1> solidsGeom, GPRTBufferOf<gprt::SolidValueFilter> filter) {
+  gprtSolidsSetValueFilter((GPRTGeom) solidsGeom, (GPRTBuffer) filter);
+}
+
+/*! fill in the occupancy bins of a value filter from a transfer function's opacities, evenly spaced over domain.
+  Bins with zero opacity are unoccupied, and cells whose values only fall in those bins are skipped. A numBins of
+  0 filters by the filter's range alone. */
+GPRT_API void gprtSolidValueFilterSetOccupancy(gprt::SolidValueFilter *filter, uint32_t numBins, const float *opacity,
+                                               float2 domain);
+
+/*! set the voxel values of a structured grid geometry, one float per voxel with x varying fastest, followed by y
+  and then z. This _has_ to be set before the accel(s) that this geom is used in get built. */
+GPRT_API void gprtVoxelsSetValues(GPRTGeom voxelGeom, GPRTBuffer values, uint3 dims,
+                                  uint32_t stride GPRT_IF_CPP(= sizeof(float)), uint32_t offset GPRT_IF_CPP(= 0));
+
+template <typename T1>
+void
+gprtVoxelsSetValues(GPRTGeomOf<T1> voxelGeom, GPRTBufferOf<float> values, uint3 dims,
+                    uint32_t stride GPRT_IF_CPP(= sizeof(float)), uint32_t offset GPRT_IF_CPP(= 0)) {
+  gprtVoxelsSetValues((GPRTGeom) voxelGeom, (GPRTBuffer) values, dims, stride, offset);
+}
+
+/*! place a structured grid geometry in object space. Voxel (i, j, k) spans origin + spacing * (i, j, k) to
+  origin + spacing * (i + 1, j + 1, k + 1). Defaults to unit voxels with the grid's corner at the origin. */
+GPRT_API void gprtVoxelsSetBounds(GPRTGeom voxelGeom, float3 origin, float3 spacing);
+
+template <typename T1>
+void
+gprtVoxelsSetBounds(GPRTGeomOf<T1> voxelGeom, float3 origin, float3 spacing) {
+  gprtVoxelsSetBounds((GPRTGeom) voxelGeom, origin, spacing);
+}
+
+/*! set the edge length, in voxels, of the bricks a structured grid is divided into. Each brick is a single
+  primitive in the tree, so larger bricks make for smaller trees at the cost of longer walks through empty
+  voxels. Defaults to 8. */
+GPRT_API void gprtVoxelsSetBrickSize(GPRTGeom voxelGeom, uint32_t brickSize);
+
+template <typename T1>
+void
+gprtVoxelsSetBrickSize(GPRTGeomOf<T1> voxelGeom, uint32_t brickSize) {
+  gprtVoxelsSetBrickSize((GPRTGeom) voxelGeom, brickSize);
+}
+
 /*! set the aabb positions (minX, minY, minZ, maxX, maxY, maxZ)
   for the given AABB geometry. This _has_ to be set before the accel(s)
   that this geom is used in get built. */
@@ -771,6 +891,10 @@ GPRT_API void gprtRequestRayRecursionDepth(uint32_t rayRecursionDepth);
 /*! Requests that ray queries be enabled for inline ray tracing support. */
 GPRT_API void gprtRequestRayQueries();
 
+/*! Requests that the driver capture per stage statistics of every pipeline, eg register counts and spills, for
+ gprtContextGetPipelineStatistics. Needs VK_KHR_pipeline_executable_properties, and may slow down pipeline builds. */
+GPRT_API void gprtRequestPipelineStatistics();
+
 GPRT_API void gprtRequestMaxAttributeSize(uint32_t attributeSize);
 
 GPRT_API void gprtRequestMaxPayloadSize(uint32_t payloadSize);
@@ -793,8 +917,121 @@ GPRT_API void gprtRequestMaxPayloadSize(uint32_t payloadSize);
 GPRT_API GPRTContext gprtContextCreate(int32_t *requestedDeviceIDs GPRT_IF_CPP(= nullptr),
                                        int numDevices GPRT_IF_CPP(= 1));
 
+/** Everything a context is configured with when it is created. Contexts keep their own configuration, so several
+ * contexts with different configurations can coexist in one process, and can be used from different threads at
+ * the same time, so long as each context is only used from one thread at a time.
+ *
+ * Start from gprtContextConfigGetDefault, which reflects any gprtRequest* calls made so far, and change what
+ * differs.
+ */
+typedef struct GPRTContextConfig {
+  /** The number of ray types, see gprtRequestRayTypeCount */
+  uint32_t numRayTypes;
+  /** See gprtRequestRayRecursionDepth */
+  uint32_t rayRecursionDepth;
+  /** In bytes, see gprtRequestMaxPayloadSize */
+  uint32_t maxRayPayloadSize;
+  /** In bytes, see gprtRequestMaxAttributeSize */
+  uint32_t maxRayHitAttributeSize;
+  /** In bytes, the parameters reserved for each kind of shader binding table record */
+  uint32_t raygenRecordSize;
+  uint32_t hitRecordSize;
+  uint32_t missRecordSize;
+  uint32_t callableRecordSize;
+  /** See gprtRequestRayQueries */
+  bool rayQueries;
+  /** See gprtRequestPipelineStatistics */
+  bool pipelineStatistics;
+  /** Enables printf from device code through the validation layers */
+  bool debugPrintf;
+  /** See gprtRequestWindow. The title is copied when the context is created. */
+  bool window;
+  uint32_t windowWidth;
+  uint32_t windowHeight;
+  const char *windowTitle;
+} GPRTContextConfig;
+
+/** @returns the configuration gprtContextCreate would use, ie the defaults along with any gprtRequest* calls made
+ * so far. The window title points into GPRT's own copy, and is only valid until the next gprtRequestWindow. */
+GPRT_API GPRTContextConfig gprtContextConfigGetDefault();
+
+/** creates a new device context like gprtContextCreate, but configured by the given config rather than by the
+  gprtRequest* calls. A null config is the same as calling gprtContextCreate.
+
+  Contexts may be created concurrently, and on different GPUs. Each context loads its own device entry points. */
+GPRT_API GPRTContext gprtContextCreateWithConfig(const GPRTContextConfig *config,
+                                                 int32_t *requestedDeviceIDs GPRT_IF_CPP(= nullptr),
+                                                 int numDevices GPRT_IF_CPP(= 1));
+
 GPRT_API void gprtContextDestroy(GPRTContext context);
 
+/** @returns the number of ray types the given context was created with */
+GPRT_API size_t gprtContextGetRayTypeCount(GPRTContext context);
+
+/** Cheap, always on counts of the work a context did, much of which is synchronous and otherwise easy to miss.
+ * Counting starts when the context is created, and restarts with gprtContextResetCounters, eg once per frame. */
+typedef struct GPRTCounters {
+  /** Command buffers submitted to the device, and waits for the device to finish them */
+  uint64_t queueSubmits;
+  uint64_t queueWaits;
+  /** Copies through staging memory, eg mapping and unmapping device buffers, and the bytes they moved */
+  uint64_t stagingCopies;
+  uint64_t bytesUploaded;
+  uint64_t bytesDownloaded;
+  /** Buffer resizes, and the bytes copied to preserve the contents of resized buffers */
+  uint64_t bufferResizes;
+  uint64_t resizeBytesCopied;
+  /** Shader binding table builds, ray tracing pipeline rebuilds they triggered, and reallocations of the tables */
+  uint64_t sbtBuilds;
+  uint64_t pipelineRebuilds;
+  uint64_t sbtReallocations;
+  /** Acceleration structure builds, updates and compactions, including those done internally */
+  uint64_t accelBuilds;
+  uint64_t accelUpdates;
+  uint64_t accelCompactions;
+  /** Texture and sampler descriptors written into the bindless heap, and times that heap grew */
+  uint64_t descriptorWrites;
+  uint64_t descriptorHeapGrowths;
+} GPRTCounters;
+
+/** @returns the counters of the given context, see GPRTCounters */
+GPRT_API GPRTCounters gprtContextGetCounters(GPRTContext context);
+
+/** Sets all counters of the given context back to zero */
+GPRT_API void gprtContextResetCounters(GPRTContext context);
+
+/** @returns the bytes of memory the given context currently holds from the driver through its allocator, including
+ * staging memory and unused space within memory blocks */
+GPRT_API size_t gprtContextGetAllocatedMemory(GPRTContext context);
+
+/**
+ * @brief Loads tuned compute group sizes from a text file, and records later tuning results to it. Each line holds a
+ * device, a compute kernel and its group size, so one file can be shared between machines. Kernels found in the
+ * cache launch with their tuned group size, see @ref gprtComputeAutotune.
+ *
+ * @param context The GPRT context
+ * @param path The tuning cache file, which doesn't need to exist yet, or null to stop using a cache
+ */
+GPRT_API void gprtContextSetTuningCache(GPRTContext context, const char *path);
+
+/**
+ * @brief Reports the ray tracing and compute pipelines of a context as JSON, to find out why a program got slow.
+ * The report holds the ray recursion depth, the stack size of every shader in the ray tracing pipeline along with
+ * the pipeline's default stack size, and, if requested with @ref gprtRequestPipelineStatistics, the statistics
+ * the driver reports for each compiled executable, typically register counts, spills and shared memory. Statistic
+ * names and units are up to the driver.
+ *
+ * Only pipelines built so far are reported, so call this after gprtBuildShaderBindingTable and after launching the
+ * compute kernels of interest.
+ *
+ * @param context The GPRT context
+ * @returns the report, valid until the next call for this context
+ */
+GPRT_API const char *gprtContextGetPipelineStatistics(GPRTContext context);
+
+/** Writes the report of @ref gprtContextGetPipelineStatistics to a file, returning false if it can't be written */
+GPRT_API bool gprtContextSavePipelineStatistics(GPRTContext context, const char *path);
+
 /**
  * @brief Creates a "compute" handle which describes a compute device program to call and the parameters to
  * pass into that compute device program. Compute programs handle data generation and transformation, but
@@ -1147,6 +1384,39 @@ GPRTAccel
 gprtLSSAccelCreate(GPRTContext context, GPRTGeomOf<T> &geom, GPRTLSSFlags flags GPRT_IF_CPP( = GPRT_LSS_CHAINED_END_CAPS)) {
   return gprtLSSAccelCreate(context, (GPRTGeom) geom, flags);
 }
+/*! set the control points of a curve geometry, as float4s holding the position in xyz and the radius in w. The
+  radius is interpolated in the same basis as the position. */
+GPRT_API void gprtCurvesSetVertices(GPRTGeom curveGeom, GPRTBuffer vertices, uint32_t count,
+                                    uint32_t stride GPRT_IF_CPP(= sizeof(float4)), uint32_t offset GPRT_IF_CPP(= 0));
+
+template <typename T1, typename T2>
+void
+gprtCurvesSetVertices(GPRTGeomOf<T1> curveGeom, GPRTBufferOf<T2> vertices, uint32_t count,
+                      uint32_t stride GPRT_IF_CPP(= sizeof(T2)), uint32_t offset GPRT_IF_CPP(= 0)) {
+  gprtCurvesSetVertices((GPRTGeom) curveGeom, (GPRTBuffer) vertices, count, stride, offset);
+}
+
+/*! set the segments of a curve geometry, one index per segment, of the first of the four consecutive control
+  points making up that segment. A strand of n control points in the B-spline basis has n - 3 segments, starting
+  at each of its first n - 3 control points. */
+GPRT_API void gprtCurvesSetIndices(GPRTGeom curveGeom, GPRTBuffer indices, uint32_t count,
+                                   uint32_t stride GPRT_IF_CPP(= sizeof(uint32_t)), uint32_t offset GPRT_IF_CPP(= 0));
+
+template <typename T1, typename T2>
+void
+gprtCurvesSetIndices(GPRTGeomOf<T1> curveGeom, GPRTBufferOf<T2> indices, uint32_t count,
+                     uint32_t stride GPRT_IF_CPP(= sizeof(uint32_t)), uint32_t offset GPRT_IF_CPP(= 0)) {
+  gprtCurvesSetIndices((GPRTGeom) curveGeom, (GPRTBuffer) indices, count, stride, offset);
+}
+
+/*! set the basis of a curve geometry's control points. Defaults to GPRT_CURVE_BSPLINE. */
+GPRT_API void gprtCurvesSetBasis(GPRTGeom curveGeom, GPRTCurveBasis basis);
+
+template <typename T1>
+void
+gprtCurvesSetBasis(GPRTGeomOf<T1> curveGeom, GPRTCurveBasis basis) {
+  gprtCurvesSetBasis((GPRTGeom) curveGeom, basis);
+}
 
 // ------------------------------------------------------------------
 /*! create a new acceleration structure for solid geometries.
@@ -1160,6 +1430,79 @@ gprtSolidAccelCreate(GPRTContext context, GPRTGeomOf<T> &geom, unsigned int flag
   return gprtSolidAccelCreate(context, (GPRTGeom) geom, flags);
 }
 
+// ------------------------------------------------------------------
+/*! create a new acceleration structure for a structured grid geometry.
+
+  Rather than one AABB per voxel, the tree holds one AABB per brick of voxels, and a built-in intersection program
+  walks the voxels of each brick the ray crosses with a 3D DDA. Hits are reported with a hit kind of
+  HIT_KIND_VOXEL at the distance the ray enters the voxel, or run of voxels, and with gprt::VoxelAttributes
+  holding the voxel's index and the distance the ray exits. These attributes require
+  gprtRequestMaxAttributeSize(sizeof(gprt::VoxelAttributes)).
+
+  A closest hit program then sees the first reported voxel along the ray, while an any hit program which ignores
+  its hits sees every voxel the ray crosses, in no particular order across bricks.
+
+  \param geom A geometry created from a GPRT_VOXELS geometry type.
+
+  \param flags A combination of GPRTVoxelFlags, selecting which voxels are reported. These are kept by the
+  geometry, so a geometry should only be used in accels created with the same flags.
+*/
+GPRT_API GPRTAccel gprtVoxelAccelCreate(GPRTContext context, GPRTGeom geom,
+                                        unsigned int flags GPRT_IF_CPP(= GPRT_VOXEL_REPORT_EACH_VOXEL));
+
+template <typename T>
+GPRTAccel
+gprtVoxelAccelCreate(GPRTContext context, GPRTGeomOf<T> &geom,
+                     unsigned int flags GPRT_IF_CPP(= GPRT_VOXEL_REPORT_EACH_VOXEL)) {
+  return gprtVoxelAccelCreate(context, (GPRTGeom) geom, flags);
+}
+
+// ------------------------------------------------------------------
+/*! create a new acceleration structure for a curve geometry.
+
+  Each segment gets an AABB computed from the exact extrema of its swept sphere, and a built-in intersection
+  program subdivides the segments a ray's box test admits, until the pieces are flat relative to their radius, and
+  intersects those as linear swept spheres. Curve ends are rounded. Hits are reported with a hit kind of 0 and a
+  single float attribute holding the curve parameter within the segment, matching GPRT_LSS.
+
+  \param geom A geometry created from a GPRT_CURVES geometry type.
+
+  \param flags reserved for future use
+*/
+GPRT_API GPRTAccel gprtCurveAccelCreate(GPRTContext context, GPRTGeom geom, unsigned int flags GPRT_IF_CPP(= 0));
+
+template <typename T>
+GPRTAccel
+gprtCurveAccelCreate(GPRTContext context, GPRTGeomOf<T> &geom, unsigned int flags GPRT_IF_CPP(= 0)) {
+  return gprtCurveAccelCreate(context, (GPRTGeom) geom, flags);
+}
+
+// ------------------------------------------------------------------
+/*! create a new acceleration structure for a motion triangle geometry.
+
+  Each triangle gets one AABB bounding it over all of its keyframes, so the tree is built once and stays valid at
+  any time, at the cost of looser bounds where triangles move far. A built-in intersection program interpolates the
+  triangle to the ray's time and intersects it from either side. Trace these with TraceMotionRay, which carries the
+  time, and read it back with MotionRayTime. Hits report BuiltInTriangleIntersectionAttributes, so contexts must
+  first call gprtRequestMaxAttributeSize(sizeof(float2)), and a hit kind of 0 for the side that
+  cross(v1 - v0, v2 - v0) faces, or 1 for the other.
+
+  VK_NV_ray_tracing_motion_blur is not used, since its trace instruction would keep device code from loading on
+  devices without it.
+
+  \param geom A geometry created from a GPRT_MOTION_TRIANGLES geometry type.
+
+  \param flags reserved for future use
+*/
+GPRT_API GPRTAccel gprtMotionTriangleAccelCreate(GPRTContext context, GPRTGeom geom,
+                                                 unsigned int flags GPRT_IF_CPP(= 0));
+
+template <typename T>
+GPRTAccel
+gprtMotionTriangleAccelCreate(GPRTContext context, GPRTGeomOf<T> &geom, unsigned int flags GPRT_IF_CPP(= 0)) {
+  return gprtMotionTriangleAccelCreate(context, (GPRTGeom) geom, flags);
+}
+
 // ------------------------------------------------------------------
 /*! create a new instance acceleration structure with given number of
   instances.
@@ -1275,6 +1618,37 @@ GPRT_API const void* gprtAccelGetDeviceAddress(GPRTAccel accel, int deviceID GPR
  * */
 GPRT_API gprt::Instance gprtAccelGetInstance(GPRTAccel blas);
 
+/**
+ * @brief Rasterizes the triangle geometry of an acceleration structure into a visibility buffer, as a fast
+ * alternative to tracing primary rays. Each pixel receives the same IDs and hit distance that the builtins
+ * InstanceIndex(), GeometryIndex(), PrimitiveIndex() and RayTCurrent() would report for a closest-hit primary
+ * ray through the pixel's center, so that raygen programs can start directly from secondary rays.
+ *
+ * @param context The GPRT context
+ * @param accel A triangle accel, or an instance accel over triangle accels. Other geometry kinds are skipped,
+ * and should instead be traced. Instances with a zero mask are skipped.
+ * @param visibility A buffer of at least width * height gprt::Visibility elements, where pixel (x, y) is
+ * written to element y * width + x, with row 0 at the top of the image. Pixels that see no geometry read
+ * as GPRT_VISIBILITY_MISS with an infinite distance.
+ * @param width The width of the visibility buffer in pixels
+ * @param height The height of the visibility buffer in pixels
+ * @param viewProjection A row-major world to clip space matrix with depth in [0, 1], for example
+ * math::perspective(...) * math::matrixFromLookAt(...).
+ * @param cameraPosition The world space origin of the camera, used to measure hit distances.
+ *
+ * @note The rasterizer's attachments are kept by the context and reused while the dimensions don't change.
+ */
+GPRT_API void gprtAccelRasterizeVisibility(GPRTContext context, GPRTAccel accel, GPRTBuffer visibility,
+                                           uint32_t width, uint32_t height, float4x4 viewProjection,
+                                           float3 cameraPosition);
+
+inline void
+gprtAccelRasterizeVisibility(GPRTContext context, GPRTAccel accel, GPRTBufferOf<gprt::Visibility> visibility,
+                             uint32_t width, uint32_t height, float4x4 viewProjection, float3 cameraPosition) {
+  gprtAccelRasterizeVisibility(context, accel, (GPRTBuffer) visibility, width, height, viewProjection,
+                               cameraPosition);
+}
+
 /**
  * @brief Creates a "geometry type", which describes the base primitive kind, device programs to call during
  * intersection, and the parameters to pass into these device programs.
@@ -1537,6 +1911,42 @@ gprtTextureClear(GPRTTextureOf<T> texture) {
   gprtTextureClear((GPRTTexture) texture);
 }
 
+/**
+ * @brief Sets all texels of all mip levels of the given texture to a value. The clear happens on the device, without
+ * any host round trip.
+ *
+ * @param texture The texture to be filled
+ * @param value A pointer to 16 bytes, interpreted as four floats for normalized and floating point formats, as four
+ * 32-bit integers for integer formats, and as a single float depth for depth formats.
+ */
+GPRT_API void gprtTextureFill(GPRTTexture texture, const void *value);
+
+/**
+ * @brief Sets all texels of all mip levels of the given texture to a floating point value.
+ *
+ * @tparam T The template type of the given texture
+ * @param texture The texture to be filled
+ * @param value The value to fill with. For depth textures, only the first component is used.
+ */
+template <typename T>
+void
+gprtTextureFill(GPRTTextureOf<T> texture, float4 value) {
+  gprtTextureFill((GPRTTexture) texture, &value);
+}
+
+/**
+ * @brief Sets all texels of all mip levels of the given integer texture to a value.
+ *
+ * @tparam T The template type of the given texture
+ * @param texture The texture to be filled
+ * @param value The value to fill with
+ */
+template <typename T>
+void
+gprtTextureFill(GPRTTextureOf<T> texture, uint4 value) {
+  gprtTextureFill((GPRTTexture) texture, &value);
+}
+
 /*! Destroys all underlying Vulkan resources for the given texture and frees any
   underlying memory*/
 GPRT_API void gprtTextureDestroy(GPRTTexture texture);
@@ -1701,6 +2111,176 @@ gprtSharedBufferCreate(GPRTContext context, size_t count = 1, const T *init = nu
   return (GPRTBufferOf<T>) gprtSharedBufferCreate(context, sizeof(T), count, init, alignment);
 }
 
+/**
+ * @brief Creates a pool for sub-allocating many small host buffers out of a few large allocations.
+ *
+ * Creating a separate Vulkan buffer and memory allocation per object becomes expensive once there are
+ * many thousands of small buffers (eg, one per mesh, or per particle group). Buffers allocated from a
+ * pool instead share large blocks of memory, so that allocating one requires no Vulkan calls. Pooled
+ * buffers are ordinary GPRTBuffer handles; their device addresses are stable for their lifetime, and
+ * they can be used anywhere a buffer created with gprtHostBufferCreate can, with the exception of
+ * gprtBufferResize. Pooled buffers are released with gprtBufferDestroy.
+ *
+ * @param context   The GPRTContext in which the pool is to be created.
+ * @param blockSize The size in bytes of each block of memory the pool allocates as it grows.
+ *                  Requests larger than this are given a dedicated block. Defaults to 64MB.
+ * @return GPRTBufferPool Returns a handle to the created pool.
+ */
+GPRT_API GPRTBufferPool gprtHostBufferPoolCreate(GPRTContext context, size_t blockSize = 64 << 20);
+
+/**
+ * @brief Creates a pool for sub-allocating many small device buffers out of a few large allocations.
+ *
+ * The device memory counterpart to gprtHostBufferPoolCreate. Buffers allocated from this pool behave
+ * like those created with gprtDeviceBufferCreate.
+ *
+ * @param context   The GPRTContext in which the pool is to be created.
+ * @param blockSize The size in bytes of each block of memory the pool allocates as it grows.
+ *                  Requests larger than this are given a dedicated block. Defaults to 64MB.
+ * @return GPRTBufferPool Returns a handle to the created pool.
+ */
+GPRT_API GPRTBufferPool gprtDeviceBufferPoolCreate(GPRTContext context, size_t blockSize = 64 << 20);
+
+/**
+ * @brief Creates a pool for sub-allocating many small shared buffers out of a few large allocations.
+ *
+ * The shared memory counterpart to gprtHostBufferPoolCreate. Buffers allocated from this pool behave
+ * like those created with gprtSharedBufferCreate.
+ *
+ * @param context   The GPRTContext in which the pool is to be created.
+ * @param blockSize The size in bytes of each block of memory the pool allocates as it grows.
+ *                  Requests larger than this are given a dedicated block. Defaults to 64MB.
+ * @return GPRTBufferPool Returns a handle to the created pool.
+ */
+GPRT_API GPRTBufferPool gprtSharedBufferPoolCreate(GPRTContext context, size_t blockSize = 64 << 20);
+
+/**
+ * @brief Allocates a buffer out of the given buffer pool.
+ *
+ * @param pool      The pool to allocate the buffer from.
+ * @param size      The size of each element in the buffer.
+ * @param count     The number of elements in the buffer. Defaults to 1 (single element).
+ * @param init      Optional pointer to initial data for buffer initialization. Defaults to nullptr.
+ * @param alignment Byte alignment for the buffer, must be a power of two. Pooled buffers are always
+ *                  aligned to at least the device's minimum storage buffer offset alignment. Defaults to 16.
+ * @return GPRTBuffer Returns a handle to the allocated buffer.
+ */
+GPRT_API GPRTBuffer gprtBufferPoolAllocate(GPRTBufferPool pool, size_t size, size_t count = 1,
+                                           const void *init = nullptr, size_t alignment = 16);
+
+/**
+ * @brief Allocates a typed buffer out of the given buffer pool.
+ *
+ * @tparam T        The data type of elements in the buffer.
+ * @param pool      The pool to allocate the buffer from.
+ * @param count     The number of elements of type T in the buffer. Defaults to 1.
+ * @param init      Optional pointer to an array of type T for initializing the buffer. Defaults to nullptr.
+ * @param alignment Byte alignment for the buffer, must be a power of two. Defaults to 16.
+ * @return GPRTBufferOf<T> Returns a handle to the allocated buffer, typed according to T.
+ */
+template <typename T>
+GPRTBufferOf<T>
+gprtBufferPoolAllocate(GPRTBufferPool pool, size_t count = 1, const T *init = nullptr, size_t alignment = 16) {
+  return (GPRTBufferOf<T>) gprtBufferPoolAllocate(pool, sizeof(T), count, init, alignment);
+}
+
+/** @brief Memory usage of a buffer pool, as reported by gprtBufferPoolGetStats */
+typedef struct {
+  uint32_t numBlocks;        // number of large allocations backing the pool
+  uint64_t numAllocations;   // number of live buffers allocated from the pool
+  uint64_t reservedBytes;    // total size of all blocks
+  uint64_t allocatedBytes;   // total size of all live buffers, excluding alignment padding
+} GPRTBufferPoolStats;
+
+/**
+ * @brief Reports the memory usage of the given buffer pool.
+ *
+ * @param pool  The pool to query.
+ * @param stats Returns the number of blocks and buffers in the pool, and their sizes.
+ */
+GPRT_API void gprtBufferPoolGetStats(GPRTBufferPool pool, GPRTBufferPoolStats *stats);
+
+/**
+ * @brief Destroys the given buffer pool, freeing all of its memory.
+ *
+ * Any buffers still allocated from the pool are released, and must not be used afterwards.
+ *
+ * @param pool The pool to destroy.
+ */
+GPRT_API void gprtBufferPoolDestroy(GPRTBufferPool pool);
+
+/**
+ * @brief Creates a pool that recycles device buffers used as per-frame temporaries, eg ray queues, sort scratch
+ * and hit buffers.
+ *
+ * Creating and destroying such buffers every frame allocates and frees device memory every frame. Transient
+ * buffers are instead handed back to their pool by gprtBufferDestroy, and later acquires of a similar size reuse
+ * them. Buffers are grouped by capacity, rounded up to a power of two. A released buffer is only reused once the
+ * device has finished all work submitted before its release, and is freed once unused for maxIdleFrames frames.
+ *
+ * Transient buffers behave like those created with gprtDeviceBufferCreate, except that they cannot be resized and
+ * that their contents are undefined when acquired.
+ *
+ * @param context       The GPRTContext in which the pool is to be created.
+ * @param maxIdleFrames The number of calls to gprtTransientPoolNextFrame a released buffer is kept for. Defaults to 4.
+ * @return GPRTTransientPool Returns a handle to the created pool.
+ */
+GPRT_API GPRTTransientPool gprtTransientPoolCreate(GPRTContext context, uint32_t maxIdleFrames = 4);
+
+/**
+ * @brief Acquires a device buffer from the given transient pool, reusing a released one if possible. Release it
+ * with gprtBufferDestroy.
+ *
+ * @param pool  The pool to acquire the buffer from.
+ * @param size  The size of each element in the buffer.
+ * @param count The number of elements in the buffer. Defaults to 1 (single element).
+ * @return GPRTBuffer Returns a handle to the acquired buffer.
+ */
+GPRT_API GPRTBuffer gprtTransientBufferAcquire(GPRTTransientPool pool, size_t size, size_t count = 1);
+
+template <typename T>
+GPRTBufferOf<T>
+gprtTransientBufferAcquire(GPRTTransientPool pool, size_t count = 1) {
+  return (GPRTBufferOf<T>) gprtTransientBufferAcquire(pool, sizeof(T), count);
+}
+
+/**
+ * @brief Marks the end of a frame, freeing buffers that have gone unused for more than the pool's maxIdleFrames.
+ *
+ * @param pool The pool to advance.
+ */
+GPRT_API void gprtTransientPoolNextFrame(GPRTTransientPool pool);
+
+/** @brief Buffer reuse of a transient pool, as reported by gprtTransientPoolGetStats */
+typedef struct {
+  uint64_t numAcquires;      // buffers acquired from the pool
+  uint64_t numReuses;        // acquires served by a released buffer, numReuses / numAcquires is the hit rate
+  uint64_t numAllocations;   // buffers the pool allocated
+  uint64_t numFrees;         // buffers the pool freed
+  uint32_t numLive;          // buffers acquired and not yet released
+  uint32_t numPending;       // released buffers the device may still be using
+  uint32_t numFree;          // released buffers ready for reuse
+  uint64_t reservedBytes;    // total capacity of all buffers the pool holds
+} GPRTTransientPoolStats;
+
+/**
+ * @brief Reports how often the given transient pool reused buffers, and how much memory it holds.
+ *
+ * @param pool  The pool to query.
+ * @param stats Returns counts of acquires, reuses, allocations and frees since the pool was created, along with
+ *              the number of buffers in each state.
+ */
+GPRT_API void gprtTransientPoolGetStats(GPRTTransientPool pool, GPRTTransientPoolStats *stats);
+
+/**
+ * @brief Destroys the given transient pool, waiting for the device and freeing all of its buffers.
+ *
+ * Any buffers still acquired from the pool are freed too, and must not be used afterwards.
+ *
+ * @param pool The pool to destroy.
+ */
+GPRT_API void gprtTransientPoolDestroy(GPRTTransientPool pool);
+
 /**
  * @brief Clears all values of the given buffer to 0
  *
@@ -1720,6 +2300,111 @@ gprtBufferClear(GPRTBufferOf<T> buffer) {
   gprtBufferClear((GPRTBuffer) buffer);
 }
 
+/**
+ * @brief Repeats a pattern of \p size bytes over \p count elements of the buffer, starting at element \p offset .
+ * The fill happens on the device, without any host round trip. Patterns that reduce to a repeated 32-bit word use
+ * vkCmdFillBuffer, while larger patterns (up to 128 bytes, in multiples of 4) use an internal compute kernel.
+ * If the buffer is mapped, its host copy is filled too, so a later unmap keeps the fill.
+ *
+ * @param context The GPRT context
+ * @param buffer The buffer to be filled
+ * @param pattern A pointer to the \p size bytes to repeat
+ * @param size The size of an individual element in the buffer
+ * @param offset The first element to fill
+ * @param count The number of elements to fill. If 0, fills through to the end of the buffer.
+ */
+GPRT_API void gprtBufferFill(GPRTContext context, GPRTBuffer buffer, const void *pattern, size_t size,
+                             size_t offset GPRT_IF_CPP(= 0), size_t count GPRT_IF_CPP(= 0));
+
+/**
+ * @brief Sets \p count elements of the buffer, starting at element \p offset , to \p value on the device.
+ *
+ * @tparam T The template type of the given buffer
+ * @param context The GPRT context
+ * @param buffer The buffer to be filled
+ * @param value The value to fill with
+ * @param offset The first element to fill
+ * @param count The number of elements to fill. If 0, fills through to the end of the buffer.
+ */
+template <typename T>
+void
+gprtBufferFill(GPRTContext context, GPRTBufferOf<T> buffer, T value, size_t offset GPRT_IF_CPP(= 0),
+               size_t count GPRT_IF_CPP(= 0)) {
+  gprtBufferFill(context, (GPRTBuffer) buffer, &value, sizeof(T), offset, count);
+}
+
+/**
+ * @brief Writes the sequence start, start + step, start + 2 * step, ... into \p count 32-bit elements of the buffer,
+ * beginning at element \p offset . The sequence is generated on the device, so device buffers must not be mapped.
+ *
+ * @param context The GPRT context
+ * @param buffer The buffer to be filled
+ * @param type The scalar type of the elements in the buffer
+ * @param start A pointer to the 32-bit first value of the sequence
+ * @param step A pointer to the 32-bit increment between consecutive values
+ * @param offset The first element to write
+ * @param count The number of elements to write. If 0, writes through to the end of the buffer.
+ */
+GPRT_API void gprtBufferIota(GPRTContext context, GPRTBuffer buffer, GPRTScalarType type, const void *start,
+                             const void *step, size_t offset GPRT_IF_CPP(= 0), size_t count GPRT_IF_CPP(= 0));
+
+/**
+ * @brief Writes the sequence start, start + step, start + 2 * step, ... into the buffer on the device.
+ *
+ * @tparam T The template type of the given buffer (uint32_t, int32_t or float)
+ * @param context The GPRT context
+ * @param buffer The buffer to be filled
+ * @param start The first value of the sequence
+ * @param step The increment between consecutive values
+ * @param offset The first element to write
+ * @param count The number of elements to write. If 0, writes through to the end of the buffer.
+ */
+template <typename T>
+void
+gprtBufferIota(GPRTContext context, GPRTBufferOf<T> buffer, T start = T(0), T step = T(1), size_t offset = 0,
+               size_t count = 0) {
+  gprtBufferIota(context, (GPRTBuffer) buffer, gprtScalarTypeOf<T>(), &start, &step, offset, count);
+}
+
+/**
+ * @brief Initializes \p count 32-bit elements of the buffer, starting at element \p offset , with values drawn
+ * uniformly from [lower, upper). Each element is computed on the device by hashing its index with \p seed , so
+ * results are reproducible for a given seed and independent of launch configuration. Device buffers must not be
+ * mapped.
+ *
+ * @param context The GPRT context
+ * @param buffer The buffer to be filled
+ * @param type The scalar type of the elements in the buffer
+ * @param seed The seed of the random sequence
+ * @param lower A pointer to the 32-bit inclusive lower bound
+ * @param upper A pointer to the 32-bit exclusive upper bound. For integer types, if lower equals upper, the full
+ * 32-bit range is used.
+ * @param offset The first element to write
+ * @param count The number of elements to write. If 0, writes through to the end of the buffer.
+ */
+GPRT_API void gprtBufferRandom(GPRTContext context, GPRTBuffer buffer, GPRTScalarType type, uint32_t seed,
+                               const void *lower, const void *upper, size_t offset GPRT_IF_CPP(= 0),
+                               size_t count GPRT_IF_CPP(= 0));
+
+/**
+ * @brief Initializes the buffer on the device with values drawn uniformly from [lower, upper).
+ *
+ * @tparam T The template type of the given buffer (uint32_t, int32_t or float)
+ * @param context The GPRT context
+ * @param buffer The buffer to be filled
+ * @param seed The seed of the random sequence
+ * @param lower The inclusive lower bound
+ * @param upper The exclusive upper bound. Defaults to [0, 1) for floats, and to the full 32-bit range for integers.
+ * @param offset The first element to write
+ * @param count The number of elements to write. If 0, writes through to the end of the buffer.
+ */
+template <typename T>
+void
+gprtBufferRandom(GPRTContext context, GPRTBufferOf<T> buffer, uint32_t seed, T lower = T(0),
+                 T upper = T(std::is_floating_point<T>::value ? 1 : 0), size_t offset = 0, size_t count = 0) {
+  gprtBufferRandom(context, (GPRTBuffer) buffer, gprtScalarTypeOf<T>(), seed, &lower, &upper, offset, count);
+}
+
 /*! Destroys all underlying Vulkan resources for the given buffer and frees any
   underlying memory*/
 GPRT_API void gprtBufferDestroy(GPRTBuffer buffer);
@@ -1870,6 +2555,112 @@ gprtBufferCopy(GPRTContext context, GPRTBufferOf<T> src, GPRTBufferOf<T> dst, ui
                  dstDeviceID);
 }
 
+/*! A region to copy between two buffers, in elements */
+typedef struct {
+  size_t srcOffset;
+  size_t dstOffset;
+  size_t count;
+} GPRTBufferCopyRegion;
+
+/***
+ * @brief Copies many regions of elements from \p src into \p dst . All regions are recorded into a single copy
+ * command and submitted once, which is much cheaper than one gprtBufferCopy call per region. Copying within one
+ * buffer is allowed, but no source region may overlap a destination region.
+ *
+ * @param context The GPRT context
+ * @param src The source buffer to copy elements from
+ * @param dst The destination buffer to copy elements into
+ * @param size The size of an individual element in the buffer
+ * @param regions An array of \p numRegions regions, with offsets and counts given in elements
+ * @param numRegions The number of regions to copy
+ */
+GPRT_API void gprtBufferCopyRegions(GPRTContext context, GPRTBuffer src, GPRTBuffer dst, size_t size,
+                                    const GPRTBufferCopyRegion *regions, uint32_t numRegions,
+                                    int srcDeviceID GPRT_IF_CPP(= 0), int dstDeviceID GPRT_IF_CPP(= 0));
+
+/***
+ * @brief Copies many regions of elements from \p src into \p dst using a single copy command.
+ *
+ * @tparam T The template type of the given buffer
+ *
+ * @param context The GPRT context
+ * @param src The source buffer to copy elements from
+ * @param dst The destination buffer to copy elements into
+ * @param regions The regions to copy, with offsets and counts given in elements
+ */
+template <typename T>
+void
+gprtBufferCopyRegions(GPRTContext context, GPRTBufferOf<T> src, GPRTBufferOf<T> dst,
+                      const std::vector<GPRTBufferCopyRegion> &regions, int srcDeviceID GPRT_IF_CPP(= 0),
+                      int dstDeviceID GPRT_IF_CPP(= 0)) {
+  gprtBufferCopyRegions(context, (GPRTBuffer) src, (GPRTBuffer) dst, sizeof(T), regions.data(),
+                        (uint32_t) regions.size(), srcDeviceID, dstDeviceID);
+}
+
+/***
+ * @brief Gathers elements on the device, such that dst[i] = src[indices[i]] for i in [0, count).
+ *
+ * Element sizes and strides must be multiples of 4 bytes. Strides larger than the element size allow
+ * gathering the leading member out of (or into) an array of larger structures.
+ *
+ * @param context The GPRT context
+ * @param src The source buffer to gather elements from
+ * @param indices A buffer of 32-bit unsigned indices into \p src
+ * @param dst The destination buffer to write \p count elements into
+ * @param size The size of an individual element in bytes
+ * @param count The number of elements to gather
+ * @param srcStride The distance in bytes between consecutive source elements. If 0, \p size is used.
+ * @param dstStride The distance in bytes between consecutive destination elements. If 0, \p size is used.
+ */
+GPRT_API void gprtBufferGather(GPRTContext context, GPRTBuffer src, GPRTBuffer indices, GPRTBuffer dst, size_t size,
+                               size_t count, size_t srcStride GPRT_IF_CPP(= 0), size_t dstStride GPRT_IF_CPP(= 0));
+
+/***
+ * @brief Gathers elements on the device, such that dst[i] = src[indices[i]] for i in [0, count).
+ *
+ * @tparam T The template type of the gathered elements
+ * @tparam I The template type of the index buffer (must be uint32_t)
+ */
+template <typename T, typename I>
+void
+gprtBufferGather(GPRTContext context, GPRTBufferOf<T> src, GPRTBufferOf<I> indices, GPRTBufferOf<T> dst,
+                 size_t count) {
+  static_assert(std::is_same<I, uint32_t>::value, "Gather indices must be 32-bit unsigned integers");
+  gprtBufferGather(context, (GPRTBuffer) src, (GPRTBuffer) indices, (GPRTBuffer) dst, sizeof(T), count);
+}
+
+/***
+ * @brief Scatters elements on the device, such that dst[indices[i]] = src[i] for i in [0, count).
+ *
+ * Element sizes and strides must be multiples of 4 bytes. If indices contain duplicates, which of the
+ * colliding elements is written is undefined.
+ *
+ * @param context The GPRT context
+ * @param src The source buffer to read \p count elements from
+ * @param indices A buffer of 32-bit unsigned indices into \p dst
+ * @param dst The destination buffer to scatter elements into
+ * @param size The size of an individual element in bytes
+ * @param count The number of elements to scatter
+ * @param srcStride The distance in bytes between consecutive source elements. If 0, \p size is used.
+ * @param dstStride The distance in bytes between consecutive destination elements. If 0, \p size is used.
+ */
+GPRT_API void gprtBufferScatter(GPRTContext context, GPRTBuffer src, GPRTBuffer indices, GPRTBuffer dst, size_t size,
+                                size_t count, size_t srcStride GPRT_IF_CPP(= 0), size_t dstStride GPRT_IF_CPP(= 0));
+
+/***
+ * @brief Scatters elements on the device, such that dst[indices[i]] = src[i] for i in [0, count).
+ *
+ * @tparam T The template type of the scattered elements
+ * @tparam I The template type of the index buffer (must be uint32_t)
+ */
+template <typename T, typename I>
+void
+gprtBufferScatter(GPRTContext context, GPRTBufferOf<T> src, GPRTBufferOf<I> indices, GPRTBufferOf<T> dst,
+                  size_t count) {
+  static_assert(std::is_same<I, uint32_t>::value, "Scatter indices must be 32-bit unsigned integers");
+  gprtBufferScatter(context, (GPRTBuffer) src, (GPRTBuffer) indices, (GPRTBuffer) dst, sizeof(T), count);
+}
+
 GPRT_API void gprtBufferTextureCopy(GPRTContext context, GPRTBuffer buffer, GPRTTexture texture, uint32_t bufferOffset,
                                     uint32_t bufferRowLength, uint32_t bufferImageHeight, uint32_t imageOffsetX,
                                     uint32_t imageOffsetY, uint32_t imageOffsetZ, uint32_t imageExtentX,
@@ -2099,6 +2890,478 @@ gprtBufferSortPayload(GPRTContext context, GPRTBufferOf<T1> keys, GPRTBufferOf<T
   gprtBufferSortPayload(context, (GPRTBuffer) keys, (GPRTBuffer) values, (GPRTBuffer) scratch);
 }
 
+/**
+ * @brief Sorts many independent ranges of a buffer in one call. Segments small enough to fit in shared memory
+ * are each sorted by a single workgroup, all in one launch, while larger segments are packed together and sorted
+ * in one batch by the global radix sort. Like gprtBufferSort, the sort is stable. The number of keys in large
+ * segments is read back to size the temporary buffers, so this call waits on the device.
+ *
+ * @param context The GPRT context
+ * @param keys A buffer of 64-bit unsigned integers
+ * @param segmentOffsets A buffer of numSegments + 1 non-decreasing 32-bit offsets, where segment i covers the
+ * keys in [segmentOffsets[i], segmentOffsets[i + 1]). Keys outside of all segments are left untouched.
+ * @param numSegments The number of segments to sort
+ * @param scratch A scratch buffer for the global radix sort, following the same rules as in gprtBufferSort.
+ */
+GPRT_API void gprtBufferSegmentedSort(GPRTContext context, GPRTBuffer keys, GPRTBuffer segmentOffsets,
+                                      uint32_t numSegments, GPRTBuffer scratch GPRT_IF_CPP(= 0));
+
+/**
+ * @brief Sorts many independent ranges of a buffer in one call.
+ *
+ * @tparam T1 The template type of the given buffer (64-bit keys are assumed)
+ * @tparam T2 The template type of the scratch buffer (uint8_t is assumed)
+ *
+ * @param context The GPRT context
+ * @param keys A buffer of 64-bit unsigned integers
+ * @param segmentOffsets A buffer of numSegments + 1 non-decreasing offsets, where segment i covers the keys in
+ * [segmentOffsets[i], segmentOffsets[i + 1])
+ * @param numSegments The number of segments to sort
+ * @param scratch A scratch buffer for the global radix sort, following the same rules as in gprtBufferSort.
+ */
+template <typename T1, typename T2>
+void
+gprtBufferSegmentedSort(GPRTContext context, GPRTBufferOf<T1> keys, GPRTBufferOf<uint32_t> segmentOffsets,
+                        uint32_t numSegments, GPRTBufferOf<T2> scratch GPRT_IF_CPP(= 0)) {
+  gprtBufferSegmentedSort(context, (GPRTBuffer) keys, (GPRTBuffer) segmentOffsets, numSegments,
+                          (GPRTBuffer) scratch);
+}
+
+/**
+ * @brief Sorts the key-value pairs within each of many independent ranges by key, in one call.
+ *
+ * @param context The GPRT context
+ * @param keys A buffer of 64-bit unsigned integer keys
+ * @param values A buffer of 64-bit values
+ * @param segmentOffsets A buffer of numSegments + 1 non-decreasing 32-bit offsets, where segment i covers the
+ * pairs in [segmentOffsets[i], segmentOffsets[i + 1])
+ * @param numSegments The number of segments to sort
+ * @param scratch A scratch buffer for the global radix sort, following the same rules as in gprtBufferSort.
+ */
+GPRT_API void gprtBufferSegmentedSortPayload(GPRTContext context, GPRTBuffer keys, GPRTBuffer values,
+                                             GPRTBuffer segmentOffsets, uint32_t numSegments,
+                                             GPRTBuffer scratch GPRT_IF_CPP(= 0));
+
+/**
+ * @brief Sorts the key-value pairs within each of many independent ranges by key, in one call.
+ *
+ * @tparam T1 The template type of the keys buffer (64-bit keys are assumed)
+ * @tparam T2 The template type of the values buffer (64-bit values are assumed)
+ * @tparam T3 The template type of the scratch buffer (uint8_t is assumed)
+ *
+ * @param context The GPRT context
+ * @param keys A buffer of 64-bit unsigned integer keys
+ * @param values A buffer of 64-bit values
+ * @param segmentOffsets A buffer of numSegments + 1 non-decreasing offsets
+ * @param numSegments The number of segments to sort
+ * @param scratch A scratch buffer for the global radix sort, following the same rules as in gprtBufferSort.
+ */
+template <typename T1, typename T2, typename T3>
+void
+gprtBufferSegmentedSortPayload(GPRTContext context, GPRTBufferOf<T1> keys, GPRTBufferOf<T2> values,
+                               GPRTBufferOf<uint32_t> segmentOffsets, uint32_t numSegments,
+                               GPRTBufferOf<T3> scratch GPRT_IF_CPP(= 0)) {
+  gprtBufferSegmentedSortPayload(context, (GPRTBuffer) keys, (GPRTBuffer) values, (GPRTBuffer) segmentOffsets,
+                                 numSegments, (GPRTBuffer) scratch);
+}
+
+/**
+ * @brief Collapses runs of equal keys, as produced by gprtBufferSort, into one key each. The number of unique keys
+ * is written to device memory, so that a following launch can read it without a round trip through the host.
+ *
+ * @param context The GPRT context
+ * @param keys A buffer of 64-bit unsigned integer keys, where equal keys are adjacent
+ * @param uniqueKeys Receives the first key of each run. Must be able to hold \p count keys.
+ * @param numUnique Receives the number of unique keys as a single 32-bit value
+ * @param count The number of keys to read. If 0, reads the whole keys buffer.
+ * @param scratch A scratch buffer, resized as needed. If null, scratch memory is allocated and released internally.
+ */
+GPRT_API void gprtBufferUnique(GPRTContext context, GPRTBuffer keys, GPRTBuffer uniqueKeys, GPRTBuffer numUnique,
+                               size_t count GPRT_IF_CPP(= 0), GPRTBuffer scratch GPRT_IF_CPP(= 0));
+
+/**
+ * @brief Collapses runs of equal keys into one key each, writing the number of unique keys to device memory.
+ *
+ * @tparam T1 The template type of the keys (64-bit keys are assumed)
+ */
+template <typename T1>
+void
+gprtBufferUnique(GPRTContext context, GPRTBufferOf<T1> keys, GPRTBufferOf<T1> uniqueKeys,
+                 GPRTBufferOf<uint32_t> numUnique, size_t count = 0, GPRTBuffer scratch = 0) {
+  gprtBufferUnique(context, (GPRTBuffer) keys, (GPRTBuffer) uniqueKeys, (GPRTBuffer) numUnique, count, scratch);
+}
+
+/**
+ * @brief Run length encodes adjacent equal keys, writing each run's key and length. The number of runs is written
+ * to device memory, so that a following launch can read it without a round trip through the host.
+ *
+ * @param context The GPRT context
+ * @param keys A buffer of 64-bit unsigned integer keys, where equal keys are adjacent
+ * @param runKeys Receives the key of each run. May be null. Must otherwise be able to hold \p count keys.
+ * @param runLengths Receives the 32-bit length of each run. Must be able to hold \p count lengths.
+ * @param numRuns Receives the number of runs as a single 32-bit value
+ * @param count The number of keys to read. If 0, reads the whole keys buffer.
+ * @param scratch A scratch buffer, resized as needed. If null, scratch memory is allocated and released internally.
+ */
+GPRT_API void gprtBufferRunLengthEncode(GPRTContext context, GPRTBuffer keys, GPRTBuffer runKeys,
+                                        GPRTBuffer runLengths, GPRTBuffer numRuns, size_t count GPRT_IF_CPP(= 0),
+                                        GPRTBuffer scratch GPRT_IF_CPP(= 0));
+
+/**
+ * @brief Run length encodes adjacent equal keys, writing the number of runs to device memory.
+ *
+ * @tparam T1 The template type of the keys (64-bit keys are assumed)
+ */
+template <typename T1>
+void
+gprtBufferRunLengthEncode(GPRTContext context, GPRTBufferOf<T1> keys, GPRTBufferOf<T1> runKeys,
+                          GPRTBufferOf<uint32_t> runLengths, GPRTBufferOf<uint32_t> numRuns, size_t count = 0,
+                          GPRTBuffer scratch = 0) {
+  gprtBufferRunLengthEncode(context, (GPRTBuffer) keys, (GPRTBuffer) runKeys, (GPRTBuffer) runLengths,
+                            (GPRTBuffer) numRuns, count, scratch);
+}
+
+/**
+ * @brief Sums the values of each run of adjacent equal keys, eg per-bin totals after gprtBufferSortPayload. The
+ * number of runs is written to device memory, so that a following launch can read it without a round trip through
+ * the host. Each run is summed sequentially in order, so float results are deterministic.
+ *
+ * @param context The GPRT context
+ * @param keys A buffer of 64-bit unsigned integer keys, where equal keys are adjacent
+ * @param values A buffer of 32-bit values, one per key
+ * @param type The scalar type of the values
+ * @param runKeys Receives the key of each run. May be null. Must otherwise be able to hold \p count keys.
+ * @param runSums Receives the sum of each run's values. Must be able to hold \p count values.
+ * @param numRuns Receives the number of runs as a single 32-bit value
+ * @param count The number of keys to read. If 0, reads the whole keys buffer.
+ * @param scratch A scratch buffer, resized as needed. If null, scratch memory is allocated and released internally.
+ */
+GPRT_API void gprtBufferReduceByKey(GPRTContext context, GPRTBuffer keys, GPRTBuffer values, GPRTScalarType type,
+                                    GPRTBuffer runKeys, GPRTBuffer runSums, GPRTBuffer numRuns,
+                                    size_t count GPRT_IF_CPP(= 0), GPRTBuffer scratch GPRT_IF_CPP(= 0));
+
+/**
+ * @brief Sums the values of each run of adjacent equal keys, writing the number of runs to device memory.
+ *
+ * @tparam T1 The template type of the keys (64-bit keys are assumed)
+ * @tparam T2 The template type of the values (uint32_t, int32_t or float)
+ */
+template <typename T1, typename T2>
+void
+gprtBufferReduceByKey(GPRTContext context, GPRTBufferOf<T1> keys, GPRTBufferOf<T2> values, GPRTBufferOf<T1> runKeys,
+                      GPRTBufferOf<T2> runSums, GPRTBufferOf<uint32_t> numRuns, size_t count = 0,
+                      GPRTBuffer scratch = 0) {
+  gprtBufferReduceByKey(context, (GPRTBuffer) keys, (GPRTBuffer) values, gprtScalarTypeOf<T2>(), (GPRTBuffer) runKeys,
+                        (GPRTBuffer) runSums, (GPRTBuffer) numRuns, count, scratch);
+}
+
+/**
+ * @brief Describes a sorted table of floats for use with gprt::lowerBound in device code.
+ *
+ * @param values A buffer of floats sorted in ascending order, eg an energy grid or tally bin edges. For
+ * logarithmically spaced grids, searching over the logarithm of the values makes better use of a search index.
+ * @param index An optional search index built by gprtBufferBuildSearchIndex, or null for a plain binary search
+ * @param count The number of values in the table. If 0, the whole values buffer is used.
+ */
+GPRT_API gprt::SortedTable gprtBufferGetSortedTable(GPRTBuffer values, GPRTBuffer index GPRT_IF_CPP(= 0),
+                                                    size_t count GPRT_IF_CPP(= 0));
+
+inline gprt::SortedTable
+gprtBufferGetSortedTable(GPRTBufferOf<float> values, GPRTBufferOf<uint32_t> index = nullptr, size_t count = 0) {
+  return gprtBufferGetSortedTable((GPRTBuffer) values, (GPRTBuffer) index, count);
+}
+
+/**
+ * @brief Builds a uniform bucket index over a sorted table of floats. Each bucket records its first table entry, so
+ * that a search only needs to look at the entries of the bucket holding the query, rather than the whole table.
+ * With about as many buckets as table entries, most searches touch only a couple of entries.
+ *
+ * The index must be rebuilt whenever the table changes.
+ *
+ * @param context The GPRT context
+ * @param values A buffer of floats sorted in ascending order
+ * @param index Receives the index. A buffer of numBuckets + 3 32-bit words, which determines the number of buckets.
+ * @param count The number of values in the table. If 0, the whole values buffer is used.
+ */
+GPRT_API void gprtBufferBuildSearchIndex(GPRTContext context, GPRTBuffer values, GPRTBuffer index,
+                                         size_t count GPRT_IF_CPP(= 0));
+
+inline void
+gprtBufferBuildSearchIndex(GPRTContext context, GPRTBufferOf<float> values, GPRTBufferOf<uint32_t> index,
+                           size_t count = 0) {
+  gprtBufferBuildSearchIndex(context, (GPRTBuffer) values, (GPRTBuffer) index, count);
+}
+
+/**
+ * @brief For each query, finds the first position of a sorted table of floats whose value is not less than the
+ * query, like std::lower_bound. Queries beyond the last value return the table size.
+ *
+ * @param context The GPRT context
+ * @param values A buffer of floats sorted in ascending order
+ * @param queries A buffer of float queries
+ * @param results Receives one 32-bit position per query
+ * @param index An optional search index built by gprtBufferBuildSearchIndex, or null for a plain binary search
+ * @param count The number of values in the table. If 0, the whole values buffer is used.
+ * @param numQueries The number of queries. If 0, the whole queries buffer is used.
+ */
+GPRT_API void gprtBufferLowerBound(GPRTContext context, GPRTBuffer values, GPRTBuffer queries, GPRTBuffer results,
+                                   GPRTBuffer index GPRT_IF_CPP(= 0), size_t count GPRT_IF_CPP(= 0),
+                                   size_t numQueries GPRT_IF_CPP(= 0));
+
+inline void
+gprtBufferLowerBound(GPRTContext context, GPRTBufferOf<float> values, GPRTBufferOf<float> queries,
+                     GPRTBufferOf<uint32_t> results, GPRTBufferOf<uint32_t> index = nullptr, size_t count = 0,
+                     size_t numQueries = 0) {
+  gprtBufferLowerBound(context, (GPRTBuffer) values, (GPRTBuffer) queries, (GPRTBuffer) results, (GPRTBuffer) index,
+                       count, numQueries);
+}
+
+/**
+ * @brief Compresses a buffer of 32-bit words on the device, eg a sparse tally or hit record buffer ahead of a read
+ * back. Each block of 256 words keeps only its non-zero words, bit packed to the width of the block's largest word,
+ * so mostly zero data and small counts compress well while dense float data grows by under 1%. The stream is
+ * self-describing, and is decompressed on the host with gprtDecompress.
+ *
+ * @param context The GPRT context
+ * @param source The buffer to compress
+ * @param compressed Receives the compressed stream. Resized to the worst case stream size if too small, which
+ * changes its device address.
+ * @param size The number of bytes to compress, a multiple of 4. If 0, compresses the whole source buffer.
+ * @param scratch A scratch buffer, resized as needed. If null, scratch memory is allocated and released internally.
+ * @return The size of the compressed stream in bytes. Reading it back costs a single 4 byte transfer.
+ */
+GPRT_API size_t gprtBufferCompress(GPRTContext context, GPRTBuffer source, GPRTBuffer compressed,
+                                   size_t size GPRT_IF_CPP(= 0), GPRTBuffer scratch GPRT_IF_CPP(= 0));
+
+template <typename T1>
+size_t
+gprtBufferCompress(GPRTContext context, GPRTBufferOf<T1> source, GPRTBufferOf<uint32_t> compressed, size_t size = 0,
+                   GPRTBuffer scratch = 0) {
+  return gprtBufferCompress(context, (GPRTBuffer) source, (GPRTBuffer) compressed, size, scratch);
+}
+
+/**
+ * @brief Decompresses a stream written by gprtBufferCompress on the host.
+ *
+ * @param compressed The compressed stream
+ * @param compressedSize The size of the compressed stream in bytes
+ * @param output Receives the decompressed words
+ * @param outputSize The size of output in bytes, which must hold all of the stream's words
+ * @return The number of bytes written to output
+ */
+GPRT_API size_t gprtDecompress(const void *compressed, size_t compressedSize, void *output, size_t outputSize);
+
+/**
+ * @brief Reads a buffer back to the host, transferring only its compressed stream. Compression runs on the device
+ * and decompression on the host, with the stream and staging memory reused between calls. Worthwhile when the
+ * transfer dominates, as with large, sparse result buffers read back repeatedly.
+ *
+ * @param context The GPRT context
+ * @param source The buffer to read
+ * @param output Receives the contents of the buffer
+ * @param size The number of bytes to read, a multiple of 4. If 0, reads the whole buffer.
+ * @return The number of compressed bytes transferred
+ */
+GPRT_API size_t gprtBufferReadCompressed(GPRTContext context, GPRTBuffer source, void *output,
+                                         size_t size GPRT_IF_CPP(= 0));
+
+template <typename T1>
+size_t
+gprtBufferReadCompressed(GPRTContext context, GPRTBufferOf<T1> source, T1 *output, size_t size = 0) {
+  return gprtBufferReadCompressed(context, (GPRTBuffer) source, (void *) output, size);
+}
+
+/**
+ * @brief Creates a checkpoint, which asynchronously saves snapshots of device buffers to disk for long running jobs.
+ * Each snapshot is copied into one of numSlots rotating, pinned host staging buffers, and a background thread writes
+ * it to "<prefix>.<version>.gprtckpt" once the copy completes, while the host carries on launching work.
+ *
+ * @param context The GPRT context
+ * @param prefix Path prefix of the checkpoint files
+ * @param numSlots The number of snapshots that may be in flight at once. More slots use more host memory, but let
+ * snapshots be taken more often than they can be written without blocking.
+ * @return GPRTCheckpoint Returns a handle to the created checkpoint.
+ */
+GPRT_API GPRTCheckpoint gprtCheckpointCreate(GPRTContext context, const char *prefix,
+                                             uint32_t numSlots GPRT_IF_CPP(= 2));
+
+/**
+ * @brief Takes a snapshot of the given buffers, returning without waiting for it to be copied or written. Later
+ * launches are ordered after the copy, so they may freely overwrite the buffers, but the buffers must not be
+ * destroyed or resized until the snapshot is written. Blocks only while every slot is still in flight.
+ *
+ * @param context The GPRT context
+ * @param checkpoint The checkpoint to snapshot into
+ * @param numBuffers The number of buffers to save
+ * @param buffers The buffers to save, in the order they're to be restored
+ * @return The snapshot's version, which counts up from 0 and names its file
+ */
+GPRT_API uint64_t gprtCheckpointSnapshot(GPRTContext context, GPRTCheckpoint checkpoint, uint32_t numBuffers,
+                                         GPRTBuffer *buffers);
+
+/**
+ * @brief Blocks until every snapshot taken so far has been written to disk.
+ *
+ * @param checkpoint The checkpoint to wait on
+ */
+GPRT_API void gprtCheckpointWait(GPRTCheckpoint checkpoint);
+
+/**
+ * @brief Returns the path of the file holding the given snapshot version. The file only exists once the snapshot
+ * has been written, and is never left partially written.
+ *
+ * @param checkpoint The checkpoint the snapshot was taken with
+ * @param version The version returned by gprtCheckpointSnapshot
+ * @returns the path, valid until the next call for this checkpoint
+ */
+GPRT_API const char *gprtCheckpointGetPath(GPRTCheckpoint checkpoint, uint64_t version);
+
+/**
+ * @brief Writes any snapshots still in flight, then destroys the checkpoint. Files already written are kept.
+ *
+ * @param checkpoint The checkpoint to destroy
+ */
+GPRT_API void gprtCheckpointDestroy(GPRTCheckpoint checkpoint);
+
+/**
+ * @brief Restores buffers from a checkpoint file written by gprtCheckpointSnapshot. The buffers must be given in
+ * the same order, and have the same sizes, as when the snapshot was taken.
+ *
+ * @param context The GPRT context
+ * @param path The checkpoint file to restore from
+ * @param numBuffers The number of buffers to restore
+ * @param buffers The buffers to restore into
+ * @return The version of the restored snapshot
+ */
+GPRT_API uint64_t gprtCheckpointRestore(GPRTContext context, const char *path, uint32_t numBuffers,
+                                        GPRTBuffer *buffers);
+
+/**
+ * @brief Creates a device resident hash map from 32-bit keys to 32-bit values, eg for sparse tallies over large
+ * meshes or for deduplication. Device code inserts, accumulates into and finds entries through
+ * gprt::hashMapInsert, gprt::hashMapAccumulate and gprt::hashMapFind, using the handle from gprtHashMapGetHandle.
+ *
+ * The map uses open addressing with linear probing, so it degrades quickly above a load factor of about 0.7.
+ * Size the capacity for the expected number of distinct keys accordingly. GPRT_HASH_MAP_EMPTY is reserved, and
+ * may not be used as a key.
+ *
+ * @param context The GPRT context
+ * @param capacity The number of slots, rounded up to a power of two
+ * @return GPRTHashMap Returns a handle to the created, empty, hash map.
+ */
+GPRT_API GPRTHashMap gprtHashMapCreate(GPRTContext context, size_t capacity);
+
+/**
+ * @brief Returns a handle to the given hash map, to pass to device code through parameters or records.
+ */
+GPRT_API gprt::HashMap gprtHashMapGetHandle(GPRTHashMap map);
+
+/**
+ * @brief Removes all entries from the given hash map, and resets its statistics.
+ */
+GPRT_API void gprtHashMapClear(GPRTContext context, GPRTHashMap map);
+
+/**
+ * @brief Copies the entries of a hash map into (key, value) arrays sorted by key.
+ *
+ * @param context The GPRT context
+ * @param map The hash map to extract
+ * @param keys Receives the keys in ascending order, or null if only the values are needed
+ * @param values Receives the value of each key, or null if only the keys are needed
+ * @return uint32_t Returns the number of entries. Both buffers must hold at least this many 32-bit values.
+ */
+GPRT_API uint32_t gprtHashMapExtract(GPRTContext context, GPRTHashMap map, GPRTBuffer keys, GPRTBuffer values);
+
+template <typename T>
+uint32_t
+gprtHashMapExtract(GPRTContext context, GPRTHashMap map, GPRTBufferOf<uint32_t> keys, GPRTBufferOf<T> values) {
+  static_assert(sizeof(T) == sizeof(uint32_t), "hash map values are 32-bit");
+  return gprtHashMapExtract(context, map, (GPRTBuffer) keys, (GPRTBuffer) values);
+}
+
+/** @brief Occupancy of a hash map, as reported by gprtHashMapGetStats */
+typedef struct {
+  uint32_t capacity;           // number of slots
+  uint32_t size;               // number of occupied slots
+  float loadFactor;            // size / capacity
+  uint32_t failedInsertions;   // insertions dropped because the map was full
+  uint32_t maxProbeLength;     // longest run of slots probed past a key's home slot
+} GPRTHashMapStats;
+
+/**
+ * @brief Reports the occupancy of the given hash map. This waits on, and reads back from, the device.
+ *
+ * A non-zero number of failed insertions means results are incomplete, and the map should be recreated larger.
+ */
+GPRT_API void gprtHashMapGetStats(GPRTHashMap map, GPRTHashMapStats *stats);
+
+/**
+ * @brief Destroys the given hash map, freeing its memory.
+ */
+GPRT_API void gprtHashMapDestroy(GPRTHashMap map);
+
+/** @brief How tally kernels combine the scores of tracks crossing the same bin */
+typedef enum {
+  // One atomic per bin a track crosses. Fine when tracks spread over many more bins than there are lanes in flight.
+  GPRT_TALLY_ATOMIC = 0,
+  // Lanes of a subgroup scoring the same bin on the same step add their scores together before a single atomic.
+  // Suits tracks that start together, eg from a common source, which keep neighboring lanes in the same bins.
+  GPRT_TALLY_SUBGROUP = 1,
+  // Each workgroup scores into its own copy of the bins in shared memory, then adds the non-zero bins to the tally
+  // once. Suits small, heavily contended tallies, and falls back to GPRT_TALLY_SUBGROUP above 4096 bins.
+  GPRT_TALLY_PRIVATIZED = 2,
+} GPRTTallyAccumulation;
+
+/**
+ * @brief Scores tracks into a regular grid tally, adding each track's weight times its length within each bin it
+ * crosses to that bin. Bins are walked by a 3D DDA, and tracks are clipped to the grid.
+ *
+ * The same walk is available to device code through gprt::tallyScoreGrid, or gprt::tallyGridWalkBegin and
+ * gprt::tallyGridWalkNext, for scoring from within a transport kernel.
+ *
+ * @param context The GPRT context
+ * @param tracks A buffer of gprt::TallyTrack
+ * @param numTracks The number of tracks to score. If 0, scores every track in the buffer.
+ * @param grid The grid of bins
+ * @param bins One float per bin, which scores are added to. Clear it, eg with gprtBufferClear, to start a tally.
+ * @param accumulation How scores to the same bin are combined
+ */
+GPRT_API void gprtTallyScoreGrid(GPRTContext context, GPRTBuffer tracks, size_t numTracks, gprt::TallyGrid grid,
+                                 GPRTBuffer bins,
+                                 GPRTTallyAccumulation accumulation GPRT_IF_CPP(= GPRT_TALLY_SUBGROUP));
+
+inline void
+gprtTallyScoreGrid(GPRTContext context, GPRTBufferOf<gprt::TallyTrack> tracks, size_t numTracks,
+                   gprt::TallyGrid grid, GPRTBufferOf<float> bins,
+                   GPRTTallyAccumulation accumulation = GPRT_TALLY_SUBGROUP) {
+  gprtTallyScoreGrid(context, (GPRTBuffer) tracks, numTracks, grid, (GPRTBuffer) bins, accumulation);
+}
+
+/**
+ * @brief Scores tracks into an unstructured mesh tally with one bin per cell, by walking the face adjacency of the
+ * mesh from each track's cell until the track ends or leaves the mesh. Tetrahedra, hexahedra, wedges and pyramids
+ * are supported, as for gprt::solidWalkBegin.
+ *
+ * Device code can score the same way through gprt::tallyScoreMesh.
+ *
+ * @param context The GPRT context
+ * @param tracks A buffer of gprt::TallyTrack, each with the cell holding its origin
+ * @param numTracks The number of tracks to score. If 0, scores every track in the buffer.
+ * @param mesh The mesh, from gprtSolidsGetMesh
+ * @param bins One float per cell, which scores are added to
+ * @param accumulation How scores to the same cell are combined
+ */
+GPRT_API void gprtTallyScoreMesh(GPRTContext context, GPRTBuffer tracks, size_t numTracks, gprt::SolidMesh mesh,
+                                 GPRTBuffer bins,
+                                 GPRTTallyAccumulation accumulation GPRT_IF_CPP(= GPRT_TALLY_SUBGROUP));
+
+inline void
+gprtTallyScoreMesh(GPRTContext context, GPRTBufferOf<gprt::TallyTrack> tracks, size_t numTracks,
+                   gprt::SolidMesh mesh, GPRTBufferOf<float> bins,
+                   GPRTTallyAccumulation accumulation = GPRT_TALLY_SUBGROUP) {
+  gprtTallyScoreMesh(context, (GPRTBuffer) tracks, numTracks, mesh, (GPRTBuffer) bins, accumulation);
+}
+
 // GPRT_API gprt::Buffer gprtBufferGetHandle(GPRTBuffer buffer, int deviceID GPRT_IF_CPP(= 0));
 
 // template <typename T>
@@ -2246,6 +3509,52 @@ gprtComputeLaunch(GPRTComputeOf<Uniforms...> compute, uint3 numGroups, uint3 gro
   _gprtComputeLaunch((GPRTCompute) compute, numGroups, groupSize, pushConstants);
 }
 
+// declaration for internal implementation
+uint32_t _gprtComputeAutotune(GPRTCompute compute, uint32_t numThreads,
+                              std::array<char, PUSH_CONSTANTS_LIMIT> pushConstants);
+
+/**
+ * @brief Benchmarks a compute kernel over candidate group sizes from 32 to THREADGROUP_LIMIT, and launches it with
+ * the fastest from then on. If a tuning cache was set with @ref gprtContextSetTuningCache, the winner is recorded
+ * there, so later runs on the same device skip tuning.
+ *
+ * Only kernels that declare their group size with the GPRT_GROUP_SIZE_CONSTANT_ID specialization constant can be
+ * tuned, and tuning any other kernel is an error. They must be one dimensional and bounds check their thread index
+ * against their element count, as a tuned launch rounds the number of threads up to a whole number of groups. The
+ * kernel is launched several times per candidate with the given uniforms, so pass representative inputs whose side
+ * effects are harmless to repeat.
+ *
+ * @param compute The compute kernel to tune
+ * @param numThreads The total number of threads of a representative launch
+ * @returns the fastest group size, or 0 if no candidate fits
+ */
+template <typename... Uniforms>
+uint32_t
+gprtComputeAutotune(GPRTComputeOf<Uniforms...> compute, uint32_t numThreads, Uniforms... uniforms) {
+  static_assert(totalSizeOf<Uniforms...>() <= PUSH_CONSTANTS_LIMIT,
+                "Total size of arguments exceeds PUSH_CONSTANTS_LIMIT bytes");
+
+  std::array<char, PUSH_CONSTANTS_LIMIT> pushConstants{};   // Initialize with zero
+  size_t offset = 0;
+
+  // Serialize each argument into the buffer
+  (handleArg(pushConstants, offset, uniforms), ...);
+
+  return _gprtComputeAutotune((GPRTCompute) compute, numThreads, pushConstants);
+}
+
+/**
+ * @brief Returns the group size a tuned compute kernel launches with, or 0 if the kernel isn't tuned and launches
+ * with its own group size.
+ */
+GPRT_API uint32_t gprtComputeGetGroupSize(GPRTCompute compute);
+
+template <typename... Uniforms>
+uint32_t
+gprtComputeGetGroupSize(GPRTComputeOf<Uniforms...> compute) {
+  return gprtComputeGetGroupSize((GPRTCompute) compute);
+}
+
 GPRT_API void gprtBeginProfile(GPRTContext context);
 
 // returned results are in milliseconds
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "gprt.h"
+
+// Parameters for rasterizing the triangles of one geometry of one instance into a visibility buffer.
+// One draw is issued per (instance, geometry) pair, with one vertex shader invocation per triangle corner.
+struct RasterVisibilityParameters {
+  float4x4 viewProjection;   // world to clip space
+  float3x4 transform;        // object to world space, ie the instance transform
+  float3 cameraPosition;     // used to convert fragment positions into hit distances
+  uint32_t instanceIndex;
+  uint8_t *vertices;         // address of the first vertex
+  uint8_t *indices;          // address of the first triangle's indices
+  uint32_t vertexStride;
+  uint32_t indexStride;
+  uint32_t firstVertex;      // added to index values before fetching vertices
+  uint32_t geometryIndex;
+};
@@ -66,6 +66,17 @@
 #define WORKGROUP_LIMIT   65535
 #define THREADGROUP_LIMIT 1024
 
+// Compute kernels opt into workgroup size tuning (see gprtComputeAutotune) by declaring their group size as the
+// specialization constant with this id, ie
+//   [vk::constant_id(GPRT_GROUP_SIZE_CONSTANT_ID)] const uint32_t groupSize = 256;
+//   [numthreads(groupSize, 1, 1)]
+#define GPRT_GROUP_SIZE_CONSTANT_ID 0
+
+// The ray tracing pipeline specializes these with the two halves of the address of the context's ray time slot,
+// through which TraceMotionRay hands its time to the intersection programs of motion geometry
+#define GPRT_RAY_TIME_SLOT_CONSTANT_ID_LO 1
+#define GPRT_RAY_TIME_SLOT_CONSTANT_ID_HI 2
+
 // Some constants for the device parallel scan implementation
 #define SCAN_PARTITON_SIZE   8192
 #define SCAN_PARTITION       (1 << 0)
@@ -100,6 +111,137 @@ struct Instance {
   uint64_t __gprtAccelAddress;
 };
 
+// Written per pixel by gprtAccelRasterizeVisibility. Fields match what a traced primary ray would
+// report through InstanceIndex(), GeometryIndex(), PrimitiveIndex() and RayTCurrent().
+// Pixels not covered by any triangle have an instanceIndex of GPRT_VISIBILITY_MISS, and infinite t.
+#define GPRT_VISIBILITY_MISS 0xFFFFFFFF
+struct Visibility {
+  uint32_t instanceIndex;
+  uint32_t geometryIndex;
+  uint32_t primitiveIndex;
+  float t;
+};
+
+// A sorted table of floats for gprt::lowerBound, eg an energy grid or tally bin edges. The optional index,
+// built by gprtBufferBuildSearchIndex, splits the table's range into uniform buckets and stores the first table
+// entry of each bucket, which narrows each search to the entries of a single bucket.
+//
+// Index layout: [0] the table's minimum, [1] buckets per unit, [2, 2 + numBuckets] the first entry of each bucket
+// followed by the table size.
+struct SortedTable {
+  float *values;
+  uint32_t *index;   // may be null, for a plain binary search
+  uint32_t count;
+  uint32_t numBuckets;
+};
+
+// A device resident, open addressing hash map from 32-bit keys to 32-bit values, created with gprtHashMapCreate
+// and used through gprt::hashMapInsert, gprt::hashMapAccumulate and gprt::hashMapFind. Slots are claimed lock
+// free with linear probing, and entries are never removed, only cleared all at once between batches.
+#define GPRT_HASH_MAP_EMPTY 0xFFFFFFFF   // reserved, may not be used as a key
+struct HashMap {
+  uint32_t *keys;
+  uint32_t *values;
+  uint32_t *stats;     // [0] occupied slots, [1] failed insertions, [2] longest probe sequence
+  uint32_t capacity;   // always a power of two
+};
+
+// Returned by gprt::subgroupAppendIf and gprt::subgroupCompact to lanes that did not append anything
+#define GPRT_SUBGROUP_NONE 0xFFFFFFFF
+
+// Hit attributes reported by the built-in intersection program of GPRT_VOXELS geometry. The ray enters the voxel
+// (or run of equal valued voxels) at RayTCurrent(), and leaves it at exitT.
+struct VoxelAttributes {
+  uint32_t voxel;   // linear index of the (first) voxel, i + dims.x * (j + dims.y * k)
+  float exitT;
+};
+
+// Lets the built-in solid intersection program skip cells that cannot contribute before inverting them, using the
+// range of vertex values the bounds kernel stores with each cell. A cell passes if its value range overlaps range
+// and, when numBins is non-zero, covers at least one occupied bin, eg one with non-zero opacity in a transfer
+// function. Set with gprtSolidsSetValueFilter. The filter lives in a buffer, so it can change between launches
+// without rebuilding the shader binding table.
+#define GPRT_SOLID_FILTER_MAX_BINS 256
+struct SolidValueFilter {
+  uint32_t *stats;   // [0] cells tested, [1] cells rejected by the filter. May be null.
+  float2 range;
+  float2 domain;     // the values covered by the bins
+  uint32_t numBins;
+  uint32_t occupied[GPRT_SOLID_FILTER_MAX_BINS + 1];   // number of occupied bins before each bin
+};
+
+// Faces of the linear solid cell types, as corner indices into a cell's (VTK ordered) vertices. Rows are indexed
+// by cell type minus GPRT_SOLID_FIRST_FACE_TYPE, and triangular faces end with GPRT_SOLID_FACE_END. Both the host,
+// when matching the faces of neighboring cells, and the device, when walking from cell to cell, use this table.
+#define GPRT_SOLID_MAX_FACES       6
+#define GPRT_SOLID_FIRST_FACE_TYPE 10   // GPRT_TETRAHEDRON
+#define GPRT_SOLID_LAST_FACE_TYPE  14   // GPRT_PYRAMID
+#define GPRT_SOLID_FACE_END        0xFF
+static const uint32_t solidFaceCorners[5][GPRT_SOLID_MAX_FACES][4] = {
+    // tetrahedron
+    {{0, 1, 3, 0xFF}, {1, 2, 3, 0xFF}, {2, 0, 3, 0xFF}, {0, 2, 1, 0xFF}, {0xFF, 0xFF, 0xFF, 0xFF}, {0xFF, 0xFF, 0xFF, 0xFF}},
+    // voxel, unsupported
+    {{0xFF, 0xFF, 0xFF, 0xFF}, {0xFF, 0xFF, 0xFF, 0xFF}, {0xFF, 0xFF, 0xFF, 0xFF},
+     {0xFF, 0xFF, 0xFF, 0xFF}, {0xFF, 0xFF, 0xFF, 0xFF}, {0xFF, 0xFF, 0xFF, 0xFF}},
+    // hexahedron
+    {{0, 4, 7, 3}, {1, 2, 6, 5}, {0, 1, 5, 4}, {3, 7, 6, 2}, {0, 3, 2, 1}, {4, 5, 6, 7}},
+    // wedge
+    {{0, 1, 2, 0xFF}, {3, 5, 4, 0xFF}, {0, 3, 4, 1}, {1, 4, 5, 2}, {2, 5, 3, 0}, {0xFF, 0xFF, 0xFF, 0xFF}},
+    // pyramid
+    {{0, 3, 2, 1}, {0, 1, 4, 0xFF}, {1, 2, 4, 0xFF}, {2, 3, 4, 0xFF}, {3, 0, 4, 0xFF}, {0xFF, 0xFF, 0xFF, 0xFF}},
+};
+
+// A solid geometry together with its face adjacency, returned by gprtSolidsGetMesh once gprtSolidsBuildAdjacency
+// has been called, and walked cell to cell with gprt::solidWalkBegin and gprt::solidWalkStep.
+//
+// Adjacency holds GPRT_SOLID_MAX_FACES entries per cell. Each is the neighbor across that face, packed as
+// (cell << 3) | face with face the neighbor's own index for the shared face, or GPRT_SOLID_BOUNDARY.
+#define GPRT_SOLID_BOUNDARY 0xFFFFFFFF
+struct SolidMesh {
+  float4 *vertices;
+  uint32_t *indices;
+  uint8_t *types;
+  uint32_t *adjacency;
+  uint32_t count;            // number of cells
+  uint32_t verticesOffset;   // all offsets and strides are in bytes
+  uint32_t verticesStride;
+  uint32_t indicesOffset;
+  uint32_t indicesStride;
+  uint32_t typesOffset;
+  uint32_t typesStride;
+};
+
+// The state of a walk through a gprt::SolidMesh. The ray is inside cell between tEnter and tExit, where the
+// interpolated vertex values are valueEnter and valueExit. Once the walk leaves the mesh, cell is
+// GPRT_SOLID_BOUNDARY.
+struct SolidWalk {
+  uint32_t cell;
+  uint32_t exitFace;
+  float tEnter;
+  float tExit;
+  float valueEnter;
+  float valueExit;
+};
+
+// A straight track of a particle, scored into a mesh tally as its weight times its length within each bin, by
+// gprtTallyScoreGrid and gprtTallyScoreMesh, or by gprt::tallyScoreGrid and gprt::tallyScoreMesh from within a
+// kernel. Mesh tallies walk the mesh from cell, the cell holding origin, eg as found by a TracePoint against the
+// mesh's SolidAccel, and skip tracks whose cell is GPRT_SOLID_BOUNDARY. Grid tallies ignore cell.
+struct TallyTrack {
+  float3 origin;
+  float length;
+  float3 direction;   // unit length
+  float weight;
+  uint32_t cell;
+};
+
+// A regular grid of tally bins over the box from lower to upper, where bin (i, j, k) is i + dims.x * (j + dims.y * k)
+struct TallyGrid {
+  float3 lower;
+  float3 upper;
+  uint3 dims;
+};
+
 // // https://publications.anl.gov/anlpubs/2014/12/79486.pdf
 // // https://www.kitware.com/modeling-arbitrary-order-lagrange-finite-elements-in-the-visualization-toolkit/
 // struct Solid {
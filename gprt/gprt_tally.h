@@ -0,0 +1,30 @@
+#pragma once
+
+#include "gprt.h"
+
+// Accumulation strategies for gprtTallyScoreGrid and gprtTallyScoreMesh.
+// Note, these must match the values of GPRTTallyAccumulation in gprt_host.h
+#define TALLY_ATOMIC     0
+#define TALLY_SUBGROUP   1
+#define TALLY_PRIVATIZED 2
+
+// One thread per track, in a grid-stride loop
+#define TALLY_THREADGROUP_SIZE 256
+
+// Privatized tallies keep a copy of every bin in shared memory, which bounds them to tallies of at most this many
+// bins, within the 16KB of shared memory Vulkan guarantees. Larger tallies fall back to subgroup aggregation.
+#define TALLY_PRIVATE_BINS 4096
+
+// Every privatized workgroup flushes all of its bins, so fewer, longer lived workgroups score each tally
+#define TALLY_PRIVATE_GROUPS 256
+
+struct TallyParameters {
+  gprt::TallyTrack *tracks;
+  float *bins;
+  gprt::SolidMesh mesh;   // for mesh tallies
+  gprt::TallyGrid grid;   // for grid tallies
+  uint32_t count;         // number of tracks
+  uint32_t stride;        // total number of threads in the launch
+  uint32_t numBins;
+  uint32_t accumulation;
+};
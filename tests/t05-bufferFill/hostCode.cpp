@@ -0,0 +1,214 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+int
+main(int ac, char **av) {
+  const uint32_t numItems = 100000000;
+
+  // Clear happens on the device, and is faster than a host round trip
+  {
+    // Arrange
+    GPRTContext context = gprtContextCreate(nullptr, 1);
+    GPRTBufferOf<uint32_t> A = gprtDeviceBufferCreate<uint32_t>(context, numItems);
+    {
+      gprtBufferMap(A);
+      uint32_t *ptr = gprtBufferGetHostPointer(A);
+      for (uint32_t i = 0; i < numItems; ++i) {
+        ptr[i] = i + 1;
+      }
+      gprtBufferUnmap(A);
+    }
+
+    // Act
+    auto start = std::chrono::high_resolution_clock::now();
+    gprtBufferClear(A);
+    auto stop = std::chrono::high_resolution_clock::now();
+    auto deviceTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+
+    // Reference, the previous map / memset / unmap round trip
+    start = std::chrono::high_resolution_clock::now();
+    {
+      gprtBufferMap(A);
+      uint32_t *ptr = gprtBufferGetHostPointer(A);
+      memset(ptr, 0, numItems * sizeof(uint32_t));
+      gprtBufferUnmap(A);
+    }
+    stop = std::chrono::high_resolution_clock::now();
+    auto hostTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    std::cout << "Clear " << numItems << " items: device " << deviceTime.count() / 1000.f << " ms, host round trip "
+              << hostTime.count() / 1000.f << " ms" << std::endl;
+
+    // Assert
+    {
+      gprtBufferFill(context, A, 7u);
+      gprtBufferClear(A);
+      gprtBufferMap(A);
+      uint32_t *ptr = gprtBufferGetHostPointer(A);
+      for (uint32_t i = 0; i < numItems; ++i) {
+        if (ptr[i] != 0)
+          throw std::runtime_error("Error, buffer not cleared!");
+      }
+      gprtBufferUnmap(A);
+    }
+
+    // Cleanup
+    gprtBufferDestroy(A);
+    gprtContextDestroy(context);
+  }
+
+  // Value and pattern fills over a sub range
+  {
+    // Arrange
+    GPRTContext context = gprtContextCreate(nullptr, 1);
+    GPRTBufferOf<float> A = gprtDeviceBufferCreate<float>(context, numItems);
+    GPRTBufferOf<float3> B = gprtDeviceBufferCreate<float3>(context, 1000);
+    GPRTBufferOf<uint8_t> C = gprtDeviceBufferCreate<uint8_t>(context, 1024);
+    gprtBufferClear(A);
+    gprtBufferClear(B);
+
+    // Act
+    gprtBufferFill(context, A, 3.5f, 10, 100);
+    gprtBufferFill(context, B, float3(1.f, 2.f, 3.f), 1);
+    gprtBufferFill(context, C, uint8_t(0xAB));
+
+    // Assert
+    {
+      gprtBufferMap(A);
+      float *ptr = gprtBufferGetHostPointer(A);
+      for (uint32_t i = 0; i < numItems; ++i) {
+        float expected = (i >= 10 && i < 110) ? 3.5f : 0.f;
+        if (ptr[i] != expected)
+          throw std::runtime_error("Error, incorrect value fill!");
+      }
+      gprtBufferUnmap(A);
+    }
+    {
+      gprtBufferMap(B);
+      float3 *ptr = gprtBufferGetHostPointer(B);
+      if (ptr[0].x != 0.f || ptr[0].y != 0.f || ptr[0].z != 0.f)
+        throw std::runtime_error("Error, pattern fill wrote outside of range!");
+      for (uint32_t i = 1; i < 1000; ++i) {
+        if (ptr[i].x != 1.f || ptr[i].y != 2.f || ptr[i].z != 3.f)
+          throw std::runtime_error("Error, incorrect pattern fill!");
+      }
+      gprtBufferUnmap(B);
+    }
+    {
+      gprtBufferMap(C);
+      uint8_t *ptr = gprtBufferGetHostPointer(C);
+      for (uint32_t i = 0; i < 1024; ++i) {
+        if (ptr[i] != 0xAB)
+          throw std::runtime_error("Error, incorrect byte fill!");
+      }
+      gprtBufferUnmap(C);
+    }
+
+    // Cleanup
+    gprtBufferDestroy(A);
+    gprtBufferDestroy(B);
+    gprtBufferDestroy(C);
+    gprtContextDestroy(context);
+  }
+
+  // Iota and random initialization
+  {
+    // Arrange
+    GPRTContext context = gprtContextCreate(nullptr, 1);
+    GPRTBufferOf<uint32_t> A = gprtDeviceBufferCreate<uint32_t>(context, numItems);
+    GPRTBufferOf<float> B = gprtDeviceBufferCreate<float>(context, numItems);
+    GPRTBufferOf<float> C = gprtDeviceBufferCreate<float>(context, numItems);
+
+    // Act
+    gprtBufferIota(context, A, 5u, 2u);
+    gprtBufferRandom(context, B, 42, -1.f, 1.f);
+    gprtBufferRandom(context, C, 42, -1.f, 1.f);
+
+    // Assert
+    {
+      gprtBufferMap(A);
+      uint32_t *ptr = gprtBufferGetHostPointer(A);
+      for (uint32_t i = 0; i < numItems; ++i) {
+        if (ptr[i] != 5u + 2u * i)
+          throw std::runtime_error("Error, incorrect iota value!");
+      }
+      gprtBufferUnmap(A);
+    }
+    {
+      gprtBufferMap(B);
+      gprtBufferMap(C);
+      float *b = gprtBufferGetHostPointer(B);
+      float *c = gprtBufferGetHostPointer(C);
+      double mean = 0.0;
+      for (uint32_t i = 0; i < numItems; ++i) {
+        if (b[i] < -1.f || b[i] >= 1.f)
+          throw std::runtime_error("Error, random value out of range!");
+        if (b[i] != c[i])
+          throw std::runtime_error("Error, random values not reproducible for a given seed!");
+        mean += b[i];
+      }
+      mean /= numItems;
+      if (fabs(mean) > 1e-2)
+        throw std::runtime_error("Error, random values not uniformly distributed!");
+      gprtBufferUnmap(B);
+      gprtBufferUnmap(C);
+    }
+
+    // Cleanup
+    gprtBufferDestroy(A);
+    gprtBufferDestroy(B);
+    gprtBufferDestroy(C);
+    gprtContextDestroy(context);
+  }
+
+  // Texture fill
+  {
+    // Arrange
+    GPRTContext context = gprtContextCreate(nullptr, 1);
+    GPRTTextureOf<float4> T = gprtDeviceTextureCreate<float4>(context, GPRT_IMAGE_TYPE_2D,
+                                                              GPRT_FORMAT_R32G32B32A32_SFLOAT, 64, 64, 1, false);
+
+    // Act
+    gprtTextureFill(T, float4(0.25f, 0.5f, 0.75f, 1.f));
+
+    // Assert
+    {
+      gprtTextureMap(T);
+      float4 *ptr = (float4 *) gprtTextureGetPointer(T);
+      for (uint32_t i = 0; i < 64 * 64; ++i) {
+        if (ptr[i].x != 0.25f || ptr[i].y != 0.5f || ptr[i].z != 0.75f || ptr[i].w != 1.f)
+          throw std::runtime_error("Error, incorrect texture fill!");
+      }
+      gprtTextureUnmap(T);
+    }
+
+    // Cleanup
+    gprtTextureDestroy(T);
+    gprtContextDestroy(context);
+  }
+}
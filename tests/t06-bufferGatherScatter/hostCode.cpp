@@ -0,0 +1,199 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+struct Particle {
+  float3 position;
+  float weight;
+  float3 direction;
+  uint32_t id;
+};
+
+int
+main(int ac, char **av) {
+  const uint32_t numItems = 10000000;
+
+  // Many small regions, one copy command
+  {
+    // Arrange
+    const uint32_t numRegions = 10000;
+    const uint32_t regionSize = 100;
+    GPRTContext context = gprtContextCreate(nullptr, 1);
+    GPRTBufferOf<uint32_t> A = gprtDeviceBufferCreate<uint32_t>(context, numRegions * regionSize);
+    GPRTBufferOf<uint32_t> B = gprtDeviceBufferCreate<uint32_t>(context, numRegions * regionSize);
+    gprtBufferIota(context, A);
+    gprtBufferClear(B);
+
+    // Reverse the order of the regions
+    std::vector<GPRTBufferCopyRegion> regions(numRegions);
+    for (uint32_t i = 0; i < numRegions; ++i) {
+      regions[i].srcOffset = i * regionSize;
+      regions[i].dstOffset = (numRegions - 1 - i) * regionSize;
+      regions[i].count = regionSize;
+    }
+
+    // Act
+    auto start = std::chrono::high_resolution_clock::now();
+    gprtBufferCopyRegions(context, A, B, regions);
+    auto stop = std::chrono::high_resolution_clock::now();
+    auto batchedTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+
+    // Reference, one submission per region
+    start = std::chrono::high_resolution_clock::now();
+    for (auto &region : regions)
+      gprtBufferCopy(context, A, B, region.srcOffset, region.dstOffset, region.count);
+    stop = std::chrono::high_resolution_clock::now();
+    auto individualTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    std::cout << "Copy " << numRegions << " regions: batched " << batchedTime.count() / 1000.f << " ms, individual "
+              << individualTime.count() / 1000.f << " ms" << std::endl;
+
+    // Assert
+    {
+      gprtBufferMap(B);
+      uint32_t *ptr = gprtBufferGetHostPointer(B);
+      for (uint32_t i = 0; i < numRegions; ++i) {
+        for (uint32_t j = 0; j < regionSize; ++j) {
+          uint32_t expected = (numRegions - 1 - i) * regionSize + j;
+          if (ptr[i * regionSize + j] != expected)
+            throw std::runtime_error("Error, incorrect region copy!");
+        }
+      }
+      gprtBufferUnmap(B);
+    }
+
+    // Cleanup
+    gprtBufferDestroy(A);
+    gprtBufferDestroy(B);
+    gprtContextDestroy(context);
+  }
+
+  // Gather / scatter round trip over a random permutation
+  {
+    // Arrange
+    GPRTContext context = gprtContextCreate(nullptr, 1);
+    std::vector<uint32_t> permutation(numItems);
+    for (uint32_t i = 0; i < numItems; ++i)
+      permutation[i] = i;
+    std::shuffle(permutation.begin(), permutation.end(), std::mt19937{0});
+
+    GPRTBufferOf<uint32_t> indices = gprtDeviceBufferCreate<uint32_t>(context, numItems, permutation.data());
+    GPRTBufferOf<float4> A = gprtDeviceBufferCreate<float4>(context, numItems);
+    GPRTBufferOf<float4> B = gprtDeviceBufferCreate<float4>(context, numItems);
+    GPRTBufferOf<float4> C = gprtDeviceBufferCreate<float4>(context, numItems);
+    {
+      gprtBufferMap(A);
+      float4 *ptr = gprtBufferGetHostPointer(A);
+      for (uint32_t i = 0; i < numItems; ++i)
+        ptr[i] = float4(float(i), float(i) + 0.25f, float(i) + 0.5f, float(i) + 0.75f);
+      gprtBufferUnmap(A);
+    }
+
+    // Act
+    gprtBeginProfile(context);
+    gprtBufferGather(context, A, indices, B, numItems);
+    float gatherTime = gprtEndProfile(context);
+
+    gprtBeginProfile(context);
+    gprtBufferScatter(context, B, indices, C, numItems);
+    float scatterTime = gprtEndProfile(context);
+
+    // Bytes read and written, including the index buffer
+    double bytes = double(numItems) * (2 * sizeof(float4) + sizeof(uint32_t));
+    std::cout << "Gather " << numItems << " float4s: " << gatherTime << " ms, " << bytes / (gatherTime * 1e6)
+              << " GB/s" << std::endl;
+    std::cout << "Scatter " << numItems << " float4s: " << scatterTime << " ms, " << bytes / (scatterTime * 1e6)
+              << " GB/s" << std::endl;
+
+    // Assert
+    {
+      gprtBufferMap(B);
+      gprtBufferMap(C);
+      float4 *b = gprtBufferGetHostPointer(B);
+      float4 *c = gprtBufferGetHostPointer(C);
+      for (uint32_t i = 0; i < numItems; ++i) {
+        if (b[i].x != float(permutation[i]))
+          throw std::runtime_error("Error, incorrect gathered value!");
+        if (c[i].x != float(i) || c[i].w != float(i) + 0.75f)
+          throw std::runtime_error("Error, scatter did not invert gather!");
+      }
+      gprtBufferUnmap(B);
+      gprtBufferUnmap(C);
+    }
+
+    // Cleanup
+    gprtBufferDestroy(indices);
+    gprtBufferDestroy(A);
+    gprtBufferDestroy(B);
+    gprtBufferDestroy(C);
+    gprtContextDestroy(context);
+  }
+
+  // Strided gather of the leading member out of an array of structures
+  {
+    // Arrange
+    const uint32_t numParticles = 1000000;
+    GPRTContext context = gprtContextCreate(nullptr, 1);
+    GPRTBufferOf<Particle> particles = gprtDeviceBufferCreate<Particle>(context, numParticles);
+    GPRTBufferOf<uint32_t> indices = gprtDeviceBufferCreate<uint32_t>(context, numParticles / 2);
+    GPRTBufferOf<float3> positions = gprtDeviceBufferCreate<float3>(context, numParticles / 2);
+    {
+      gprtBufferMap(particles);
+      Particle *ptr = gprtBufferGetHostPointer(particles);
+      for (uint32_t i = 0; i < numParticles; ++i) {
+        ptr[i].position = float3(float(i), 1.f, 2.f);
+        ptr[i].weight = 1.f;
+        ptr[i].direction = float3(0.f);
+        ptr[i].id = i;
+      }
+      gprtBufferUnmap(particles);
+    }
+    // Every other particle
+    gprtBufferIota(context, indices, 0u, 2u);
+
+    // Act
+    gprtBufferGather(context, (GPRTBuffer) particles, (GPRTBuffer) indices, (GPRTBuffer) positions, sizeof(float3),
+                     numParticles / 2, sizeof(Particle), sizeof(float3));
+
+    // Assert
+    {
+      gprtBufferMap(positions);
+      float3 *ptr = gprtBufferGetHostPointer(positions);
+      for (uint32_t i = 0; i < numParticles / 2; ++i) {
+        if (ptr[i].x != float(2 * i) || ptr[i].y != 1.f || ptr[i].z != 2.f)
+          throw std::runtime_error("Error, incorrect strided gather!");
+      }
+      gprtBufferUnmap(positions);
+    }
+
+    // Cleanup
+    gprtBufferDestroy(particles);
+    gprtBufferDestroy(indices);
+    gprtBufferDestroy(positions);
+    gprtContextDestroy(context);
+  }
+}
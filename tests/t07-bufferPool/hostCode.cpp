@@ -0,0 +1,194 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+
+int
+main(int ac, char **av) {
+  const uint32_t numPooledBuffers = 1000000;
+  // Every regular buffer is its own VkBuffer, with a staging buffer of its own for device buffers. A million of them
+  // takes minutes to create and can run into driver limits on the number of live objects, so the regular case is
+  // scaled down, and its per buffer time and memory extrapolated to numPooledBuffers for comparison.
+  const uint32_t numRegularBuffers = 10000;
+  const uint32_t elementsPerBuffer = 16;
+
+  // Creation time and memory use of many small buffers, pooled versus individually allocated
+  {
+    // Arrange
+    GPRTContext context = gprtContextCreate(nullptr, 1);
+    std::vector<GPRTBufferOf<uint32_t>> regular(numRegularBuffers);
+    std::vector<GPRTBufferOf<uint32_t>> pooled(numPooledBuffers);
+    GPRTBufferPool pool = gprtDeviceBufferPoolCreate(context);
+
+    // Act
+    size_t memoryBefore = gprtContextGetAllocatedMemory(context);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < numRegularBuffers; ++i)
+      regular[i] = gprtDeviceBufferCreate<uint32_t>(context, elementsPerBuffer);
+    auto stop = std::chrono::high_resolution_clock::now();
+    auto regularTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    size_t regularMemory = gprtContextGetAllocatedMemory(context) - memoryBefore;
+
+    memoryBefore = gprtContextGetAllocatedMemory(context);
+    start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < numPooledBuffers; ++i)
+      pooled[i] = gprtBufferPoolAllocate<uint32_t>(pool, elementsPerBuffer);
+    stop = std::chrono::high_resolution_clock::now();
+    auto pooledTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    size_t pooledMemory = gprtContextGetAllocatedMemory(context) - memoryBefore;
+
+    GPRTBufferPoolStats stats;
+    gprtBufferPoolGetStats(pool, &stats);
+    float regularScale = float(numPooledBuffers) / numRegularBuffers;
+    std::cout << "Create " << numRegularBuffers << " regular buffers: " << regularTime.count() / 1000.f << " ms ("
+              << float(regularTime.count()) / numRegularBuffers << " us per buffer), "
+              << regularMemory / (1024.f * 1024.f) << " MB (" << float(regularMemory) / numRegularBuffers
+              << " bytes per buffer)" << std::endl;
+    std::cout << "  extrapolated to " << numPooledBuffers << " buffers: " << regularTime.count() * regularScale / 1000.f
+              << " ms, " << regularMemory * regularScale / (1024.f * 1024.f) << " MB" << std::endl;
+    std::cout << "Create " << numPooledBuffers << " pooled buffers: " << pooledTime.count() / 1000.f << " ms ("
+              << float(pooledTime.count()) / numPooledBuffers << " us per buffer), "
+              << pooledMemory / (1024.f * 1024.f) << " MB (" << float(pooledMemory) / numPooledBuffers
+              << " bytes per buffer)" << std::endl;
+    std::cout << "Pool: " << stats.numBlocks << " blocks, " << stats.reservedBytes / (1024.f * 1024.f) << " MB reserved, "
+              << stats.allocatedBytes / (1024.f * 1024.f) << " MB allocated" << std::endl;
+
+    // Assert
+    if (stats.numAllocations != numPooledBuffers)
+      throw std::runtime_error("Error, incorrect number of pooled allocations!");
+    if (stats.allocatedBytes != uint64_t(numPooledBuffers) * elementsPerBuffer * sizeof(uint32_t))
+      throw std::runtime_error("Error, incorrect number of pooled bytes!");
+    if (stats.reservedBytes < stats.allocatedBytes)
+      throw std::runtime_error("Error, pool reserved fewer bytes than were allocated!");
+    {
+      // Every pooled buffer has its own, non-overlapping device address
+      std::set<uint64_t> addresses;
+      for (uint32_t i = 0; i < numPooledBuffers; ++i)
+        addresses.insert((uint64_t) gprtBufferGetDevicePointer(pooled[i]));
+      if (addresses.size() != numPooledBuffers)
+        throw std::runtime_error("Error, pooled buffers share a device address!");
+      uint64_t previous = 0;
+      for (uint64_t address : addresses) {
+        if (previous != 0 && address - previous < elementsPerBuffer * sizeof(uint32_t))
+          throw std::runtime_error("Error, pooled buffers overlap!");
+        previous = address;
+      }
+    }
+
+    // Cleanup
+    start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < numPooledBuffers; ++i)
+      gprtBufferDestroy(pooled[i]);
+    stop = std::chrono::high_resolution_clock::now();
+    auto releaseTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    std::cout << "Destroy " << numPooledBuffers << " pooled buffers: " << releaseTime.count() / 1000.f << " ms"
+              << std::endl;
+
+    gprtBufferPoolGetStats(pool, &stats);
+    if (stats.numAllocations != 0 || stats.allocatedBytes != 0)
+      throw std::runtime_error("Error, pooled buffers were not returned to the pool!");
+
+    for (uint32_t i = 0; i < numRegularBuffers; ++i)
+      gprtBufferDestroy(regular[i]);
+    gprtBufferPoolDestroy(pool);
+    gprtContextDestroy(context);
+  }
+
+  // Pooled buffers behave like regular buffers
+  {
+    // Arrange
+    const uint32_t numBuffers = 1000;
+    GPRTContext context = gprtContextCreate(nullptr, 1);
+    GPRTBufferPool hostPool = gprtHostBufferPoolCreate(context, 1 << 20);
+    GPRTBufferPool devicePool = gprtDeviceBufferPoolCreate(context, 1 << 20);
+    std::vector<GPRTBufferOf<uint32_t>> host(numBuffers);
+    std::vector<GPRTBufferOf<uint32_t>> device(numBuffers);
+    std::vector<uint32_t> init(elementsPerBuffer);
+    for (uint32_t i = 0; i < numBuffers; ++i) {
+      for (uint32_t j = 0; j < elementsPerBuffer; ++j)
+        init[j] = i * elementsPerBuffer + j;
+      host[i] = gprtBufferPoolAllocate<uint32_t>(hostPool, elementsPerBuffer, init.data());
+      device[i] = gprtBufferPoolAllocate<uint32_t>(devicePool, elementsPerBuffer);
+    }
+    // Larger than a block, so gets a dedicated one
+    GPRTBufferOf<uint32_t> large = gprtBufferPoolAllocate<uint32_t>(devicePool, 1 << 20);
+
+    // Act
+    for (uint32_t i = 0; i < numBuffers; ++i) {
+      // Host to device, reversing the order of the buffers
+      gprtBufferCopy(context, host[i], device[numBuffers - 1 - i], 0, 0, elementsPerBuffer);
+      // Device side initializers address pooled buffers through their device address
+      if (i % 2 == 0)
+        gprtBufferIota(context, host[i], 7u);
+    }
+    gprtBufferFill(context, large, 42u);
+
+    // Assert
+    for (uint32_t i = 0; i < numBuffers; ++i) {
+      gprtBufferMap(device[i]);
+      uint32_t *d = gprtBufferGetHostPointer(device[i]);
+      uint32_t *h = gprtBufferGetHostPointer(host[i]);
+      uint32_t source = numBuffers - 1 - i;
+      for (uint32_t j = 0; j < elementsPerBuffer; ++j) {
+        if (d[j] != source * elementsPerBuffer + j)
+          throw std::runtime_error("Error, incorrect copy into pooled buffer!");
+        uint32_t expected = (i % 2 == 0) ? 7 + j : i * elementsPerBuffer + j;
+        if (h[j] != expected)
+          throw std::runtime_error("Error, write to pooled buffer leaked into a neighbor!");
+      }
+      gprtBufferUnmap(device[i]);
+    }
+    {
+      gprtBufferMap(large);
+      uint32_t *ptr = gprtBufferGetHostPointer(large);
+      for (uint32_t i = 0; i < (1 << 20); ++i)
+        if (ptr[i] != 42)
+          throw std::runtime_error("Error, incorrect fill of dedicated pooled buffer!");
+      gprtBufferUnmap(large);
+    }
+
+    // Freed ranges are reused rather than growing the pool
+    GPRTBufferPoolStats before, after;
+    gprtBufferPoolGetStats(devicePool, &before);
+    gprtBufferDestroy(large);
+    for (uint32_t i = 0; i < numBuffers; i += 2) {
+      gprtBufferDestroy(device[i]);
+      device[i] = gprtBufferPoolAllocate<uint32_t>(devicePool, elementsPerBuffer);
+    }
+    gprtBufferPoolGetStats(devicePool, &after);
+    if (after.numBlocks != before.numBlocks - 1 || after.reservedBytes >= before.reservedBytes)
+      throw std::runtime_error("Error, pool did not release its dedicated block or reuse freed ranges!");
+
+    // Cleanup
+    for (uint32_t i = 0; i < numBuffers; ++i) {
+      gprtBufferDestroy(host[i]);
+      gprtBufferDestroy(device[i]);
+    }
+    gprtBufferPoolDestroy(hostPool);
+    gprtBufferPoolDestroy(devicePool);
+    gprtContextDestroy(context);
+  }
+}
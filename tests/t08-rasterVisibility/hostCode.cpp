@@ -0,0 +1,231 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+extern GPRTProgram t08_deviceCode;
+
+#ifndef M_PI
+#define M_PI 3.1415926f
+#endif
+
+// A unit UV sphere, dense enough that the full scene is several million triangles
+void
+makeSphere(uint32_t rings, uint32_t segments, std::vector<float3> &vertices, std::vector<uint3> &indices) {
+  for (uint32_t r = 0; r <= rings; ++r) {
+    float phi = M_PI * float(r) / float(rings);
+    for (uint32_t s = 0; s <= segments; ++s) {
+      float theta = 2.f * M_PI * float(s) / float(segments);
+      vertices.push_back(float3(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta)));
+    }
+  }
+  for (uint32_t r = 0; r < rings; ++r) {
+    for (uint32_t s = 0; s < segments; ++s) {
+      uint32_t a = r * (segments + 1) + s;
+      uint32_t b = a + segments + 1;
+      indices.push_back(uint3(a, b, a + 1));
+      indices.push_back(uint3(a + 1, b, b + 1));
+    }
+  }
+}
+
+int
+main(int ac, char **av) {
+  const uint32_t width = 1920;
+  const uint32_t height = 1080;
+  const uint32_t gridSize = 16;
+  const uint32_t numIterations = 20;
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t08_deviceCode);
+
+  GPRTGeomTypeOf<void> trianglesGeomType = gprtGeomTypeCreate<void>(context, GPRT_TRIANGLES);
+  gprtGeomTypeSetClosestHitProg(trianglesGeomType, 0, module, "TriangleMesh");
+  GPRTMissOf<void> miss = gprtMissCreate<void>(context, module, "miss");
+  GPRTRayGenOf<RayGenData> primaryRays = gprtRayGenCreate<RayGenData>(context, module, "PrimaryRays");
+  GPRTRayGenOf<RayGenData> shadowRays = gprtRayGenCreate<RayGenData>(context, module, "ShadowRays");
+
+  // Scene: a grid of sphere instances resting on a ground plane
+  std::vector<float3> sphereVertices;
+  std::vector<uint3> sphereIndices;
+  makeSphere(64, 128, sphereVertices, sphereIndices);
+  GPRTBufferOf<float3> sphereVertexBuffer =
+      gprtDeviceBufferCreate<float3>(context, sphereVertices.size(), sphereVertices.data());
+  GPRTBufferOf<uint3> sphereIndexBuffer =
+      gprtDeviceBufferCreate<uint3>(context, sphereIndices.size(), sphereIndices.data());
+  GPRTGeomOf<void> sphereGeom = gprtGeomCreate<void>(context, trianglesGeomType);
+  gprtTrianglesSetVertices(sphereGeom, sphereVertexBuffer, sphereVertices.size());
+  gprtTrianglesSetIndices(sphereGeom, sphereIndexBuffer, sphereIndices.size());
+  GPRTAccel sphereAccel = gprtTriangleAccelCreate(context, sphereGeom);
+  gprtAccelBuild(context, sphereAccel, GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+
+  float3 groundVertices[4] = {{-1.f, 0.f, -1.f}, {1.f, 0.f, -1.f}, {1.f, 0.f, 1.f}, {-1.f, 0.f, 1.f}};
+  uint3 groundIndices[2] = {{0, 1, 2}, {0, 2, 3}};
+  GPRTBufferOf<float3> groundVertexBuffer = gprtDeviceBufferCreate<float3>(context, 4, groundVertices);
+  GPRTBufferOf<uint3> groundIndexBuffer = gprtDeviceBufferCreate<uint3>(context, 2, groundIndices);
+  GPRTGeomOf<void> groundGeom = gprtGeomCreate<void>(context, trianglesGeomType);
+  gprtTrianglesSetVertices(groundGeom, groundVertexBuffer, 4);
+  gprtTrianglesSetIndices(groundGeom, groundIndexBuffer, 2);
+  GPRTAccel groundAccel = gprtTriangleAccelCreate(context, groundGeom);
+  gprtAccelBuild(context, groundAccel, GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+
+  std::vector<gprt::Instance> instances;
+  for (uint32_t z = 0; z < gridSize; ++z) {
+    for (uint32_t x = 0; x < gridSize; ++x) {
+      gprt::Instance instance = gprtAccelGetInstance(sphereAccel);
+      float scale = 0.6f + 0.4f * float((x * 7 + z * 13) % 5) / 4.f;
+      float tx = (float(x) - 0.5f * float(gridSize - 1)) * 2.5f;
+      float tz = (float(z) - 0.5f * float(gridSize - 1)) * 2.5f;
+      instance.transform = {scale, 0.f, 0.f, tx, 0.f, scale, 0.f, scale - 1.f, 0.f, 0.f, scale, tz};
+      instances.push_back(instance);
+    }
+  }
+  gprt::Instance ground = gprtAccelGetInstance(groundAccel);
+  float extent = 2.5f * gridSize;
+  ground.transform = {extent, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, -1.f, 0.f, 0.f, extent, 0.f};
+  instances.push_back(ground);
+
+  GPRTBufferOf<gprt::Instance> instanceBuffer =
+      gprtDeviceBufferCreate<gprt::Instance>(context, instances.size(), instances.data());
+  GPRTAccel world = gprtInstanceAccelCreate(context, instances.size(), instanceBuffer);
+  gprtAccelBuild(context, world, GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+
+  std::cout << "Scene: " << instances.size() << " instances, "
+            << uint64_t(gridSize) * gridSize * sphereIndices.size() + 2 << " triangles" << std::endl;
+
+  // One visibility and shadow buffer per method, so that the results can be compared afterwards
+  GPRTBufferOf<gprt::Visibility> tracedVisibility = gprtDeviceBufferCreate<gprt::Visibility>(context, width * height);
+  GPRTBufferOf<gprt::Visibility> rasterVisibility = gprtDeviceBufferCreate<gprt::Visibility>(context, width * height);
+  GPRTBufferOf<uint32_t> tracedShadows = gprtDeviceBufferCreate<uint32_t>(context, width * height);
+  GPRTBufferOf<uint32_t> rasterShadows = gprtDeviceBufferCreate<uint32_t>(context, width * height);
+
+  RayGenData *primaryData = gprtRayGenGetParameters(primaryRays);
+  primaryData->visibility = gprtBufferGetDevicePointer(tracedVisibility);
+  primaryData->world = gprtAccelGetDeviceAddress(world);
+
+  // The shadow pass is shared, reading from whichever visibility buffer it is pointed at
+  RayGenData *shadowData = gprtRayGenGetParameters(shadowRays);
+  shadowData->world = gprtAccelGetDeviceAddress(world);
+
+  gprtBuildShaderBindingTable(context);
+
+  float3 lookFrom = {0.f, 12.f, 30.f};
+  float3 lookAt = {0.f, 0.f, 0.f};
+  float3 lookUp = {0.f, 1.f, 0.f};
+  float4x4 view = math::matrixFromLookAt(lookFrom, lookAt, lookUp);
+  float4x4 projection = math::perspective(float(M_PI) / 4.f, float(width) / float(height), 0.1f, 1000.f);
+  float4x4 viewProjection = mul(projection, view);
+
+  PushConstants pc;
+  pc.inverseViewProjection = inverse(viewProjection);
+  pc.cameraPosition = lookFrom;
+  pc.lightDirection = normalize(float3(0.3f, 1.f, 0.5f));
+
+  auto pointShadowsAt = [&](GPRTBufferOf<gprt::Visibility> visibility, GPRTBufferOf<uint32_t> shadows) {
+    shadowData->visibility = gprtBufferGetDevicePointer(visibility);
+    shadowData->shadowed = gprtBufferGetDevicePointer(shadows);
+    gprtBuildShaderBindingTable(context, GPRT_SBT_RAYGEN);
+  };
+
+  // Warm up both paths, which also creates the rasterizer's pipeline and attachments
+  gprtRayGenLaunch2D(context, primaryRays, width, height, pc);
+  gprtAccelRasterizeVisibility(context, world, rasterVisibility, width, height, viewProjection, lookFrom);
+
+  // Act
+  float tracedPrimaryTime = 0.f, rasterPrimaryTime = 0.f, tracedShadowTime = 0.f, rasterShadowTime = 0.f;
+  for (uint32_t i = 0; i < numIterations; ++i) {
+    gprtBeginProfile(context);
+    gprtRayGenLaunch2D(context, primaryRays, width, height, pc);
+    tracedPrimaryTime += gprtEndProfile(context);
+
+    pointShadowsAt(tracedVisibility, tracedShadows);
+    gprtBeginProfile(context);
+    gprtRayGenLaunch2D(context, shadowRays, width, height, pc);
+    tracedShadowTime += gprtEndProfile(context);
+
+    gprtBeginProfile(context);
+    gprtAccelRasterizeVisibility(context, world, rasterVisibility, width, height, viewProjection, lookFrom);
+    rasterPrimaryTime += gprtEndProfile(context);
+
+    pointShadowsAt(rasterVisibility, rasterShadows);
+    gprtBeginProfile(context);
+    gprtRayGenLaunch2D(context, shadowRays, width, height, pc);
+    rasterShadowTime += gprtEndProfile(context);
+  }
+  tracedPrimaryTime /= numIterations;
+  tracedShadowTime /= numIterations;
+  rasterPrimaryTime /= numIterations;
+  rasterShadowTime /= numIterations;
+
+  std::cout << "Traced primary visibility: " << tracedPrimaryTime << " ms, + shadows: "
+            << tracedPrimaryTime + tracedShadowTime << " ms" << std::endl;
+  std::cout << "Rasterized primary visibility: " << rasterPrimaryTime << " ms, + shadows: "
+            << rasterPrimaryTime + rasterShadowTime << " ms" << std::endl;
+
+  // Assert
+  // Rasterization and ray traversal resolve pixels on shared triangle edges differently, and compute
+  // distances with different rounding, so a small fraction of pixels is allowed to disagree.
+  gprtBufferMap(tracedVisibility);
+  gprtBufferMap(rasterVisibility);
+  gprtBufferMap(tracedShadows);
+  gprtBufferMap(rasterShadows);
+  gprt::Visibility *traced = gprtBufferGetHostPointer(tracedVisibility);
+  gprt::Visibility *raster = gprtBufferGetHostPointer(rasterVisibility);
+  uint32_t *tracedShadowed = gprtBufferGetHostPointer(tracedShadows);
+  uint32_t *rasterShadowed = gprtBufferGetHostPointer(rasterShadows);
+  uint32_t numPixels = width * height, numHits = 0, visibilityMatches = 0, shadowMatches = 0;
+  for (uint32_t i = 0; i < numPixels; ++i) {
+    const gprt::Visibility &a = traced[i];
+    const gprt::Visibility &b = raster[i];
+    if (a.instanceIndex != GPRT_VISIBILITY_MISS)
+      numHits++;
+    bool match = a.instanceIndex == b.instanceIndex;
+    if (match && a.instanceIndex != GPRT_VISIBILITY_MISS) {
+      match = a.geometryIndex == b.geometryIndex && a.primitiveIndex == b.primitiveIndex &&
+              fabsf(a.t - b.t) <= 1e-3f * a.t + 1e-3f;
+    }
+    if (match)
+      visibilityMatches++;
+    if (tracedShadowed[i] == rasterShadowed[i])
+      shadowMatches++;
+  }
+  gprtBufferUnmap(tracedVisibility);
+  gprtBufferUnmap(rasterVisibility);
+  gprtBufferUnmap(tracedShadows);
+  gprtBufferUnmap(rasterShadows);
+
+  std::cout << "Pixels hit: " << numHits << " / " << numPixels << ", visibility agrees on " << visibilityMatches
+            << ", shadows agree on " << shadowMatches << std::endl;
+  if (numHits < numPixels / 2)
+    throw std::runtime_error("Error, camera does not see the scene!");
+  if (visibilityMatches < 0.99 * numPixels)
+    throw std::runtime_error("Error, rasterized visibility does not match traced visibility!");
+  if (shadowMatches < 0.99 * numPixels)
+    throw std::runtime_error("Error, shadows from rasterized visibility do not match traced shadows!");
+
+  gprtContextDestroy(context);
+}
@@ -0,0 +1,39 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "gprt.h"
+
+struct RayGenData {
+  // One entry per pixel, either traced here or rasterized by gprtAccelRasterizeVisibility
+  gprt::Visibility *visibility;
+  // One entry per pixel, non-zero where the visible surface is in shadow
+  uint32_t *shadowed;
+  SurfaceAccelerationStructure world;
+};
+
+/* Constants that change each frame */
+struct PushConstants {
+  // Clip to world space, used to generate the same primary rays the rasterizer sees
+  float4x4 inverseViewProjection;
+  float3 cameraPosition;
+  float3 lightDirection;
+};
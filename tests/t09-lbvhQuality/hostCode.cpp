@@ -0,0 +1,211 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+
+#include <gprt.h>
+#include "gprt_lbvh.h"
+#include "sharedCode.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+extern GPRTProgram t09_deviceCode;
+
+#ifndef M_PI
+#define M_PI 3.1415926f
+#endif
+
+// Mimics CAD assemblies: many small, densely tessellated parts (eg, fasteners) scattered between long, thin
+// panels and beams. Long triangles span many Morton cells, which is where Morton-ordered builds do worst.
+void
+makeClusteredScene(std::vector<float3> &vertices, std::vector<uint3> &indices) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+
+  const uint32_t numParts = 256, rings = 16, segments = 16;
+  for (uint32_t part = 0; part < numParts; ++part) {
+    float3 center = {uniform(rng), uniform(rng), uniform(rng)};
+    float radius = 0.01f + 0.02f * (uniform(rng) * 0.5f + 0.5f);
+    uint32_t base = uint32_t(vertices.size());
+    for (uint32_t r = 0; r <= rings; ++r) {
+      float phi = M_PI * float(r) / float(rings);
+      for (uint32_t s = 0; s <= segments; ++s) {
+        float theta = 2.f * M_PI * float(s) / float(segments);
+        vertices.push_back(center + radius * float3(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta)));
+      }
+    }
+    for (uint32_t r = 0; r < rings; ++r) {
+      for (uint32_t s = 0; s < segments; ++s) {
+        uint32_t a = base + r * (segments + 1) + s;
+        uint32_t b = a + segments + 1;
+        indices.push_back(uint3(a, b, a + 1));
+        indices.push_back(uint3(a + 1, b, b + 1));
+      }
+    }
+  }
+
+  const uint32_t numBeams = 4096;
+  for (uint32_t beam = 0; beam < numBeams; ++beam) {
+    float3 a = {uniform(rng), uniform(rng), uniform(rng)};
+    float3 b = {uniform(rng), uniform(rng), uniform(rng)};
+    float3 offset = 0.005f * float3(uniform(rng), uniform(rng), uniform(rng));
+    uint32_t base = uint32_t(vertices.size());
+    vertices.push_back(a);
+    vertices.push_back(b);
+    vertices.push_back(b + offset);
+    indices.push_back(uint3(base, base + 1, base + 2));
+  }
+}
+
+// Every primitive must be referenced by exactly one leaf, reachable from the root
+void
+validateTree(GPRTLBVH &lbvh) {
+  uint32_t numPrims = lbvh.handle.numPrims;
+  gprtBufferMap(lbvh.nodes);
+  int4 *nodes = gprtBufferGetHostPointer(lbvh.nodes);
+  std::vector<uint32_t> references(numPrims, 0);
+  std::vector<int> stack = {0};
+  uint32_t numVisited = 0;
+  while (!stack.empty()) {
+    int address = stack.back();
+    stack.pop_back();
+    if (++numVisited > lbvh.handle.numNodes)
+      throw std::runtime_error("Error, tree contains a cycle!");
+    int4 node = nodes[address];
+    if (node.w != -1) {
+      references[node.w]++;
+      continue;
+    }
+    if (nodes[node.x].z != address || nodes[node.y].z != address)
+      throw std::runtime_error("Error, child does not point back to its parent!");
+    stack.push_back(node.x);
+    stack.push_back(node.y);
+  }
+  gprtBufferUnmap(lbvh.nodes);
+  for (uint32_t i = 0; i < numPrims; ++i)
+    if (references[i] != 1)
+      throw std::runtime_error("Error, primitive is not referenced by exactly one leaf!");
+}
+
+int
+main(int ac, char **av) {
+  const uint32_t numRays = 1 << 20;
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t09_deviceCode);
+  GPRTComputeOf<TraversalParams> traceRays = gprtComputeCreate<TraversalParams>(context, module, "TraceRays");
+
+  std::vector<float3> vertices;
+  std::vector<uint3> indices;
+  makeClusteredScene(vertices, indices);
+  uint32_t numPrims = uint32_t(indices.size());
+  GPRTBufferOf<float3> vertexBuffer = gprtDeviceBufferCreate<float3>(context, vertices.size(), vertices.data());
+  GPRTBufferOf<uint3> indexBuffer = gprtDeviceBufferCreate<uint3>(context, indices.size(), indices.data());
+  GPRTBufferOf<float> hitDistances[2] = {gprtDeviceBufferCreate<float>(context, numRays),
+                                         gprtDeviceBufferCreate<float>(context, numRays)};
+  GPRTBufferOf<uint32_t> nodeVisits[2] = {gprtDeviceBufferCreate<uint32_t>(context, numRays),
+                                          gprtDeviceBufferCreate<uint32_t>(context, numRays)};
+  std::cout << "Scene: " << numPrims << " triangles" << std::endl;
+
+  const char *names[2] = {"fast", "high quality"};
+  GPRTLBVHBuildMode modes[2] = {GPRT_LBVH_BUILD_FAST, GPRT_LBVH_BUILD_HIGH_QUALITY};
+  GPRTLBVHStats stats[2];
+  float traceTimes[2];
+  double averageVisits[2];
+  for (uint32_t i = 0; i < 2; ++i) {
+    // Act
+    GPRTLBVH lbvh = gprtTriangleLBVHCreate(context, vertexBuffer, indexBuffer, numPrims);
+    // The first build also warms up pipelines and sort scratch memory, so time the second
+    gprtLBVHBuild(context, lbvh, modes[i]);
+    gprtLBVHBuild(context, lbvh, modes[i]);
+    gprtLBVHGetStats(lbvh, &stats[i]);
+    validateTree(lbvh);
+    // Each leaf references exactly one primitive, so the stats must agree with the tree
+    if (stats[i].averageLeafSize != 1.f)
+      throw std::runtime_error("Error, average leaf size is not one primitive per leaf!");
+
+    TraversalParams params;
+    params.nodes = gprtBufferGetDevicePointer(lbvh.nodes);
+    params.aabbs = gprtBufferGetDevicePointer(lbvh.aabbs);
+    params.positions = gprtBufferGetDevicePointer(vertexBuffer);
+    params.triangles = gprtBufferGetDevicePointer(indexBuffer);
+    params.hitDistances = gprtBufferGetDevicePointer(hitDistances[i]);
+    params.nodeVisits = gprtBufferGetDevicePointer(nodeVisits[i]);
+    params.numRays = numRays;
+    params.seed = 1234;
+    uint32_t numGroups = (numRays + TRAVERSAL_THREADGROUP_SIZE - 1) / TRAVERSAL_THREADGROUP_SIZE;
+    gprtComputeLaunch(traceRays, {numGroups, 1, 1}, {TRAVERSAL_THREADGROUP_SIZE, 1, 1}, params);
+    gprtBeginProfile(context);
+    gprtComputeLaunch(traceRays, {numGroups, 1, 1}, {TRAVERSAL_THREADGROUP_SIZE, 1, 1}, params);
+    traceTimes[i] = gprtEndProfile(context);
+
+    gprtBufferMap(nodeVisits[i]);
+    uint32_t *visits = gprtBufferGetHostPointer(nodeVisits[i]);
+    uint64_t totalVisits = 0;
+    for (uint32_t r = 0; r < numRays; ++r)
+      totalVisits += visits[r];
+    gprtBufferUnmap(nodeVisits[i]);
+    averageVisits[i] = double(totalVisits) / double(numRays);
+
+    std::cout << "LBVH (" << names[i] << "): build " << stats[i].buildTime << " ms, SAH cost " << stats[i].sahCost
+              << ", overlap " << stats[i].overlap << ", average leaf size " << stats[i].averageLeafSize
+              << ", average leaf depth " << stats[i].averageLeafDepth << ", max leaf depth " << stats[i].maxLeafDepth
+              << ", trace " << traceTimes[i] << " ms, " << averageVisits[i] << " nodes per ray" << std::endl;
+
+    gprtLBVHDestroy(lbvh);
+  }
+
+  // Assert
+  // Restructuring only ever accepts treelets that lower the SAH cost
+  if (stats[1].sahCost > stats[0].sahCost)
+    throw std::runtime_error("Error, high quality build has a higher SAH cost than the fast build!");
+
+  // Both trees contain the same triangles, so every ray must find the same closest hit
+  {
+    gprtBufferMap(hitDistances[0]);
+    gprtBufferMap(hitDistances[1]);
+    float *fast = gprtBufferGetHostPointer(hitDistances[0]);
+    float *optimized = gprtBufferGetHostPointer(hitDistances[1]);
+    uint32_t numHits = 0;
+    for (uint32_t r = 0; r < numRays; ++r) {
+      if (std::isinf(fast[r]) != std::isinf(optimized[r]) ||
+          (!std::isinf(fast[r]) && fabsf(fast[r] - optimized[r]) > 1e-5f * fast[r]))
+        throw std::runtime_error("Error, trees disagree on the closest hit!");
+      if (!std::isinf(fast[r]))
+        numHits++;
+    }
+    gprtBufferUnmap(hitDistances[0]);
+    gprtBufferUnmap(hitDistances[1]);
+    std::cout << numHits << " of " << numRays << " rays hit" << std::endl;
+  }
+
+  for (uint32_t i = 0; i < 2; ++i) {
+    gprtBufferDestroy(hitDistances[i]);
+    gprtBufferDestroy(nodeVisits[i]);
+  }
+  gprtBufferDestroy(vertexBuffer);
+  gprtBufferDestroy(indexBuffer);
+  gprtComputeDestroy(traceRays);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
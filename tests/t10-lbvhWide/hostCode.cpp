@@ -0,0 +1,199 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+
+#include <gprt.h>
+#include "gprt_lbvh.h"
+#include "sharedCode.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+extern GPRTProgram t10_deviceCode;
+
+#ifndef M_PI
+#define M_PI 3.1415926f
+#endif
+
+// Many small tessellated spheres, scattered throughout the unit cube
+void
+makeScene(std::vector<float3> &vertices, std::vector<uint3> &indices) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+
+  const uint32_t numSpheres = 1024, rings = 12, segments = 12;
+  for (uint32_t sphere = 0; sphere < numSpheres; ++sphere) {
+    float3 center = {uniform(rng), uniform(rng), uniform(rng)};
+    float radius = 0.01f + 0.03f * (uniform(rng) * 0.5f + 0.5f);
+    uint32_t base = uint32_t(vertices.size());
+    for (uint32_t r = 0; r <= rings; ++r) {
+      float phi = M_PI * float(r) / float(rings);
+      for (uint32_t s = 0; s <= segments; ++s) {
+        float theta = 2.f * M_PI * float(s) / float(segments);
+        vertices.push_back(center + radius * float3(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta)));
+      }
+    }
+    for (uint32_t r = 0; r < rings; ++r) {
+      for (uint32_t s = 0; s < segments; ++s) {
+        uint32_t a = base + r * (segments + 1) + s;
+        uint32_t b = a + segments + 1;
+        indices.push_back(uint3(a, b, a + 1));
+        indices.push_back(uint3(a + 1, b, b + 1));
+      }
+    }
+  }
+}
+
+// Every primitive must be referenced by exactly one wide leaf slot, reachable from the root
+void
+validateWideTree(GPRTLBVH &lbvh, uint32_t width) {
+  uint32_t numPrims = lbvh.handle.numPrims;
+  uint32_t nodeWords = LBVH_WIDE_NODE_WORDS(width);
+  gprtBufferMap(lbvh.wideNodes);
+  uint32_t *wideNodes = gprtBufferGetHostPointer(lbvh.wideNodes);
+  std::vector<uint32_t> references(numPrims, 0);
+  std::vector<uint32_t> stack = {0};
+  uint32_t numVisited = 0;
+  while (!stack.empty()) {
+    uint32_t *node = wideNodes + uint64_t(stack.back()) * nodeWords;
+    stack.pop_back();
+    if (++numVisited > lbvh.numWideNodes)
+      throw std::runtime_error("Error, wide tree contains a cycle!");
+    uint32_t numChildren = node[3] >> 24;
+    if (numChildren == 0 || numChildren > width)
+      throw std::runtime_error("Error, wide node has an invalid child count!");
+    for (uint32_t c = 0; c < numChildren; ++c) {
+      uint32_t child = node[4 + c];
+      if (child & LBVH_WIDE_LEAF_BIT)
+        references[child & ~LBVH_WIDE_LEAF_BIT]++;
+      else
+        stack.push_back(child);
+    }
+  }
+  gprtBufferUnmap(lbvh.wideNodes);
+  for (uint32_t i = 0; i < numPrims; ++i)
+    if (references[i] != 1)
+      throw std::runtime_error("Error, primitive is not referenced by exactly one wide leaf!");
+}
+
+int
+main(int ac, char **av) {
+  const uint32_t numRays = 1 << 20;
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t10_deviceCode);
+  GPRTComputeOf<TraversalParams> traceBinary = gprtComputeCreate<TraversalParams>(context, module, "TraceBinary");
+  GPRTComputeOf<TraversalParams> traceWide = gprtComputeCreate<TraversalParams>(context, module, "TraceWide");
+
+  std::vector<float3> vertices;
+  std::vector<uint3> indices;
+  makeScene(vertices, indices);
+  uint32_t numPrims = uint32_t(indices.size());
+  GPRTBufferOf<float3> vertexBuffer = gprtDeviceBufferCreate<float3>(context, vertices.size(), vertices.data());
+  GPRTBufferOf<uint3> indexBuffer = gprtDeviceBufferCreate<uint3>(context, indices.size(), indices.data());
+  std::cout << "Scene: " << numPrims << " triangles" << std::endl;
+
+  // Act
+  GPRTLBVH lbvh = gprtTriangleLBVHCreate(context, vertexBuffer, indexBuffer, numPrims);
+  gprtLBVHBuild(context, lbvh, GPRT_LBVH_BUILD_HIGH_QUALITY);
+
+  // Layout 0 is the binary tree, layouts 1 and 2 are the 4 and 8 wide collapses of it
+  const char *names[3] = {"binary", "4-wide", "8-wide"};
+  uint32_t widths[3] = {2, 4, 8};
+  GPRTBufferOf<float> hitDistances[3];
+  float traceTimes[3];
+  double averageVisits[3];
+  for (uint32_t i = 0; i < 3; ++i) {
+    hitDistances[i] = gprtDeviceBufferCreate<float>(context, numRays);
+    GPRTBufferOf<uint32_t> nodeVisits = gprtDeviceBufferCreate<uint32_t>(context, numRays);
+
+    TraversalParams params = {};
+    params.nodes = gprtBufferGetDevicePointer(lbvh.nodes);
+    params.aabbs = gprtBufferGetDevicePointer(lbvh.aabbs);
+    params.positions = gprtBufferGetDevicePointer(vertexBuffer);
+    params.triangles = gprtBufferGetDevicePointer(indexBuffer);
+    params.hitDistances = gprtBufferGetDevicePointer(hitDistances[i]);
+    params.nodeVisits = gprtBufferGetDevicePointer(nodeVisits);
+    params.numRays = numRays;
+    params.seed = 1234;
+    GPRTComputeOf<TraversalParams> trace = traceBinary;
+    if (widths[i] > 2) {
+      gprtLBVHCollapse(context, lbvh, widths[i]);
+      validateWideTree(lbvh, widths[i]);
+      params.wideNodes = gprtBufferGetDevicePointer(lbvh.wideNodes);
+      params.wideWidth = widths[i];
+      trace = traceWide;
+    }
+
+    // The first launch warms up the pipeline, so time the second
+    uint32_t numGroups = (numRays + TRAVERSAL_THREADGROUP_SIZE - 1) / TRAVERSAL_THREADGROUP_SIZE;
+    gprtComputeLaunch(trace, {numGroups, 1, 1}, {TRAVERSAL_THREADGROUP_SIZE, 1, 1}, params);
+    gprtBeginProfile(context);
+    gprtComputeLaunch(trace, {numGroups, 1, 1}, {TRAVERSAL_THREADGROUP_SIZE, 1, 1}, params);
+    traceTimes[i] = gprtEndProfile(context);
+
+    gprtBufferMap(nodeVisits);
+    uint32_t *visits = gprtBufferGetHostPointer(nodeVisits);
+    uint64_t totalVisits = 0;
+    for (uint32_t r = 0; r < numRays; ++r)
+      totalVisits += visits[r];
+    gprtBufferUnmap(nodeVisits);
+    gprtBufferDestroy(nodeVisits);
+    averageVisits[i] = double(totalVisits) / double(numRays);
+
+    uint32_t numNodes = (widths[i] > 2) ? lbvh.numWideNodes : lbvh.handle.numInner;
+    std::cout << names[i] << ": " << numNodes << " inner nodes, " << averageVisits[i] << " nodes per ray, "
+              << traceTimes[i] << " ms, " << (double(numRays) / (traceTimes[i] * 1e3)) << " Mrays/s" << std::endl;
+  }
+
+  // Assert
+  // Quantized bounds are conservative, so every layout must find the same closest hit
+  gprtBufferMap(hitDistances[0]);
+  float *reference = gprtBufferGetHostPointer(hitDistances[0]);
+  for (uint32_t i = 1; i < 3; ++i) {
+    gprtBufferMap(hitDistances[i]);
+    float *wide = gprtBufferGetHostPointer(hitDistances[i]);
+    for (uint32_t r = 0; r < numRays; ++r) {
+      if (std::isinf(reference[r]) != std::isinf(wide[r]) ||
+          (!std::isinf(reference[r]) && fabsf(reference[r] - wide[r]) > 1e-5f * reference[r]))
+        throw std::runtime_error(std::string("Error, ") + names[i] + " traversal disagrees on the closest hit!");
+    }
+    gprtBufferUnmap(hitDistances[i]);
+  }
+  gprtBufferUnmap(hitDistances[0]);
+
+  // Wider nodes trade more box tests per node for fewer nodes per ray
+  if (averageVisits[2] > averageVisits[1] || averageVisits[1] > averageVisits[0])
+    throw std::runtime_error("Error, wider nodes visited more nodes per ray!");
+
+  for (uint32_t i = 0; i < 3; ++i)
+    gprtBufferDestroy(hitDistances[i]);
+  gprtLBVHDestroy(lbvh);
+  gprtBufferDestroy(vertexBuffer);
+  gprtBufferDestroy(indexBuffer);
+  gprtComputeDestroy(traceBinary);
+  gprtComputeDestroy(traceWide);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
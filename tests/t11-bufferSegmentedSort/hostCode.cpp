@@ -0,0 +1,168 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Builds segment offsets from a generator of segment sizes, until about numKeys keys are covered
+std::vector<uint32_t>
+makeSegments(uint32_t numKeys, std::function<uint32_t(std::mt19937 &)> segmentSize) {
+  std::mt19937 rng(7);
+  std::vector<uint32_t> offsets = {0};
+  while (offsets.back() < numKeys)
+    offsets.push_back(std::min(numKeys, offsets.back() + segmentSize(rng)));
+  return offsets;
+}
+
+int
+main(int ac, char **av) {
+  const uint32_t numKeys = 1 << 22;
+
+  struct Distribution {
+    const char *name;
+    std::function<uint32_t(std::mt19937 &)> segmentSize;
+  };
+  std::vector<Distribution> distributions = {
+      // eg, hits within each ray's list
+      {"tiny (1-16)", [](std::mt19937 &rng) { return std::uniform_int_distribution<uint32_t>(1, 16)(rng); }},
+      // eg, rays within each screen tile
+      {"tiles (64-1024)", [](std::mt19937 &rng) { return std::uniform_int_distribution<uint32_t>(64, 1024)(rng); }},
+      // eg, particles within each mesh cell, where a few cells hold most particles
+      {"power law",
+       [](std::mt19937 &rng) {
+         float u = std::uniform_real_distribution<float>(0.f, 1.f)(rng);
+         return uint32_t(4.f / std::pow(std::max(u, 1e-4f), 1.5f));
+       }},
+      {"few large (64K)", [](std::mt19937 &rng) { return uint32_t(1 << 16); }},
+  };
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTBufferOf<uint64_t> keys = gprtDeviceBufferCreate<uint64_t>(context, numKeys);
+  GPRTBufferOf<uint64_t> values = gprtDeviceBufferCreate<uint64_t>(context, numKeys);
+  GPRTBufferOf<uint8_t> scratch = gprtDeviceBufferCreate<uint8_t>(context);
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<uint32_t> uniformKey(0, 1 << 16);
+  std::vector<uint64_t> inputKeys(numKeys);
+  for (uint32_t i = 0; i < numKeys; ++i)
+    inputKeys[i] = uniformKey(rng);
+
+  for (auto &distribution : distributions) {
+    // Arrange
+    std::vector<uint32_t> offsets = makeSegments(numKeys, distribution.segmentSize);
+    uint32_t numSegments = uint32_t(offsets.size() - 1);
+    GPRTBufferOf<uint32_t> segmentOffsets = gprtDeviceBufferCreate<uint32_t>(context, offsets.size(), offsets.data());
+
+    // Values record each key's original position, so that stability can be checked
+    auto upload = [&](bool encodeSegments) {
+      gprtBufferMap(keys);
+      gprtBufferMap(values);
+      uint64_t *k = gprtBufferGetHostPointer(keys);
+      uint64_t *v = gprtBufferGetHostPointer(values);
+      for (uint32_t s = 0; s < numSegments; ++s) {
+        for (uint32_t i = offsets[s]; i < offsets[s + 1]; ++i) {
+          k[i] = encodeSegments ? ((uint64_t(s) << 32) | inputKeys[i]) : inputKeys[i];
+          v[i] = i;
+        }
+      }
+      gprtBufferUnmap(keys);
+      gprtBufferUnmap(values);
+    };
+
+    // Act
+    // The first sort warms up pipelines and scratch memory, so time the second
+    upload(false);
+    gprtBufferSegmentedSortPayload(context, keys, values, segmentOffsets, numSegments, scratch);
+    upload(false);
+    auto start = std::chrono::high_resolution_clock::now();
+    gprtBufferSegmentedSortPayload(context, keys, values, segmentOffsets, numSegments, scratch);
+    auto stop = std::chrono::high_resolution_clock::now();
+    float segmentedTime = std::chrono::duration<float, std::milli>(stop - start).count();
+
+    // Assert
+    {
+      gprtBufferMap(keys);
+      gprtBufferMap(values);
+      uint64_t *k = gprtBufferGetHostPointer(keys);
+      uint64_t *v = gprtBufferGetHostPointer(values);
+      std::vector<uint32_t> expected;
+      for (uint32_t s = 0; s < numSegments; ++s) {
+        expected.resize(offsets[s + 1] - offsets[s]);
+        for (uint32_t i = 0; i < expected.size(); ++i)
+          expected[i] = offsets[s] + i;
+        std::stable_sort(expected.begin(), expected.end(),
+                         [&](uint32_t a, uint32_t b) { return inputKeys[a] < inputKeys[b]; });
+        for (uint32_t i = 0; i < expected.size(); ++i) {
+          uint32_t index = offsets[s] + i;
+          if (k[index] != inputKeys[expected[i]])
+            throw std::runtime_error("Error, segment is not sorted!");
+          if (v[index] != expected[i])
+            throw std::runtime_error("Error, segment sort moved a value outside its segment or is not stable!");
+        }
+      }
+      gprtBufferUnmap(keys);
+      gprtBufferUnmap(values);
+    }
+
+    // Without a payload, only the keys move
+    upload(false);
+    gprtBufferSegmentedSort(context, keys, segmentOffsets, numSegments, scratch);
+    {
+      gprtBufferMap(keys);
+      uint64_t *k = gprtBufferGetHostPointer(keys);
+      std::vector<uint64_t> expected;
+      for (uint32_t s = 0; s < numSegments; ++s) {
+        expected.assign(inputKeys.begin() + offsets[s], inputKeys.begin() + offsets[s + 1]);
+        std::sort(expected.begin(), expected.end());
+        for (uint32_t i = 0; i < expected.size(); ++i)
+          if (k[offsets[s] + i] != expected[i])
+            throw std::runtime_error("Error, keys only segment is not sorted!");
+      }
+      gprtBufferUnmap(keys);
+    }
+
+    // Reference, a single global sort with segment IDs encoded into the high key bits
+    upload(true);
+    start = std::chrono::high_resolution_clock::now();
+    gprtBufferSortPayload(context, keys, values, scratch);
+    stop = std::chrono::high_resolution_clock::now();
+    float encodedTime = std::chrono::duration<float, std::milli>(stop - start).count();
+
+    std::cout << "Segmented sort, " << distribution.name << ": " << numSegments << " segments, segmented "
+              << segmentedTime << " ms, encoded global sort " << encodedTime << " ms" << std::endl;
+
+    gprtBufferDestroy(segmentOffsets);
+  }
+
+  // Cleanup
+  gprtBufferDestroy(keys);
+  gprtBufferDestroy(values);
+  gprtBufferDestroy(scratch);
+  gprtContextDestroy(context);
+}
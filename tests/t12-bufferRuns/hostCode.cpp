@@ -0,0 +1,184 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+extern GPRTProgram t12_deviceCode;
+
+int
+main(int ac, char **av) {
+  const uint32_t numKeys = 1 << 22;
+
+  // Arrange
+  // Sorted keys, as they would come out of gprtBufferSortPayload, with runs of random length
+  std::mt19937 rng(3);
+  std::bernoulli_distribution newRun(0.2);
+  std::uniform_int_distribution<uint32_t> uniformCount(0, 100);
+  std::uniform_real_distribution<float> uniformWeight(0.f, 1.f);
+  std::vector<uint64_t> keysHost(numKeys);
+  std::vector<uint32_t> countsHost(numKeys);
+  std::vector<float> weightsHost(numKeys);
+  uint64_t key = 0;
+  for (uint32_t i = 0; i < numKeys; ++i) {
+    key += newRun(rng) ? 1 : 0;
+    keysHost[i] = key * 7919;
+    countsHost[i] = uniformCount(rng);
+    weightsHost[i] = uniformWeight(rng);
+  }
+
+  // Reference
+  std::vector<uint64_t> runKeysHost;
+  std::vector<uint32_t> runLengthsHost, runCountsHost;
+  std::vector<float> runWeightsHost;
+  for (uint32_t i = 0; i < numKeys; ++i) {
+    if (i == 0 || keysHost[i] != keysHost[i - 1]) {
+      runKeysHost.push_back(keysHost[i]);
+      runLengthsHost.push_back(0);
+      runCountsHost.push_back(0);
+      runWeightsHost.push_back(0.f);
+    }
+    runLengthsHost.back()++;
+    runCountsHost.back() += countsHost[i];
+    runWeightsHost.back() += weightsHost[i];
+  }
+  uint32_t numRunsHost = uint32_t(runKeysHost.size());
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t12_deviceCode);
+  GPRTComputeOf<AverageParams> runAverages = gprtComputeCreate<AverageParams>(context, module, "RunAverages");
+
+  GPRTBufferOf<uint64_t> keys = gprtDeviceBufferCreate<uint64_t>(context, numKeys, keysHost.data());
+  GPRTBufferOf<uint32_t> counts = gprtDeviceBufferCreate<uint32_t>(context, numKeys, countsHost.data());
+  GPRTBufferOf<float> weights = gprtDeviceBufferCreate<float>(context, numKeys, weightsHost.data());
+  GPRTBufferOf<uint64_t> uniqueKeys = gprtDeviceBufferCreate<uint64_t>(context, numKeys);
+  GPRTBufferOf<uint64_t> runKeys = gprtDeviceBufferCreate<uint64_t>(context, numKeys);
+  GPRTBufferOf<uint32_t> runLengths = gprtDeviceBufferCreate<uint32_t>(context, numKeys);
+  GPRTBufferOf<uint32_t> runCounts = gprtDeviceBufferCreate<uint32_t>(context, numKeys);
+  GPRTBufferOf<float> runWeights = gprtDeviceBufferCreate<float>(context, numKeys);
+  GPRTBufferOf<float> averages = gprtDeviceBufferCreate<float>(context, numKeys);
+  GPRTBufferOf<uint32_t> numUnique = gprtDeviceBufferCreate<uint32_t>(context, 1);
+  GPRTBufferOf<uint32_t> numRuns[3] = {gprtDeviceBufferCreate<uint32_t>(context, 1),
+                                       gprtDeviceBufferCreate<uint32_t>(context, 1),
+                                       gprtDeviceBufferCreate<uint32_t>(context, 1)};
+  GPRTBuffer scratch = gprtDeviceBufferCreate(context, 1, 1);
+
+  // Act
+  // The first call warms up pipelines and scratch memory, so time the second
+  gprtBufferUnique(context, keys, uniqueKeys, numUnique, 0, scratch);
+  auto start = std::chrono::high_resolution_clock::now();
+  gprtBufferUnique(context, keys, uniqueKeys, numUnique, 0, scratch);
+  auto stop = std::chrono::high_resolution_clock::now();
+  float uniqueTime = std::chrono::duration<float, std::milli>(stop - start).count();
+
+  start = std::chrono::high_resolution_clock::now();
+  gprtBufferRunLengthEncode(context, keys, runKeys, runLengths, numRuns[0], 0, scratch);
+  stop = std::chrono::high_resolution_clock::now();
+  float encodeTime = std::chrono::duration<float, std::milli>(stop - start).count();
+
+  start = std::chrono::high_resolution_clock::now();
+  gprtBufferReduceByKey(context, keys, counts, (GPRTBufferOf<uint64_t>) nullptr, runCounts, numRuns[1], 0, scratch);
+  stop = std::chrono::high_resolution_clock::now();
+  float reduceTime = std::chrono::duration<float, std::milli>(stop - start).count();
+
+  gprtBufferReduceByKey(context, keys, weights, (GPRTBufferOf<uint64_t>) nullptr, runWeights, numRuns[2], 0, scratch);
+
+  // Chain straight into a launch, without reading the number of runs back
+  AverageParams params;
+  params.runSums = gprtBufferGetDevicePointer(runWeights);
+  params.runLengths = gprtBufferGetDevicePointer(runLengths);
+  params.numRuns = gprtBufferGetDevicePointer(numRuns[2]);
+  params.runAverages = gprtBufferGetDevicePointer(averages);
+  uint32_t numGroups = (numKeys + AVERAGE_THREADGROUP_SIZE - 1) / AVERAGE_THREADGROUP_SIZE;
+  gprtComputeLaunch(runAverages, {numGroups, 1, 1}, {AVERAGE_THREADGROUP_SIZE, 1, 1}, params);
+
+  std::cout << numKeys << " keys, " << numRunsHost << " runs: unique " << uniqueTime << " ms, run length encode "
+            << encodeTime << " ms, reduce by key " << reduceTime << " ms" << std::endl;
+
+  // Assert
+  auto readCount = [](GPRTBufferOf<uint32_t> buffer) {
+    gprtBufferMap(buffer);
+    uint32_t count = gprtBufferGetHostPointer(buffer)[0];
+    gprtBufferUnmap(buffer);
+    return count;
+  };
+  if (readCount(numUnique) != numRunsHost)
+    throw std::runtime_error("Error, incorrect number of unique keys!");
+  for (uint32_t i = 0; i < 3; ++i)
+    if (readCount(numRuns[i]) != numRunsHost)
+      throw std::runtime_error("Error, incorrect number of runs!");
+
+  gprtBufferMap(uniqueKeys);
+  gprtBufferMap(runKeys);
+  gprtBufferMap(runLengths);
+  gprtBufferMap(runCounts);
+  gprtBufferMap(runWeights);
+  gprtBufferMap(averages);
+  uint64_t *u = gprtBufferGetHostPointer(uniqueKeys);
+  uint64_t *k = gprtBufferGetHostPointer(runKeys);
+  uint32_t *l = gprtBufferGetHostPointer(runLengths);
+  uint32_t *c = gprtBufferGetHostPointer(runCounts);
+  float *w = gprtBufferGetHostPointer(runWeights);
+  float *a = gprtBufferGetHostPointer(averages);
+  for (uint32_t r = 0; r < numRunsHost; ++r) {
+    if (u[r] != runKeysHost[r] || k[r] != runKeysHost[r])
+      throw std::runtime_error("Error, incorrect run key!");
+    if (l[r] != runLengthsHost[r])
+      throw std::runtime_error("Error, incorrect run length!");
+    if (c[r] != runCountsHost[r])
+      throw std::runtime_error("Error, incorrect integer run sum!");
+    if (fabsf(w[r] - runWeightsHost[r]) > 1e-5f * runWeightsHost[r])
+      throw std::runtime_error("Error, incorrect float run sum!");
+    if (fabsf(a[r] - runWeightsHost[r] / float(runLengthsHost[r])) > 1e-6f)
+      throw std::runtime_error("Error, incorrect run average!");
+  }
+  gprtBufferUnmap(uniqueKeys);
+  gprtBufferUnmap(runKeys);
+  gprtBufferUnmap(runLengths);
+  gprtBufferUnmap(runCounts);
+  gprtBufferUnmap(runWeights);
+  gprtBufferUnmap(averages);
+
+  // Cleanup
+  for (uint32_t i = 0; i < 3; ++i)
+    gprtBufferDestroy(numRuns[i]);
+  gprtBufferDestroy(numUnique);
+  gprtBufferDestroy(averages);
+  gprtBufferDestroy(runWeights);
+  gprtBufferDestroy(runCounts);
+  gprtBufferDestroy(runLengths);
+  gprtBufferDestroy(runKeys);
+  gprtBufferDestroy(uniqueKeys);
+  gprtBufferDestroy(weights);
+  gprtBufferDestroy(counts);
+  gprtBufferDestroy(keys);
+  gprtBufferDestroy(scratch);
+  gprtComputeDestroy(runAverages);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
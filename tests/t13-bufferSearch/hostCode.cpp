@@ -0,0 +1,117 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Mimics a continuous energy cross section grid in log space: a smooth background, plus dense clusters of points
+// around resonances
+std::vector<float>
+makeEnergyGrid(uint32_t count, std::mt19937 &rng) {
+  const float logMin = std::log(1e-5f), logMax = std::log(2e7f);
+  std::uniform_real_distribution<float> uniform(logMin, logMax);
+  std::vector<float> resonances(64);
+  for (float &r : resonances)
+    r = uniform(rng);
+  std::uniform_int_distribution<size_t> pick(0, resonances.size() - 1);
+  std::normal_distribution<float> width(0.f, 0.01f);
+
+  std::vector<float> grid(count);
+  for (uint32_t i = 0; i < count; ++i)
+    grid[i] = (i % 2 == 0) ? uniform(rng) : std::clamp(resonances[pick(rng)] + width(rng), logMin, logMax);
+  std::sort(grid.begin(), grid.end());
+  return grid;
+}
+
+int
+main(int ac, char **av) {
+  const uint32_t numQueries = 1 << 22;
+  std::mt19937 rng(11);
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTBufferOf<float> queries = gprtDeviceBufferCreate<float>(context, numQueries);
+  GPRTBufferOf<uint32_t> results[2] = {gprtDeviceBufferCreate<uint32_t>(context, numQueries),
+                                       gprtDeviceBufferCreate<uint32_t>(context, numQueries)};
+
+  for (uint32_t count : {100000u, 1000000u, 10000000u}) {
+    // Arrange
+    std::vector<float> grid = makeEnergyGrid(count, rng);
+    // Queries cover the whole grid, and a little beyond both ends
+    std::uniform_real_distribution<float> uniform(grid.front() - 1.f, grid.back() + 1.f);
+    std::vector<float> queriesHost(numQueries);
+    for (float &q : queriesHost)
+      q = uniform(rng);
+    // a few queries land exactly on grid points
+    for (uint32_t i = 0; i < numQueries; i += 97)
+      queriesHost[i] = grid[i % count];
+
+    GPRTBufferOf<float> table = gprtDeviceBufferCreate<float>(context, count, grid.data());
+    uint32_t numBuckets = count / 2;
+    GPRTBufferOf<uint32_t> index = gprtDeviceBufferCreate<uint32_t>(context, numBuckets + 3);
+    gprtBufferMap(queries);
+    std::copy(queriesHost.begin(), queriesHost.end(), gprtBufferGetHostPointer(queries));
+    gprtBufferUnmap(queries);
+
+    // Act
+    gprtBufferBuildSearchIndex(context, table, index);
+
+    // The first launch warms up the pipeline, so time the second
+    float times[2];
+    for (uint32_t accelerated = 0; accelerated < 2; ++accelerated) {
+      GPRTBufferOf<uint32_t> searchIndex = accelerated ? index : nullptr;
+      gprtBufferLowerBound(context, table, queries, results[accelerated], searchIndex);
+      gprtBeginProfile(context);
+      gprtBufferLowerBound(context, table, queries, results[accelerated], searchIndex);
+      times[accelerated] = gprtEndProfile(context);
+    }
+    std::cout << "Lower bound over " << count << " entries: plain " << numQueries / (times[0] * 1e3f)
+              << " M lookups/s, bucket index (" << numBuckets << " buckets) " << numQueries / (times[1] * 1e3f)
+              << " M lookups/s" << std::endl;
+
+    // Assert
+    for (uint32_t accelerated = 0; accelerated < 2; ++accelerated) {
+      gprtBufferMap(results[accelerated]);
+      uint32_t *ptr = gprtBufferGetHostPointer(results[accelerated]);
+      for (uint32_t i = 0; i < numQueries; ++i) {
+        uint32_t expected = uint32_t(std::lower_bound(grid.begin(), grid.end(), queriesHost[i]) - grid.begin());
+        if (ptr[i] != expected)
+          throw std::runtime_error(accelerated ? "Error, indexed lower bound disagrees with std::lower_bound!"
+                                               : "Error, lower bound disagrees with std::lower_bound!");
+      }
+      gprtBufferUnmap(results[accelerated]);
+    }
+
+    gprtBufferDestroy(index);
+    gprtBufferDestroy(table);
+  }
+
+  // Cleanup
+  gprtBufferDestroy(results[0]);
+  gprtBufferDestroy(results[1]);
+  gprtBufferDestroy(queries);
+  gprtContextDestroy(context);
+}
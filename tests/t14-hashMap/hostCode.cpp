@@ -0,0 +1,164 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+extern GPRTProgram t14_deviceCode;
+
+int
+main(int ac, char **av) {
+  // A 256^3 tally mesh, of which particles only ever reach about 1%
+  const uint32_t numBins = 256 * 256 * 256;
+  const uint32_t numActiveBins = numBins / 100;
+  const uint32_t numScores = 1 << 23;
+
+  // Arrange
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<uint32_t> uniformBin(0, numBins - 1);
+  std::uniform_real_distribution<float> uniformWeight(0.f, 1.f);
+  std::vector<uint32_t> activeBins(numActiveBins);
+  for (uint32_t &bin : activeBins)
+    bin = uniformBin(rng);
+  // Skew the scores towards a few hot bins, like the cells around a source
+  std::geometric_distribution<uint32_t> hotBin(4.0 / numActiveBins);
+  std::vector<uint32_t> binsHost(numScores);
+  std::vector<float> weightsHost(numScores);
+  std::map<uint32_t, double> reference;
+  for (uint32_t i = 0; i < numScores; ++i) {
+    binsHost[i] = activeBins[std::min<uint32_t>(hotBin(rng), numActiveBins - 1)];
+    weightsHost[i] = uniformWeight(rng);
+    reference[binsHost[i]] += weightsHost[i];
+  }
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t14_deviceCode);
+  GPRTComputeOf<ScoreParams> scoreDense = gprtComputeCreate<ScoreParams>(context, module, "ScoreDense");
+  GPRTComputeOf<ScoreParams> scoreSparse = gprtComputeCreate<ScoreParams>(context, module, "ScoreSparse");
+
+  GPRTBufferOf<uint32_t> bins = gprtDeviceBufferCreate<uint32_t>(context, numScores, binsHost.data());
+  GPRTBufferOf<float> weights = gprtDeviceBufferCreate<float>(context, numScores, weightsHost.data());
+  GPRTBufferOf<float> dense = gprtDeviceBufferCreate<float>(context, numBins);
+  // Room for every active bin at a load factor below a half, in 1/16th of the dense tally's memory
+  GPRTHashMap sparse = gprtHashMapCreate(context, 2 * numActiveBins);
+
+  ScoreParams params = {};
+  params.bins = gprtBufferGetDevicePointer(bins);
+  params.weights = gprtBufferGetDevicePointer(weights);
+  params.dense = (uint32_t *) gprtBufferGetDevicePointer(dense);
+  params.sparse = gprtHashMapGetHandle(sparse);
+  params.numScores = numScores;
+  uint32_t numGroups = std::min<uint32_t>((numScores + SCORE_THREADGROUP_SIZE - 1) / SCORE_THREADGROUP_SIZE, 65535);
+  params.stride = numGroups * SCORE_THREADGROUP_SIZE;
+
+  // Act
+  // Each tally is cleared and scored twice, timing the second round once pipelines are warm
+  float scoreTimes[2], clearTimes[2];
+  for (uint32_t round = 0; round < 2; ++round) {
+    auto start = std::chrono::high_resolution_clock::now();
+    gprtBufferClear(dense);
+    auto stop = std::chrono::high_resolution_clock::now();
+    clearTimes[0] = std::chrono::duration<float, std::milli>(stop - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    gprtHashMapClear(context, sparse);
+    stop = std::chrono::high_resolution_clock::now();
+    clearTimes[1] = std::chrono::duration<float, std::milli>(stop - start).count();
+
+    gprtBeginProfile(context);
+    gprtComputeLaunch(scoreDense, {numGroups, 1, 1}, {SCORE_THREADGROUP_SIZE, 1, 1}, params);
+    scoreTimes[0] = gprtEndProfile(context);
+
+    gprtBeginProfile(context);
+    gprtComputeLaunch(scoreSparse, {numGroups, 1, 1}, {SCORE_THREADGROUP_SIZE, 1, 1}, params);
+    scoreTimes[1] = gprtEndProfile(context);
+  }
+
+  GPRTHashMapStats stats;
+  gprtHashMapGetStats(sparse, &stats);
+  std::cout << numScores << " scores into " << reference.size() << " of " << numBins << " bins" << std::endl;
+  std::cout << "Dense tally: score " << numScores / (scoreTimes[0] * 1e3f) << " Mscores/s, clear " << clearTimes[0]
+            << " ms" << std::endl;
+  std::cout << "Sparse tally: score " << numScores / (scoreTimes[1] * 1e3f) << " Mscores/s, clear " << clearTimes[1]
+            << " ms, load factor " << stats.loadFactor << ", longest probe " << stats.maxProbeLength << std::endl;
+
+  GPRTBufferOf<uint32_t> keys = gprtDeviceBufferCreate<uint32_t>(context, stats.size);
+  GPRTBufferOf<float> values = gprtDeviceBufferCreate<float>(context, stats.size);
+  uint32_t count = gprtHashMapExtract(context, sparse, keys, values);
+  // Keys alone, eg to find which bins were hit
+  GPRTBufferOf<uint32_t> keysOnly = gprtDeviceBufferCreate<uint32_t>(context, stats.size);
+  uint32_t keysOnlyCount = gprtHashMapExtract(context, sparse, (GPRTBuffer) keysOnly, nullptr);
+
+  // Assert
+  if (stats.failedInsertions != 0)
+    throw std::runtime_error("Error, sparse tally overflowed!");
+  if (stats.size != reference.size() || count != reference.size() || keysOnlyCount != reference.size())
+    throw std::runtime_error("Error, incorrect number of sparse tally bins!");
+
+  gprtBufferMap(keys);
+  gprtBufferMap(keysOnly);
+  gprtBufferMap(values);
+  gprtBufferMap(dense);
+  uint32_t *k = gprtBufferGetHostPointer(keys);
+  uint32_t *ko = gprtBufferGetHostPointer(keysOnly);
+  float *v = gprtBufferGetHostPointer(values);
+  float *d = gprtBufferGetHostPointer(dense);
+  uint32_t i = 0;
+  for (auto &entry : reference) {
+    // Scoring order differs between runs, so sums only agree to within rounding
+    float tolerance = 1e-4f * float(entry.second);
+    if (k[i] != entry.first)
+      throw std::runtime_error("Error, sparse tally bins are incorrect or unsorted!");
+    if (ko[i] != entry.first)
+      throw std::runtime_error("Error, keys extracted alone are incorrect or unsorted!");
+    if (fabsf(v[i] - float(entry.second)) > tolerance)
+      throw std::runtime_error("Error, incorrect sparse tally!");
+    if (fabsf(d[entry.first] - float(entry.second)) > tolerance)
+      throw std::runtime_error("Error, incorrect dense tally!");
+    ++i;
+  }
+  gprtBufferUnmap(dense);
+  gprtBufferUnmap(values);
+  gprtBufferUnmap(keysOnly);
+  gprtBufferUnmap(keys);
+
+  // Cleanup
+  gprtBufferDestroy(values);
+  gprtBufferDestroy(keysOnly);
+  gprtBufferDestroy(keys);
+  gprtHashMapDestroy(sparse);
+  gprtBufferDestroy(dense);
+  gprtBufferDestroy(weights);
+  gprtBufferDestroy(bins);
+  gprtComputeDestroy(scoreSparse);
+  gprtComputeDestroy(scoreDense);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
@@ -0,0 +1,199 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+extern GPRTProgram t15_deviceCode;
+
+int
+main(int ac, char **av) {
+  const uint32_t gridSize = 128;
+  const uint32_t width = 1024;
+  const uint32_t height = 1024;
+  const uint32_t numIterations = 10;
+
+  // Arrange
+  // A few soft blobs, quantized to a handful of levels so that neighboring voxels often share a value
+  const float3 centers[3] = {{0.35f, 0.4f, 0.5f}, {0.65f, 0.55f, 0.45f}, {0.5f, 0.7f, 0.7f}};
+  uint3 dims = {gridSize, gridSize, gridSize};
+  std::vector<float> valuesHost(gridSize * gridSize * gridSize);
+  std::vector<float3> boxesHost;
+  std::vector<uint32_t> boxVoxelsHost;
+  float spacing = 1.f / gridSize;
+  for (uint32_t k = 0; k < gridSize; ++k) {
+    for (uint32_t j = 0; j < gridSize; ++j) {
+      for (uint32_t i = 0; i < gridSize; ++i) {
+        float3 p = float3(i + 0.5f, j + 0.5f, k + 0.5f) * spacing;
+        float density = 0.f;
+        for (const float3 &c : centers) {
+          float3 d = p - c;
+          density += expf(-dot(d, d) / 0.02f);
+        }
+        uint32_t index = i + gridSize * (j + gridSize * k);
+        valuesHost[index] = (density > 0.3f) ? floorf(density * 8.f) / 8.f : 0.f;
+        if (valuesHost[index] != 0.f) {
+          boxesHost.push_back(float3(i, j, k) * spacing);
+          boxesHost.push_back(float3(i + 1, j + 1, k + 1) * spacing);
+          boxVoxelsHost.push_back(index);
+        }
+      }
+    }
+  }
+  uint32_t numBoxes = uint32_t(boxVoxelsHost.size());
+
+  gprtRequestMaxAttributeSize(sizeof(gprt::VoxelAttributes));
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t15_deviceCode);
+
+  GPRTGeomTypeOf<VoxelBoxData> boxType = gprtGeomTypeCreate<VoxelBoxData>(context, GPRT_AABBS);
+  gprtGeomTypeSetIntersectionProg(boxType, 0, module, "VoxelBox");
+  gprtGeomTypeSetAnyHitProg(boxType, 0, module, "BoxDepth");
+  GPRTGeomTypeOf<VoxelGridData> gridType = gprtGeomTypeCreate<VoxelGridData>(context, GPRT_VOXELS);
+  gprtGeomTypeSetAnyHitProg(gridType, 0, module, "GridDepth");
+  GPRTMissOf<void> miss = gprtMissCreate<void>(context, module, "miss");
+  GPRTRayGenOf<RayGenData> rayGen = gprtRayGenCreate<RayGenData>(context, module, "Integrate");
+
+  GPRTBufferOf<float> values = gprtDeviceBufferCreate<float>(context, valuesHost.size(), valuesHost.data());
+  GPRTBufferOf<float3> boxes = gprtDeviceBufferCreate<float3>(context, boxesHost.size(), boxesHost.data());
+  GPRTBufferOf<uint32_t> boxVoxels = gprtDeviceBufferCreate<uint32_t>(context, numBoxes, boxVoxelsHost.data());
+
+  // One AABB per voxel
+  GPRTGeomOf<VoxelBoxData> boxGeom = gprtGeomCreate(context, boxType);
+  gprtAABBsSetPositions(boxGeom, boxes, numBoxes, 2 * sizeof(float3));
+  VoxelBoxData *boxData = gprtGeomGetParameters(boxGeom);
+  boxData->aabbs = gprtBufferGetDevicePointer(boxes);
+  boxData->voxels = gprtBufferGetDevicePointer(boxVoxels);
+  boxData->values = gprtBufferGetDevicePointer(values);
+  GPRTAccel boxAccel = gprtAABBAccelCreate(context, boxGeom);
+  gprtAccelBuild(context, boxAccel, GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+
+  // One AABB per brick, reporting each voxel, and then each run of equal voxels
+  GPRTAccel gridAccels[2];
+  GPRTGeomOf<VoxelGridData> gridGeoms[2];
+  const unsigned int gridFlags[2] = {GPRT_VOXEL_REPORT_EACH_VOXEL | GPRT_VOXEL_SKIP_EMPTY,
+                                     GPRT_VOXEL_REPORT_VALUE_CHANGES | GPRT_VOXEL_SKIP_EMPTY};
+  for (uint32_t i = 0; i < 2; ++i) {
+    gridGeoms[i] = gprtGeomCreate(context, gridType);
+    gprtVoxelsSetValues(gridGeoms[i], values, dims);
+    gprtVoxelsSetBounds(gridGeoms[i], float3(0.f, 0.f, 0.f), float3(spacing, spacing, spacing));
+    gprtGeomGetParameters(gridGeoms[i])->values = gprtBufferGetDevicePointer(values);
+    gridAccels[i] = gprtVoxelAccelCreate(context, gridGeoms[i], gridFlags[i]);
+    gprtAccelBuild(context, gridAccels[i], GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+  }
+
+  GPRTAccel blases[3] = {boxAccel, gridAccels[0], gridAccels[1]};
+  GPRTBufferOf<gprt::Instance> instances[3];
+  GPRTAccel worlds[3];
+  GPRTBufferOf<float2> results[3];
+  for (uint32_t i = 0; i < 3; ++i) {
+    gprt::Instance instance = gprtAccelGetInstance(blases[i]);
+    instances[i] = gprtDeviceBufferCreate<gprt::Instance>(context, 1, &instance);
+    worlds[i] = gprtInstanceAccelCreate(context, 1, instances[i]);
+    gprtAccelBuild(context, worlds[i], GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+    results[i] = gprtDeviceBufferCreate<float2>(context, width * height);
+  }
+
+  RayGenData *rayGenData = gprtRayGenGetParameters(rayGen);
+  rayGenData->eye = float3(1.6f, 1.2f, 2.1f);
+  rayGenData->target = float3(0.5f, 0.5f, 0.5f);
+  gprtBuildShaderBindingTable(context);
+
+  // Act
+  const char *names[3] = {"AABB per voxel", "Voxel bricks", "Voxel bricks, runs"};
+  float times[3];
+  for (uint32_t i = 0; i < 3; ++i) {
+    rayGenData->world = gprtAccelGetDeviceAddress(worlds[i]);
+    rayGenData->results = gprtBufferGetDevicePointer(results[i]);
+    gprtBuildShaderBindingTable(context, GPRT_SBT_RAYGEN);
+
+    gprtRayGenLaunch2D(context, rayGen, width, height);
+    times[i] = 0.f;
+    for (uint32_t iteration = 0; iteration < numIterations; ++iteration) {
+      gprtBeginProfile(context);
+      gprtRayGenLaunch2D(context, rayGen, width, height);
+      times[i] += gprtEndProfile(context) / numIterations;
+    }
+  }
+
+  std::cout << gridSize << "^3 grid, " << numBoxes << " non-empty voxels" << std::endl;
+  for (uint32_t i = 0; i < 3; ++i) {
+    size_t bytes = gprtAccelGetSize(blases[i]);
+    std::cout << names[i] << ": BLAS " << bytes / (1024.f * 1024.f) << " MB (" << float(bytes) / numBoxes
+              << " bytes per voxel), " << (width * height) / (times[i] * 1e3f) << " Mrays/s" << std::endl;
+  }
+
+  // Assert
+  for (uint32_t i = 0; i < 3; ++i)
+    gprtBufferMap(results[i]);
+  float2 *box = gprtBufferGetHostPointer(results[0]);
+  float2 *grid = gprtBufferGetHostPointer(results[1]);
+  float2 *runs = gprtBufferGetHostPointer(results[2]);
+  uint32_t numRays = width * height, countMismatches = 0;
+  uint64_t totalVoxels = 0, totalRuns = 0;
+  for (uint32_t r = 0; r < numRays; ++r) {
+    float tolerance = 1e-3f * box[r].x + 1e-5f;
+    if (fabsf(grid[r].x - box[r].x) > tolerance || fabsf(runs[r].x - box[r].x) > tolerance)
+      throw std::runtime_error("Error, optical depths differ between methods!");
+    // Rays grazing voxel edges may clip a voxel to zero length in one method and not the other
+    if (grid[r].y != box[r].y)
+      countMismatches++;
+    if (runs[r].y > grid[r].y)
+      throw std::runtime_error("Error, value runs reported more hits than voxels!");
+    totalVoxels += uint64_t(grid[r].y);
+    totalRuns += uint64_t(runs[r].y);
+  }
+  for (uint32_t i = 0; i < 3; ++i)
+    gprtBufferUnmap(results[i]);
+  std::cout << "Voxels per ray: " << float(totalVoxels) / numRays << ", runs per ray: "
+            << float(totalRuns) / numRays << std::endl;
+  if (countMismatches > numRays / 1000)
+    throw std::runtime_error("Error, too many rays visited a different number of voxels!");
+  if (gprtAccelGetSize(gridAccels[0]) >= gprtAccelGetSize(boxAccel))
+    throw std::runtime_error("Error, brick tree is not smaller than the per voxel tree!");
+
+  // Cleanup
+  for (uint32_t i = 0; i < 3; ++i) {
+    gprtBufferDestroy(results[i]);
+    gprtAccelDestroy(worlds[i]);
+    gprtBufferDestroy(instances[i]);
+  }
+  for (uint32_t i = 0; i < 2; ++i) {
+    gprtAccelDestroy(gridAccels[i]);
+    gprtGeomDestroy(gridGeoms[i]);
+  }
+  gprtAccelDestroy(boxAccel);
+  gprtGeomDestroy(boxGeom);
+  gprtBufferDestroy(boxVoxels);
+  gprtBufferDestroy(boxes);
+  gprtBufferDestroy(values);
+  gprtRayGenDestroy(rayGen);
+  gprtMissDestroy(miss);
+  gprtGeomTypeDestroy(gridType);
+  gprtGeomTypeDestroy(boxType);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
@@ -0,0 +1,48 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "gprt.h"
+
+// Every method reports gprt::VoxelAttributes, so that the same any hit program integrates all of them
+struct Payload {
+  float opticalDepth;
+  uint32_t numVoxels;
+};
+
+// One AABB per non-empty voxel, intersected by a user program
+struct VoxelBoxData {
+  float3 *aabbs;
+  uint32_t *voxels;   // index of the voxel each AABB came from
+  float *values;
+};
+
+// A single GPRT_VOXELS geometry, intersected by the built-in DDA
+struct VoxelGridData {
+  float *values;
+};
+
+struct RayGenData {
+  SurfaceAccelerationStructure world;
+  float2 *results;   // optical depth and number of reported hits, per ray
+  float3 eye;
+  float3 target;
+};
@@ -0,0 +1,228 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+extern GPRTProgram t16_deviceCode;
+
+// The value carried by each vertex. Linear, so that both hexahedra and tetrahedra interpolate it exactly.
+static float
+field(float3 p) {
+  return p.x + 2.f * p.y + 3.f * p.z;
+}
+
+int
+main(int ac, char **av) {
+  const uint32_t gridSize = 48;
+  const uint32_t numRays = 1 << 18;
+  const uint32_t numIterations = 10;
+  const float step = 0.25f / gridSize;   // distance between marched samples, a few per cell
+
+  // Arrange
+  // A unit cube of gridSize^3 hexahedra sharing their vertices, and the same cube split into six tetrahedra per
+  // hexahedron around each hexahedron's 0-6 diagonal, which keeps the faces of neighboring tetrahedra conforming
+  auto vertexIndex = [&](uint32_t i, uint32_t j, uint32_t k) { return i + (gridSize + 1) * (j + (gridSize + 1) * k); };
+  std::vector<float4> verticesHost;
+  for (uint32_t k = 0; k <= gridSize; ++k) {
+    for (uint32_t j = 0; j <= gridSize; ++j) {
+      for (uint32_t i = 0; i <= gridSize; ++i) {
+        float3 p = float3(i, j, k) / float(gridSize);
+        verticesHost.push_back(float4(p.x, p.y, p.z, field(p)));
+      }
+    }
+  }
+  const uint32_t tetCorners[6][4] = {{0, 1, 2, 6}, {0, 2, 3, 6}, {0, 3, 7, 6},
+                                     {0, 7, 4, 6}, {0, 4, 5, 6}, {0, 5, 1, 6}};
+  std::vector<uint32_t> hexIndicesHost, tetIndicesHost;
+  for (uint32_t k = 0; k < gridSize; ++k) {
+    for (uint32_t j = 0; j < gridSize; ++j) {
+      for (uint32_t i = 0; i < gridSize; ++i) {
+        uint32_t corners[8] = {vertexIndex(i, j, k),         vertexIndex(i + 1, j, k),
+                               vertexIndex(i + 1, j + 1, k), vertexIndex(i, j + 1, k),
+                               vertexIndex(i, j, k + 1),     vertexIndex(i + 1, j, k + 1),
+                               vertexIndex(i + 1, j + 1, k + 1), vertexIndex(i, j + 1, k + 1)};
+        hexIndicesHost.insert(hexIndicesHost.end(), corners, corners + 8);
+        for (const auto &tet : tetCorners) {
+          for (uint32_t c = 0; c < 8; ++c)
+            tetIndicesHost.push_back(c < 4 ? corners[tet[c]] : 0);
+        }
+      }
+    }
+  }
+  uint32_t numHexes = uint32_t(hexIndicesHost.size() / 8);
+  uint32_t numTets = uint32_t(tetIndicesHost.size() / 8);
+
+  // Rays start anywhere inside the cube and head off in any direction
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  std::vector<float3> originsHost(numRays), directionsHost(numRays);
+  for (uint32_t r = 0; r < numRays; ++r) {
+    originsHost[r] = float3(0.02f + 0.96f * uniform(rng), 0.02f + 0.96f * uniform(rng), 0.02f + 0.96f * uniform(rng));
+    float z = 2.f * uniform(rng) - 1.f;
+    float phi = 6.2831853f * uniform(rng);
+    float s = sqrtf(1.f - z * z);
+    directionsHost[r] = float3(s * cosf(phi), s * sinf(phi), z);
+  }
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t16_deviceCode);
+
+  GPRTGeomTypeOf<SolidData> solidType = gprtGeomTypeCreate<SolidData>(context, GPRT_SOLIDS);
+  gprtGeomTypeSetClosestHitProg(solidType, 0, module, "Locate");
+  GPRTMissOf<void> miss = gprtMissCreate<void>(context, module, "miss");
+  GPRTRayGenOf<RayGenData> walkRayGen = gprtRayGenCreate<RayGenData>(context, module, "Walk");
+  GPRTRayGenOf<RayGenData> marchRayGen = gprtRayGenCreate<RayGenData>(context, module, "March");
+
+  GPRTBufferOf<float4> vertices = gprtDeviceBufferCreate<float4>(context, verticesHost.size(), verticesHost.data());
+  GPRTBufferOf<uint32_t> indices[2] = {
+      gprtDeviceBufferCreate<uint32_t>(context, hexIndicesHost.size(), hexIndicesHost.data()),
+      gprtDeviceBufferCreate<uint32_t>(context, tetIndicesHost.size(), tetIndicesHost.data())};
+  const uint8_t cellTypes[2] = {GPRT_HEXAHEDRON, GPRT_TETRAHEDRON};
+  const uint32_t numCells[2] = {numHexes, numTets};
+  GPRTBufferOf<uint8_t> types[2];
+  GPRTGeomOf<SolidData> geoms[2];
+  GPRTAccel blases[2];
+  GPRTBufferOf<gprt::Instance> instances[2];
+  GPRTAccel worlds[2];
+  for (uint32_t m = 0; m < 2; ++m) {
+    // every cell shares one type
+    types[m] = gprtDeviceBufferCreate<uint8_t>(context, 1, &cellTypes[m]);
+    geoms[m] = gprtGeomCreate(context, solidType);
+    gprtSolidsSetVertices(geoms[m], vertices, uint32_t(verticesHost.size()));
+    gprtSolidsSetIndices(geoms[m], indices[m], numCells[m], 8 * sizeof(uint32_t));
+    gprtSolidsSetTypes(geoms[m], types[m], numCells[m], 0);
+    gprtSolidsBuildAdjacency(context, geoms[m]);
+    blases[m] = gprtSolidAccelCreate(context, geoms[m]);
+    gprtAccelBuild(context, blases[m], GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+    gprt::Instance instance = gprtAccelGetInstance(blases[m]);
+    instances[m] = gprtDeviceBufferCreate<gprt::Instance>(context, 1, &instance);
+    worlds[m] = gprtInstanceAccelCreate(context, 1, instances[m]);
+    gprtAccelBuild(context, worlds[m], GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+  }
+
+  GPRTBufferOf<float3> origins = gprtDeviceBufferCreate<float3>(context, numRays, originsHost.data());
+  GPRTBufferOf<float3> directions = gprtDeviceBufferCreate<float3>(context, numRays, directionsHost.data());
+  GPRTBufferOf<float2> walkResults = gprtDeviceBufferCreate<float2>(context, numRays);
+  GPRTBufferOf<float2> marchResults = gprtDeviceBufferCreate<float2>(context, numRays);
+
+  // The integral of a linear field along the ray, up to where the ray leaves the cube
+  std::vector<float> expected(numRays);
+  for (uint32_t r = 0; r < numRays; ++r) {
+    float3 o = originsHost[r], d = directionsHost[r];
+    float tExit = 1e20f;
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+      if (d[axis] > 0.f)
+        tExit = std::min(tExit, (1.f - o[axis]) / d[axis]);
+      if (d[axis] < 0.f)
+        tExit = std::min(tExit, -o[axis] / d[axis]);
+    }
+    expected[r] = 0.5f * (field(o) + field(o + tExit * d)) * tExit;
+  }
+
+  // Act
+  const char *names[2] = {"hexahedra", "tetrahedra"};
+  for (uint32_t m = 0; m < 2; ++m) {
+    GPRTRayGenOf<RayGenData> rayGens[2] = {walkRayGen, marchRayGen};
+    GPRTBufferOf<float2> results[2] = {walkResults, marchResults};
+    float times[2];
+    for (uint32_t method = 0; method < 2; ++method) {
+      RayGenData *rayGenData = gprtRayGenGetParameters(rayGens[method]);
+      rayGenData->world = gprtAccelGetDeviceAddress(worlds[m]);
+      rayGenData->mesh = gprtSolidsGetMesh(geoms[m]);
+      rayGenData->origins = gprtBufferGetDevicePointer(origins);
+      rayGenData->directions = gprtBufferGetDevicePointer(directions);
+      rayGenData->results = gprtBufferGetDevicePointer(results[method]);
+      rayGenData->step = step;
+      gprtBuildShaderBindingTable(context);
+
+      gprtRayGenLaunch1D(context, rayGens[method], numRays);
+      times[method] = 0.f;
+      for (uint32_t iteration = 0; iteration < numIterations; ++iteration) {
+        gprtBeginProfile(context);
+        gprtRayGenLaunch1D(context, rayGens[method], numRays);
+        times[method] += gprtEndProfile(context) / numIterations;
+      }
+    }
+
+    // Assert
+    gprtBufferMap(walkResults);
+    gprtBufferMap(marchResults);
+    float2 *walk = gprtBufferGetHostPointer(walkResults);
+    float2 *march = gprtBufferGetHostPointer(marchResults);
+    uint64_t walkedCells = 0, marchedCells = 0, lostRays = 0;
+    for (uint32_t r = 0; r < numRays; ++r) {
+      if (walk[r].y == 0.f) {
+        lostRays++;   // the starting point was not found, eg on a shared face missed by both cells
+        continue;
+      }
+      if (fabsf(walk[r].x - expected[r]) > 1e-3f * fabsf(expected[r]) + 1e-4f)
+        throw std::runtime_error(std::string("Error, walking the ") + names[m] + " gave the wrong integral!");
+      // the midpoint rule is exact for a linear field, except over the partial sample at the boundary, where the
+      // field is at most 6
+      if (fabsf(march[r].x - expected[r]) > 6.f * step + 1e-3f * fabsf(expected[r]))
+        throw std::runtime_error(std::string("Error, marching the ") + names[m] + " gave the wrong integral!");
+      walkedCells += uint64_t(walk[r].y);
+      marchedCells += uint64_t(march[r].y);
+    }
+    gprtBufferUnmap(walkResults);
+    gprtBufferUnmap(marchResults);
+    if (lostRays > numRays / 1000)
+      throw std::runtime_error(std::string("Error, too many rays failed to locate a starting cell among the ") +
+                               names[m] + "!");
+    if (marchedCells > walkedCells)
+      throw std::runtime_error(std::string("Error, marching visited cells that walking missed in the ") + names[m] +
+                               "!");
+
+    std::cout << numCells[m] << " " << names[m] << ", " << float(walkedCells) / numRays << " cells per ray" << std::endl;
+    std::cout << "  TracePoint every " << step * gridSize << " cells: " << walkedCells / (times[1] * 1e6f) << " Mcells/s"
+              << std::endl;
+    std::cout << "  Adjacency walk: " << walkedCells / (times[0] * 1e6f) << " Mcells/s" << std::endl;
+  }
+
+  // Cleanup
+  gprtBufferDestroy(marchResults);
+  gprtBufferDestroy(walkResults);
+  gprtBufferDestroy(directions);
+  gprtBufferDestroy(origins);
+  for (uint32_t m = 0; m < 2; ++m) {
+    gprtAccelDestroy(worlds[m]);
+    gprtBufferDestroy(instances[m]);
+    gprtAccelDestroy(blases[m]);
+    gprtGeomDestroy(geoms[m]);
+    gprtBufferDestroy(types[m]);
+    gprtBufferDestroy(indices[m]);
+  }
+  gprtBufferDestroy(vertices);
+  gprtRayGenDestroy(marchRayGen);
+  gprtRayGenDestroy(walkRayGen);
+  gprtMissDestroy(miss);
+  gprtGeomTypeDestroy(solidType);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
@@ -0,0 +1,197 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+extern GPRTProgram t17_deviceCode;
+
+int
+main(int ac, char **av) {
+  const uint32_t gridSize = 48;
+  const uint32_t width = 512;
+  const uint32_t height = 512;
+  const uint32_t numSamples = 256;
+  const uint32_t numBins = 64;
+  const uint32_t numIterations = 10;
+
+  // Arrange
+  // A unit cube of hexahedra over a few narrow blobs, so that only a small fraction of cells reach the threshold
+  const float3 centers[3] = {{0.3f, 0.35f, 0.4f}, {0.7f, 0.6f, 0.5f}, {0.45f, 0.7f, 0.7f}};
+  auto vertexIndex = [&](uint32_t i, uint32_t j, uint32_t k) { return i + (gridSize + 1) * (j + (gridSize + 1) * k); };
+  std::vector<float4> verticesHost;
+  for (uint32_t k = 0; k <= gridSize; ++k) {
+    for (uint32_t j = 0; j <= gridSize; ++j) {
+      for (uint32_t i = 0; i <= gridSize; ++i) {
+        float3 p = float3(i, j, k) / float(gridSize);
+        float value = 0.f;
+        for (const float3 &c : centers) {
+          float3 d = p - c;
+          value += expf(-dot(d, d) / 0.005f);
+        }
+        verticesHost.push_back(float4(p.x, p.y, p.z, std::min(value, 1.f)));
+      }
+    }
+  }
+  std::vector<uint32_t> indicesHost;
+  for (uint32_t k = 0; k < gridSize; ++k) {
+    for (uint32_t j = 0; j < gridSize; ++j) {
+      for (uint32_t i = 0; i < gridSize; ++i) {
+        uint32_t corners[8] = {vertexIndex(i, j, k),         vertexIndex(i + 1, j, k),
+                               vertexIndex(i + 1, j + 1, k), vertexIndex(i, j + 1, k),
+                               vertexIndex(i, j, k + 1),     vertexIndex(i + 1, j, k + 1),
+                               vertexIndex(i + 1, j + 1, k + 1), vertexIndex(i, j + 1, k + 1)};
+        indicesHost.insert(indicesHost.end(), corners, corners + 8);
+      }
+    }
+  }
+  uint32_t numCells = gridSize * gridSize * gridSize;
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t17_deviceCode);
+
+  GPRTGeomTypeOf<SolidData> solidType = gprtGeomTypeCreate<SolidData>(context, GPRT_SOLIDS);
+  gprtGeomTypeSetClosestHitProg(solidType, 0, module, "Sample");
+  GPRTMissOf<void> miss = gprtMissCreate<void>(context, module, "miss");
+  GPRTRayGenOf<RayGenData> rayGen = gprtRayGenCreate<RayGenData>(context, module, "March");
+
+  const uint8_t hexahedron = GPRT_HEXAHEDRON;
+  GPRTBufferOf<float4> vertices = gprtDeviceBufferCreate<float4>(context, verticesHost.size(), verticesHost.data());
+  GPRTBufferOf<uint32_t> indices = gprtDeviceBufferCreate<uint32_t>(context, indicesHost.size(), indicesHost.data());
+  GPRTBufferOf<uint8_t> types = gprtDeviceBufferCreate<uint8_t>(context, 1, &hexahedron);
+
+  // The filter is read at every launch, so a host buffer lets us change it without rebuilding the SBT
+  GPRTBufferOf<uint32_t> stats = gprtDeviceBufferCreate<uint32_t>(context, 2);
+  GPRTBufferOf<gprt::SolidValueFilter> filter = gprtHostBufferCreate<gprt::SolidValueFilter>(context, 1);
+  gprt::SolidValueFilter *filterHost = gprtBufferGetHostPointer(filter);
+  filterHost->stats = gprtBufferGetDevicePointer(stats);
+
+  GPRTGeomOf<SolidData> geom = gprtGeomCreate(context, solidType);
+  gprtSolidsSetVertices(geom, vertices, uint32_t(verticesHost.size()));
+  gprtSolidsSetIndices(geom, indices, numCells, 8 * sizeof(uint32_t));
+  gprtSolidsSetTypes(geom, types, numCells, 0);
+  gprtSolidsSetValueFilter(geom, filter);
+  GPRTAccel blas = gprtSolidAccelCreate(context, geom);
+  gprtAccelBuild(context, blas, GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+  gprt::Instance instance = gprtAccelGetInstance(blas);
+  GPRTBufferOf<gprt::Instance> instances = gprtDeviceBufferCreate<gprt::Instance>(context, 1, &instance);
+  GPRTAccel world = gprtInstanceAccelCreate(context, 1, instances);
+  gprtAccelBuild(context, world, GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+
+  GPRTBufferOf<float> results[3];
+  for (uint32_t i = 0; i < 3; ++i)
+    results[i] = gprtDeviceBufferCreate<float>(context, width * height);
+
+  RayGenData *rayGenData = gprtRayGenGetParameters(rayGen);
+  rayGenData->world = gprtAccelGetDeviceAddress(world);
+  rayGenData->numSamples = numSamples;
+  gprtBuildShaderBindingTable(context);
+
+  // Transfer function opacities sampled at the top of each bin, so that a bin is occupied if any of its values
+  // are visible
+  std::vector<float> binOpacity(numBins);
+  for (uint32_t i = 0; i < numBins; ++i)
+    binOpacity[i] = opacity(float(i + 1) / numBins);
+
+  // Act
+  // Every cell passes, then only cells reaching the threshold, then only cells covering a visible bin
+  const char *names[3] = {"No filter", "Value range", "Occupancy bins"};
+  float times[3];
+  uint32_t tested[3], rejected[3];
+  for (uint32_t method = 0; method < 3; ++method) {
+    filterHost->range = float2(-FLT_MAX, FLT_MAX);
+    gprtSolidValueFilterSetOccupancy(filterHost, 0, nullptr, float2(0.f, 1.f));
+    if (method == 1)
+      filterHost->range = float2(OPACITY_THRESHOLD, FLT_MAX);
+    if (method == 2)
+      gprtSolidValueFilterSetOccupancy(filterHost, numBins, binOpacity.data(), float2(0.f, 1.f));
+
+    rayGenData->results = gprtBufferGetDevicePointer(results[method]);
+    gprtBuildShaderBindingTable(context, GPRT_SBT_RAYGEN);
+
+    // Count cell tests over a single launch
+    gprtBufferClear(stats);
+    gprtRayGenLaunch2D(context, rayGen, width, height);
+    gprtBufferMap(stats);
+    tested[method] = gprtBufferGetHostPointer(stats)[0];
+    rejected[method] = gprtBufferGetHostPointer(stats)[1];
+    gprtBufferUnmap(stats);
+
+    times[method] = 0.f;
+    for (uint32_t iteration = 0; iteration < numIterations; ++iteration) {
+      gprtBeginProfile(context);
+      gprtRayGenLaunch2D(context, rayGen, width, height);
+      times[method] += gprtEndProfile(context) / numIterations;
+    }
+  }
+
+  uint64_t numQueries = uint64_t(width) * height * numSamples;
+  std::cout << numCells << " hexahedra, " << numQueries << " point queries" << std::endl;
+  for (uint32_t method = 0; method < 3; ++method) {
+    std::cout << names[method] << ": " << tested[method] << " cells tested, " << tested[method] - rejected[method]
+              << " inverted, " << numQueries / (times[method] * 1e6f) << " Mqueries/s" << std::endl;
+  }
+
+  // Assert
+  // Rejected cells are fully transparent, so filtering must not change the image
+  for (uint32_t i = 0; i < 3; ++i)
+    gprtBufferMap(results[i]);
+  float *reference = gprtBufferGetHostPointer(results[0]);
+  for (uint32_t method = 1; method < 3; ++method) {
+    float *filtered = gprtBufferGetHostPointer(results[method]);
+    for (uint32_t r = 0; r < width * height; ++r) {
+      if (fabsf(filtered[r] - reference[r]) > 1e-4f)
+        throw std::runtime_error(std::string("Error, ") + names[method] + " filtering changed the result!");
+    }
+  }
+  for (uint32_t i = 0; i < 3; ++i)
+    gprtBufferUnmap(results[i]);
+  if (rejected[0] != 0)
+    throw std::runtime_error("Error, a filter passing every value rejected cells!");
+  for (uint32_t method = 1; method < 3; ++method) {
+    if (tested[method] - rejected[method] >= tested[0] - rejected[0])
+      throw std::runtime_error(std::string("Error, ") + names[method] + " filtering did not reduce inversions!");
+  }
+
+  // Cleanup
+  for (uint32_t i = 0; i < 3; ++i)
+    gprtBufferDestroy(results[i]);
+  gprtAccelDestroy(world);
+  gprtBufferDestroy(instances);
+  gprtAccelDestroy(blas);
+  gprtGeomDestroy(geom);
+  gprtBufferDestroy(filter);
+  gprtBufferDestroy(stats);
+  gprtBufferDestroy(types);
+  gprtBufferDestroy(indices);
+  gprtBufferDestroy(vertices);
+  gprtRayGenDestroy(rayGen);
+  gprtMissDestroy(miss);
+  gprtGeomTypeDestroy(solidType);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
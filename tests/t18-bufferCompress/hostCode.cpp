@@ -0,0 +1,122 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+int
+main(int ac, char **av) {
+  const uint32_t numWords = 1 << 25;
+  const uint32_t numIterations = 5;
+
+  // Arrange
+  // Realistic tally data: a float flux tally that particles only reach near a few sources, integer hit counts
+  // over a detector, and dense noise as the incompressible worst case
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  std::vector<std::vector<uint32_t>> datasets(3, std::vector<uint32_t>(numWords, 0));
+  const char *names[3] = {"Sparse flux tally", "Hit counts", "Dense noise"};
+  for (uint32_t i = 0; i < numWords; ++i) {
+    float x = float(i % 1024) / 1024.f, y = float(i / 1024 % 1024) / 1024.f, z = float(i / (1024 * 1024)) / 32.f;
+    float r2 = (x - 0.3f) * (x - 0.3f) + (y - 0.6f) * (y - 0.6f) + (z - 0.5f) * (z - 0.5f);
+    if (r2 < 0.01f && uniform(rng) < 0.5f) {
+      float flux = expf(-r2 / 0.002f) * uniform(rng);
+      memcpy(&datasets[0][i], &flux, sizeof(float));
+    }
+    if (uniform(rng) < 0.3f)
+      datasets[1][i] = 1 + uint32_t(-logf(1.f - uniform(rng)) * 20.f);
+    float noise = uniform(rng);
+    memcpy(&datasets[2][i], &noise, sizeof(float));
+  }
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTBufferOf<uint32_t> buffer = gprtDeviceBufferCreate<uint32_t>(context, numWords);
+  std::vector<uint32_t> output(numWords);
+  double bytes = double(numWords) * sizeof(uint32_t);
+
+  for (uint32_t d = 0; d < 3; ++d) {
+    gprtBufferMap(buffer);
+    memcpy(gprtBufferGetHostPointer(buffer), datasets[d].data(), numWords * sizeof(uint32_t));
+    gprtBufferUnmap(buffer);
+
+    // Act
+    // The baseline maps the whole buffer and copies it out
+    double mapTime = 0.0, compressedTime = 0.0;
+    size_t compressedSize = 0;
+    for (uint32_t iteration = 0; iteration < numIterations; ++iteration) {
+      auto start = std::chrono::high_resolution_clock::now();
+      gprtBufferMap(buffer);
+      memcpy(output.data(), gprtBufferGetHostPointer(buffer), numWords * sizeof(uint32_t));
+      gprtBufferUnmap(buffer);
+      auto end = std::chrono::high_resolution_clock::now();
+      mapTime += std::chrono::duration<double>(end - start).count() / numIterations;
+
+      std::fill(output.begin(), output.end(), 0xDEADBEEF);
+      start = std::chrono::high_resolution_clock::now();
+      compressedSize = gprtBufferReadCompressed(context, buffer, output.data());
+      end = std::chrono::high_resolution_clock::now();
+      compressedTime += std::chrono::duration<double>(end - start).count() / numIterations;
+
+      // Assert
+      if (memcmp(output.data(), datasets[d].data(), numWords * sizeof(uint32_t)) != 0)
+        throw std::runtime_error(std::string("Error, ") + names[d] + " did not survive a compressed read back!");
+    }
+
+    std::cout << names[d] << ": ratio " << bytes / compressedSize << ", map " << bytes / (mapTime * 1e9)
+              << " GB/s, compressed " << bytes / (compressedTime * 1e9) << " GB/s effective" << std::endl;
+    if (d < 2 && compressedSize * 2 > bytes)
+      throw std::runtime_error(std::string("Error, ") + names[d] + " compressed by less than 2x!");
+    if (compressedSize > bytes * 1.01)
+      throw std::runtime_error("Error, incompressible data grew by more than 1%!");
+  }
+
+  // The device stream also round trips through gprtBufferCompress and gprtDecompress, including a partial buffer
+  {
+    const uint32_t partialWords = numWords / 3;
+    GPRTBufferOf<uint32_t> compressed = gprtDeviceBufferCreate<uint32_t>(context, 1);
+    gprtBufferMap(buffer);
+    memcpy(gprtBufferGetHostPointer(buffer), datasets[1].data(), numWords * sizeof(uint32_t));
+    gprtBufferUnmap(buffer);
+    size_t compressedSize = gprtBufferCompress(context, buffer, compressed, partialWords * sizeof(uint32_t));
+    gprtBufferMap(compressed);
+    std::fill(output.begin(), output.end(), 0xDEADBEEF);
+    size_t written = gprtDecompress(gprtBufferGetHostPointer(compressed), compressedSize, output.data(),
+                                    numWords * sizeof(uint32_t));
+    gprtBufferUnmap(compressed);
+    if (written != partialWords * sizeof(uint32_t) ||
+        memcmp(output.data(), datasets[1].data(), partialWords * sizeof(uint32_t)) != 0 ||
+        output[partialWords] != 0xDEADBEEF)
+      throw std::runtime_error("Error, partial compression did not round trip!");
+    gprtBufferDestroy(compressed);
+  }
+
+  // Cleanup
+  gprtBufferDestroy(buffer);
+  gprtContextDestroy(context);
+}
@@ -0,0 +1,131 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <gprt.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Each generation of the simulated job overwrites every buffer with an iota, so any snapshot can be checked
+static uint32_t
+generationStart(uint32_t generation, uint32_t buffer, uint32_t numBuffers) {
+  return (generation * numBuffers + buffer) << 20;
+}
+
+int
+main(int ac, char **av) {
+  const uint32_t numBuffers = 4;
+  const uint32_t numWords = 1 << 24;
+  const uint32_t numGenerations = 6;
+  const std::string prefix = "t19_checkpoint";
+
+  // Arrange
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  std::vector<GPRTBufferOf<uint32_t>> buffers(numBuffers);
+  for (uint32_t b = 0; b < numBuffers; ++b)
+    buffers[b] = gprtDeviceBufferCreate<uint32_t>(context, numWords);
+  GPRTBuffer *handles = (GPRTBuffer *) buffers.data();
+  double bytes = double(numBuffers) * numWords * sizeof(uint32_t);
+
+  // Act
+  // The baseline maps each buffer in turn and writes it out before the job may continue
+  double baselineStall = 0.0;
+  for (uint32_t generation = 0; generation < numGenerations; ++generation) {
+    for (uint32_t b = 0; b < numBuffers; ++b)
+      gprtBufferIota(context, buffers[b], generationStart(generation, b, numBuffers));
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string path = prefix + ".baseline";
+    FILE *file = fopen(path.c_str(), "wb");
+    for (uint32_t b = 0; b < numBuffers; ++b) {
+      gprtBufferMap(buffers[b]);
+      fwrite(gprtBufferGetHostPointer(buffers[b]), sizeof(uint32_t), numWords, file);
+      gprtBufferUnmap(buffers[b]);
+    }
+    fclose(file);
+    auto end = std::chrono::high_resolution_clock::now();
+    baselineStall += std::chrono::duration<double>(end - start).count() / numGenerations;
+    std::remove(path.c_str());
+  }
+
+  // Snapshots return as soon as the copies are submitted, and the next generation is launched right behind them
+  GPRTCheckpoint checkpoint = gprtCheckpointCreate(context, prefix.c_str(), 2);
+  double snapshotStall = 0.0;
+  auto jobStart = std::chrono::high_resolution_clock::now();
+  for (uint32_t generation = 0; generation < numGenerations; ++generation) {
+    for (uint32_t b = 0; b < numBuffers; ++b)
+      gprtBufferIota(context, buffers[b], generationStart(generation, b, numBuffers));
+
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t version = gprtCheckpointSnapshot(context, checkpoint, numBuffers, handles);
+    auto end = std::chrono::high_resolution_clock::now();
+    snapshotStall += std::chrono::duration<double>(end - start).count() / numGenerations;
+    if (version != generation)
+      throw std::runtime_error("Snapshot versions should count up from zero");
+  }
+  gprtCheckpointWait(checkpoint);
+  auto jobEnd = std::chrono::high_resolution_clock::now();
+
+  // Assert
+  std::cout << "Checkpointing " << bytes / 1e6 << " MB of state" << std::endl;
+  std::cout << "\tMap and write stall: " << baselineStall * 1e3 << " ms (" << bytes / baselineStall / 1e9 << " GB/s)"
+            << std::endl;
+  std::cout << "\tSnapshot stall: " << snapshotStall * 1e3 << " ms" << std::endl;
+  std::cout << "\tAll snapshots written after " << std::chrono::duration<double>(jobEnd - jobStart).count() * 1e3
+            << " ms" << std::endl;
+
+  // Every snapshot must hold the generation it was taken at, even though the next one overwrote the buffers
+  std::vector<uint32_t> words(numWords);
+  for (uint32_t generation = 0; generation < numGenerations; ++generation) {
+    std::string path = gprtCheckpointGetPath(checkpoint, generation);
+    for (uint32_t b = 0; b < numBuffers; ++b)
+      gprtBufferFill(context, buffers[b], 0u);
+    uint64_t version = gprtCheckpointRestore(context, path.c_str(), numBuffers, handles);
+    if (version != generation)
+      throw std::runtime_error("Restored the wrong checkpoint version");
+
+    for (uint32_t b = 0; b < numBuffers; ++b) {
+      gprtBufferMap(buffers[b]);
+      memcpy(words.data(), gprtBufferGetHostPointer(buffers[b]), numWords * sizeof(uint32_t));
+      gprtBufferUnmap(buffers[b]);
+      uint32_t start = generationStart(generation, b, numBuffers);
+      for (uint32_t i = 0; i < numWords; ++i) {
+        if (words[i] != start + i)
+          throw std::runtime_error("Buffer " + std::to_string(b) + " restored from checkpoint " +
+                                   std::to_string(generation) + " differs at word " + std::to_string(i));
+      }
+    }
+    std::remove(path.c_str());
+  }
+
+  // Cleanup
+  gprtCheckpointDestroy(checkpoint);
+  for (auto buffer : buffers)
+    gprtBufferDestroy(buffer);
+  gprtContextDestroy(context);
+  return 0;
+}
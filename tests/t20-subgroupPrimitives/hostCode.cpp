@@ -0,0 +1,278 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+extern GPRTProgram t20_deviceCode;
+
+int
+main(int ac, char **av) {
+  const uint32_t numParticles = 1 << 24;
+  const uint32_t numSegmentValues = 1 << 20;
+  const uint32_t numBins = 1 << 16;
+
+  // Arrange
+  // Most particles bank nothing, as in a transport step where few collisions produce secondaries
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  std::vector<uint32_t> numSecondariesHost(numParticles);
+  std::vector<uint32_t> valuesHost(numParticles);
+  std::vector<uint32_t> binsHost(numParticles);
+  uint64_t totalSecondaries = 0;
+  for (uint32_t i = 0; i < numParticles; ++i) {
+    numSecondariesHost[i] = (uniform(rng) < 0.2f) ? 1 + rng() % 3 : 0;
+    totalSecondaries += numSecondariesHost[i];
+    valuesHost[i] = rng();
+    // Neighboring particles sit in the same few bins
+    binsHost[i] = ((i / 16) * 2654435761u + rng() % 2) % numBins;
+  }
+  std::vector<uint32_t> segmentValuesHost(numSegmentValues), headsHost(numSegmentValues);
+  for (uint32_t i = 0; i < numSegmentValues; ++i) {
+    segmentValuesHost[i] = rng() % 1000;
+    headsHost[i] = uniform(rng) < 0.15f;
+  }
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t20_deviceCode);
+  GPRTComputeOf<BankParams> bankPerLane = gprtComputeCreate<BankParams>(context, module, "BankPerLane");
+  GPRTComputeOf<BankParams> bankPerSubgroup = gprtComputeCreate<BankParams>(context, module, "BankPerSubgroup");
+  GPRTComputeOf<CompactParams> compact = gprtComputeCreate<CompactParams>(context, module, "Compact");
+  GPRTComputeOf<SegmentParams> segment = gprtComputeCreate<SegmentParams>(context, module, "Segment");
+  GPRTComputeOf<TallyParams> tallyPerLane = gprtComputeCreate<TallyParams>(context, module, "TallyPerLane");
+  GPRTComputeOf<TallyParams> tallyPerSubgroup = gprtComputeCreate<TallyParams>(context, module, "TallyPerSubgroup");
+
+  GPRTBufferOf<uint32_t> numSecondaries =
+      gprtDeviceBufferCreate<uint32_t>(context, numParticles, numSecondariesHost.data());
+  GPRTBufferOf<uint32_t> bank = gprtDeviceBufferCreate<uint32_t>(context, totalSecondaries);
+  GPRTBufferOf<uint32_t> values = gprtDeviceBufferCreate<uint32_t>(context, numParticles, valuesHost.data());
+  GPRTBufferOf<uint32_t> compacted = gprtDeviceBufferCreate<uint32_t>(context, numParticles);
+  GPRTBufferOf<uint32_t> bins = gprtDeviceBufferCreate<uint32_t>(context, numParticles, binsHost.data());
+  GPRTBufferOf<uint32_t> tally = gprtDeviceBufferCreate<uint32_t>(context, numBins);
+  GPRTBufferOf<uint32_t> counter = gprtDeviceBufferCreate<uint32_t>(context, 1);
+
+  GPRTBufferOf<uint32_t> segmentValues =
+      gprtDeviceBufferCreate<uint32_t>(context, numSegmentValues, segmentValuesHost.data());
+  GPRTBufferOf<uint32_t> heads = gprtDeviceBufferCreate<uint32_t>(context, numSegmentValues, headsHost.data());
+  GPRTBufferOf<uint32_t> inclusive = gprtDeviceBufferCreate<uint32_t>(context, numSegmentValues);
+  GPRTBufferOf<uint32_t> exclusive = gprtDeviceBufferCreate<uint32_t>(context, numSegmentValues);
+  GPRTBufferOf<uint32_t> sums = gprtDeviceBufferCreate<uint32_t>(context, numSegmentValues);
+  GPRTBufferOf<uint32_t> lanes = gprtDeviceBufferCreate<uint32_t>(context, numSegmentValues);
+  GPRTBufferOf<uint32_t> laneCount = gprtDeviceBufferCreate<uint32_t>(context, 1);
+
+  uint32_t numGroups = std::min<uint32_t>(numParticles / SUBGROUP_THREADGROUP_SIZE, 65535);
+  uint32_t stride = numGroups * SUBGROUP_THREADGROUP_SIZE;
+
+  BankParams bankParams = {};
+  bankParams.numSecondaries = gprtBufferGetDevicePointer(numSecondaries);
+  bankParams.bank = gprtBufferGetDevicePointer(bank);
+  bankParams.bankSize = gprtBufferGetDevicePointer(counter);
+  bankParams.numParticles = numParticles;
+  bankParams.stride = stride;
+
+  CompactParams compactParams = {};
+  compactParams.input = gprtBufferGetDevicePointer(values);
+  compactParams.output = gprtBufferGetDevicePointer(compacted);
+  compactParams.outputSize = gprtBufferGetDevicePointer(counter);
+  compactParams.count = numParticles;
+  compactParams.stride = stride;
+
+  SegmentParams segmentParams = {};
+  segmentParams.values = gprtBufferGetDevicePointer(segmentValues);
+  segmentParams.heads = gprtBufferGetDevicePointer(heads);
+  segmentParams.inclusive = gprtBufferGetDevicePointer(inclusive);
+  segmentParams.exclusive = gprtBufferGetDevicePointer(exclusive);
+  segmentParams.sums = gprtBufferGetDevicePointer(sums);
+  segmentParams.lanes = gprtBufferGetDevicePointer(lanes);
+  segmentParams.laneCount = gprtBufferGetDevicePointer(laneCount);
+
+  TallyParams tallyParams = {};
+  tallyParams.bins = gprtBufferGetDevicePointer(bins);
+  tallyParams.tally = gprtBufferGetDevicePointer(tally);
+  tallyParams.numScores = numParticles;
+  tallyParams.stride = stride;
+
+  // Act
+  // The segmented operations run first, to find the subgroup size that the atomic counts below depend on
+  gprtComputeLaunch(segment, {numSegmentValues / SUBGROUP_THREADGROUP_SIZE, 1, 1}, {SUBGROUP_THREADGROUP_SIZE, 1, 1},
+                    segmentParams);
+  gprtBufferMap(laneCount);
+  uint32_t subgroupSize = *gprtBufferGetHostPointer(laneCount);
+  gprtBufferUnmap(laneCount);
+
+  // Each kernel runs twice, timing the second round once pipelines are warm
+  GPRTComputeOf<BankParams> bankKernels[2] = {bankPerLane, bankPerSubgroup};
+  GPRTComputeOf<TallyParams> tallyKernels[2] = {tallyPerLane, tallyPerSubgroup};
+  float bankTimes[2], tallyTimes[2];
+  std::vector<uint32_t> bankHost[2], tallyHost[2];
+  uint32_t bankSizes[2];
+  for (uint32_t variant = 0; variant < 2; ++variant) {
+    for (uint32_t round = 0; round < 2; ++round) {
+      gprtBufferClear(counter);
+      gprtBeginProfile(context);
+      gprtComputeLaunch(bankKernels[variant], {numGroups, 1, 1}, {SUBGROUP_THREADGROUP_SIZE, 1, 1}, bankParams);
+      bankTimes[variant] = gprtEndProfile(context);
+
+      gprtBufferClear(tally);
+      gprtBeginProfile(context);
+      gprtComputeLaunch(tallyKernels[variant], {numGroups, 1, 1}, {SUBGROUP_THREADGROUP_SIZE, 1, 1}, tallyParams);
+      tallyTimes[variant] = gprtEndProfile(context);
+    }
+    gprtBufferMap(counter);
+    bankSizes[variant] = *gprtBufferGetHostPointer(counter);
+    gprtBufferUnmap(counter);
+    gprtBufferMap(bank);
+    bankHost[variant].assign(gprtBufferGetHostPointer(bank), gprtBufferGetHostPointer(bank) + totalSecondaries);
+    gprtBufferUnmap(bank);
+    gprtBufferMap(tally);
+    tallyHost[variant].assign(gprtBufferGetHostPointer(tally), gprtBufferGetHostPointer(tally) + numBins);
+    gprtBufferUnmap(tally);
+  }
+
+  gprtBufferClear(counter);
+  gprtComputeLaunch(compact, {numGroups, 1, 1}, {SUBGROUP_THREADGROUP_SIZE, 1, 1}, compactParams);
+
+  // Assert
+  // Subgroups cover consecutive threads, so with a grid stride that's a multiple of the subgroup size, each subgroup
+  // handles consecutive runs of subgroupSize particles
+  uint64_t bankAtomics = 0, tallyAtomics = 0;
+  for (uint32_t first = 0; first < numParticles; first += subgroupSize) {
+    bool any = false;
+    std::set<uint32_t> distinctBins;
+    for (uint32_t i = first; i < first + subgroupSize; ++i) {
+      any |= numSecondariesHost[i] > 0;
+      distinctBins.insert(binsHost[i]);
+    }
+    bankAtomics += any;
+    tallyAtomics += distinctBins.size();
+  }
+  std::cout << "Subgroup size " << subgroupSize << std::endl;
+  std::cout << "Banking " << totalSecondaries << " secondaries from " << numParticles << " particles" << std::endl;
+  std::cout << "\tPer lane: " << totalSecondaries << " atomics, " << numParticles / (bankTimes[0] * 1e3f)
+            << " Mparticles/s" << std::endl;
+  std::cout << "\tPer subgroup: " << bankAtomics << " atomics, " << numParticles / (bankTimes[1] * 1e3f)
+            << " Mparticles/s" << std::endl;
+  std::cout << "Scoring " << numParticles << " particles into " << numBins << " bins" << std::endl;
+  std::cout << "\tPer lane: " << numParticles << " atomics, " << numParticles / (tallyTimes[0] * 1e3f)
+            << " Mscores/s" << std::endl;
+  std::cout << "\tPer subgroup: " << tallyAtomics << " atomics, " << numParticles / (tallyTimes[1] * 1e3f)
+            << " Mscores/s" << std::endl;
+
+  std::vector<uint32_t> expectedBank;
+  for (uint32_t i = 0; i < numParticles; ++i)
+    expectedBank.insert(expectedBank.end(), numSecondariesHost[i], i);
+  std::vector<uint32_t> expectedTally(numBins, 0);
+  for (uint32_t i = 0; i < numParticles; ++i)
+    expectedTally[binsHost[i]]++;
+  for (uint32_t variant = 0; variant < 2; ++variant) {
+    if (bankSizes[variant] != totalSecondaries)
+      throw std::runtime_error("Error, incorrect number of banked secondaries!");
+    // Banking order depends on scheduling, but every particle must appear once per secondary
+    std::sort(bankHost[variant].begin(), bankHost[variant].end());
+    if (bankHost[variant] != expectedBank)
+      throw std::runtime_error("Error, incorrect bank of secondaries!");
+    if (tallyHost[variant] != expectedTally)
+      throw std::runtime_error("Error, incorrect tally!");
+  }
+
+  std::vector<uint32_t> expectedCompacted;
+  for (uint32_t value : valuesHost)
+    if (value & 1)
+      expectedCompacted.push_back(value);
+  gprtBufferMap(counter);
+  uint32_t compactedSize = *gprtBufferGetHostPointer(counter);
+  gprtBufferUnmap(counter);
+  if (compactedSize != expectedCompacted.size())
+    throw std::runtime_error("Error, incorrect number of compacted values!");
+  gprtBufferMap(compacted);
+  std::vector<uint32_t> compactedHost(gprtBufferGetHostPointer(compacted),
+                                      gprtBufferGetHostPointer(compacted) + compactedSize);
+  gprtBufferUnmap(compacted);
+  std::sort(compactedHost.begin(), compactedHost.end());
+  std::sort(expectedCompacted.begin(), expectedCompacted.end());
+  if (compactedHost != expectedCompacted)
+    throw std::runtime_error("Error, incorrect compacted values!");
+
+  gprtBufferMap(inclusive);
+  gprtBufferMap(exclusive);
+  gprtBufferMap(sums);
+  gprtBufferMap(lanes);
+  uint32_t *inclusiveHost = gprtBufferGetHostPointer(inclusive);
+  uint32_t *exclusiveHost = gprtBufferGetHostPointer(exclusive);
+  uint32_t *sumsHost = gprtBufferGetHostPointer(sums);
+  uint32_t *lanesHost = gprtBufferGetHostPointer(lanes);
+  for (uint32_t first = 0; first < numSegmentValues;) {
+    // Segments start at heads, and at the start of every subgroup
+    uint32_t last = first + 1;
+    while (last < numSegmentValues && !headsHost[last] && last % subgroupSize != 0)
+      ++last;
+    uint32_t sum = 0;
+    for (uint32_t i = first; i < last; ++i) {
+      if (lanesHost[i] != i % subgroupSize)
+        throw std::runtime_error("Error, subgroups do not cover consecutive threads!");
+      if (exclusiveHost[i] != sum)
+        throw std::runtime_error("Error, incorrect segmented exclusive sum!");
+      sum += segmentValuesHost[i];
+      if (inclusiveHost[i] != sum)
+        throw std::runtime_error("Error, incorrect segmented inclusive sum!");
+    }
+    for (uint32_t i = first; i < last; ++i)
+      if (sumsHost[i] != sum)
+        throw std::runtime_error("Error, incorrect segmented sum!");
+    first = last;
+  }
+  gprtBufferUnmap(lanes);
+  gprtBufferUnmap(sums);
+  gprtBufferUnmap(exclusive);
+  gprtBufferUnmap(inclusive);
+
+  // Cleanup
+  gprtBufferDestroy(laneCount);
+  gprtBufferDestroy(lanes);
+  gprtBufferDestroy(sums);
+  gprtBufferDestroy(exclusive);
+  gprtBufferDestroy(inclusive);
+  gprtBufferDestroy(heads);
+  gprtBufferDestroy(segmentValues);
+  gprtBufferDestroy(counter);
+  gprtBufferDestroy(tally);
+  gprtBufferDestroy(bins);
+  gprtBufferDestroy(compacted);
+  gprtBufferDestroy(values);
+  gprtBufferDestroy(bank);
+  gprtBufferDestroy(numSecondaries);
+  gprtComputeDestroy(tallyPerSubgroup);
+  gprtComputeDestroy(tallyPerLane);
+  gprtComputeDestroy(segment);
+  gprtComputeDestroy(compact);
+  gprtComputeDestroy(bankPerSubgroup);
+  gprtComputeDestroy(bankPerLane);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
@@ -0,0 +1,62 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "gprt.h"
+
+#define SUBGROUP_THREADGROUP_SIZE 256
+
+// Each particle banks some number of secondaries, appending its own index once per secondary
+struct BankParams {
+  uint32_t *numSecondaries;
+  uint32_t *bank;
+  uint32_t *bankSize;
+  uint32_t numParticles;
+  uint32_t stride;   // total number of threads in the launch
+};
+
+// Keeps the values whose low bit is set
+struct CompactParams {
+  uint32_t *input;
+  uint32_t *output;
+  uint32_t *outputSize;
+  uint32_t count;
+  uint32_t stride;   // total number of threads in the launch
+};
+
+// One value per thread, with no grid stride loop, so that every subgroup is always fully active
+struct SegmentParams {
+  uint32_t *values;
+  uint32_t *heads;
+  uint32_t *inclusive;
+  uint32_t *exclusive;
+  uint32_t *sums;
+  uint32_t *lanes;       // the lane that handled each value
+  uint32_t *laneCount;
+};
+
+// Scores one count per particle into the tally bin holding it
+struct TallyParams {
+  uint32_t *bins;
+  uint32_t *tally;
+  uint32_t numScores;
+  uint32_t stride;   // total number of threads in the launch
+};
@@ -0,0 +1,227 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+extern GPRTProgram t21_deviceCode;
+
+// Evaluates a uniform cubic B-spline span, position and radius alike
+static float4
+evaluateBSpline(const float4 *p, float u) {
+  float s = 1.f - u;
+  float b0 = s * s * s / 6.f;
+  float b1 = (3.f * u * u * u - 6.f * u * u + 4.f) / 6.f;
+  float b2 = (-3.f * u * u * u + 3.f * u * u + 3.f * u + 1.f) / 6.f;
+  float b3 = u * u * u / 6.f;
+  return p[0] * b0 + p[1] * b1 + p[2] * b2 + p[3] * b3;
+}
+
+int
+main(int ac, char **av) {
+  const uint32_t numStrands = 8192;
+  const uint32_t pointsPerStrand = 8;
+  const uint32_t segmentsPerStrand = pointsPerStrand - 3;
+  const uint32_t numSegments = numStrands * segmentsPerStrand;
+  const uint32_t tessellations[2] = {4, 16};
+  const uint32_t width = 1024;
+  const uint32_t height = 1024;
+  const uint32_t numIterations = 10;
+
+  // Arrange
+  // Wavy, tapering strands growing up out of a disk
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  std::vector<float4> pointsHost;
+  std::vector<uint32_t> segmentsHost;
+  for (uint32_t s = 0; s < numStrands; ++s) {
+    float angle = 6.2831853f * uniform(rng);
+    float distance = 0.4f * sqrtf(uniform(rng));
+    float phase = 6.2831853f * uniform(rng);
+    float3 root = float3(0.5f + distance * cosf(angle), 0.f, 0.5f + distance * sinf(angle));
+    for (uint32_t i = 0; i < pointsPerStrand; ++i) {
+      float v = float(i) / float(pointsPerStrand - 1);
+      float3 p = root + float3(0.08f * sinf(phase + 5.f * v), v, 0.08f * cosf(phase + 4.f * v));
+      pointsHost.push_back(float4(p.x, p.y, p.z, 0.004f * (1.f - 0.7f * v)));
+    }
+    for (uint32_t i = 0; i < segmentsPerStrand; ++i)
+      segmentsHost.push_back(s * pointsPerStrand + i);
+  }
+
+  // The equivalent linear swept spheres, chained along each strand
+  std::vector<float4> lssPointsHost[2];
+  std::vector<uint2> lssSegmentsHost[2];
+  for (uint32_t l = 0; l < 2; ++l) {
+    for (uint32_t s = 0; s < numStrands; ++s) {
+      uint32_t first = uint32_t(lssPointsHost[l].size());
+      for (uint32_t i = 0; i < segmentsPerStrand; ++i) {
+        const float4 *p = &pointsHost[s * pointsPerStrand + i];
+        for (uint32_t j = 0; j < tessellations[l]; ++j)
+          lssPointsHost[l].push_back(evaluateBSpline(p, float(j) / tessellations[l]));
+      }
+      lssPointsHost[l].push_back(evaluateBSpline(&pointsHost[s * pointsPerStrand + segmentsPerStrand - 1], 1.f));
+      for (uint32_t i = 0; i < segmentsPerStrand * tessellations[l]; ++i)
+        lssSegmentsHost[l].push_back(uint2(first + i, first + i + 1));
+    }
+  }
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t21_deviceCode);
+
+  GPRTGeomTypeOf<CurveData> curveType = gprtGeomTypeCreate<CurveData>(context, GPRT_CURVES);
+  gprtGeomTypeSetClosestHitProg(curveType, 0, module, "CurveHit");
+  GPRTGeomTypeOf<LSSData> lssType = gprtGeomTypeCreate<LSSData>(context, GPRT_LSS);
+  gprtGeomTypeSetClosestHitProg(lssType, 0, module, "LSSHit");
+  GPRTMissOf<void> miss = gprtMissCreate<void>(context, module, "miss");
+  GPRTRayGenOf<RayGenData> rayGen = gprtRayGenCreate<RayGenData>(context, module, "Trace");
+
+  GPRTBufferOf<float4> points = gprtDeviceBufferCreate<float4>(context, pointsHost.size(), pointsHost.data());
+  GPRTBufferOf<uint32_t> segments = gprtDeviceBufferCreate<uint32_t>(context, numSegments, segmentsHost.data());
+  GPRTGeomOf<CurveData> curveGeom = gprtGeomCreate(context, curveType);
+  gprtCurvesSetVertices(curveGeom, points, uint32_t(pointsHost.size()));
+  gprtCurvesSetIndices(curveGeom, segments, numSegments);
+  gprtCurvesSetBasis(curveGeom, GPRT_CURVE_BSPLINE);
+  gprtGeomGetParameters(curveGeom)->vertices = gprtBufferGetDevicePointer(points);
+  GPRTAccel curveAccel = gprtCurveAccelCreate(context, curveGeom);
+  gprtAccelBuild(context, curveAccel, GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+
+  GPRTBufferOf<float4> lssPoints[2];
+  GPRTBufferOf<uint2> lssSegments[2];
+  GPRTGeomOf<LSSData> lssGeoms[2];
+  GPRTAccel lssAccels[2];
+  for (uint32_t l = 0; l < 2; ++l) {
+    lssPoints[l] = gprtDeviceBufferCreate<float4>(context, lssPointsHost[l].size(), lssPointsHost[l].data());
+    lssSegments[l] = gprtDeviceBufferCreate<uint2>(context, lssSegmentsHost[l].size(), lssSegmentsHost[l].data());
+    lssGeoms[l] = gprtGeomCreate(context, lssType);
+    gprtLSSSetVertices(lssGeoms[l], lssPoints[l], uint32_t(lssPointsHost[l].size()));
+    gprtLSSSetIndices(lssGeoms[l], lssSegments[l], uint32_t(lssSegmentsHost[l].size()));
+    gprtGeomGetParameters(lssGeoms[l])->vertices = gprtBufferGetDevicePointer(lssPoints[l]);
+    lssAccels[l] = gprtLSSAccelCreate(context, lssGeoms[l]);
+    gprtAccelBuild(context, lssAccels[l], GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+  }
+
+  GPRTAccel blases[3] = {curveAccel, lssAccels[0], lssAccels[1]};
+  size_t inputBytes[3] = {pointsHost.size() * sizeof(float4) + segmentsHost.size() * sizeof(uint32_t),
+                          lssPointsHost[0].size() * sizeof(float4) + lssSegmentsHost[0].size() * sizeof(uint2),
+                          lssPointsHost[1].size() * sizeof(float4) + lssSegmentsHost[1].size() * sizeof(uint2)};
+  GPRTBufferOf<gprt::Instance> instances[3];
+  GPRTAccel worlds[3];
+  GPRTBufferOf<float> results[3];
+  for (uint32_t i = 0; i < 3; ++i) {
+    gprt::Instance instance = gprtAccelGetInstance(blases[i]);
+    instances[i] = gprtDeviceBufferCreate<gprt::Instance>(context, 1, &instance);
+    worlds[i] = gprtInstanceAccelCreate(context, 1, instances[i]);
+    gprtAccelBuild(context, worlds[i], GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+    results[i] = gprtDeviceBufferCreate<float>(context, width * height);
+  }
+
+  RayGenData *rayGenData = gprtRayGenGetParameters(rayGen);
+  rayGenData->eye = float3(1.4f, 0.9f, 1.6f);
+  rayGenData->target = float3(0.5f, 0.5f, 0.5f);
+  gprtBuildShaderBindingTable(context);
+
+  // Act
+  const char *names[3] = {"Cubic B-spline curves", "LSS, 4 per segment", "LSS, 16 per segment"};
+  float times[3];
+  for (uint32_t i = 0; i < 3; ++i) {
+    rayGenData->world = gprtAccelGetDeviceAddress(worlds[i]);
+    rayGenData->results = gprtBufferGetDevicePointer(results[i]);
+    gprtBuildShaderBindingTable(context, GPRT_SBT_RAYGEN);
+
+    gprtRayGenLaunch2D(context, rayGen, width, height);
+    times[i] = 0.f;
+    for (uint32_t iteration = 0; iteration < numIterations; ++iteration) {
+      gprtBeginProfile(context);
+      gprtRayGenLaunch2D(context, rayGen, width, height);
+      times[i] += gprtEndProfile(context) / numIterations;
+    }
+  }
+
+  std::cout << numStrands << " strands, " << numSegments << " cubic segments" << std::endl;
+  for (uint32_t i = 0; i < 3; ++i) {
+    size_t bytes = gprtAccelGetSize(blases[i]);
+    std::cout << names[i] << ": BLAS " << bytes / (1024.f * 1024.f) << " MB, input "
+              << inputBytes[i] / (1024.f * 1024.f) << " MB, " << (width * height) / (times[i] * 1e3f)
+              << " Mrays/s" << std::endl;
+  }
+
+  // Assert
+  for (uint32_t i = 0; i < 3; ++i)
+    gprtBufferMap(results[i]);
+  float *curve = gprtBufferGetHostPointer(results[0]);
+  uint32_t numRays = width * height, numCurveHits = 0;
+  uint32_t coverageMismatches[2] = {0, 0}, depthMismatches[2] = {0, 0};
+  for (uint32_t r = 0; r < numRays; ++r) {
+    if (curve[r] >= 0.f)
+      numCurveHits++;
+    for (uint32_t l = 0; l < 2; ++l) {
+      float lss = gprtBufferGetHostPointer(results[l + 1])[r];
+      if ((curve[r] >= 0.f) != (lss >= 0.f))
+        coverageMismatches[l]++;
+      else if (curve[r] >= 0.f && fabsf(curve[r] - lss) > 0.01f)
+        depthMismatches[l]++;
+    }
+  }
+  for (uint32_t i = 0; i < 3; ++i)
+    gprtBufferUnmap(results[i]);
+  for (uint32_t l = 0; l < 2; ++l)
+    std::cout << names[l + 1] << ": " << 100.f * coverageMismatches[l] / numCurveHits << "% of hits disagree on "
+              << "coverage, " << 100.f * depthMismatches[l] / numCurveHits << "% on depth" << std::endl;
+
+  if (numCurveHits < numRays / 20)
+    throw std::runtime_error("Error, curves covered too few pixels!");
+  // The finer tessellation converges to the curve, so only silhouettes should differ
+  if (coverageMismatches[1] + depthMismatches[1] > numCurveHits / 50)
+    throw std::runtime_error("Error, curves disagree with their fine tessellation!");
+  if (coverageMismatches[1] > coverageMismatches[0])
+    throw std::runtime_error("Error, curves agree less with the fine tessellation than the coarse one!");
+  if (gprtAccelGetSize(curveAccel) >= gprtAccelGetSize(lssAccels[1]))
+    throw std::runtime_error("Error, curve tree is not smaller than the fine tessellation's!");
+
+  // Cleanup
+  for (uint32_t i = 0; i < 3; ++i) {
+    gprtBufferDestroy(results[i]);
+    gprtAccelDestroy(worlds[i]);
+    gprtBufferDestroy(instances[i]);
+  }
+  for (uint32_t l = 0; l < 2; ++l) {
+    gprtAccelDestroy(lssAccels[l]);
+    gprtGeomDestroy(lssGeoms[l]);
+    gprtBufferDestroy(lssSegments[l]);
+    gprtBufferDestroy(lssPoints[l]);
+  }
+  gprtAccelDestroy(curveAccel);
+  gprtGeomDestroy(curveGeom);
+  gprtBufferDestroy(segments);
+  gprtBufferDestroy(points);
+  gprtRayGenDestroy(rayGen);
+  gprtMissDestroy(miss);
+  gprtGeomTypeDestroy(lssType);
+  gprtGeomTypeDestroy(curveType);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
@@ -0,0 +1,150 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern GPRTProgram t22_deviceCode;
+
+const uint32_t width = 256;
+const uint32_t height = 256;
+const uint32_t numIterations = 200;
+
+// Creates its own context from the given config, and traces a quad over and over, checking which hit program
+// and which record each ray type ends up with
+template <typename QuadData>
+void
+traceQuad(const GPRTContextConfig &config, const char *rayGenName, const char *missName,
+          std::vector<const char *> hitNames, std::vector<uint32_t> expected, std::string &error) {
+  try {
+    GPRTContext context = gprtContextCreateWithConfig(&config);
+    if (gprtContextGetRayTypeCount(context) != config.numRayTypes)
+      throw std::runtime_error("context has the wrong number of ray types!");
+    GPRTModule module = gprtModuleCreate(context, t22_deviceCode);
+
+    GPRTGeomTypeOf<QuadData> quadType = gprtGeomTypeCreate<QuadData>(context, GPRT_TRIANGLES);
+    for (uint32_t rayType = 0; rayType < config.numRayTypes; ++rayType)
+      gprtGeomTypeSetClosestHitProg(quadType, rayType, module, hitNames[rayType]);
+    GPRTMissOf<void> miss = gprtMissCreate<void>(context, module, missName);
+    GPRTRayGenOf<RayGenData> rayGen = gprtRayGenCreate<RayGenData>(context, module, rayGenName);
+
+    float3 verticesHost[4] = {{-2.f, -2.f, 0.f}, {2.f, -2.f, 0.f}, {2.f, 2.f, 0.f}, {-2.f, 2.f, 0.f}};
+    uint3 indicesHost[2] = {{0, 1, 2}, {0, 2, 3}};
+    GPRTBufferOf<float3> vertices = gprtDeviceBufferCreate<float3>(context, 4, verticesHost);
+    GPRTBufferOf<uint3> indices = gprtDeviceBufferCreate<uint3>(context, 2, indicesHost);
+    GPRTGeomOf<QuadData> quad = gprtGeomCreate(context, quadType);
+    gprtTrianglesSetVertices(quad, vertices, 4);
+    gprtTrianglesSetIndices(quad, indices, 2);
+    QuadData *quadData = gprtGeomGetParameters(quad);
+    uint32_t *values = (uint32_t *) quadData;
+    for (uint32_t i = 0; i < sizeof(QuadData) / sizeof(uint32_t); ++i)
+      values[i] = 0;
+    values[0] = expected[0];
+    values[sizeof(QuadData) / sizeof(uint32_t) - 1] = expected.back();
+
+    GPRTAccel blas = gprtTriangleAccelCreate(context, quad);
+    gprtAccelBuild(context, blas, GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+    gprt::Instance instance = gprtAccelGetInstance(blas);
+    GPRTBufferOf<gprt::Instance> instances = gprtDeviceBufferCreate<gprt::Instance>(context, 1, &instance);
+    GPRTAccel world = gprtInstanceAccelCreate(context, 1, instances);
+    gprtAccelBuild(context, world, GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+
+    GPRTBufferOf<uint32_t> results = gprtDeviceBufferCreate<uint32_t>(context, width * height);
+    RayGenData *rayGenData = gprtRayGenGetParameters(rayGen);
+    rayGenData->world = gprtAccelGetDeviceAddress(world);
+    rayGenData->results = gprtBufferGetDevicePointer(results);
+    rayGenData->numRayTypes = config.numRayTypes;
+    gprtBuildShaderBindingTable(context);
+
+    for (uint32_t iteration = 0; iteration < numIterations; ++iteration) {
+      uint32_t rayType = iteration % config.numRayTypes;
+      rayGenData->rayType = rayType;
+      gprtBuildShaderBindingTable(context, GPRT_SBT_RAYGEN);
+      gprtRayGenLaunch2D(context, rayGen, width, height);
+
+      gprtBufferMap(results);
+      uint32_t *resultsHost = gprtBufferGetHostPointer(results);
+      for (uint32_t i = 0; i < width * height; ++i) {
+        if (resultsHost[i] != expected[rayType])
+          throw std::runtime_error("ray type " + std::to_string(rayType) + " returned " +
+                                   std::to_string(resultsHost[i]) + " rather than " +
+                                   std::to_string(expected[rayType]) + "!");
+      }
+      gprtBufferUnmap(results);
+    }
+
+    gprtBufferDestroy(results);
+    gprtAccelDestroy(world);
+    gprtBufferDestroy(instances);
+    gprtAccelDestroy(blas);
+    gprtGeomDestroy(quad);
+    gprtBufferDestroy(indices);
+    gprtBufferDestroy(vertices);
+    gprtRayGenDestroy(rayGen);
+    gprtMissDestroy(miss);
+    gprtGeomTypeDestroy(quadType);
+    gprtModuleDestroy(module);
+    gprtContextDestroy(context);
+  } catch (const std::exception &e) {
+    error = e.what();
+  }
+}
+
+int
+main(int ac, char **av) {
+  // Arrange
+  // One context as configured by default, and another with two ray types, a larger payload and larger hit records
+  GPRTContextConfig smallConfig = gprtContextConfigGetDefault();
+  smallConfig.maxRayPayloadSize = sizeof(SmallPayload);
+
+  GPRTContextConfig largeConfig = gprtContextConfigGetDefault();
+  largeConfig.numRayTypes = 2;
+  largeConfig.maxRayPayloadSize = sizeof(LargePayload);
+  largeConfig.hitRecordSize = 512;
+  static_assert(sizeof(LargeQuadData) > 256, "the large record must not fit the default hit record size");
+
+  // Act
+  std::string smallError, largeError;
+  std::thread smallThread(traceQuad<SmallQuadData>, std::cref(smallConfig), "SmallRayGen", "SmallMiss",
+                          std::vector<const char *>{"SmallHit"}, std::vector<uint32_t>{7}, std::ref(smallError));
+  std::thread largeThread(traceQuad<LargeQuadData>, std::cref(largeConfig), "LargeRayGen", "LargeMiss",
+                          std::vector<const char *>{"LargeHitFirst", "LargeHitLast"}, std::vector<uint32_t>{11, 13},
+                          std::ref(largeError));
+  smallThread.join();
+  largeThread.join();
+
+  // Assert
+  if (!smallError.empty())
+    throw std::runtime_error("Error, default configured context failed: " + smallError);
+  if (!largeError.empty())
+    throw std::runtime_error("Error, two ray type context failed: " + largeError);
+  // Neither context changed the defaults
+  GPRTContextConfig defaults = gprtContextConfigGetDefault();
+  if (defaults.numRayTypes != 1 || defaults.hitRecordSize != smallConfig.hitRecordSize)
+    throw std::runtime_error("Error, creating a configured context changed the defaults!");
+  std::cout << "Both contexts traced " << numIterations << " launches concurrently" << std::endl;
+}
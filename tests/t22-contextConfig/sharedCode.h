@@ -0,0 +1,51 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "gprt.h"
+
+// The two contexts use differently sized payloads and records, each fitting only its own configuration
+#define LARGE_RECORD_VALUES 100
+
+struct SmallPayload {
+  uint32_t value;
+};
+
+struct LargePayload {
+  uint32_t value;
+  float3 unused;
+};
+
+struct SmallQuadData {
+  uint32_t value;
+};
+
+// Larger than the default hit record size
+struct LargeQuadData {
+  uint32_t values[LARGE_RECORD_VALUES];
+};
+
+struct RayGenData {
+  SurfaceAccelerationStructure world;
+  uint32_t *results;
+  uint32_t rayType;
+  uint32_t numRayTypes;
+};
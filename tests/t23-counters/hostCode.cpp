@@ -0,0 +1,120 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+extern GPRTProgram t23_deviceCode;
+
+static void
+expect(uint64_t counter, uint64_t expected, const char *name) {
+  if (counter != expected)
+    throw std::runtime_error(std::string("Error, expected ") + std::to_string(expected) + " " + name + ", got " +
+                             std::to_string(counter) + "!");
+}
+
+int
+main(int ac, char **av) {
+  const uint32_t count = 1 << 16;
+  const uint64_t bytes = count * sizeof(uint32_t);
+
+  // Arrange
+  GPRTContext context = gprtContextCreate();
+  GPRTModule module = gprtModuleCreate(context, t23_deviceCode);
+  std::vector<uint32_t> valuesHost(count, 0);
+  GPRTBufferOf<uint32_t> values = gprtDeviceBufferCreate<uint32_t>(context, count, valuesHost.data());
+  GPRTBufferOf<uint32_t> hostValues = gprtHostBufferCreate<uint32_t>(context, count, valuesHost.data());
+  GPRTRayGenOf<RayGenData> increment = gprtRayGenCreate<RayGenData>(context, module, "Increment");
+  gprtRayGenGetParameters(increment)->values = gprtBufferGetDevicePointer(values);
+
+  // Act and assert
+  // A fresh context has already done work, but resetting forgets it
+  GPRTCounters counters = gprtContextGetCounters(context);
+  if (counters.queueSubmits == 0 || counters.stagingCopies == 0)
+    throw std::runtime_error("Error, creating a device buffer from host data went uncounted!");
+  gprtContextResetCounters(context);
+  counters = gprtContextGetCounters(context);
+  expect(counters.queueSubmits + counters.queueWaits + counters.stagingCopies + counters.bytesUploaded +
+             counters.bytesDownloaded + counters.sbtBuilds + counters.accelBuilds,
+         0, "counts after a reset");
+
+  // The first table build builds the pipeline and allocates the raygen table, later ones reuse both
+  gprtBuildShaderBindingTable(context);
+  gprtBuildShaderBindingTable(context);
+  counters = gprtContextGetCounters(context);
+  expect(counters.sbtBuilds, 2, "table builds");
+  expect(counters.pipelineRebuilds, 1, "pipeline rebuilds");
+  expect(counters.sbtReallocations, 1, "table reallocations");
+
+  // A program created late forces both again
+  GPRTRayGenOf<RayGenData> decrement = gprtRayGenCreate<RayGenData>(context, module, "Decrement");
+  gprtRayGenGetParameters(decrement)->values = gprtBufferGetDevicePointer(values);
+  gprtBuildShaderBindingTable(context);
+  counters = gprtContextGetCounters(context);
+  expect(counters.pipelineRebuilds, 2, "pipeline rebuilds");
+  expect(counters.sbtReallocations, 2, "table reallocations");
+
+  // Launches submit and wait once each
+  gprtContextResetCounters(context);
+  for (uint32_t i = 0; i < 3; ++i)
+    gprtRayGenLaunch1D(context, increment, count);
+  counters = gprtContextGetCounters(context);
+  expect(counters.queueSubmits, 3, "submits");
+  expect(counters.queueWaits, 3, "waits");
+  expect(counters.stagingCopies, 0, "staging copies");
+
+  // Mapping a device buffer downloads it, and unmapping uploads it back, while host buffers are mapped in place
+  gprtContextResetCounters(context);
+  gprtBufferMap(values);
+  if (gprtBufferGetHostPointer(values)[count - 1] != 3)
+    throw std::runtime_error("Error, launches did not run!");
+  gprtBufferUnmap(values);
+  gprtBufferMap(hostValues);
+  gprtBufferUnmap(hostValues);
+  counters = gprtContextGetCounters(context);
+  expect(counters.stagingCopies, 2, "staging copies");
+  expect(counters.bytesDownloaded, bytes, "bytes downloaded");
+  expect(counters.bytesUploaded, bytes, "bytes uploaded");
+  expect(counters.queueSubmits, 2, "submits");
+
+  // Growing a buffer while keeping its contents copies all of them
+  gprtContextResetCounters(context);
+  gprtBufferResize(context, values, 2 * count, true);
+  gprtBufferResize(context, values, 2 * count, true);
+  counters = gprtContextGetCounters(context);
+  expect(counters.bufferResizes, 1, "resizes");
+  expect(counters.resizeBytesCopied, bytes, "bytes copied by resizes");
+
+  std::cout << "All counters matched" << std::endl;
+
+  // Cleanup
+  gprtRayGenDestroy(decrement);
+  gprtRayGenDestroy(increment);
+  gprtBufferDestroy(hostValues);
+  gprtBufferDestroy(values);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
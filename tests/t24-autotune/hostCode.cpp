@@ -0,0 +1,131 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+extern GPRTProgram t24_deviceCode;
+
+// Launches with the kernel's own group size, leaving it to GPRT to regroup the threads if the kernel is tuned
+static void
+launchAndCheck(GPRTContext context, GPRTComputeOf<AffineParams> affine, GPRTBufferOf<float> y, AffineParams params) {
+  gprtBufferClear(y);
+  uint32_t numGroups = (params.count + AUTOTUNE_DEFAULT_GROUP_SIZE - 1) / AUTOTUNE_DEFAULT_GROUP_SIZE;
+  gprtComputeLaunch(affine, {numGroups, 1, 1}, {AUTOTUNE_DEFAULT_GROUP_SIZE, 1, 1}, params);
+
+  gprtBufferMap(y);
+  float *result = gprtBufferGetHostPointer(y);
+  for (uint32_t i = 0; i < params.count; ++i) {
+    float expected = params.a * float(i % 1024) + params.b;
+    if (result[i] != expected)
+      throw std::runtime_error("Error, element " + std::to_string(i) + " is " + std::to_string(result[i]) +
+                               ", expected " + std::to_string(expected) + "!");
+  }
+  gprtBufferUnmap(y);
+}
+
+int
+main(int ac, char **av) {
+  // Not a multiple of any candidate, so tuned launches must bounds check
+  const uint32_t count = 1000003;
+  const char *cachePath = "t24_tuning_cache.txt";
+  std::remove(cachePath);
+
+  std::vector<float> xHost(count);
+  for (uint32_t i = 0; i < count; ++i)
+    xHost[i] = float(i % 1024);
+
+  uint32_t tunedGroupSize = 0;
+  for (uint32_t run = 0; run < 2; ++run) {
+    // Arrange
+    GPRTContext context = gprtContextCreate();
+    gprtContextSetTuningCache(context, cachePath);
+    GPRTModule module = gprtModuleCreate(context, t24_deviceCode);
+    GPRTBufferOf<float> x = gprtDeviceBufferCreate<float>(context, count, xHost.data());
+    GPRTBufferOf<float> y = gprtDeviceBufferCreate<float>(context, count);
+    GPRTComputeOf<AffineParams> affine = gprtComputeCreate<AffineParams>(context, module, "Affine");
+    GPRTComputeOf<AffineParams> affineFixed = gprtComputeCreate<AffineParams>(context, module, "AffineFixed");
+
+    AffineParams params;
+    params.x = gprtBufferGetDevicePointer(x);
+    params.y = gprtBufferGetDevicePointer(y);
+    params.a = 2.f;
+    params.b = 1.f;
+    params.count = count;
+
+    // Act and assert
+    if (run == 0) {
+      // Untuned kernels keep their own group size
+      if (gprtComputeGetGroupSize(affine) != 0)
+        throw std::runtime_error("Error, kernel is tuned before tuning!");
+      launchAndCheck(context, affine, y, params);
+
+      tunedGroupSize = gprtComputeAutotune(affine, count, params);
+      std::cout << "Tuned group size " << tunedGroupSize << std::endl;
+      if (tunedGroupSize < 32 || tunedGroupSize > THREADGROUP_LIMIT || (tunedGroupSize & (tunedGroupSize - 1)) != 0)
+        throw std::runtime_error("Error, tuning picked an unexpected group size!");
+      if (gprtComputeGetGroupSize(affine) != tunedGroupSize)
+        throw std::runtime_error("Error, tuned group size is not used!");
+      if (!std::ifstream(cachePath).good())
+        throw std::runtime_error("Error, tuning cache was not written!");
+
+      // Plant an entry for the fixed size kernel, as a stale cache might hold. The kernels share a module, and with
+      // it the hash in their keys. A group size of 1024 would launch a quarter of the threads if it were used.
+      std::string line;
+      {
+        std::ifstream cache(cachePath);
+        while (std::getline(cache, line) && line.find(" Affine:") == std::string::npos)
+          ;
+      }
+      size_t keyStart = line.find(" Affine:") + 1;
+      size_t sizeStart = line.rfind(' ');
+      std::ofstream(cachePath, std::ios::app) << line.substr(0, keyStart) << "AffineFixed"
+                                              << line.substr(keyStart + 6, sizeStart - keyStart - 6) << " 1024\n";
+    } else {
+      // A new context picks up the earlier result from the cache without tuning again
+      if (gprtComputeGetGroupSize(affine) != tunedGroupSize)
+        throw std::runtime_error("Error, tuned group size was not loaded from the cache!");
+      // but never applies one to a kernel whose group size can't be specialized
+      if (gprtComputeGetGroupSize(affineFixed) != 0)
+        throw std::runtime_error("Error, fixed group size kernel picked up a tuned group size!");
+    }
+    launchAndCheck(context, affine, y, params);
+    launchAndCheck(context, affineFixed, y, params);
+
+    // Cleanup
+    gprtComputeDestroy(affineFixed);
+    gprtComputeDestroy(affine);
+    gprtBufferDestroy(y);
+    gprtBufferDestroy(x);
+    gprtModuleDestroy(module);
+    gprtContextDestroy(context);
+  }
+
+  std::remove(cachePath);
+  std::cout << "Tuned launches matched" << std::endl;
+}
@@ -0,0 +1,99 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+extern GPRTProgram t25_deviceCode;
+
+static void
+expectInReport(const std::string &report, const std::string &text) {
+  if (report.find(text) == std::string::npos)
+    throw std::runtime_error("Error, pipeline statistics are missing " + text + "!\n" + report);
+}
+
+int
+main(int ac, char **av) {
+  const uint32_t count = 1024;
+  const char *reportPath = "t25_pipeline_statistics.json";
+
+  // Arrange
+  gprtRequestRayRecursionDepth(2);
+  gprtRequestPipelineStatistics();
+  GPRTContext context = gprtContextCreate();
+  GPRTModule module = gprtModuleCreate(context, t25_deviceCode);
+  GPRTBufferOf<uint32_t> values = gprtDeviceBufferCreate<uint32_t>(context, count);
+  GPRTRayGenOf<RayGenData> fill = gprtRayGenCreate<RayGenData>(context, module, "Fill");
+  GPRTMissOf<void> miss = gprtMissCreate<void>(context, module, "Miss");
+  GPRTComputeOf<ComputeParams> twice = gprtComputeCreate<ComputeParams>(context, module, "Double");
+  gprtRayGenGetParameters(fill)->values = gprtBufferGetDevicePointer(values);
+
+  // Nothing is built yet
+  std::string report = gprtContextGetPipelineStatistics(context);
+  expectInReport(report, "\"rayRecursionDepth\": 2");
+  expectInReport(report, "\"rayTracingPipeline\": null");
+
+  // Act
+  gprtBuildShaderBindingTable(context);
+  gprtRayGenLaunch1D(context, fill, count);
+  ComputeParams params = {gprtBufferGetDevicePointer(values), count};
+  gprtComputeLaunch(twice, {count / 64, 1, 1}, {64, 1, 1}, params);
+  report = gprtContextGetPipelineStatistics(context);
+  std::cout << report;
+
+  // Assert
+  expectInReport(report, "\"stackSize\": ");
+  expectInReport(report, "\"entryPoint\": \"Fill\"");
+  expectInReport(report, "\"entryPoint\": \"Miss\"");
+  expectInReport(report, "\"entryPoint\": \"Double\"");
+  // Drivers without VK_KHR_pipeline_executable_properties only report stack sizes
+  if (report.find("\"executableStatistics\": true") != std::string::npos)
+    expectInReport(report, "\"statistics\": {");
+
+  if (!gprtContextSavePipelineStatistics(context, reportPath))
+    throw std::runtime_error("Error, pipeline statistics could not be saved!");
+  std::ifstream saved(reportPath);
+  std::string savedReport((std::istreambuf_iterator<char>(saved)), std::istreambuf_iterator<char>());
+  if (savedReport != report)
+    throw std::runtime_error("Error, saved pipeline statistics differ from the report!");
+  saved.close();
+  std::remove(reportPath);
+
+  gprtBufferMap(values);
+  if (gprtBufferGetHostPointer(values)[count - 1] != 2 * (count - 1))
+    throw std::runtime_error("Error, launches did not run!");
+  gprtBufferUnmap(values);
+
+  // Cleanup
+  gprtComputeDestroy(twice);
+  gprtMissDestroy(miss);
+  gprtRayGenDestroy(fill);
+  gprtBufferDestroy(values);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
@@ -0,0 +1,106 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int
+main(int ac, char **av) {
+  const uint32_t numFrames = 200;
+  const uint32_t maxIdleFrames = 4;
+  // Per frame temporaries whose sizes jitter from frame to frame, as queue sizes would
+  const uint32_t baseCounts[] = {1 << 20, 1 << 16, 1 << 12};
+
+  // Arrange
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTTransientPool pool = gprtTransientPoolCreate(context, maxIdleFrames);
+
+  // Act, creating and destroying temporaries every frame
+  auto start = std::chrono::high_resolution_clock::now();
+  for (uint32_t frame = 0; frame < numFrames; ++frame) {
+    for (uint32_t baseCount : baseCounts) {
+      GPRTBufferOf<uint32_t> temporary = gprtDeviceBufferCreate<uint32_t>(context, baseCount - frame);
+      gprtBufferClear(temporary);
+      gprtBufferDestroy(temporary);
+    }
+  }
+  auto stop = std::chrono::high_resolution_clock::now();
+  auto regularTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+
+  // Act, recycling them through the pool
+  std::vector<uint64_t> addresses;
+  start = std::chrono::high_resolution_clock::now();
+  for (uint32_t frame = 0; frame < numFrames; ++frame) {
+    for (uint32_t i = 0; i < 3; ++i) {
+      uint32_t count = baseCounts[i] - frame;
+      GPRTBufferOf<uint32_t> temporary = gprtTransientBufferAcquire<uint32_t>(pool, count);
+      if (gprtBufferGetSize(temporary) != count * sizeof(uint32_t))
+        throw std::runtime_error("Error, transient buffer does not report its requested size!");
+      gprtBufferClear(temporary);
+      uint64_t address = (uint64_t) gprtBufferGetDevicePointer(temporary);
+      if (frame == 0)
+        addresses.push_back(address);
+      else if (addresses[i] != address)
+        throw std::runtime_error("Error, transient buffer was not recycled!");
+      gprtBufferDestroy(temporary);
+    }
+    gprtTransientPoolNextFrame(pool);
+  }
+  stop = std::chrono::high_resolution_clock::now();
+  auto transientTime = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+
+  // Assert
+  GPRTTransientPoolStats stats;
+  gprtTransientPoolGetStats(pool, &stats);
+  std::cout << "Regular temporaries: " << regularTime.count() / 1000.f << " ms" << std::endl;
+  std::cout << "Transient temporaries: " << transientTime.count() / 1000.f << " ms" << std::endl;
+  std::cout << "Reuse hit rate: " << 100.f * stats.numReuses / stats.numAcquires << "%, " << stats.numAllocations
+            << " allocations, " << stats.reservedBytes / 1024.f << " KiB reserved" << std::endl;
+  if (stats.numAcquires != 3 * numFrames || stats.numAllocations != 3 ||
+      stats.numReuses != stats.numAcquires - stats.numAllocations)
+    throw std::runtime_error("Error, unexpected number of transient allocations!");
+  if (stats.numLive != 0 || stats.numPending != 0 || stats.numFree != 3)
+    throw std::runtime_error("Error, released transient buffers were not returned to the pool!");
+
+  // Buffers held by the frame are not handed out again until released
+  GPRTBufferOf<uint32_t> first = gprtTransientBufferAcquire<uint32_t>(pool, baseCounts[2]);
+  GPRTBufferOf<uint32_t> second = gprtTransientBufferAcquire<uint32_t>(pool, baseCounts[2]);
+  if (gprtBufferGetDevicePointer(first) == gprtBufferGetDevicePointer(second))
+    throw std::runtime_error("Error, a live transient buffer was handed out twice!");
+  gprtBufferDestroy(second);
+  gprtBufferDestroy(first);
+
+  // Buffers left unused for more than maxIdleFrames frames are freed, counting the frame they were released in
+  for (uint32_t frame = 0; frame < maxIdleFrames + 2; ++frame)
+    gprtTransientPoolNextFrame(pool);
+  gprtTransientPoolGetStats(pool, &stats);
+  if (stats.numFree != 0 || stats.reservedBytes != 0 || stats.numFrees != stats.numAllocations)
+    throw std::runtime_error("Error, idle transient buffers were not freed!");
+
+  // Cleanup
+  gprtTransientPoolDestroy(pool);
+  gprtContextDestroy(context);
+}
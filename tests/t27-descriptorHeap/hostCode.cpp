@@ -0,0 +1,126 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+extern GPRTProgram t27_deviceCode;
+
+int
+main(int ac, char **av) {
+  // Textures are created and destroyed in rounds, so that drivers limiting the number of live allocations to 4096
+  // can still run this. Each round is still far beyond the initial 256 descriptors of the heap.
+  const uint32_t numRounds = 5;
+  const uint32_t texturesPerRound = 2048;
+  const uint32_t numProbes = 257;
+
+  // Arrange
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t27_deviceCode);
+  GPRTComputeOf<ProbeParams> probe = gprtComputeCreate<ProbeParams>(context, module, "Probe");
+  GPRTBufferOf<DescriptorHandle<Texture2D>> handles =
+      gprtHostBufferCreate<DescriptorHandle<Texture2D>>(context, numProbes);
+  GPRTBufferOf<float> results = gprtHostBufferCreate<float>(context, numProbes);
+
+  std::chrono::microseconds createTime(0), destroyTime(0);
+  uint32_t firstRoundMaxIndex = 0;
+  uint64_t firstRoundGrowths = 0;
+  for (uint32_t round = 0; round < numRounds; ++round) {
+    // Act, creating the textures of this round, each holding its own number
+    std::vector<GPRTTextureOf<float>> textures(texturesPerRound);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < texturesPerRound; ++i) {
+      float value = float(round * texturesPerRound + i);
+      textures[i] = gprtDeviceTextureCreate<float>(context, GPRT_IMAGE_TYPE_2D, GPRT_FORMAT_R32_SFLOAT, 1, 1, 1,
+                                                   false, &value);
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    createTime += std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+
+    // Assert, every live texture has its own slot in the heap
+    std::set<uint32_t> indices;
+    for (auto texture : textures)
+      indices.insert(gprtTextureGetIndex(texture));
+    if (indices.size() != texturesPerRound)
+      throw std::runtime_error("Error, live textures share a descriptor index!");
+    uint32_t maxIndex = *indices.rbegin();
+
+    // Assert, textures on both sides of every heap growth read back correctly
+    DescriptorHandle<Texture2D> *handlesHost = gprtBufferGetHostPointer(handles);
+    for (uint32_t j = 0; j < numProbes; ++j)
+      handlesHost[j] = gprtTextureGet2DHandle(textures[(j * 8) % texturesPerRound]);
+    ProbeParams params;
+    params.textures = gprtBufferGetDevicePointer(handles);
+    params.results = gprtBufferGetDevicePointer(results);
+    params.count = numProbes;
+    gprtComputeLaunch(probe, {(numProbes + 63) / 64, 1, 1}, {64, 1, 1}, params);
+    float *resultsHost = gprtBufferGetHostPointer(results);
+    for (uint32_t j = 0; j < numProbes; ++j) {
+      float expected = float(round * texturesPerRound + (j * 8) % texturesPerRound);
+      if (resultsHost[j] != expected)
+        throw std::runtime_error("Error, probe " + std::to_string(j) + " read " + std::to_string(resultsHost[j]) +
+                                 ", expected " + std::to_string(expected) + "!");
+    }
+
+    // Assert, the heap grew in the first round, and later rounds reuse the slots released before them
+    GPRTCounters counters = gprtContextGetCounters(context);
+    if (round == 0) {
+      if (counters.descriptorHeapGrowths == 0)
+        throw std::runtime_error("Error, the descriptor heap did not grow!");
+      firstRoundMaxIndex = maxIndex;
+      firstRoundGrowths = counters.descriptorHeapGrowths;
+    } else {
+      if (maxIndex > firstRoundMaxIndex)
+        throw std::runtime_error("Error, descriptor index " + std::to_string(maxIndex) +
+                                 " was not recycled, expected at most " + std::to_string(firstRoundMaxIndex) + "!");
+      if (counters.descriptorHeapGrowths != firstRoundGrowths)
+        throw std::runtime_error("Error, the descriptor heap grew although released slots were available!");
+    }
+
+    // Act, destroying the textures of this round
+    start = std::chrono::high_resolution_clock::now();
+    for (auto texture : textures)
+      gprtTextureDestroy(texture);
+    stop = std::chrono::high_resolution_clock::now();
+    destroyTime += std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+  }
+
+  GPRTCounters counters = gprtContextGetCounters(context);
+  std::cout << "Created " << numRounds * texturesPerRound << " textures in " << createTime.count() / 1000.f
+            << " ms, destroyed them in " << destroyTime.count() / 1000.f << " ms" << std::endl;
+  std::cout << counters.descriptorHeapGrowths << " heap growths, " << counters.descriptorWrites
+            << " descriptor writes" << std::endl;
+
+  // Cleanup
+  gprtBufferDestroy(results);
+  gprtBufferDestroy(handles);
+  gprtComputeDestroy(probe);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
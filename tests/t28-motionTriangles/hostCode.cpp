@@ -0,0 +1,219 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include "sharedCode.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+extern GPRTProgram t28_deviceCode;
+
+int
+main(int ac, char **av) {
+  const uint32_t gridSize = 512;   // quads along each side of the sheet
+  const uint32_t numVertices = (gridSize + 1) * (gridSize + 1);
+  const uint32_t numTriangles = 2 * gridSize * gridSize;
+  const uint32_t numKeys = 4;
+  const uint32_t numSteps = 32;
+  const uint32_t width = 1024;
+  const uint32_t height = 1024;
+
+  // Arrange
+  // A rippling sheet, whose ripples travel and grow from one keyframe to the next
+  std::vector<float3> keysHost(numKeys * numVertices);
+  for (uint32_t k = 0; k < numKeys; ++k) {
+    float phase = 1.5f * k;
+    float amplitude = 0.02f + 0.02f * k;
+    for (uint32_t y = 0; y <= gridSize; ++y) {
+      for (uint32_t x = 0; x <= gridSize; ++x) {
+        float u = float(x) / gridSize, v = float(y) / gridSize;
+        float h = amplitude * sinf(12.f * u + phase) * cosf(9.f * v - phase);
+        keysHost[k * numVertices + y * (gridSize + 1) + x] = float3(u, h, v);
+      }
+    }
+  }
+  std::vector<uint3> trianglesHost;
+  for (uint32_t y = 0; y < gridSize; ++y) {
+    for (uint32_t x = 0; x < gridSize; ++x) {
+      uint32_t i = y * (gridSize + 1) + x;
+      trianglesHost.push_back(uint3(i, i + 1, i + gridSize + 2));
+      trianglesHost.push_back(uint3(i, i + gridSize + 2, i + gridSize + 1));
+    }
+  }
+
+  gprtRequestMaxAttributeSize(sizeof(float2));
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+  GPRTModule module = gprtModuleCreate(context, t28_deviceCode);
+
+  GPRTGeomTypeOf<MotionData> motionType = gprtGeomTypeCreate<MotionData>(context, GPRT_MOTION_TRIANGLES);
+  gprtGeomTypeSetClosestHitProg(motionType, 0, module, "MotionHit");
+  GPRTGeomTypeOf<TriangleData> triangleType = gprtGeomTypeCreate<TriangleData>(context, GPRT_TRIANGLES);
+  gprtGeomTypeSetClosestHitProg(triangleType, 0, module, "TriangleHit");
+  GPRTMissOf<void> miss = gprtMissCreate<void>(context, module, "miss");
+  GPRTRayGenOf<RayGenData> traceMotion = gprtRayGenCreate<RayGenData>(context, module, "TraceMotion");
+  GPRTRayGenOf<RayGenData> traceStatic = gprtRayGenCreate<RayGenData>(context, module, "TraceStatic");
+  GPRTComputeOf<InterpolateParams> interpolate = gprtComputeCreate<InterpolateParams>(context, module, "Interpolate");
+
+  GPRTBufferOf<uint3> triangles = gprtDeviceBufferCreate<uint3>(context, numTriangles, trianglesHost.data());
+  GPRTBufferOf<float3> keys = gprtDeviceBufferCreate<float3>(context, keysHost.size(), keysHost.data());
+  GPRTBufferOf<float3> keyBuffers[numKeys];
+  for (uint32_t k = 0; k < numKeys; ++k)
+    keyBuffers[k] = gprtDeviceBufferCreate<float3>(context, numVertices, &keysHost[k * numVertices]);
+  GPRTBufferOf<float3> vertices = gprtDeviceBufferCreate<float3>(context, numVertices, keysHost.data());
+
+  // One build over all keyframes
+  auto start = std::chrono::high_resolution_clock::now();
+  GPRTGeomOf<MotionData> motionGeom = gprtGeomCreate(context, motionType);
+  gprtTrianglesSetMotionVertices(motionGeom, numKeys, keyBuffers, numVertices);
+  gprtTrianglesSetIndices(motionGeom, triangles, numTriangles);
+  gprtGeomGetParameters(motionGeom)->keys = gprtBufferGetDevicePointer(keys);
+  GPRTAccel motionAccel = gprtMotionTriangleAccelCreate(context, motionGeom);
+  gprtAccelBuild(context, motionAccel, GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+  gprt::Instance motionInstance = gprtAccelGetInstance(motionAccel);
+  GPRTBufferOf<gprt::Instance> motionInstances = gprtDeviceBufferCreate<gprt::Instance>(context, 1, &motionInstance);
+  GPRTAccel motionWorld = gprtInstanceAccelCreate(context, 1, motionInstances);
+  gprtAccelBuild(context, motionWorld, GPRT_BUILD_MODE_FAST_TRACE_NO_UPDATE);
+  float motionBuildTime =
+      std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+  // A tree over the first keyframe, refit at every step
+  GPRTGeomOf<TriangleData> triangleGeom = gprtGeomCreate(context, triangleType);
+  gprtTrianglesSetVertices(triangleGeom, vertices, numVertices);
+  gprtTrianglesSetIndices(triangleGeom, triangles, numTriangles);
+  gprtGeomGetParameters(triangleGeom)->vertices = gprtBufferGetDevicePointer(vertices);
+  GPRTAccel triangleAccel = gprtTriangleAccelCreate(context, triangleGeom);
+  gprtAccelBuild(context, triangleAccel, GPRT_BUILD_MODE_FAST_TRACE_AND_UPDATE);
+  gprt::Instance triangleInstance = gprtAccelGetInstance(triangleAccel);
+  GPRTBufferOf<gprt::Instance> triangleInstances =
+      gprtDeviceBufferCreate<gprt::Instance>(context, 1, &triangleInstance);
+  GPRTAccel triangleWorld = gprtInstanceAccelCreate(context, 1, triangleInstances);
+  gprtAccelBuild(context, triangleWorld, GPRT_BUILD_MODE_FAST_TRACE_AND_UPDATE);
+
+  GPRTBufferOf<float> motionResults = gprtDeviceBufferCreate<float>(context, width * height);
+  GPRTBufferOf<float> staticResults = gprtDeviceBufferCreate<float>(context, width * height);
+  RayGenData *motionData = gprtRayGenGetParameters(traceMotion);
+  RayGenData *staticData = gprtRayGenGetParameters(traceStatic);
+  for (RayGenData *data : {motionData, staticData}) {
+    data->eye = float3(1.4f, 0.9f, 1.6f);
+    data->target = float3(0.5f, 0.f, 0.5f);
+    data->time = 0.f;
+  }
+  motionData->world = gprtAccelGetDeviceAddress(motionWorld);
+  motionData->results = gprtBufferGetDevicePointer(motionResults);
+  staticData->world = gprtAccelGetDeviceAddress(triangleWorld);
+  staticData->results = gprtBufferGetDevicePointer(staticResults);
+  gprtBuildShaderBindingTable(context);
+
+  // Warm up, which also sizes the ray times
+  gprtRayGenLaunch2D(context, traceMotion, width, height);
+  gprtRayGenLaunch2D(context, traceStatic, width, height);
+
+  // Act
+  InterpolateParams params;
+  params.keys = gprtBufferGetDevicePointer(keys);
+  params.vertices = gprtBufferGetDevicePointer(vertices);
+  params.numKeys = numKeys;
+  params.numVertices = numVertices;
+  float motionTraceTime = 0.f, refitTime = 0.f, staticTraceTime = 0.f;
+  uint32_t numRays = width * height, numHits = 0, coverageMismatches = 0, depthMismatches = 0;
+  for (uint32_t step = 0; step < numSteps; ++step) {
+    float time = float(step) / float(numSteps - 1);
+    motionData->time = time;
+    staticData->time = time;
+    gprtBuildShaderBindingTable(context, GPRT_SBT_RAYGEN);
+
+    gprtBeginProfile(context);
+    gprtRayGenLaunch2D(context, traceMotion, width, height);
+    motionTraceTime += gprtEndProfile(context);
+
+    start = std::chrono::high_resolution_clock::now();
+    params.time = time;
+    gprtComputeLaunch(interpolate, {(numVertices + 255) / 256, 1, 1}, {256, 1, 1}, params);
+    gprtAccelUpdate(context, triangleAccel);
+    gprtAccelUpdate(context, triangleWorld);
+    refitTime += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    gprtBeginProfile(context);
+    gprtRayGenLaunch2D(context, traceStatic, width, height);
+    staticTraceTime += gprtEndProfile(context);
+
+    // Both interpolate the same keyframes, so only rays grazing an edge should disagree
+    gprtBufferMap(motionResults);
+    gprtBufferMap(staticResults);
+    float *motion = gprtBufferGetHostPointer(motionResults);
+    float *refit = gprtBufferGetHostPointer(staticResults);
+    for (uint32_t r = 0; r < numRays; ++r) {
+      if (refit[r] >= 0.f)
+        numHits++;
+      if ((motion[r] >= 0.f) != (refit[r] >= 0.f))
+        coverageMismatches++;
+      else if (refit[r] >= 0.f && fabsf(motion[r] - refit[r]) > 1e-3f * refit[r])
+        depthMismatches++;
+    }
+    gprtBufferUnmap(motionResults);
+    gprtBufferUnmap(staticResults);
+  }
+
+  std::cout << numTriangles << " triangles, " << numKeys << " keyframes, " << numSteps << " time steps" << std::endl;
+  std::cout << "Motion: one build " << motionBuildTime << " ms, tracing " << motionTraceTime / numSteps
+            << " ms per step, BLAS " << gprtAccelGetSize(motionAccel) / (1024.f * 1024.f) << " MB" << std::endl;
+  std::cout << "Refit: updates " << refitTime / numSteps << " ms per step, tracing " << staticTraceTime / numSteps
+            << " ms per step, BLAS " << gprtAccelGetSize(triangleAccel) / (1024.f * 1024.f) << " MB" << std::endl;
+  std::cout << "Over all steps: motion " << motionBuildTime + motionTraceTime << " ms, refit "
+            << refitTime + staticTraceTime << " ms" << std::endl;
+  std::cout << 100.f * coverageMismatches / numHits << "% of hits disagree on coverage, "
+            << 100.f * depthMismatches / numHits << "% on depth" << std::endl;
+
+  // Assert
+  if (numHits < numSteps * numRays / 10)
+    throw std::runtime_error("Error, the sheet covered too few pixels!");
+  if (coverageMismatches + depthMismatches > numHits / 1000)
+    throw std::runtime_error("Error, motion triangles disagree with the refit keyframes!");
+
+  // Cleanup
+  gprtBufferDestroy(staticResults);
+  gprtBufferDestroy(motionResults);
+  gprtAccelDestroy(triangleWorld);
+  gprtBufferDestroy(triangleInstances);
+  gprtAccelDestroy(triangleAccel);
+  gprtGeomDestroy(triangleGeom);
+  gprtAccelDestroy(motionWorld);
+  gprtBufferDestroy(motionInstances);
+  gprtAccelDestroy(motionAccel);
+  gprtGeomDestroy(motionGeom);
+  gprtBufferDestroy(vertices);
+  for (uint32_t k = 0; k < numKeys; ++k)
+    gprtBufferDestroy(keyBuffers[k]);
+  gprtBufferDestroy(keys);
+  gprtBufferDestroy(triangles);
+  gprtComputeDestroy(interpolate);
+  gprtRayGenDestroy(traceStatic);
+  gprtRayGenDestroy(traceMotion);
+  gprtMissDestroy(miss);
+  gprtGeomTypeDestroy(triangleType);
+  gprtGeomTypeDestroy(motionType);
+  gprtModuleDestroy(module);
+  gprtContextDestroy(context);
+}
@@ -0,0 +1,54 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "gprt.h"
+
+struct Payload {
+  float t;   // negative on a miss
+};
+
+// A sheet moving through keyframes, intersected at each ray's time by the built-in motion triangle program
+struct MotionData {
+  float3 *keys;   // keyframes, one after another
+};
+
+// The same sheet, interpolated to each time step on the device and refit
+struct TriangleData {
+  float3 *vertices;
+};
+
+struct RayGenData {
+  SurfaceAccelerationStructure world;
+  float *results;   // hit distance per ray
+  float3 eye;
+  float3 target;
+  float time;
+};
+
+// Interpolates the keyframes, stored one after another, to a time step
+struct InterpolateParams {
+  float3 *keys;
+  float3 *vertices;
+  uint32_t numKeys;
+  uint32_t numVertices;
+  float time;
+};
@@ -0,0 +1,259 @@
+// MIT License
+
+// Copyright (c) 2022 Nathan V. Morrical
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gprt.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Length of the segment from a to b within the box from lo to hi, by clipping against each slab in turn
+static double
+clippedLength(const double a[3], const double b[3], const double lo[3], const double hi[3]) {
+  double t0 = 0.0, t1 = 1.0;
+  for (int d = 0; d < 3; ++d) {
+    double delta = b[d] - a[d];
+    if (delta == 0.0) {
+      if (a[d] < lo[d] || a[d] > hi[d])
+        return 0.0;
+      continue;
+    }
+    double tLo = (lo[d] - a[d]) / delta, tHi = (hi[d] - a[d]) / delta;
+    t0 = std::max(t0, std::min(tLo, tHi));
+    t1 = std::min(t1, std::max(tLo, tHi));
+  }
+  double length = sqrt((b[0] - a[0]) * (b[0] - a[0]) + (b[1] - a[1]) * (b[1] - a[1]) + (b[2] - a[2]) * (b[2] - a[2]));
+  return t1 > t0 ? (t1 - t0) * length : 0.0;
+}
+
+int
+main(int ac, char **av) {
+  const uint32_t gridSize = 16;
+  const uint32_t numBins = gridSize * gridSize * gridSize;   // small enough to privatize
+  const uint32_t numTracks = 1 << 18;
+  const uint32_t numIterations = 10;
+  const float meanLength = 0.2f;
+
+  // Arrange
+  // The unit cube as a gridSize^3 regular grid, as the same grid of hexahedra, and split into six tetrahedra per
+  // hexahedron around each hexahedron's 0-6 diagonal, with hexahedron i + gridSize * (j + gridSize * k) matching
+  // grid bin (i, j, k), and tetrahedron t of a hexahedron being cell 6 * hexahedron + t
+  auto vertexIndex = [&](uint32_t i, uint32_t j, uint32_t k) { return i + (gridSize + 1) * (j + (gridSize + 1) * k); };
+  std::vector<float4> verticesHost;
+  for (uint32_t k = 0; k <= gridSize; ++k) {
+    for (uint32_t j = 0; j <= gridSize; ++j) {
+      for (uint32_t i = 0; i <= gridSize; ++i)
+        verticesHost.push_back(float4(float(i) / gridSize, float(j) / gridSize, float(k) / gridSize, 0.f));
+    }
+  }
+  const uint32_t tetCorners[6][4] = {{0, 1, 2, 6}, {0, 2, 3, 6}, {0, 3, 7, 6},
+                                     {0, 7, 4, 6}, {0, 4, 5, 6}, {0, 5, 1, 6}};
+  std::vector<uint32_t> hexIndicesHost, tetIndicesHost;
+  for (uint32_t k = 0; k < gridSize; ++k) {
+    for (uint32_t j = 0; j < gridSize; ++j) {
+      for (uint32_t i = 0; i < gridSize; ++i) {
+        uint32_t corners[8] = {vertexIndex(i, j, k),         vertexIndex(i + 1, j, k),
+                               vertexIndex(i + 1, j + 1, k), vertexIndex(i, j + 1, k),
+                               vertexIndex(i, j, k + 1),     vertexIndex(i + 1, j, k + 1),
+                               vertexIndex(i + 1, j + 1, k + 1), vertexIndex(i, j + 1, k + 1)};
+        hexIndicesHost.insert(hexIndicesHost.end(), corners, corners + 8);
+        for (const auto &tet : tetCorners) {
+          for (uint32_t c = 0; c < 8; ++c)
+            tetIndicesHost.push_back(c < 4 ? corners[tet[c]] : 0);
+        }
+      }
+    }
+  }
+
+  // The hexahedron holding p, and which of its tetrahedra does, from the order of p's coordinates within it
+  auto locate = [&](float3 p, uint32_t &hex, uint32_t &tet) {
+    float u[3] = {p.x * gridSize, p.y * gridSize, p.z * gridSize};
+    uint32_t c[3];
+    for (int d = 0; d < 3; ++d) {
+      c[d] = std::min<uint32_t>(uint32_t(u[d]), gridSize - 1);
+      u[d] -= float(c[d]);
+    }
+    hex = c[0] + gridSize * (c[1] + gridSize * c[2]);
+    float x = u[0], y = u[1], z = u[2];
+    uint32_t t = (x >= y && y >= z)   ? 0
+                 : (y >= x && x >= z) ? 1
+                 : (y >= z && z >= x) ? 2
+                 : (z >= y && y >= x) ? 3
+                 : (z >= x && x >= y) ? 4
+                                      : 5;
+    tet = 6 * hex + t;
+  };
+
+  // Two sources: tracks starting anywhere in the cube, which rarely share a bin, and tracks all starting near one
+  // point, which keep crowding into the same few bins
+  std::mt19937 rng(29);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  std::exponential_distribution<float> exponential(1.f / meanLength);
+  const char *sourceNames[2] = {"Uniform source", "Point source"};
+  std::vector<gprt::TallyTrack> hexTracksHost[2], tetTracksHost[2];
+  std::vector<double> reference[2];
+  for (uint32_t s = 0; s < 2; ++s) {
+    hexTracksHost[s].resize(numTracks);
+    reference[s].assign(numBins, 0.0);
+    for (uint32_t t = 0; t < numTracks; ++t) {
+      gprt::TallyTrack &track = hexTracksHost[s][t];
+      if (s == 0)
+        track.origin = float3(0.01f + 0.98f * uniform(rng), 0.01f + 0.98f * uniform(rng), 0.01f + 0.98f * uniform(rng));
+      else
+        track.origin = float3(0.53f + 0.01f * uniform(rng), 0.47f + 0.01f * uniform(rng), 0.51f + 0.01f * uniform(rng));
+      float z = 2.f * uniform(rng) - 1.f;
+      float phi = 6.2831853f * uniform(rng);
+      float r = sqrtf(1.f - z * z);
+      track.direction = float3(r * cosf(phi), r * sinf(phi), z);
+      track.length = exponential(rng);
+      track.weight = 0.5f + uniform(rng);
+
+      // Analytic scores, from the track's length within each bin its bounding box overlaps
+      double a[3] = {track.origin.x, track.origin.y, track.origin.z};
+      double b[3] = {a[0] + double(track.direction.x) * track.length, a[1] + double(track.direction.y) * track.length,
+                     a[2] + double(track.direction.z) * track.length};
+      int lower[3], upper[3];
+      for (int d = 0; d < 3; ++d) {
+        lower[d] = std::clamp(int(floor(std::min(a[d], b[d]) * gridSize)), 0, int(gridSize) - 1);
+        upper[d] = std::clamp(int(floor(std::max(a[d], b[d]) * gridSize)), 0, int(gridSize) - 1);
+      }
+      for (int k = lower[2]; k <= upper[2]; ++k) {
+        for (int j = lower[1]; j <= upper[1]; ++j) {
+          for (int i = lower[0]; i <= upper[0]; ++i) {
+            double lo[3] = {double(i) / gridSize, double(j) / gridSize, double(k) / gridSize};
+            double hi[3] = {double(i + 1) / gridSize, double(j + 1) / gridSize, double(k + 1) / gridSize};
+            reference[s][i + gridSize * (j + gridSize * k)] += track.weight * clippedLength(a, b, lo, hi);
+          }
+        }
+      }
+    }
+    tetTracksHost[s] = hexTracksHost[s];
+    for (uint32_t t = 0; t < numTracks; ++t)
+      locate(hexTracksHost[s][t].origin, hexTracksHost[s][t].cell, tetTracksHost[s][t].cell);
+  }
+
+  GPRTContext context = gprtContextCreate(nullptr, 1);
+
+  GPRTBufferOf<float4> vertices = gprtDeviceBufferCreate<float4>(context, verticesHost.size(), verticesHost.data());
+  GPRTBufferOf<uint32_t> indices[2] = {
+      gprtDeviceBufferCreate<uint32_t>(context, hexIndicesHost.size(), hexIndicesHost.data()),
+      gprtDeviceBufferCreate<uint32_t>(context, tetIndicesHost.size(), tetIndicesHost.data())};
+  const uint8_t cellTypes[2] = {GPRT_HEXAHEDRON, GPRT_TETRAHEDRON};
+  const uint32_t numCells[2] = {numBins, 6 * numBins};
+  GPRTGeomTypeOf<void> solidType = gprtGeomTypeCreate<void>(context, GPRT_SOLIDS);
+  GPRTBufferOf<uint8_t> types[2];
+  GPRTGeomOf<void> geoms[2];
+  gprt::SolidMesh meshes[2];
+  for (uint32_t m = 0; m < 2; ++m) {
+    // every cell shares one type
+    types[m] = gprtDeviceBufferCreate<uint8_t>(context, 1, &cellTypes[m]);
+    geoms[m] = gprtGeomCreate(context, solidType);
+    gprtSolidsSetVertices(geoms[m], vertices, uint32_t(verticesHost.size()));
+    gprtSolidsSetIndices(geoms[m], indices[m], numCells[m], 8 * sizeof(uint32_t));
+    gprtSolidsSetTypes(geoms[m], types[m], numCells[m], 0);
+    gprtSolidsBuildAdjacency(context, geoms[m]);
+    meshes[m] = gprtSolidsGetMesh(geoms[m]);
+  }
+
+  gprt::TallyGrid grid;
+  grid.lower = float3(0.f, 0.f, 0.f);
+  grid.upper = float3(1.f, 1.f, 1.f);
+  grid.dims = uint3(gridSize, gridSize, gridSize);
+
+  GPRTBufferOf<gprt::TallyTrack> hexTracks = gprtDeviceBufferCreate<gprt::TallyTrack>(context, numTracks);
+  GPRTBufferOf<gprt::TallyTrack> tetTracks = gprtDeviceBufferCreate<gprt::TallyTrack>(context, numTracks);
+  GPRTBufferOf<float> bins = gprtDeviceBufferCreate<float>(context, numCells[1]);
+
+  const char *tallyNames[3] = {"grid", "hexahedral mesh", "tetrahedral mesh"};
+  const char *accumulationNames[3] = {"atomic", "subgroup", "privatized"};
+  const GPRTTallyAccumulation accumulations[3] = {GPRT_TALLY_ATOMIC, GPRT_TALLY_SUBGROUP, GPRT_TALLY_PRIVATIZED};
+  for (uint32_t s = 0; s < 2; ++s) {
+    gprtBufferMap(hexTracks);
+    std::copy(hexTracksHost[s].begin(), hexTracksHost[s].end(), gprtBufferGetHostPointer(hexTracks));
+    gprtBufferUnmap(hexTracks);
+    gprtBufferMap(tetTracks);
+    std::copy(tetTracksHost[s].begin(), tetTracksHost[s].end(), gprtBufferGetHostPointer(tetTracks));
+    gprtBufferUnmap(tetTracks);
+
+    double total = 0.0;
+    for (double score : reference[s])
+      total += score;
+    std::cout << sourceNames[s] << ", " << numTracks << " tracks into " << numBins << " bins:" << std::endl;
+
+    for (uint32_t tally = 0; tally < 3; ++tally) {
+      for (uint32_t a = 0; a < 3; ++a) {
+        // Act
+        // Scored from a clear tally each iteration, keeping the fastest once pipelines are warm
+        float time = 1e30f;
+        for (uint32_t iteration = 0; iteration < numIterations; ++iteration) {
+          gprtBufferClear(bins);
+          gprtBeginProfile(context);
+          if (tally == 0)
+            gprtTallyScoreGrid(context, hexTracks, numTracks, grid, bins, accumulations[a]);
+          else if (tally == 1)
+            gprtTallyScoreMesh(context, hexTracks, numTracks, meshes[0], bins, accumulations[a]);
+          else
+            gprtTallyScoreMesh(context, tetTracks, numTracks, meshes[1], bins, accumulations[a]);
+          time = std::min(time, gprtEndProfile(context));
+        }
+        std::cout << "  " << tallyNames[tally] << ", " << accumulationNames[a] << ": "
+                  << numTracks / (time * 1e3f) << " Mtracks/s" << std::endl;
+
+        // Assert
+        // Scoring order differs between runs, and the walks step cell to cell in single precision, so the tallies
+        // only agree with the analytic scores to within rounding
+        gprtBufferMap(bins);
+        float *scores = gprtBufferGetHostPointer(bins);
+        double error = 0.0;
+        for (uint32_t bin = 0; bin < numBins; ++bin) {
+          // each hexahedron's score is the sum over its six tetrahedra
+          double score = 0.0;
+          for (uint32_t t = 0; t < (tally == 2 ? 6u : 1u); ++t)
+            score += scores[(tally == 2 ? 6 * bin : bin) + t];
+          double difference = fabs(score - reference[s][bin]);
+          error += difference;
+          if (difference > 1e-3 * reference[s][bin] + 1e-4 * total / numBins)
+            throw std::runtime_error(std::string("Error, incorrect ") + tallyNames[tally] + " tally!");
+        }
+        gprtBufferUnmap(bins);
+        if (error > 1e-4 * total)
+          throw std::runtime_error(std::string("Error, inaccurate ") + tallyNames[tally] + " tally!");
+      }
+    }
+  }
+
+  // Cleanup
+  gprtBufferDestroy(bins);
+  gprtBufferDestroy(tetTracks);
+  gprtBufferDestroy(hexTracks);
+  for (uint32_t m = 0; m < 2; ++m) {
+    gprtGeomDestroy(geoms[m]);
+    gprtBufferDestroy(types[m]);
+    gprtBufferDestroy(indices[m]);
+  }
+  gprtGeomTypeDestroy(solidType);
+  gprtBufferDestroy(vertices);
+  gprtContextDestroy(context);
+}